@@ -229,6 +229,12 @@ $O/LzFindMt.o: ../../../C/LzFindMt.c
 $O/LzFindOpt.o: ../../../C/LzFindOpt.c
 	$(CC) $(CFLAGS) $<
 
+$O/MemBudget.o: ../../../C/MemBudget.c
+	$(CC) $(CFLAGS) $<
+
+$O/ThreadPool.o: ../../../C/ThreadPool.c
+	$(CC) $(CFLAGS) $<
+
 $O/Threads.o: ../../../C/Threads.c
 	$(CC) $(CFLAGS) $<
 # endif
@@ -352,6 +358,8 @@ $O/7zipUninstall.o: ../../../C/Util/7zipUninstall/7zipUninstall.c
 	$(CC) $(CFLAGS) $<
 $O/LzmaUtil.o: ../../../C/Util/Lzma/LzmaUtil.c
 	$(CC) $(CFLAGS) $<
+$O/LzmaBatchUtil.o: ../../../C/Util/LzmaBatch/LzmaBatchUtil.c
+	$(CC) $(CFLAGS) $<
 $O/XzUtil.o: ../../../C/Util/Xz/XzUtil.c
 	$(CC) $(CFLAGS) $<
 
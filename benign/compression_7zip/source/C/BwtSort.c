@@ -3,6 +3,8 @@
 
 #include "Precomp.h"
 
+#include <string.h>
+
 #include "BwtSort.h"
 #include "Sort.h"
 
@@ -626,3 +628,288 @@ UInt32 BlockSort(UInt32 *Indices, const Byte *data, size_t blockSize)
 #endif
   return Groups[0];
 }
+
+
+
+/* ---------- SA-IS ----------
+  Induced sorting of suffixes (Nong, Zhang, Chan) with virtual sentinel.
+  We sort suffixes of (data + data) string: the order of suffixes that start
+  in first half is same as the order of (data) rotations. */
+
+#define SAIS_EMPTY ((UInt32)0xFFFFFFFF)
+
+#define SAIS_CHR(i)  (cs == 1 ? (UInt32)((const Byte *)s)[i] : ((const UInt32 *)s)[i])
+/* (t) is bit array: 1 - S-type, 0 - L-type */
+#define SAIS_T_GET(i)  ((t[(i) >> 3] >> ((i) & 7)) & 1)
+#define SAIS_T_SET_S(i)  t[(i) >> 3] |= (Byte)(1 << ((i) & 7));
+#define SAIS_IS_LMS(i)  ((i) > 0 && SAIS_T_GET(i) && !SAIS_T_GET((i) - 1))
+
+static void SaIs_GetBuckets(const void *s, unsigned cs, UInt32 *bkt, size_t n, size_t k, BoolInt end)
+{
+  size_t i;
+  UInt32 sum = 0;
+  for (i = 0; i < k; i++)
+    bkt[i] = 0;
+  for (i = 0; i < n; i++)
+    bkt[SAIS_CHR(i)]++;
+  for (i = 0; i < k; i++)
+  {
+    const UInt32 v = bkt[i];
+    sum += v;
+    bkt[i] = end ? sum : sum - v;
+  }
+}
+
+static void SaIs_InduceL(const Byte *t, UInt32 *SA, const void *s, unsigned cs, UInt32 *bkt, size_t n, size_t k)
+{
+  size_t i;
+  SaIs_GetBuckets(s, cs, bkt, n, k, False);
+  /* suffix (n - 1) is L-type, and it's placed after virtual sentinel */
+  SA[bkt[SAIS_CHR(n - 1)]++] = (UInt32)(n - 1);
+  for (i = 0; i < n; i++)
+  {
+    UInt32 j = SA[i];
+    if (j != SAIS_EMPTY && j != 0)
+    {
+      j--;
+      if (!SAIS_T_GET(j))
+        SA[bkt[SAIS_CHR(j)]++] = j;
+    }
+  }
+}
+
+static void SaIs_InduceS(const Byte *t, UInt32 *SA, const void *s, unsigned cs, UInt32 *bkt, size_t n, size_t k)
+{
+  size_t i;
+  SaIs_GetBuckets(s, cs, bkt, n, k, True);
+  for (i = n; i != 0; i--)
+  {
+    UInt32 j = SA[i - 1];
+    if (j != SAIS_EMPTY && j != 0)
+    {
+      j--;
+      if (SAIS_T_GET(j))
+        SA[--bkt[SAIS_CHR(j)]] = j;
+    }
+  }
+}
+
+/* (s) is string of (n) symbols with values < (k): Byte symbols (cs == 1) or UInt32 symbols (cs == 4).
+   SA[n] will contain suffix array. */
+
+static SRes SaIs(const void *s, UInt32 *SA, size_t n, size_t k, unsigned cs, ISzAllocPtr alloc)
+{
+  Byte *t;
+  UInt32 *bkt;
+  size_t i, n1, name;
+  SRes res = SZ_OK;
+
+  t = (Byte *)ISzAlloc_Alloc(alloc, (n + 7) >> 3);
+  if (!t)
+    return SZ_ERROR_MEM;
+  bkt = (UInt32 *)ISzAlloc_Alloc(alloc, k * sizeof(UInt32));
+  if (!bkt)
+  {
+    ISzAlloc_Free(alloc, t);
+    return SZ_ERROR_MEM;
+  }
+
+  for (i = 0; i < ((n + 7) >> 3); i++)
+    t[i] = 0;
+  /* suffix (n - 1) is L-type, because virtual sentinel is smaller than any symbol */
+  for (i = n - 1; i != 0; i--)
+  {
+    const UInt32 c0 = SAIS_CHR(i - 1);
+    const UInt32 c1 = SAIS_CHR(i);
+    if (c0 < c1 || (c0 == c1 && SAIS_T_GET(i)))
+      SAIS_T_SET_S(i - 1)
+  }
+
+  /* stage 1: sort all LMS-substrings */
+  SaIs_GetBuckets(s, cs, bkt, n, k, True);
+  for (i = 0; i < n; i++)
+    SA[i] = SAIS_EMPTY;
+  for (i = 1; i < n; i++)
+    if (SAIS_IS_LMS(i))
+      SA[--bkt[SAIS_CHR(i)]] = (UInt32)i;
+  SaIs_InduceL(t, SA, s, cs, bkt, n, k);
+  SaIs_InduceS(t, SA, s, cs, bkt, n, k);
+
+  /* move sorted LMS-substrings to first (n1) items of SA */
+  n1 = 0;
+  for (i = 0; i < n; i++)
+  {
+    const UInt32 pos = SA[i];
+    if (SAIS_IS_LMS(pos))
+      SA[n1++] = pos;
+  }
+
+  /* name the LMS-substrings */
+  for (i = n1; i < n; i++)
+    SA[i] = SAIS_EMPTY;
+  name = 0;
+  {
+    UInt32 prev = SAIS_EMPTY;
+    for (i = 0; i < n1; i++)
+    {
+      const UInt32 pos = SA[i];
+      BoolInt diff = False;
+      size_t d;
+      for (d = 0;; d++)
+      {
+        if (prev == SAIS_EMPTY
+            || pos + d == n
+            || prev + d == n
+            || SAIS_CHR(pos + d) != SAIS_CHR(prev + d)
+            || SAIS_T_GET(pos + d) != SAIS_T_GET(prev + d))
+        {
+          diff = True;
+          break;
+        }
+        if (d != 0 && (SAIS_IS_LMS(pos + d) || SAIS_IS_LMS(prev + d)))
+          break;
+      }
+      if (diff)
+      {
+        name++;
+        prev = pos;
+      }
+      SA[n1 + (pos >> 1)] = (UInt32)(name - 1);
+    }
+  }
+  {
+    size_t j = n;
+    for (i = n; i != n1;)
+    {
+      i--;
+      if (SA[i] != SAIS_EMPTY)
+        SA[--j] = SA[i];
+    }
+  }
+
+  /* stage 2: sort reduced string */
+  {
+    UInt32 *s1 = SA + n - n1;
+    if (name < n1)
+    {
+      ISzAlloc_Free(alloc, bkt);
+      res = SaIs(s1, SA, n1, name, 4, alloc);
+      bkt = NULL;
+      if (res == SZ_OK)
+      {
+        bkt = (UInt32 *)ISzAlloc_Alloc(alloc, k * sizeof(UInt32));
+        if (!bkt)
+          res = SZ_ERROR_MEM;
+      }
+      if (res != SZ_OK)
+      {
+        ISzAlloc_Free(alloc, t);
+        return res;
+      }
+    }
+    else
+      for (i = 0; i < n1; i++)
+        SA[s1[i]] = (UInt32)i;
+
+    /* stage 3: induce the result from sorted LMS-suffixes */
+    {
+      size_t j = 0;
+      for (i = 1; i < n; i++)
+        if (SAIS_IS_LMS(i))
+          s1[j++] = (UInt32)i;
+    }
+    for (i = 0; i < n1; i++)
+      SA[i] = s1[SA[i]];
+  }
+  for (i = n1; i < n; i++)
+    SA[i] = SAIS_EMPTY;
+  SaIs_GetBuckets(s, cs, bkt, n, k, True);
+  for (i = n1; i != 0; i--)
+  {
+    const UInt32 j = SA[i - 1];
+    SA[i - 1] = SAIS_EMPTY;
+    SA[--bkt[SAIS_CHR(j)]] = j;
+  }
+  SaIs_InduceL(t, SA, s, cs, bkt, n, k);
+  SaIs_InduceS(t, SA, s, cs, bkt, n, k);
+
+  ISzAlloc_Free(alloc, bkt);
+  ISzAlloc_Free(alloc, t);
+  return res;
+}
+
+
+SRes BlockSort_SaIs(UInt32 *indices, const Byte *data, size_t blockSize, UInt32 *origPtr, ISzAllocPtr alloc)
+{
+  const size_t size2 = blockSize * 2;
+  Byte *data2;
+  size_t i, j;
+  *origPtr = 0;
+  if (blockSize <= 1)
+  {
+    if (blockSize != 0)
+      indices[0] = 0;
+    return SZ_OK;
+  }
+  data2 = (Byte *)ISzAlloc_Alloc(alloc, size2);
+  if (!data2)
+    return SZ_ERROR_MEM;
+  memcpy(data2, data, blockSize);
+  memcpy(data2 + blockSize, data, blockSize);
+  {
+    const SRes res = SaIs(data2, indices, size2, 256, 1, alloc);
+    ISzAlloc_Free(alloc, data2);
+    RINOK(res)
+  }
+  for (i = 0, j = 0; i < size2; i++)
+  {
+    const UInt32 v = indices[i];
+    if (v < blockSize)
+    {
+      if (v == 0)
+        *origPtr = (UInt32)j;
+      indices[j++] = v;
+    }
+  }
+  return SZ_OK;
+}
+
+
+/* We estimate average length of repeated strings with simple hash table,
+   as in LZ match finder. BlockSort() is slow, if the matches are long:
+   it needs more passes of prefix doubling for such data. */
+
+#define kRepHashBits 16
+#define kRepMaxLen 64
+#define kRepStep 8
+#define kRepAvgLen_Threshold 12
+
+BoolInt BlockSort_IsRepetitive(UInt32 *indices, const Byte *data, size_t blockSize)
+{
+  UInt32 *hash = indices;
+  size_t i, numChecks = 0, sumLen = 0;
+  if (blockSize < (1 << 16))
+    return False;
+  for (i = 0; i < ((size_t)1 << kRepHashBits); i++)
+    hash[i] = 0;
+  for (i = 1; i < blockSize - kRepMaxLen; i++)
+  {
+    const Byte *p = data + i;
+    const UInt32 h = (((UInt32)p[0] << 8 | p[1]) * 0x9E3779B1 ^ ((UInt32)p[2] << 8 | p[3]) * 0x85EBCA77) >> (32 - kRepHashBits);
+    if ((i & (kRepStep - 1)) == 0)
+    {
+      const UInt32 prev = hash[h];
+      numChecks++;
+      if (prev != 0)
+      {
+        const Byte *p2 = data + prev;
+        unsigned len;
+        for (len = 0; len < kRepMaxLen && p2[len] == p[len]; len++)
+        {}
+        sumLen += len;
+      }
+    }
+    hash[h] = (UInt32)i;
+  }
+  return (sumLen >= numChecks * kRepAvgLen_Threshold);
+}
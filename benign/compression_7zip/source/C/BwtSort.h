@@ -22,6 +22,23 @@ EXTERN_C_BEGIN
 
 UInt32 BlockSort(UInt32 *indices, const Byte *data, size_t blockSize);
 
+/*
+BlockSort_SaIs() - linear time sorting (SA-IS) of (data) rotations.
+  It's faster than BlockSort() for blocks with long repeated strings.
+  (indices) must contain BLOCK_SORT_BUF_SIZE(blockSize) items, as for BlockSort().
+  (blockSize <= ((UInt32)1 << 30))
+  Temporary buffers are allocated with (alloc).
+returns:
+  SZ_OK         : (indices) contains sorted rotations, (*origPtr) is position of rotation 0
+  SZ_ERROR_MEM  : allocation error
+*/
+SRes BlockSort_SaIs(UInt32 *indices, const Byte *data, size_t blockSize, UInt32 *origPtr, ISzAllocPtr alloc);
+
+/* returns 1, if (data) contains many long repeated strings,
+   and BlockSort_SaIs() is recommended for such block.
+   (indices) is used as temp buffer, as in BlockSort() */
+BoolInt BlockSort_IsRepetitive(UInt32 *indices, const Byte *data, size_t blockSize);
+
 EXTERN_C_END
 
 #endif
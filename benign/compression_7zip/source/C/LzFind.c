@@ -595,6 +595,36 @@ void MatchFinder_Init(void *_p)
 }
 
 
+#define GET_NUM_HASH_REFS(p) ((size_t)(p)->fixedHashSize + (p)->hashMask + 1)
+#define GET_NUM_PREFIX_SONS(p, prefixSize) ((size_t)((prefixSize) + 1) << ((p)->btMode ? 1 : 0))
+
+size_t MatchFinder_GetPrefixStateSize(const CMatchFinder *p, UInt32 prefixSize)
+{
+  return GET_NUM_HASH_REFS(p) + GET_NUM_PREFIX_SONS(p, prefixSize);
+}
+
+void MatchFinder_SavePrefix(const CMatchFinder *p, CLzRef *refs, UInt32 prefixSize)
+{
+  const size_t numHashRefs = GET_NUM_HASH_REFS(p);
+  memcpy(refs, p->hash, numHashRefs * sizeof(CLzRef));
+  memcpy(refs + numHashRefs, p->son, GET_NUM_PREFIX_SONS(p, prefixSize) * sizeof(CLzRef));
+}
+
+void MatchFinder_RestorePrefix(CMatchFinder *p, const CLzRef *refs, UInt32 prefixSize)
+{
+  const size_t numHashRefs = GET_NUM_HASH_REFS(p);
+  memcpy(p->hash, refs, numHashRefs * sizeof(CLzRef));
+  memcpy(p->son, refs + numHashRefs, GET_NUM_PREFIX_SONS(p, prefixSize) * sizeof(CLzRef));
+  MatchFinder_Init_4(p);
+  MatchFinder_ReadBlock(p);
+  /* it's same state as after MatchFinder_Init() and Skip(prefixSize) */
+  p->pos += prefixSize;
+  p->buffer += prefixSize;
+  p->cyclicBufferPos = (p->pos - CYC_TO_POS_OFFSET);
+  MatchFinder_SetLimits(p);
+}
+
+
 
 #ifdef MY_CPU_X86_OR_AMD64
   #if defined(__clang__) && (__clang_major__ >= 4) \
@@ -147,6 +147,20 @@ void MatchFinder_Init_4(CMatchFinder *p);
 // void MatchFinder_Init(CMatchFinder *p);
 void MatchFinder_Init(void *p);
 
+/*
+The functions for the data with preset prefix (for direct input mode only).
+  MatchFinder_SavePrefix() saves hash tables and the records for first (prefixSize) bytes
+    after MatchFinder_Init() and Skip(prefixSize) calls.
+  MatchFinder_RestorePrefix() replaces MatchFinder_Init() and Skip(prefixSize) calls
+    for new input buffer that starts with same (prefixSize) bytes.
+    The hash mask and the size of cyclic buffer must be same as in saving.
+  (prefixSize + 1 < cyclicBufferSize) is required.
+  MatchFinder_GetPrefixStateSize() returns the number of (CLzRef) items for saved state.
+*/
+size_t MatchFinder_GetPrefixStateSize(const CMatchFinder *p, UInt32 prefixSize);
+void MatchFinder_SavePrefix(const CMatchFinder *p, CLzRef *refs, UInt32 prefixSize);
+void MatchFinder_RestorePrefix(CMatchFinder *p, const CLzRef *refs, UInt32 prefixSize);
+
 UInt32* Bt3Zip_MatchFinder_GetMatches(CMatchFinder *p, UInt32 *distances);
 UInt32* Hc3Zip_MatchFinder_GetMatches(CMatchFinder *p, UInt32 *distances);
 
@@ -88,7 +88,7 @@ static void MtSync_Construct(CMtSync *p)
   p->wasCreated = False;
   p->csWasInitialized = False;
   p->csWasEntered = False;
-  Thread_CONSTRUCT(&p->thread)
+  PoolThread_CONSTRUCT(&p->thread)
   Event_Construct(&p->canStart);
   Event_Construct(&p->wasStopped);
   Semaphore_Construct(&p->freeSemaphore);
@@ -152,7 +152,7 @@ static UInt32 MtSync_GetNextBlock(CMtSync *p)
 Z7_NO_INLINE
 static void MtSync_StopWriting(CMtSync *p)
 {
-  if (!Thread_WasCreated(&p->thread) || p->needStart)
+  if (!PoolThread_WasCreated(&p->thread) || p->needStart)
     return;
 
     PRF(printf("\nMtSync_StopWriting %p\n", p));
@@ -192,7 +192,7 @@ static void MtSync_Destruct(CMtSync *p)
 {
     PRF(printf("\nMtSync_Destruct %p\n", p));
   
-  if (Thread_WasCreated(&p->thread))
+  if (PoolThread_WasCreated(&p->thread))
   {
     /* we want thread to be in Stopped state before sending EXIT command.
        note: stop(btSync) will stop (htSync) also */
@@ -201,7 +201,7 @@ static void MtSync_Destruct(CMtSync *p)
     p->exit = True;
     // if (p->needStart)  // it's (true)
     Event_Set(&p->canStart);  // we send EXIT command to thread
-    Thread_Wait_Close(&p->thread);  // we wait thread finishing
+    PoolThread_Wait_Close(&p->thread);  // we wait thread finishing
   }
 
   if (p->csWasInitialized)
@@ -263,14 +263,14 @@ static WRes MtSync_Create_WRes(CMtSync *p, THREAD_FUNC_TYPE startAddress, void *
 
 #ifdef _WIN32
   if (p->affinityGroup >= 0)
-    wres = Thread_Create_With_Group(&p->thread, startAddress, obj,
+    wres = Thread_Create_With_Group(&p->thread.thread, startAddress, obj,
         (unsigned)(UInt32)p->affinityGroup, (CAffinityMask)p->affinityInGroup);
   else
 #endif
   if (p->affinity != 0)
-    wres = Thread_Create_With_Affinity(&p->thread, startAddress, obj, (CAffinityMask)p->affinity);
+    wres = Thread_Create_With_Affinity(&p->thread.thread, startAddress, obj, (CAffinityMask)p->affinity);
   else
-    wres = Thread_Create(&p->thread, startAddress, obj);
+    wres = PoolThread_Create(&p->thread, startAddress, obj);
 
   RINOK_THREAD(wres)
   p->wasCreated = True;
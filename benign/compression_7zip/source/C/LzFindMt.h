@@ -5,6 +5,7 @@
 #define ZIP7_INC_LZ_FIND_MT_H
 
 #include "LzFind.h"
+#include "ThreadPool.h"
 #include "Threads.h"
 
 EXTERN_C_BEGIN
@@ -15,7 +16,7 @@ typedef struct
   Int32 affinityGroup;
   UInt64 affinityInGroup;
   UInt64 affinity;
-  CThread thread;
+  CPoolThread thread;
 
   BoolInt wasCreated;
   BoolInt needStart;
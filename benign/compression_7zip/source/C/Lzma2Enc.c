@@ -783,6 +783,8 @@ SRes Lzma2Enc_Encode2(CLzma2EncHandle p,
 
     p->mtCoder.numThreadsMax = (unsigned)p->props.numBlockThreads_Max;
     p->mtCoder.numThreadGroups = p->props.numThreadGroups;
+    p->mtCoder.memUsagePerThread = LzmaEncProps_GetMemUsage(&p->props.lzmaProps)
+        + p->mtCoder.blockSize + p->outBufSize;
     p->mtCoder.expectedDataSize = p->expectedDataSize;
     
     {
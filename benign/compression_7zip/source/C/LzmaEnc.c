@@ -116,6 +116,27 @@ UInt32 LzmaEncProps_GetDictSize(const CLzmaEncProps *props2)
   return props.dictSize;
 }
 
+UInt64 LzmaEncProps_GetMemUsage(const CLzmaEncProps *props2)
+{
+  UInt64 size;
+  CLzmaEncProps props = *props2;
+  LzmaEncProps_Normalize(&props);
+  size = props.dictSize;
+  /* window with (keepAddBufferBefore) and (keepAddBufferAfter) */
+  size += (size >> 1) + ((UInt32)1 << 20);
+  /* son[] of match finder: 2 links per position in binTree mode */
+  size += (UInt64)props.dictSize * (props.btMode ? 8 : 4);
+  /* hash[] */
+  size += (UInt64)props.dictSize * 2;
+  /* encoder state and saved state */
+  size += (UInt32)1 << 21;
+  #ifndef Z7_ST
+  if (props.numThreads > 1)
+    size += (UInt32)5 << 20; /* hash and binTree buffers of LzFindMt */
+  #endif
+  return size;
+}
+
 
 /*
 x86/x64:
@@ -481,6 +502,11 @@ struct CLzmaEnc
 
   CSaveState saveState;
 
+  CLzRef *prefixRefs;   /* saved state of match finder for preset prefix */
+  size_t prefixRefsSize;
+  UInt32 prefixSaved;   /* the number of bytes in saved state, (0) means no saved state */
+  UInt32 prefixHashMask;
+
   // BoolInt mf_Failure;
   #ifndef Z7_ST
   Byte pad2[128];
@@ -537,6 +563,7 @@ SRes LzmaEnc_SetProps(CLzmaEncHandle p, const CLzmaEncProps *props2)
   // GET_CLzmaEnc_p
   CLzmaEncProps props = *props2;
   LzmaEncProps_Normalize(&props);
+  p->prefixSaved = 0;
 
   if (props.lc > LZMA_LC_MAX
       || props.lp > LZMA_LP_MAX
@@ -2328,6 +2355,8 @@ static void LzmaEnc_Construct(CLzmaEnc *p)
 {
   RangeEnc_Construct(&p->rc);
   MatchFinder_Construct(&MFB);
+  p->prefixRefs = NULL;
+  p->prefixRefsSize = 0;
   
   #ifndef Z7_ST
   p->matchFinderMt.MatchFinder = &MFB;
@@ -2373,6 +2402,8 @@ static void LzmaEnc_Destruct(CLzmaEnc *p, ISzAllocPtr alloc, ISzAllocPtr allocBi
   #endif
   
   MatchFinder_Free(&MFB, allocBig);
+  ISzAlloc_Free(allocBig, p->prefixRefs);
+  p->prefixRefs = NULL;
   LzmaEnc_FreeLits(p, alloc);
   RangeEnc_Free(&p->rc, alloc);
 }
@@ -3040,6 +3071,26 @@ SRes LzmaEnc_Encode(CLzmaEncHandle p, ISeqOutStreamPtr outStream, ISeqInStreamPt
 }
 
 
+/* LzmaEnc_EncodeFromBuf() reads the whole input data directly from (src) buffer,
+   so the match finder doesn't copy input data to its own window buffer */
+
+SRes LzmaEnc_EncodeFromBuf(CLzmaEncHandle p, ISeqOutStreamPtr outStream, const Byte *src, SizeT srcLen,
+    ICompressProgressPtr progress, ISzAllocPtr alloc, ISzAllocPtr allocBig)
+{
+  // GET_CLzmaEnc_p
+  SRes res;
+  p->rc.outStream = outStream;
+  res = LzmaEnc_MemPrepare(p, src, srcLen, 0, alloc, allocBig);
+  if (res == SZ_OK)
+  {
+    res = LzmaEnc_Encode2(p, progress);
+    if (res == SZ_OK && p->nowPos64 != srcLen)
+      res = SZ_ERROR_FAIL;
+  }
+  return res;
+}
+
+
 SRes LzmaEnc_WriteProperties(CLzmaEncHandle p, Byte *props, SizeT *size)
 {
   if (*size < LZMA_PROPS_SIZE)
@@ -3083,7 +3134,34 @@ unsigned LzmaEnc_IsWriteEndMark(CLzmaEncHandle p)
 }
 
 
-SRes LzmaEnc_MemEncode(CLzmaEncHandle p, Byte *dest, SizeT *destLen, const Byte *src, SizeT srcLen,
+/* it inserts (numSaved) bytes of prefix to match finder, and it saves the state of match finder.
+   The match finder gets only the prefix data, so the state doesn't depend from next data */
+
+static SRes LzmaEnc_SavePrefix(CLzmaEnc *p, const Byte *src, UInt32 prefixSize, UInt32 numSaved, ISzAllocPtr allocBig)
+{
+  const size_t size = MatchFinder_GetPrefixStateSize(&MFB, numSaved);
+  p->prefixSaved = 0;
+  if (size > p->prefixRefsSize)
+  {
+    ISzAlloc_Free(allocBig, p->prefixRefs);
+    p->prefixRefsSize = 0;
+    p->prefixRefs = (CLzRef *)ISzAlloc_Alloc(allocBig, size * sizeof(CLzRef));
+    if (!p->prefixRefs)
+      return SZ_ERROR_MEM;
+    p->prefixRefsSize = size;
+  }
+  MatchFinder_SET_DIRECT_INPUT_BUF(&MFB, src, prefixSize)
+  MatchFinder_Init(&MFB);
+  p->matchFinder.Skip(p->matchFinderObj, numSaved);
+  MatchFinder_SavePrefix(&MFB, p->prefixRefs, numSaved);
+  p->prefixSaved = numSaved;
+  p->prefixHashMask = MFB.hashMask;
+  return SZ_OK;
+}
+
+
+SRes LzmaEnc_MemEncode_Prefix(CLzmaEncHandle p, Byte *dest, SizeT *destLen, const Byte *src, SizeT srcLen,
+    SizeT prefixSize, BoolInt reusePrefix,
     int writeEndMark, ICompressProgressPtr progress, ISzAllocPtr alloc, ISzAllocPtr allocBig)
 {
   SRes res;
@@ -3091,6 +3169,11 @@ SRes LzmaEnc_MemEncode(CLzmaEncHandle p, Byte *dest, SizeT *destLen, const Byte
 
   CLzmaEnc_SeqOutStreamBuf outStream;
 
+  if (prefixSize > srcLen)
+    prefixSize = srcLen;
+  if (prefixSize >= ((UInt32)1 << 31))
+    return SZ_ERROR_PARAM;
+
   outStream.vt.Write = SeqOutStreamBuf_Write;
   outStream.data = dest;
   outStream.rem = *destLen;
@@ -3099,8 +3182,52 @@ SRes LzmaEnc_MemEncode(CLzmaEncHandle p, Byte *dest, SizeT *destLen, const Byte
   p->writeEndMark = writeEndMark;
   p->rc.outStream = &outStream.vt;
 
-  res = LzmaEnc_MemPrepare(p, src, srcLen, 0, alloc, allocBig);
+  MatchFinder_SET_DIRECT_INPUT_BUF(&MFB, src, srcLen)
+  /* the size of hash table must not depend from (srcLen) for saved state of prefix */
+  LzmaEnc_SetDataSize(p, prefixSize != 0 ? (UInt64)(Int64)-1 : srcLen);
+  res = LzmaEnc_AllocAndInit(p, 0, alloc, allocBig);
   
+  if (res == SZ_OK && prefixSize != 0)
+  {
+    /* we insert the prefix to match finder without encoding.
+       (nowPos64 != 0) disables the encoding of first byte as literal without context */
+    UInt32 numSkip = (UInt32)prefixSize;
+    #ifndef Z7_ST
+    if (p->mtMode)
+    {
+      res = MatchFinderMt_InitMt(&p->matchFinderMt);
+      if (res == SZ_OK)
+        p->matchFinder.Init(p->matchFinderObj);
+    }
+    else
+    #endif
+    /* the last (keepSizeAfter) bytes of prefix are inserted in each call,
+       because the records for these positions depend from the data after prefix */
+    if (numSkip > MFB.keepSizeAfter && numSkip < MFB.cyclicBufferSize - 1)
+    {
+      const UInt32 numSaved = numSkip - MFB.keepSizeAfter;
+      if (!reusePrefix
+          || p->prefixSaved != numSaved
+          || p->prefixHashMask != MFB.hashMask)
+        res = LzmaEnc_SavePrefix(p, src, numSkip, numSaved, allocBig);
+      if (res == SZ_OK)
+      {
+        MatchFinder_SET_DIRECT_INPUT_BUF(&MFB, src, srcLen)
+        MatchFinder_RestorePrefix(&MFB, p->prefixRefs, numSaved);
+        numSkip -= numSaved;
+      }
+    }
+    else
+      p->matchFinder.Init(p->matchFinderObj);
+    
+    if (res == SZ_OK)
+    {
+      p->needInit = 0;
+      p->matchFinder.Skip(p->matchFinderObj, numSkip);
+      p->nowPos64 = prefixSize;
+    }
+  }
+
   if (res == SZ_OK)
   {
     res = LzmaEnc_Encode2(p, progress);
@@ -3115,6 +3242,14 @@ SRes LzmaEnc_MemEncode(CLzmaEncHandle p, Byte *dest, SizeT *destLen, const Byte
 }
 
 
+SRes LzmaEnc_MemEncode(CLzmaEncHandle p, Byte *dest, SizeT *destLen, const Byte *src, SizeT srcLen,
+    int writeEndMark, ICompressProgressPtr progress, ISzAllocPtr alloc, ISzAllocPtr allocBig)
+{
+  return LzmaEnc_MemEncode_Prefix(p, dest, destLen, src, srcLen, 0, False,
+      writeEndMark, progress, alloc, allocBig);
+}
+
+
 SRes LzmaEncode(Byte *dest, SizeT *destLen, const Byte *src, SizeT srcLen,
     const CLzmaEncProps *props, Byte *propsEncoded, SizeT *propsSize, int writeEndMark,
     ICompressProgressPtr progress, ISzAllocPtr alloc, ISzAllocPtr allocBig)
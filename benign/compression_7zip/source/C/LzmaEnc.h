@@ -42,6 +42,10 @@ void LzmaEncProps_Init(CLzmaEncProps *p);
 void LzmaEncProps_Normalize(CLzmaEncProps *p);
 UInt32 LzmaEncProps_GetDictSize(const CLzmaEncProps *props2);
 
+/* LzmaEncProps_GetMemUsage() returns the estimated size of memory
+   that is allocated by one encoder (window, match finder and encoder state) */
+UInt64 LzmaEncProps_GetMemUsage(const CLzmaEncProps *props2);
+
 
 /* ---------- CLzmaEncHandle Interface ---------- */
 
@@ -72,6 +76,27 @@ SRes LzmaEnc_Encode(CLzmaEncHandle p, ISeqOutStreamPtr outStream, ISeqInStreamPt
     ICompressProgressPtr progress, ISzAllocPtr alloc, ISzAllocPtr allocBig);
 SRes LzmaEnc_MemEncode(CLzmaEncHandle p, Byte *dest, SizeT *destLen, const Byte *src, SizeT srcLen,
     int writeEndMark, ICompressProgressPtr progress, ISzAllocPtr alloc, ISzAllocPtr allocBig);
+SRes LzmaEnc_EncodeFromBuf(CLzmaEncHandle p, ISeqOutStreamPtr outStream, const Byte *src, SizeT srcLen,
+    ICompressProgressPtr progress, ISzAllocPtr alloc, ISzAllocPtr allocBig);
+
+/*
+LzmaEnc_MemEncode_Prefix() encodes the data (src + prefixSize ... src + srcLen).
+  The first (prefixSize) bytes of (src) are used as preset dictionary:
+  the encoder can use the matches to these bytes, but it doesn't write them to stream.
+  The decoder must have same (prefixSize) bytes in dictionary before
+  the decoded data, and it must start the decoding with (processedPos = prefixSize).
+  (prefixSize == 0) is same as LzmaEnc_MemEncode().
+  The encoder saves the state of match finder after prefix insertion.
+  reusePrefix:
+    False : the encoder inserts the prefix to match finder and saves new state.
+    True  : the prefix data is same as in previous call for that encoder (p).
+            So the encoder restores the saved state instead of prefix insertion.
+  The size of hash table for data with prefix doesn't depend from (srcLen).
+  So it's recommended to reduce dictSize in props (reduceSize) for small data.
+*/
+SRes LzmaEnc_MemEncode_Prefix(CLzmaEncHandle p, Byte *dest, SizeT *destLen, const Byte *src, SizeT srcLen,
+    SizeT prefixSize, BoolInt reusePrefix,
+    int writeEndMark, ICompressProgressPtr progress, ISzAllocPtr alloc, ISzAllocPtr allocBig);
 
 
 /* ---------- One Call Interface ---------- */
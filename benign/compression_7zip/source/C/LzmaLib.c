@@ -3,11 +3,17 @@
 
 #include "Precomp.h"
 
+#include <string.h>
+
 #include "Alloc.h"
 #include "LzmaDec.h"
 #include "LzmaEnc.h"
 #include "LzmaLib.h"
 
+#ifndef Z7_ST
+#include "ThreadPool.h"
+#endif
+
 Z7_STDAPI LzmaCompress(unsigned char *dest, size_t *destLen, const unsigned char *src, size_t srcLen,
   unsigned char *outProps, size_t *outPropsSize,
   int level, /* 0 <= level <= 9, default = 5 */
@@ -40,3 +46,351 @@ Z7_STDAPI LzmaUncompress(unsigned char *dest, size_t *destLen, const unsigned ch
   ELzmaStatus status;
   return LzmaDecode(dest, destLen, src, srcLen, props, (unsigned)propsSize, LZMA_FINISH_ANY, &status, &g_Alloc);
 }
+
+
+/* ---------- LzmaBatch ---------- */
+
+#define LZMA_BATCH_THREADS_MAX 64
+
+/* InterlockedIncrement() works with LONG. So we split big arrays to parts */
+#define LZMA_BATCH_PART_MAX ((size_t)1 << 30)
+
+typedef struct
+{
+  CLzmaBatch *batch;
+  CLzmaEncHandle enc;
+  CLzmaDec dec;
+  Byte *buf;       /* preset dictionary followed by the data of current item */
+  size_t bufSize;
+  #ifndef Z7_ST
+  CPoolThread thread;
+  #endif
+} CLzmaBatchCtx;
+
+struct CLzmaBatch
+{
+  CLzmaEncProps props;
+  Byte *dict;
+  size_t dictSize;
+  unsigned numThreads;
+
+  CLzmaBatchItem *items;
+  size_t numItems;
+  BoolInt decodeMode;
+  const Byte *decProps;
+  unsigned decPropsSize;
+  #ifndef Z7_ST
+  LONG volatile nextItem;
+  #else
+  size_t nextItem;
+  #endif
+
+  CLzmaBatchCtx ctxs[LZMA_BATCH_THREADS_MAX];
+};
+
+
+static BoolInt LzmaBatchCtx_ReserveBuf(CLzmaBatchCtx *c, size_t size)
+{
+  const CLzmaBatch *p = c->batch;
+  if (c->buf && c->bufSize >= size)
+    return True;
+  ISzAlloc_Free(&g_Alloc, c->buf);
+  c->bufSize = 0;
+  /* we reserve additional space for next items that can be larger */
+  if (size < ((size_t)1 << (sizeof(size_t) * 8 - 2)))
+    size += size >> 2;
+  c->buf = (Byte *)ISzAlloc_Alloc(&g_Alloc, size);
+  if (!c->buf)
+    return False;
+  c->bufSize = size;
+  if (p->dictSize != 0)
+    memcpy(c->buf, p->dict, p->dictSize);
+  return True;
+}
+
+
+static SRes LzmaBatchCtx_Encode(CLzmaBatchCtx *c, CLzmaBatchItem *item)
+{
+  const CLzmaBatch *p = c->batch;
+  const size_t dictSize = p->dictSize;
+  if (!c->enc)
+  {
+    SRes res;
+    c->enc = LzmaEnc_Create(&g_Alloc);
+    if (!c->enc)
+      return SZ_ERROR_MEM;
+    res = LzmaEnc_SetProps(c->enc, &p->props);
+    if (res != SZ_OK)
+    {
+      LzmaEnc_Destroy(c->enc, &g_Alloc, &g_Alloc);
+      c->enc = NULL;
+      return res;
+    }
+  }
+  if (dictSize == 0)
+    return LzmaEnc_MemEncode(c->enc, item->dest, &item->destLen, item->src, item->srcLen,
+        0, NULL, &g_Alloc, &g_Alloc);
+  if (item->srcLen > (size_t)0 - 1 - dictSize
+      || !LzmaBatchCtx_ReserveBuf(c, dictSize + item->srcLen))
+    return SZ_ERROR_MEM;
+  memcpy(c->buf + dictSize, item->src, item->srcLen);
+  /* all items use same preset dictionary. So the encoder can reuse the state for it */
+  return LzmaEnc_MemEncode_Prefix(c->enc, item->dest, &item->destLen, c->buf, dictSize + item->srcLen,
+      dictSize, True, 0, NULL, &g_Alloc, &g_Alloc);
+}
+
+
+static SRes LzmaBatchCtx_Decode(CLzmaBatchCtx *c, CLzmaBatchItem *item)
+{
+  const CLzmaBatch *p = c->batch;
+  const size_t dictSize = p->dictSize;
+  CLzmaDec *dec = &c->dec;
+  ELzmaStatus status;
+  SRes res;
+  const SizeT outSize = item->destLen;
+  SizeT inSize = item->srcLen;
+  item->destLen = 0;
+  item->srcLen = 0;
+  RINOK(LzmaDec_AllocateProbs(dec, p->decProps, p->decPropsSize, &g_Alloc))
+  if (dictSize == 0)
+  {
+    dec->dic = item->dest;
+    dec->dicBufSize = outSize;
+    LzmaDec_Init(dec);
+  }
+  else
+  {
+    /* the decoder continues the data of preset dictionary in (buf) */
+    if (outSize > (size_t)0 - 1 - dictSize
+        || !LzmaBatchCtx_ReserveBuf(c, dictSize + outSize))
+      return SZ_ERROR_MEM;
+    dec->dic = c->buf;
+    dec->dicBufSize = dictSize + outSize;
+    LzmaDec_Init(dec);
+    dec->dicPos = dictSize;
+    dec->processedPos = (UInt32)dictSize;
+  }
+  res = LzmaDec_DecodeToDic(dec, dec->dicBufSize, item->src, &inSize, LZMA_FINISH_ANY, &status);
+  item->srcLen = inSize;
+  item->destLen = dec->dicPos - dictSize;
+  if (dictSize != 0)
+    memcpy(item->dest, c->buf + dictSize, item->destLen);
+  if (res == SZ_OK && status == LZMA_STATUS_NEEDS_MORE_INPUT)
+    res = SZ_ERROR_INPUT_EOF;
+  return res;
+}
+
+
+static void LzmaBatchCtx_Process(CLzmaBatchCtx *c)
+{
+  CLzmaBatch *p = c->batch;
+  for (;;)
+  {
+    CLzmaBatchItem *item;
+    size_t i;
+    #ifndef Z7_ST
+    i = (size_t)(UInt32)InterlockedIncrement(&p->nextItem) - 1;
+    #else
+    i = p->nextItem++;
+    #endif
+    if (i >= p->numItems)
+      return;
+    item = &p->items[i];
+    item->res = p->decodeMode ?
+        LzmaBatchCtx_Decode(c, item) :
+        LzmaBatchCtx_Encode(c, item);
+  }
+}
+
+
+#ifndef Z7_ST
+static THREAD_FUNC_DECL LzmaBatch_ThreadFunc(void *pp)
+{
+  LzmaBatchCtx_Process((CLzmaBatchCtx *)pp);
+  return THREAD_FUNC_RET_ZERO;
+}
+#endif
+
+
+static SRes LzmaBatch_Code(CLzmaBatch *p, CLzmaBatchItem *items, size_t numItems)
+{
+  SRes res = SZ_OK;
+  size_t i;
+
+  for (i = 0; i < numItems;)
+  {
+    size_t cur = numItems - i;
+    if (cur > LZMA_BATCH_PART_MAX)
+      cur = LZMA_BATCH_PART_MAX;
+    p->items = items + i;
+    p->numItems = cur;
+    p->nextItem = 0;
+    {
+    #ifndef Z7_ST
+      unsigned numThreads = p->numThreads;
+      unsigned numReserved;
+      unsigned t;
+      if (numThreads > cur)
+        numThreads = (unsigned)cur;
+      numReserved = ThreadPool_Reserve(numThreads);
+      numThreads = numReserved;
+      /* the context (0) works in caller thread */
+      for (t = 1; t < numThreads; t++)
+      {
+        CLzmaBatchCtx *c = &p->ctxs[t];
+        PoolThread_CONSTRUCT(&c->thread)
+        if (PoolThread_Create(&c->thread, LzmaBatch_ThreadFunc, c) != 0)
+          break; // the items will be processed by another threads
+      }
+      numThreads = t;
+    #endif
+
+      LzmaBatchCtx_Process(&p->ctxs[0]);
+    
+    #ifndef Z7_ST
+      for (t = 1; t < numThreads; t++)
+        if (PoolThread_Wait_Close(&p->ctxs[t].thread) != 0)
+          res = SZ_ERROR_THREAD;
+      ThreadPool_Release(numReserved);
+    #endif
+    }
+    i += cur;
+  }
+  
+  if (res != SZ_OK)
+    return res;
+  for (i = 0; i < numItems; i++)
+    if (items[i].res != SZ_OK)
+      return items[i].res;
+  return SZ_OK;
+}
+
+
+Z7_STDAPI LzmaBatch_Create(CLzmaBatchHandle *pp,
+  unsigned char *outProps, size_t *outPropsSize,
+  int level, unsigned dictSize, int lc, int lp, int pb, int fb,
+  size_t maxItemSize,
+  const unsigned char *presetDict, size_t presetDictSize,
+  int numThreads)
+{
+  CLzmaBatch *p;
+  unsigned i;
+  SRes res;
+  *pp = NULL;
+  if (numThreads < 0)
+    numThreads = 1;
+  if (numThreads == 0 || numThreads > LZMA_BATCH_THREADS_MAX)
+    return SZ_ERROR_PARAM;
+  /* the decoder's (processedPos) is 32-bit */
+  if (presetDictSize >= ((UInt32)1 << 31))
+    return SZ_ERROR_PARAM;
+  
+  p = (CLzmaBatch *)ISzAlloc_Alloc(&g_Alloc, sizeof(CLzmaBatch));
+  if (!p)
+    return SZ_ERROR_MEM;
+  
+  LzmaEncProps_Init(&p->props);
+  p->props.level = level;
+  p->props.dictSize = dictSize;
+  p->props.lc = lc;
+  p->props.lp = lp;
+  p->props.pb = pb;
+  p->props.fb = fb;
+  /* each item is compressed in one thread */
+  p->props.numThreads = 1;
+  if (maxItemSize != 0)
+    p->props.reduceSize = (UInt64)presetDictSize + maxItemSize;
+  LzmaEncProps_Normalize(&p->props);
+  
+  #ifdef Z7_ST
+  numThreads = 1;
+  #endif
+  p->numThreads = (unsigned)numThreads;
+  p->dict = NULL;
+  p->dictSize = 0;
+  for (i = 0; i < LZMA_BATCH_THREADS_MAX; i++)
+  {
+    CLzmaBatchCtx *c = &p->ctxs[i];
+    c->batch = p;
+    c->enc = NULL;
+    LzmaDec_CONSTRUCT(&c->dec)
+    c->buf = NULL;
+    c->bufSize = 0;
+  }
+  
+  res = SZ_OK;
+  if (presetDictSize != 0)
+  {
+    p->dict = (Byte *)ISzAlloc_Alloc(&g_Alloc, presetDictSize);
+    if (!p->dict)
+      res = SZ_ERROR_MEM;
+    else
+    {
+      memcpy(p->dict, presetDict, presetDictSize);
+      p->dictSize = presetDictSize;
+    }
+  }
+  
+  if (res == SZ_OK)
+  {
+    /* we write the properties of the encoder that will be used for items */
+    CLzmaEncHandle enc = LzmaEnc_Create(&g_Alloc);
+    if (!enc)
+      res = SZ_ERROR_MEM;
+    else
+    {
+      res = LzmaEnc_SetProps(enc, &p->props);
+      if (res == SZ_OK)
+        res = LzmaEnc_WriteProperties(enc, outProps, outPropsSize);
+      if (res == SZ_OK)
+        p->ctxs[0].enc = enc;
+      else
+        LzmaEnc_Destroy(enc, &g_Alloc, &g_Alloc);
+    }
+  }
+  
+  if (res != SZ_OK)
+  {
+    LzmaBatch_Destroy(p);
+    return res;
+  }
+  *pp = p;
+  return SZ_OK;
+}
+
+
+void Z7_STDCALL LzmaBatch_Destroy(CLzmaBatchHandle p)
+{
+  unsigned i;
+  if (!p)
+    return;
+  for (i = 0; i < LZMA_BATCH_THREADS_MAX; i++)
+  {
+    CLzmaBatchCtx *c = &p->ctxs[i];
+    if (c->enc)
+      LzmaEnc_Destroy(c->enc, &g_Alloc, &g_Alloc);
+    LzmaDec_FreeProbs(&c->dec, &g_Alloc);
+    ISzAlloc_Free(&g_Alloc, c->buf);
+  }
+  ISzAlloc_Free(&g_Alloc, p->dict);
+  ISzAlloc_Free(&g_Alloc, p);
+}
+
+
+Z7_STDAPI LzmaBatch_Compress(CLzmaBatchHandle p, CLzmaBatchItem *items, size_t numItems)
+{
+  p->decodeMode = False;
+  return LzmaBatch_Code(p, items, numItems);
+}
+
+
+Z7_STDAPI LzmaBatch_Uncompress(CLzmaBatchHandle p, CLzmaBatchItem *items, size_t numItems,
+  const unsigned char *props, size_t propsSize)
+{
+  if (propsSize != LZMA_PROPS_SIZE)
+    return SZ_ERROR_UNSUPPORTED;
+  p->decodeMode = True;
+  p->decProps = props;
+  p->decPropsSize = (unsigned)propsSize;
+  return LzmaBatch_Code(p, items, numItems);
+}
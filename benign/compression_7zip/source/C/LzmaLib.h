@@ -133,6 +133,84 @@ Returns:
 Z7_STDAPI LzmaUncompress(unsigned char *dest, size_t *destLen, const unsigned char *src, SizeT *srcLen,
   const unsigned char *props, size_t propsSize);
 
+
+/*
+LzmaBatch - interface for many small buffers
+--------------------------------------------
+
+LzmaCompress() and LzmaUncompress() allocate the encoder / decoder state
+and the match finder tables in each call. That allocation and initialization
+can take more time than the coding of small buffer (1-64 KB).
+CLzmaBatchHandle keeps the pool of coder contexts (one context per thread).
+Each context keeps the encoder, the decoder and the match finder tables,
+and reuses them for all buffers.
+LzmaBatch_Compress() and LzmaBatch_Uncompress() process the array of items
+in (numThreads) threads. Each item is coded as independent LZMA stream
+without end marker, as LzmaCompress() does.
+
+LzmaBatch_Create
+  outProps, outPropsSize, level, dictSize, lc, lp, pb, fb - same as in LzmaCompress().
+  maxItemSize - the expected maximum size of item. If (maxItemSize != 0),
+         the encoder reduces the dictionary size and the size of
+         match finder tables for (presetDictSize + maxItemSize) bytes.
+         Larger items also can be compressed, but with smaller dictionary.
+  presetDict, presetDictSize - optional preset dictionary (can be NULL / 0).
+         The data that is similar to preset dictionary can be compressed
+         with the matches to that dictionary. The library keeps the copy of
+         dictionary data. The decoder must use same preset dictionary.
+         The encoder inserts the dictionary to match finder for each item,
+         so big preset dictionary (larger than items) reduces the speed.
+  numThreads - the number of threads for items processing: 1 <= numThreads <= 64.
+         The default value (-1) is 1. Each item is coded in one thread.
+         If the process uses ThreadPool (ThreadPool.h), the threads are
+         taken from the pool and they are reserved from its limit.
+
+LzmaBatch_Compress / LzmaBatch_Uncompress
+  In:
+    items[i].src, srcLen  - input data
+    items[i].dest         - output data buffer
+    items[i].destLen      - output data buffer size
+  Out:
+    items[i].destLen      - processed output size
+    items[i].srcLen       - processed input size (LzmaBatch_Uncompress only)
+    items[i].res          - result code for item, same as in LzmaCompress() / LzmaUncompress()
+  LzmaBatch_Uncompress() uses the properties (props) that were written by
+  LzmaBatch_Create() on compression side, and the preset dictionary of batch (p).
+  Returns:
+    SZ_OK, if all items were processed without errors.
+    SZ_ERROR_THREAD for errors in multithreading functions.
+    Or the result code of first item with error.
+
+The caller must not call functions for same batch (p) from different threads simultaneously.
+*/
+
+typedef struct
+{
+  const unsigned char *src;
+  size_t srcLen;
+  unsigned char *dest;
+  size_t destLen;
+  int res;
+} CLzmaBatchItem;
+
+typedef struct CLzmaBatch CLzmaBatch;
+typedef CLzmaBatch * CLzmaBatchHandle;
+
+Z7_STDAPI LzmaBatch_Create(CLzmaBatchHandle *p,
+  unsigned char *outProps, size_t *outPropsSize, /* *outPropsSize must be = 5 */
+  int level, unsigned dictSize, int lc, int lp, int pb, int fb,
+  size_t maxItemSize, /* 0 = unknown */
+  const unsigned char *presetDict, size_t presetDictSize,
+  int numThreads /* 1 <= numThreads <= 64, default = 1 */
+  );
+
+void Z7_STDCALL LzmaBatch_Destroy(CLzmaBatchHandle p);
+
+Z7_STDAPI LzmaBatch_Compress(CLzmaBatchHandle p, CLzmaBatchItem *items, size_t numItems);
+
+Z7_STDAPI LzmaBatch_Uncompress(CLzmaBatchHandle p, CLzmaBatchItem *items, size_t numItems,
+  const unsigned char *props, size_t propsSize);
+
 EXTERN_C_END
 
 #endif
@@ -0,0 +1,201 @@
+/* MemBudget.c -- Process-wide memory budget for coders
+: Public domain */
+
+#include "Precomp.h"
+
+#include "MemBudget.h"
+#include "Threads.h"
+
+static CCriticalSection g_MemBudget_cs;
+static BoolInt g_MemBudget_Created;
+static CMemBudgetStat g_MemBudget;
+
+/* thread local mark: the memory for coders in current thread was reserved by outer level */
+#ifdef _WIN32
+static DWORD g_MemBudget_Tls = TLS_OUT_OF_INDEXES;
+#else
+static pthread_key_t g_MemBudget_Tls;
+#endif
+static Byte g_MemBudget_ThreadMark;
+
+
+WRes MemBudget_Create(UInt64 limit)
+{
+  if (!g_MemBudget_Created)
+  {
+   #ifdef _WIN32
+    g_MemBudget_Tls = TlsAlloc();
+    if (g_MemBudget_Tls == TLS_OUT_OF_INDEXES)
+      return GetLastError();
+   #else
+    RINOK_WRes(pthread_key_create(&g_MemBudget_Tls, NULL))
+   #endif
+    {
+      const WRes wres = CriticalSection_Init(&g_MemBudget_cs);
+      if (wres != 0)
+      {
+       #ifdef _WIN32
+        TlsFree(g_MemBudget_Tls);
+       #else
+        pthread_key_delete(g_MemBudget_Tls);
+       #endif
+        return wres;
+      }
+    }
+    g_MemBudget.Reserved = 0;
+    g_MemBudget.Peak = 0;
+    g_MemBudget.NumReduced = 0;
+    g_MemBudget_Created = True;
+  }
+  g_MemBudget.Limit = limit;
+  return 0;
+}
+
+
+void MemBudget_Free(void)
+{
+  if (!g_MemBudget_Created)
+    return;
+  g_MemBudget_Created = False;
+  CriticalSection_Delete(&g_MemBudget_cs);
+ #ifdef _WIN32
+  TlsFree(g_MemBudget_Tls);
+ #else
+  pthread_key_delete(g_MemBudget_Tls);
+ #endif
+}
+
+
+void MemBudget_SetLimit(UInt64 limit)
+{
+  if (!g_MemBudget_Created)
+    return;
+  CriticalSection_Enter(&g_MemBudget_cs);
+  g_MemBudget.Limit = limit;
+  CriticalSection_Leave(&g_MemBudget_cs);
+}
+
+
+static UInt64 MemBudget_GetAvail_Locked(void)
+{
+  if (g_MemBudget.Limit == 0)
+    return (UInt64)(Int64)-1;
+  if (g_MemBudget.Reserved >= g_MemBudget.Limit)
+    return 0;
+  return g_MemBudget.Limit - g_MemBudget.Reserved;
+}
+
+
+static unsigned MemBudget_Reserve2(UInt64 unitSize, unsigned numWanted, unsigned numMin)
+{
+  unsigned num = numWanted;
+  CriticalSection_Enter(&g_MemBudget_cs);
+  if (unitSize != 0)
+  {
+    const UInt64 numAvail = MemBudget_GetAvail_Locked() / unitSize;
+    if (num > numAvail)
+    {
+      num = (unsigned)numAvail;
+      if (num < numMin)
+        num = numMin;
+      g_MemBudget.NumReduced++;
+    }
+    g_MemBudget.Reserved += unitSize * num;
+    if (g_MemBudget.Peak < g_MemBudget.Reserved)
+      g_MemBudget.Peak = g_MemBudget.Reserved;
+  }
+  CriticalSection_Leave(&g_MemBudget_cs);
+  return num;
+}
+
+
+unsigned MemBudget_Reserve(UInt64 unitSize, unsigned numWanted)
+{
+  if (!g_MemBudget_Created || numWanted == 0)
+    return numWanted;
+  return MemBudget_Reserve2(unitSize, numWanted, 1);
+}
+
+
+unsigned MemBudget_Reserve_Optional(UInt64 unitSize, unsigned numWanted)
+{
+  if (!g_MemBudget_Created || numWanted == 0)
+    return numWanted;
+  return MemBudget_Reserve2(unitSize, numWanted, 0);
+}
+
+
+void MemBudget_SetThreadReserved(BoolInt reserved)
+{
+  if (!g_MemBudget_Created)
+    return;
+ #ifdef _WIN32
+  TlsSetValue(g_MemBudget_Tls, reserved ? &g_MemBudget_ThreadMark : NULL);
+ #else
+  pthread_setspecific(g_MemBudget_Tls, reserved ? &g_MemBudget_ThreadMark : NULL);
+ #endif
+}
+
+
+BoolInt MemBudget_IsThreadReserved(void)
+{
+  if (!g_MemBudget_Created)
+    return False;
+ #ifdef _WIN32
+  return TlsGetValue(g_MemBudget_Tls) != NULL;
+ #else
+  return pthread_getspecific(g_MemBudget_Tls) != NULL;
+ #endif
+}
+
+
+unsigned MemBudget_ReserveThreads(UInt64 unitSize, unsigned numWanted, unsigned *numReserved)
+{
+  *numReserved = 0;
+  if (!g_MemBudget_Created || numWanted == 0)
+    return numWanted;
+  if (!MemBudget_IsThreadReserved())
+  {
+    *numReserved = MemBudget_Reserve2(unitSize, numWanted, 1);
+    return *numReserved;
+  }
+  /* the first thread of coder uses the memory that was reserved by outer level.
+     So we reserve units only for additional threads, and they are optional. */
+  if (numWanted == 1)
+    return 1;
+  *numReserved = MemBudget_Reserve2(unitSize, numWanted - 1, 0);
+  return *numReserved + 1;
+}
+
+
+void MemBudget_Release(UInt64 unitSize, unsigned num)
+{
+  if (!g_MemBudget_Created || num == 0)
+    return;
+  CriticalSection_Enter(&g_MemBudget_cs);
+  g_MemBudget.Reserved -= unitSize * num;
+  CriticalSection_Leave(&g_MemBudget_cs);
+}
+
+
+UInt64 MemBudget_GetAvail(void)
+{
+  UInt64 avail;
+  if (!g_MemBudget_Created)
+    return (UInt64)(Int64)-1;
+  CriticalSection_Enter(&g_MemBudget_cs);
+  avail = MemBudget_GetAvail_Locked();
+  CriticalSection_Leave(&g_MemBudget_cs);
+  return avail;
+}
+
+
+BoolInt MemBudget_GetStat(CMemBudgetStat *stat)
+{
+  if (!g_MemBudget_Created)
+    return False;
+  CriticalSection_Enter(&g_MemBudget_cs);
+  *stat = g_MemBudget;
+  CriticalSection_Leave(&g_MemBudget_cs);
+  return True;
+}
@@ -0,0 +1,76 @@
+/* MemBudget.h -- Process-wide memory budget for coders
+: Public domain */
+
+#ifndef ZIP7_INC_MEM_BUDGET_H
+#define ZIP7_INC_MEM_BUDGET_H
+
+#include "7zTypes.h"
+
+EXTERN_C_BEGIN
+
+/*
+The memory budget bounds the total size of big buffers that are allocated
+by simultaneous multithreaded operations in the process
+(zip threads, MtCoder and MtDec threads of nested coders).
+
+The coder estimates the memory size required for one thread (unit),
+and it reserves units from budget before the allocation of buffers.
+If the budget is exhausted, the coder uses smaller number of threads.
+
+If the budget was not created with MemBudget_Create(),
+MemBudget_Reserve() returns (numWanted) and no statistics is collected.
+*/
+
+typedef struct
+{
+  UInt64 Limit;       /* (0) means no limit */
+  UInt64 Reserved;    /* current reserved size */
+  UInt64 Peak;        /* maximum reserved size */
+  UInt32 NumReduced;  /* number of reservations that got less units than wanted */
+} CMemBudgetStat;
+
+/*
+MemBudget_Create(limit)
+  creates the budget. (limit == 0) means no limit: only statistics is collected.
+  It must be called before any multithreaded operation in the process.
+MemBudget_Free()
+  The caller must call it, only if there are no running multithreaded operations.
+*/
+WRes MemBudget_Create(UInt64 limit);
+void MemBudget_Free(void);
+void MemBudget_SetLimit(UInt64 limit);
+
+/* MemBudget_Reserve() reserves up to (numWanted) units of (unitSize) bytes.
+   It returns the number of reserved units.
+   At least one unit is reserved for (numWanted != 0), even if the limit was reached.
+   So the caller can make progress with one thread. */
+unsigned MemBudget_Reserve(UInt64 unitSize, unsigned numWanted);
+/* MemBudget_Reserve_Optional() can return 0, if the limit was reached */
+unsigned MemBudget_Reserve_Optional(UInt64 unitSize, unsigned numWanted);
+void MemBudget_Release(UInt64 unitSize, unsigned num);
+
+/*
+The memory is reserved only once for each nesting level of coders.
+If the outer level (for example, zip thread) has reserved the memory
+that includes the memory of coder that works in current thread,
+it calls MemBudget_SetThreadReserved(True) in that thread.
+
+MemBudget_ReserveThreads() is called by multithreaded coder (MtCoder, MtDec).
+  It returns the number of threads that the coder can use.
+  If current thread was marked with MemBudget_SetThreadReserved(True),
+  the first thread of coder uses the memory reserved by outer level,
+  and units are reserved only for additional threads.
+  (*numReserved) receives the number of reserved units for MemBudget_Release().
+*/
+void MemBudget_SetThreadReserved(BoolInt reserved);
+BoolInt MemBudget_IsThreadReserved(void);
+unsigned MemBudget_ReserveThreads(UInt64 unitSize, unsigned numWanted, unsigned *numReserved);
+
+/* it returns (UInt64)(Int64)-1, if there is no limit */
+UInt64 MemBudget_GetAvail(void);
+/* it returns False, if the budget was not created */
+BoolInt MemBudget_GetStat(CMemBudgetStat *stat);
+
+EXTERN_C_END
+
+#endif
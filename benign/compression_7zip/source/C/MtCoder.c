@@ -50,16 +50,16 @@ static SRes MtCoderThread_CreateAndStart(CMtCoderThread *t
   if (wres == 0)
   {
     t->stop = False;
-    if (!Thread_WasCreated(&t->thread))
+    if (!PoolThread_WasCreated(&t->thread))
     {
 #ifdef _WIN32
       if (mtc->numThreadGroups)
-        wres = Thread_Create_With_Group(&t->thread, ThreadFunc, t,
+        wres = Thread_Create_With_Group(&t->thread.thread, ThreadFunc, t,
             ThreadNextGroup_GetNext(&mtc->nextGroup), // group
             0); // affinityMask
       else
 #endif
-        wres = Thread_Create(&t->thread, ThreadFunc, t);
+        wres = PoolThread_Create(&t->thread, ThreadFunc, t);
     }
     if (wres == 0)
       wres = Event_Set(&t->startEvent);
@@ -73,11 +73,11 @@ static SRes MtCoderThread_CreateAndStart(CMtCoderThread *t
 Z7_FORCE_INLINE
 static void MtCoderThread_Destruct(CMtCoderThread *t)
 {
-  if (Thread_WasCreated(&t->thread))
+  if (PoolThread_WasCreated(&t->thread))
   {
     t->stop = 1;
     Event_Set(&t->startEvent);
-    Thread_Wait_Close(&t->thread);
+    PoolThread_Wait_Close(&t->thread);
   }
 
   Event_Close(&t->startEvent);
@@ -367,6 +367,7 @@ void MtCoder_Construct(CMtCoder *p)
   p->numThreadsMax = 0;
   p->numThreadGroups = 0;
   p->expectedDataSize = (UInt64)(Int64)-1;
+  p->memUsagePerThread = 0;
 
   p->inStream = NULL;
   p->inData = NULL;
@@ -379,6 +380,8 @@ void MtCoder_Construct(CMtCoder *p)
   p->mtCallbackObject = NULL;
 
   p->allocatedBufsSize = 0;
+  p->memBudgetUnit = 0;
+  p->memBudgetNum = 0;
 
   Event_Construct(&p->readEvent);
   Semaphore_Construct(&p->blocksSemaphore);
@@ -391,7 +394,7 @@ void MtCoder_Construct(CMtCoder *p)
     t->inBuf = NULL;
     t->stop = False;
     Event_Construct(&t->startEvent);
-    Thread_CONSTRUCT(&t->thread)
+    PoolThread_CONSTRUCT(&t->thread)
   }
 
   #ifdef MTCODER_USE_WRITE_THREAD
@@ -421,6 +424,9 @@ static void MtCoder_Free(CMtCoder *p)
   for (i = 0; i < MTCODER_THREADS_MAX; i++)
     MtCoderThread_Destruct(&p->threads[i]);
 
+  MemBudget_Release(p->memBudgetUnit, p->memBudgetNum);
+  p->memBudgetNum = 0;
+
   Event_Close(&p->readEvent);
   Semaphore_Close(&p->blocksSemaphore);
 
@@ -442,17 +448,14 @@ void MtCoder_Destruct(CMtCoder *p)
 }
 
 
-SRes MtCoder_Code(CMtCoder *p)
+static SRes MtCoder_Code2(CMtCoder *p, unsigned numThreads)
 {
-  unsigned numThreads = p->numThreadsMax;
   unsigned numBlocksMax;
   unsigned i;
   SRes res = SZ_OK;
 
   // printf("\n====== MtCoder_Code : \n");
 
-  if (numThreads > MTCODER_THREADS_MAX)
-      numThreads = MTCODER_THREADS_MAX;
   numBlocksMax = MTCODER_GET_NUM_BLOCKS_FROM_THREADS(numThreads);
   
   if (p->blockSize < ((UInt32)1 << 26)) numBlocksMax++;
@@ -599,6 +602,31 @@ SRes MtCoder_Code(CMtCoder *p)
   return res;
 }
 
+
+SRes MtCoder_Code(CMtCoder *p)
+{
+  unsigned numThreads = p->numThreadsMax;
+  unsigned numMemThreads;
+  UInt64 memUnit = p->memUsagePerThread;
+  SRes res;
+  if (numThreads > MTCODER_THREADS_MAX)
+      numThreads = MTCODER_THREADS_MAX;
+  if (memUnit == 0)
+    memUnit = (UInt64)p->blockSize * 2;
+  // the global limit of thread pool can reduce the number of coder threads
+  numThreads = ThreadPool_Reserve(numThreads);
+  /* and the memory budget of process also can reduce it.
+     The buffers of threads are kept allocated after MtCoder_Code() for next calls,
+     so the reservation is released only in MtCoder_Free().
+     The buffers of previous call are reused or reallocated, so we replace old reservation. */
+  MemBudget_Release(p->memBudgetUnit, p->memBudgetNum);
+  p->memBudgetUnit = memUnit;
+  numMemThreads = MemBudget_ReserveThreads(memUnit, numThreads, &p->memBudgetNum);
+  res = MtCoder_Code2(p, numMemThreads);
+  ThreadPool_Release(numThreads);
+  return res;
+}
+
 #endif
 
 #undef RINOK_THREAD
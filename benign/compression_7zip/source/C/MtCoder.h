@@ -51,7 +51,7 @@ typedef struct
   Byte *inBuf;
 
   CAutoResetEvent startEvent;
-  CThread thread;
+  CPoolThread thread;
 } CMtCoderThread;
 
 
@@ -79,6 +79,7 @@ typedef struct CMtCoder_
   unsigned numThreadsMax;
   unsigned numThreadGroups;
   UInt64 expectedDataSize;
+  UInt64 memUsagePerThread; /* estimated memory for one thread, (0) : (blockSize * 2) */
 
   ISeqInStreamPtr inStream;
   const Byte *inData;
@@ -94,6 +95,8 @@ typedef struct CMtCoder_
   /* internal variables */
   
   size_t allocatedBufsSize;
+  UInt64 memBudgetUnit;    /* the reservation in memory budget is kept while the buffers are allocated */
+  unsigned memBudgetNum;
 
   CAutoResetEvent readEvent;
   CSemaphore blocksSemaphore;
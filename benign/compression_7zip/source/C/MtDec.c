@@ -116,9 +116,9 @@ static SRes MtDecThread_CreateAndStart(CMtDecThread *t)
   // wres = 17; // for test
   if (wres == 0)
   {
-    if (Thread_WasCreated(&t->thread))
+    if (PoolThread_WasCreated(&t->thread))
       return SZ_OK;
-    wres = Thread_Create(&t->thread, MtDec_ThreadFunc, t);
+    wres = PoolThread_Create(&t->thread, MtDec_ThreadFunc, t);
     if (wres == 0)
       return SZ_OK;
   }
@@ -145,11 +145,11 @@ void MtDecThread_FreeInBufs(CMtDecThread *t)
 
 static void MtDecThread_CloseThread(CMtDecThread *t)
 {
-  if (Thread_WasCreated(&t->thread))
+  if (PoolThread_WasCreated(&t->thread))
   {
     Event_Set(&t->canWrite); /* we can disable it. There are no threads waiting canWrite in normal cases */
     Event_Set(&t->canRead);
-    Thread_Wait_Close(&t->thread);
+    PoolThread_Wait_Close(&t->thread);
   }
 
   Event_Close(&t->canRead);
@@ -950,6 +950,7 @@ void MtDec_Construct(CMtDec *p)
   p->inBufSize = (size_t)1 << 18;
 
   p->numThreadsMax = 0;
+  p->memUsagePerThread = 0;
 
   p->inStream = NULL;
   
@@ -969,6 +970,8 @@ void MtDec_Construct(CMtDec *p)
   p->mtCallbackObject = NULL;
 
   p->allocatedBufsSize = 0;
+  p->memBudgetUnit = 0;
+  p->memBudgetNum = 0;
 
   for (i = 0; i < MTDEC_THREADS_MAX; i++)
   {
@@ -978,7 +981,7 @@ void MtDec_Construct(CMtDec *p)
     t->inBuf = NULL;
     Event_Construct(&t->canRead);
     Event_Construct(&t->canWrite);
-    Thread_CONSTRUCT(&t->thread)
+    PoolThread_CONSTRUCT(&t->thread)
   }
 
   // Event_Construct(&p->finishedEvent);
@@ -1003,6 +1006,9 @@ static void MtDec_Free(CMtDec *p)
     ISzAlloc_Free(p->alloc, p->crossBlock);
     p->crossBlock = NULL;
   }
+
+  MemBudget_Release(p->memBudgetUnit, p->memBudgetNum);
+  p->memBudgetNum = 0;
 }
 
 
@@ -1017,6 +1023,8 @@ void MtDec_Destruct(CMtDec *p)
 SRes MtDec_Code(CMtDec *p)
 {
   unsigned i;
+  unsigned numReserved;
+  UInt64 memUnit = p->memUsagePerThread;
 
   p->inProcessed = 0;
 
@@ -1046,7 +1054,16 @@ SRes MtDec_Code(CMtDec *p)
     unsigned numThreads = p->numThreadsMax;
     if (numThreads > MTDEC_THREADS_MAX)
       numThreads = MTDEC_THREADS_MAX;
-    p->numStartedThreads_Limit = numThreads;
+    // the global limit of thread pool can reduce the number of decoder threads
+    numReserved = ThreadPool_Reserve(numThreads);
+    /* and the memory budget of process also can reduce it.
+       The buffers of threads are kept allocated after MtDec_Code(),
+       so the reservation is released only in MtDec_Free(). */
+    if (memUnit == 0)
+      memUnit = (UInt64)p->inBufSize * 2;
+    MemBudget_Release(p->memBudgetUnit, p->memBudgetNum);
+    p->memBudgetUnit = memUnit;
+    p->numStartedThreads_Limit = MemBudget_ReserveThreads(memUnit, numReserved, &p->memBudgetNum);
     p->numStartedThreads = 0;
   }
 
@@ -1092,6 +1109,7 @@ SRes MtDec_Code(CMtDec *p)
     // wres = 17; // for test
     // wres = Event_Wait(&p->finishedEvent);
 
+    ThreadPool_Release(numReserved);
     sres = MY_SRes_HRESULT_FROM_WRes(wres);
 
     if (sres != 0)
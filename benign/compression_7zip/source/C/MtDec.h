@@ -7,6 +7,8 @@
 #include "7zTypes.h"
 
 #ifndef Z7_ST
+#include "MemBudget.h"
+#include "ThreadPool.h"
 #include "Threads.h"
 #endif
 
@@ -36,8 +38,6 @@ SRes MtProgress_ProgressAdd(CMtProgress *p, UInt64 inSize, UInt64 outSize);
 SRes MtProgress_GetError(CMtProgress *p);
 void MtProgress_SetError(CMtProgress *p, SRes res);
 
-struct CMtDec;
-
 typedef struct
 {
   struct CMtDec_ *mtDec;
@@ -47,7 +47,7 @@ typedef struct
   size_t inDataSize_Start; // size of input data in start block
   UInt64 inDataSize;       // total size of input data in all blocks
 
-  CThread thread;
+  CPoolThread thread;
   CAutoResetEvent canRead;
   CAutoResetEvent canWrite;
   void  *allocaPtr;
@@ -123,6 +123,7 @@ typedef struct CMtDec_
   
   size_t inBufSize;        /* size of input block */
   unsigned numThreadsMax;
+  UInt64 memUsagePerThread; /* estimated memory for one thread, (0) : (inBufSize * 2) */
   // size_t inBlockMax;
   unsigned numThreadsMax_2;
 
@@ -140,6 +141,8 @@ typedef struct CMtDec_
   /* internal variables */
   
   size_t allocatedBufsSize;
+  UInt64 memBudgetUnit;    /* the reservation in memory budget is kept while the buffers are allocated */
+  unsigned memBudgetNum;
 
   BoolInt exitThread;
   WRes exitThreadWRes;
@@ -0,0 +1,213 @@
+/* ThreadPool.c -- Process-wide pool of worker threads
+: Public domain */
+
+#include "Precomp.h"
+
+#include <stdlib.h>
+
+#include "ThreadPool.h"
+
+/* we don't keep more idle workers than that number.
+   Another finished workers are terminated. */
+#define THREAD_POOL_IDLE_MAX 256
+
+struct CPoolWorker_
+{
+  CPoolWorker *next;  /* in list of idle workers */
+  CThread thread;
+  CAutoResetEvent startEvent;
+  CAutoResetEvent finishedEvent;
+  THREAD_FUNC_TYPE func;
+  LPVOID param;
+  BoolInt exit;
+};
+
+static CCriticalSection g_ThreadPool_cs;
+static BoolInt g_ThreadPool_Created;
+static CPoolWorker *g_ThreadPool_Idle;
+static unsigned g_ThreadPool_NumIdle;
+static unsigned g_ThreadPool_Limit;
+static unsigned g_ThreadPool_NumReserved;
+
+
+static THREAD_FUNC_DECL PoolWorker_ThreadFunc(void *pp)
+{
+  CPoolWorker *w = (CPoolWorker *)pp;
+  for (;;)
+  {
+    if (Event_Wait(&w->startEvent) != 0)
+      return (THREAD_FUNC_RET_TYPE)SZ_ERROR_THREAD;
+    if (w->exit)
+      return THREAD_FUNC_RET_ZERO;
+    w->func(w->param);
+    Event_Set(&w->finishedEvent);
+  }
+}
+
+
+static void PoolWorker_Destroy(CPoolWorker *w)
+{
+  if (Thread_WasCreated(&w->thread))
+  {
+    w->exit = True;
+    Event_Set(&w->startEvent);
+    Thread_Wait_Close(&w->thread);
+  }
+  Event_Close(&w->startEvent);
+  Event_Close(&w->finishedEvent);
+  free(w);
+}
+
+
+static WRes PoolWorker_Create(CPoolWorker **wp)
+{
+  WRes wres;
+  CPoolWorker *w = (CPoolWorker *)malloc(sizeof(CPoolWorker));
+  *wp = NULL;
+  if (!w)
+    return SZ_ERROR_MEM;
+  w->next = NULL;
+  w->exit = False;
+  Thread_CONSTRUCT(&w->thread)
+  Event_Construct(&w->startEvent);
+  Event_Construct(&w->finishedEvent);
+  wres = AutoResetEvent_CreateNotSignaled(&w->startEvent);
+  if (wres == 0)
+    wres = AutoResetEvent_CreateNotSignaled(&w->finishedEvent);
+  if (wres == 0)
+    wres = Thread_Create(&w->thread, PoolWorker_ThreadFunc, w);
+  if (wres != 0)
+  {
+    PoolWorker_Destroy(w);
+    return wres;
+  }
+  *wp = w;
+  return 0;
+}
+
+
+WRes PoolThread_Create(CPoolThread *p, THREAD_FUNC_TYPE func, LPVOID param)
+{
+  CPoolWorker *w = NULL;
+  if (!g_ThreadPool_Created)
+    return Thread_Create(&p->thread, func, param);
+
+  CriticalSection_Enter(&g_ThreadPool_cs);
+  w = g_ThreadPool_Idle;
+  if (w)
+  {
+    g_ThreadPool_Idle = w->next;
+    g_ThreadPool_NumIdle--;
+  }
+  CriticalSection_Leave(&g_ThreadPool_cs);
+
+  if (!w)
+  {
+    const WRes wres = PoolWorker_Create(&w);
+    if (wres != 0)
+      return wres;
+  }
+  w->next = NULL;
+  w->func = func;
+  w->param = param;
+  p->worker = w;
+  return Event_Set(&w->startEvent);
+}
+
+
+WRes PoolThread_Wait_Close(CPoolThread *p)
+{
+  WRes wres;
+  CPoolWorker *w = p->worker;
+  if (!w)
+    return Thread_Wait_Close(&p->thread);
+  p->worker = NULL;
+  wres = Event_Wait(&w->finishedEvent);
+  if (wres == 0)
+  {
+    CriticalSection_Enter(&g_ThreadPool_cs);
+    if (g_ThreadPool_Created && g_ThreadPool_NumIdle < THREAD_POOL_IDLE_MAX)
+    {
+      w->next = g_ThreadPool_Idle;
+      g_ThreadPool_Idle = w;
+      g_ThreadPool_NumIdle++;
+      w = NULL;
+    }
+    CriticalSection_Leave(&g_ThreadPool_cs);
+  }
+  if (w)
+    PoolWorker_Destroy(w);
+  return wres;
+}
+
+
+WRes ThreadPool_Create(unsigned numThreadsLimit)
+{
+  if (!g_ThreadPool_Created)
+  {
+    RINOK_WRes(CriticalSection_Init(&g_ThreadPool_cs))
+    g_ThreadPool_Idle = NULL;
+    g_ThreadPool_NumIdle = 0;
+    g_ThreadPool_NumReserved = 0;
+    g_ThreadPool_Created = True;
+  }
+  g_ThreadPool_Limit = numThreadsLimit;
+  return 0;
+}
+
+
+void ThreadPool_Free(void)
+{
+  if (!g_ThreadPool_Created)
+    return;
+  while (g_ThreadPool_Idle)
+  {
+    CPoolWorker *w = g_ThreadPool_Idle;
+    g_ThreadPool_Idle = w->next;
+    PoolWorker_Destroy(w);
+  }
+  g_ThreadPool_NumIdle = 0;
+  g_ThreadPool_Created = False;
+  CriticalSection_Delete(&g_ThreadPool_cs);
+}
+
+
+void ThreadPool_SetLimit(unsigned numThreadsLimit)
+{
+  if (!g_ThreadPool_Created)
+    return;
+  CriticalSection_Enter(&g_ThreadPool_cs);
+  g_ThreadPool_Limit = numThreadsLimit;
+  CriticalSection_Leave(&g_ThreadPool_cs);
+}
+
+
+unsigned ThreadPool_Reserve(unsigned numWanted)
+{
+  unsigned num = numWanted;
+  if (!g_ThreadPool_Created || numWanted == 0)
+    return numWanted;
+  CriticalSection_Enter(&g_ThreadPool_cs);
+  if (g_ThreadPool_Limit != 0)
+  {
+    const unsigned rem = g_ThreadPool_NumReserved < g_ThreadPool_Limit ?
+        g_ThreadPool_Limit - g_ThreadPool_NumReserved : 0;
+    if (num > rem)
+      num = rem;
+    if (num == 0)
+      num = 1;
+  }
+  g_ThreadPool_NumReserved += num;
+  CriticalSection_Leave(&g_ThreadPool_cs);
+  return num;
+}
+
+
+void ThreadPool_Release(unsigned num)
+{
+  if (!g_ThreadPool_Created || num == 0)
+    return;
+  CriticalSection_Enter(&g_ThreadPool_cs);
+  g_ThreadPool_NumReserved -= num;
+  CriticalSection_Leave(&g_ThreadPool_cs);
+}
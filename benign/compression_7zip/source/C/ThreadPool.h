@@ -0,0 +1,66 @@
+/* ThreadPool.h -- Process-wide pool of worker threads
+: Public domain */
+
+#ifndef ZIP7_INC_THREAD_POOL_H
+#define ZIP7_INC_THREAD_POOL_H
+
+#include "Threads.h"
+
+EXTERN_C_BEGIN
+
+/*
+The pool keeps finished threads and reuses them for new thread functions.
+So the multithreaded components (MtCoder, MtDec, LzFindMt, CVirtThread)
+don't create and destroy OS threads for each stream or folder.
+
+Also the pool supports global limit for the number of running worker threads
+in the process. The block coders that can work with any number of threads
+(MtCoder, MtDec) reserve the threads from that limit.
+So simultaneous operations in same process (for example, several
+archives processed by the host of 7z.dll, or nested coders in zip threads)
+don't oversubscribe the CPU.
+
+If the pool was not created with ThreadPool_Create(),
+PoolThread_Create() creates new OS thread as Thread_Create() does,
+and ThreadPool_Reserve() returns (numWanted).
+*/
+
+typedef struct CPoolWorker_ CPoolWorker;
+
+typedef struct
+{
+  CPoolWorker *worker;  /* worker from pool */
+  CThread thread;       /* dedicated thread, if pool is not used */
+} CPoolThread;
+
+#define PoolThread_CONSTRUCT(p) { (p)->worker = NULL;  Thread_CONSTRUCT(&(p)->thread) }
+#define PoolThread_WasCreated(p) ((p)->worker != NULL || Thread_WasCreated(&(p)->thread))
+
+/* PoolThread_Create() runs (func) in idle worker of pool, or in new thread */
+WRes PoolThread_Create(CPoolThread *p, THREAD_FUNC_TYPE func, LPVOID param);
+/* PoolThread_Wait_Close() waits for the end of (func),
+   and then it returns the worker to pool */
+WRes PoolThread_Wait_Close(CPoolThread *p);
+
+/*
+ThreadPool_Create(numThreadsLimit)
+  creates the pool. (numThreadsLimit == 0) means no limit for running threads.
+  It must be called before any multithreaded operation in the process.
+ThreadPool_Free()
+  terminates all idle workers. The caller must call it,
+  only if there are no running multithreaded operations.
+*/
+WRes ThreadPool_Create(unsigned numThreadsLimit);
+void ThreadPool_Free(void);
+void ThreadPool_SetLimit(unsigned numThreadsLimit);
+
+/* ThreadPool_Reserve() reserves up to (numWanted) threads from global limit.
+   It returns the number of reserved threads.
+   At least one thread is reserved for (numWanted != 0), even if the limit was reached.
+   So the caller can make progress without waiting for another operations. */
+unsigned ThreadPool_Reserve(unsigned numWanted);
+void ThreadPool_Release(unsigned num);
+
+EXTERN_C_END
+
+#endif
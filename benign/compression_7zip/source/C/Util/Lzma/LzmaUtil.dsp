@@ -182,10 +182,26 @@ SOURCE=.\Precomp.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\MemBudget.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\ThreadPool.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Threads.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\MemBudget.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\ThreadPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Threads.h
 # End Source File
 # End Target
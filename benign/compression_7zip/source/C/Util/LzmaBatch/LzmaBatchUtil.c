@@ -0,0 +1,350 @@
+/* LzmaBatchUtil.c -- Benchmark for LzmaBatch interface of LZMA library
+: Public domain */
+
+#include "Precomp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include "../../7zWindows.h"
+#else
+#include <sys/time.h>
+#endif
+
+#include "../../CpuArch.h"
+
+#include "../../Alloc.h"
+#include "../../7zFile.h"
+#include "../../7zVersion.h"
+#include "../../LzmaLib.h"
+
+#ifndef Z7_ST
+#include "../../ThreadPool.h"
+#endif
+
+/*
+The program splits the input file to records of same size,
+and it compares the speed of LzmaCompress() / LzmaUncompress() calls for each record
+with the speed of LzmaBatch_Compress() / LzmaBatch_Uncompress() for all records.
+Also it checks that the decoded data is same as original data.
+*/
+
+static void Print(const char *s)
+{
+  fputs(s, stdout);
+}
+
+static void PrintHelp(void)
+{
+  Print(
+    "\n" "LZMA Batch benchmark " MY_VERSION_CPU " : " MY_COPYRIGHT_DATE
+    "\n"
+    "\n" "Usage:  lzmabatch [switches] inputFile"
+    "\n" "  -r{N}  : record size in bytes (default 4096)"
+    "\n" "  -l{N}  : compression level 0-9 (default 5)"
+    "\n" "  -t{N}  : number of threads for LzmaBatch (default 1)"
+    "\n" "  -p{N}  : number of passes (default 1)"
+    "\n" "  -D{file} : preset dictionary file"
+    "\n");
+}
+
+static int PrintError(const char *message)
+{
+  Print("\nError: ");
+  Print(message);
+  Print("\n");
+  return 1;
+}
+
+static int PrintErrorNumber(SRes val)
+{
+  printf("\n7-Zip error code: %d\n", (int)val);
+  return 1;
+}
+
+
+static UInt64 GetTimeUs(void)
+{
+  #ifdef _WIN32
+  LARGE_INTEGER freq, v;
+  if (QueryPerformanceFrequency(&freq) && freq.QuadPart != 0)
+  {
+    QueryPerformanceCounter(&v);
+    return (UInt64)v.QuadPart * 1000000 / (UInt64)freq.QuadPart;
+  }
+  return (UInt64)GetTickCount() * 1000;
+  #else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (UInt64)tv.tv_sec * 1000000 + (UInt64)tv.tv_usec;
+  #endif
+}
+
+
+static void PrintSpeed(const char *name, UInt64 size, UInt64 packSize, UInt64 timeUs)
+{
+  if (timeUs == 0)
+    timeUs = 1;
+  printf("%-22s: %10u -> %10u : %8.1f MB/s\n", name,
+      (unsigned)size, (unsigned)packSize, (double)size / (double)timeUs);
+}
+
+
+static WRes ReadFile2(const char *name, Byte **data, size_t *size)
+{
+  CSzFile file;
+  UInt64 len;
+  WRes wres;
+  *data = NULL;
+  *size = 0;
+  File_Construct(&file);
+  wres = InFile_Open(&file, name);
+  if (wres != 0)
+    return wres;
+  wres = File_GetLength(&file, &len);
+  if (wres == 0)
+  {
+    if (len > ((size_t)1 << 30))
+      wres = E_OUTOFMEMORY;
+    else
+    {
+      size_t len2 = (size_t)len;
+      *data = (Byte *)MyAlloc(len2 == 0 ? 1 : len2);
+      if (!*data)
+        wres = E_OUTOFMEMORY;
+      else
+      {
+        wres = File_Read(&file, *data, &len2);
+        *size = len2;
+      }
+    }
+  }
+  File_Close(&file);
+  return wres;
+}
+
+
+static int main2(int numArgs, const char *args[])
+{
+  const char *inName = NULL;
+  const char *dictName = NULL;
+  size_t recSize = 4096;
+  int level = 5;
+  int numThreads = 1;
+  unsigned numPasses = 1;
+  Byte *data = NULL;
+  size_t dataSize = 0;
+  Byte *dict = NULL;
+  size_t dictSize = 0;
+  int i;
+
+  for (i = 1; i < numArgs; i++)
+  {
+    const char *s = args[i];
+    if (s[0] == '-')
+    {
+      const char c = s[1];
+      const char *v = s + 2;
+      if (c == 'D')
+        dictName = v;
+      else
+      {
+        char *end;
+        const unsigned long n = strtoul(v, &end, 10);
+        if (end == v || *end != 0)
+          return PrintError("Incorrect switch");
+        switch (c)
+        {
+          case 'r': recSize = (size_t)n; break;
+          case 'l': level = (int)n; break;
+          case 't': numThreads = (int)n; break;
+          case 'p': numPasses = (unsigned)n; break;
+          default: return PrintError("Incorrect switch");
+        }
+      }
+    }
+    else if (!inName)
+      inName = s;
+    else
+      return PrintError("Incorrect command");
+  }
+  if (!inName)
+  {
+    PrintHelp();
+    return 0;
+  }
+  if (recSize == 0 || numPasses == 0)
+    return PrintError("Incorrect switch");
+  
+  if (ReadFile2(inName, &data, &dataSize) != 0)
+    return PrintError("Cannot read input file");
+  if (dictName && ReadFile2(dictName, &dict, &dictSize) != 0)
+  {
+    MyFree(data);
+    return PrintError("Cannot read dictionary file");
+  }
+
+  {
+    const size_t numRecs = (dataSize + recSize - 1) / recSize;
+    /* the size of output buffer for incompressible data */
+    const size_t packMax = recSize + recSize / 16 + 64;
+    CLzmaBatchItem *items = (CLzmaBatchItem *)MyAlloc(numRecs * sizeof(CLzmaBatchItem) + 1);
+    Byte *packBuf = (Byte *)MyAlloc(numRecs * packMax + 1);
+    Byte *unpackBuf = (Byte *)MyAlloc(dataSize + 1);
+    size_t *packSizes = (size_t *)MyAlloc(numRecs * sizeof(size_t) + 1);
+    unsigned char props[LZMA_PROPS_SIZE];
+    size_t propsSize = LZMA_PROPS_SIZE;
+    CLzmaBatchHandle batch = NULL;
+    SRes res = SZ_OK;
+
+    if (!items || !packBuf || !unpackBuf || !packSizes)
+      res = SZ_ERROR_MEM;
+    if (res == SZ_OK)
+      res = LzmaBatch_Create(&batch, props, &propsSize,
+          level, 0, -1, -1, -1, -1, recSize, dict, dictSize, numThreads);
+    
+    printf("Records: %u x %u bytes, preset dictionary: %u bytes, threads: %d\n\n",
+        (unsigned)numRecs, (unsigned)recSize, (unsigned)dictSize, numThreads);
+    
+    if (res == SZ_OK && dictSize == 0)
+    {
+      /* we use same dictionary size as in batch for single calls */
+      const unsigned dicSize = GetUi32(props + 1);
+      UInt64 packSize = 0;
+      unsigned pass;
+      const UInt64 startTime = GetTimeUs();
+      for (pass = 0; pass < numPasses && res == SZ_OK; pass++)
+      {
+        size_t k;
+        packSize = 0;
+        for (k = 0; k < numRecs && res == SZ_OK; k++)
+        {
+          unsigned char props2[LZMA_PROPS_SIZE];
+          size_t props2Size = LZMA_PROPS_SIZE;
+          size_t srcLen = dataSize - k * recSize;
+          size_t destLen = packMax;
+          if (srcLen > recSize)
+            srcLen = recSize;
+          res = LzmaCompress(packBuf + k * packMax, &destLen, data + k * recSize, srcLen,
+              props2, &props2Size, level, dicSize, -1, -1, -1, -1, 1);
+          packSizes[k] = destLen;
+          packSize += destLen;
+        }
+      }
+      if (res == SZ_OK)
+        PrintSpeed("LzmaCompress", (UInt64)dataSize * numPasses, packSize * numPasses,
+            GetTimeUs() - startTime);
+
+      if (res == SZ_OK)
+      {
+        const UInt64 startTime2 = GetTimeUs();
+        for (pass = 0; pass < numPasses && res == SZ_OK; pass++)
+        {
+          size_t k;
+          for (k = 0; k < numRecs && res == SZ_OK; k++)
+          {
+            size_t srcLen = packSizes[k];
+            size_t destLen = dataSize - k * recSize;
+            if (destLen > recSize)
+              destLen = recSize;
+            res = LzmaUncompress(unpackBuf + k * recSize, &destLen,
+                packBuf + k * packMax, &srcLen, props, propsSize);
+          }
+        }
+        if (res == SZ_OK)
+          PrintSpeed("LzmaUncompress", (UInt64)dataSize * numPasses, packSize * numPasses,
+              GetTimeUs() - startTime2);
+        if (res == SZ_OK && memcmp(data, unpackBuf, dataSize) != 0)
+          res = SZ_ERROR_DATA;
+      }
+    }
+
+    if (res == SZ_OK)
+    {
+      UInt64 packSize = 0;
+      unsigned pass;
+      const UInt64 startTime = GetTimeUs();
+      for (pass = 0; pass < numPasses && res == SZ_OK; pass++)
+      {
+        size_t k;
+        for (k = 0; k < numRecs; k++)
+        {
+          CLzmaBatchItem *item = &items[k];
+          item->src = data + k * recSize;
+          item->srcLen = dataSize - k * recSize;
+          if (item->srcLen > recSize)
+            item->srcLen = recSize;
+          item->dest = packBuf + k * packMax;
+          item->destLen = packMax;
+        }
+        res = LzmaBatch_Compress(batch, items, numRecs);
+      }
+      if (res == SZ_OK)
+      {
+        size_t k;
+        for (k = 0; k < numRecs; k++)
+        {
+          packSizes[k] = items[k].destLen;
+          packSize += packSizes[k];
+        }
+        PrintSpeed("LzmaBatch_Compress", (UInt64)dataSize * numPasses, packSize * numPasses,
+            GetTimeUs() - startTime);
+      }
+
+      if (res == SZ_OK)
+      {
+        const UInt64 startTime2 = GetTimeUs();
+        memset(unpackBuf, 0, dataSize);
+        for (pass = 0; pass < numPasses && res == SZ_OK; pass++)
+        {
+          size_t k;
+          for (k = 0; k < numRecs; k++)
+          {
+            CLzmaBatchItem *item = &items[k];
+            const size_t unpackSize = dataSize - k * recSize;
+            item->src = packBuf + k * packMax;
+            item->srcLen = packSizes[k];
+            item->dest = unpackBuf + k * recSize;
+            item->destLen = unpackSize > recSize ? recSize : unpackSize;
+          }
+          res = LzmaBatch_Uncompress(batch, items, numRecs, props, propsSize);
+        }
+        if (res == SZ_OK)
+          PrintSpeed("LzmaBatch_Uncompress", (UInt64)dataSize * numPasses, packSize * numPasses,
+              GetTimeUs() - startTime2);
+        if (res == SZ_OK && memcmp(data, unpackBuf, dataSize) != 0)
+          res = SZ_ERROR_DATA;
+      }
+    }
+
+    LzmaBatch_Destroy(batch);
+    MyFree(packSizes);
+    MyFree(unpackBuf);
+    MyFree(packBuf);
+    MyFree(items);
+    MyFree(dict);
+    MyFree(data);
+
+    if (res == SZ_ERROR_DATA)
+      return PrintError("Decoded data is not same as original data");
+    if (res != SZ_OK)
+      return PrintErrorNumber(res);
+  }
+  return 0;
+}
+
+
+int Z7_CDECL main(int numArgs, const char *args[])
+{
+  int res;
+  #ifndef Z7_ST
+  ThreadPool_Create(0);
+  #endif
+  res = main2(numArgs, args);
+  #ifndef Z7_ST
+  ThreadPool_Free();
+  #endif
+  return res;
+}
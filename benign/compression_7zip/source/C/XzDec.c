@@ -1451,6 +1451,7 @@ typedef struct
 {
   Byte *outBuf;
   size_t outBufSize;
+  unsigned outBuf_BudgetNum; // the number of (outBufSize) units reserved in memory budget
   size_t outPreSize;
   size_t inPreSize;
   size_t inPreHeaderSize;
@@ -1539,6 +1540,9 @@ struct CXzDecMt
   BoolInt mtc_WasConstructed;
   CMtDec mtc;
   CXzDecMtThread coders[MTDEC_THREADS_MAX];
+
+  size_t memUseMax;         // (props.memUseMax) that can be reduced by memory budget for current call
+  BoolInt outBuf0_WasReserved; // the buffer of first thread is included to reservation of outer level
   #endif
 };
 
@@ -1570,6 +1574,8 @@ CXzDecMtHandle XzDecMt_Create(ISzAllocPtr alloc, ISzAllocPtr allocMid)
 
   #ifndef Z7_ST
   p->mtc_WasConstructed = False;
+  p->memUseMax = 0;
+  p->outBuf0_WasReserved = False;
   {
     unsigned i;
     for (i = 0; i < MTDEC_THREADS_MAX; i++)
@@ -1578,6 +1584,7 @@ CXzDecMtHandle XzDecMt_Create(ISzAllocPtr alloc, ISzAllocPtr allocMid)
       coder->dec_created = False;
       coder->outBuf = NULL;
       coder->outBufSize = 0;
+      coder->outBuf_BudgetNum = 0;
     }
   }
   #endif
@@ -1597,8 +1604,10 @@ static void XzDecMt_FreeOutBufs(CXzDecMt *p)
     if (coder->outBuf)
     {
       ISzAlloc_Free(p->allocMid, coder->outBuf);
+      MemBudget_Release(coder->outBufSize, coder->outBuf_BudgetNum);
       coder->outBuf = NULL;
       coder->outBufSize = 0;
+      coder->outBuf_BudgetNum = 0;
     }
   }
   p->unpackBlockMaxSize = 0;
@@ -1767,7 +1776,7 @@ static void XzDecMt_Callback_Parse(void *obj, unsigned coderIndex, CMtDecCallbac
           && XzBlock_HasPackSize(block))
       {
         {
-          if (block->unpackSize * 2 * me->mtc.numStartedThreads > me->props.memUseMax)
+          if (block->unpackSize * 2 * me->mtc.numStartedThreads > me->memUseMax)
           {
             cc->state = MTDEC_PARSE_OVERFLOW;
             return; // SZ_OK;
@@ -1835,7 +1844,7 @@ static void XzDecMt_Callback_Parse(void *obj, unsigned coderIndex, CMtDecCallbac
             blockMax = coder->outPreSize;
           {
             UInt64 required = (UInt64)blockMax * (me->mtc.numStartedThreads + 1) * 2;
-            if (me->props.memUseMax < required)
+            if (me->memUseMax < required)
               cc->canCreateNewThread = False;
           }
         }
@@ -1885,17 +1894,36 @@ static SRes XzDecMt_Callback_PreCode(void *pp, unsigned coderIndex)
     if (dest)
     {
       ISzAlloc_Free(me->allocMid, dest);
+      MemBudget_Release(coder->outBufSize, coder->outBuf_BudgetNum);
       coder->outBuf = NULL;
       coder->outBufSize = 0;
+      coder->outBuf_BudgetNum = 0;
     }
     {
+      /* the unpack buffer is reserved in memory budget, when it's allocated.
+         The first thread always gets the reservation.
+         If another thread can't get reservation, we return SZ_ERROR_MEM,
+         and the decoder switches to single-thread mode for remaining data. */
+      unsigned budgetNum = 0;
       size_t outPreSize = coder->outPreSize;
+      if (coderIndex != 0)
+      {
+        budgetNum = MemBudget_Reserve_Optional(outPreSize, 1);
+        if (budgetNum == 0)
+          return SZ_ERROR_MEM;
+      }
+      else if (!me->outBuf0_WasReserved)
+        budgetNum = MemBudget_Reserve(outPreSize, 1);
       if (outPreSize == 0)
         outPreSize = 1;
       dest = (Byte *)ISzAlloc_Alloc(me->allocMid, outPreSize);
+      if (!dest)
+      {
+        MemBudget_Release(coder->outPreSize, budgetNum);
+        return SZ_ERROR_MEM;
+      }
+      coder->outBuf_BudgetNum = budgetNum;
     }
-    if (!dest)
-      return SZ_ERROR_MEM;
     coder->outBuf = dest;
     coder->outBufSize = coder->outPreSize;
 
@@ -2728,6 +2756,29 @@ SRes XzDecMt_Decode(CXzDecMtHandle p,
     vt.Write = XzDecMt_Callback_Write;
 
 
+    {
+      /* if the memory budget of process is limited, we reduce (memUseMax)
+         that limits unpack buffers of threads for this call. If block doesn't fit,
+         the decoder switches to single-thread mode for remaining data.
+         (memUseMax) is not reserved here: each unpack buffer
+         is reserved in XzDecMt_Callback_PreCode(), when it's allocated. */
+      UInt64 avail = MemBudget_GetAvail();
+      p->memUseMax = p->props.memUseMax;
+      if (avail != (UInt64)(Int64)-1)
+      {
+        // the buffers that were allocated in previous call are reserved already
+        unsigned i;
+        for (i = 0; i < MTDEC_THREADS_MAX; i++)
+        {
+          const CXzDecMtThread *coder = &p->coders[i];
+          avail += (UInt64)coder->outBufSize * coder->outBuf_BudgetNum;
+        }
+        if (p->memUseMax > avail)
+          p->memUseMax = (size_t)avail;
+      }
+      p->outBuf0_WasReserved = MemBudget_IsThreadReserved();
+    }
+
     res = MtDec_Code(&p->mtc);
 
 
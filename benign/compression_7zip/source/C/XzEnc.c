@@ -1242,6 +1242,8 @@ SRes XzEnc_Encode(CXzEncHandle p, ISeqOutStreamPtr outStream, ISeqInStreamPtr in
 
     p->mtCoder.numThreadsMax = (unsigned)props->numBlockThreads_Max;
     p->mtCoder.numThreadGroups = props->numThreadGroups;
+    p->mtCoder.memUsagePerThread = LzmaEncProps_GetMemUsage(&props->lzma2Props.lzmaProps)
+        + p->mtCoder.blockSize + p->outBufSize;
     p->mtCoder.expectedDataSize = p->expectedDataSize;
     
     RINOK(MtCoder_Code(&p->mtCoder))
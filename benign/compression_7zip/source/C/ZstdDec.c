@@ -1406,6 +1406,130 @@ static void ZstdDec1_Init(CZstdDec1 *p)
 
 
 
+/* ---------- Dictionary ---------- */
+
+#define k_ZstdDict_Signature  0xEC30A437
+
+struct CZstdDecDict
+{
+  UInt32 id;
+  Byte entropy_Defined;
+  Byte ll_accuracy;
+  Byte of_accuracy;
+  Byte ml_accuracy;
+  CZstdDecOffset reps[3];
+  const Byte *content;
+  size_t contentSize;
+  ISzAllocPtr alloc;
+  CZstdDecFseTables fse;
+  CZstdDecHufTable huf;
+  // the copy of dictionary data follows the structure
+};
+
+
+static SRes ZstdDecDict_Parse(CZstdDecDict * const p, const Byte * const data, const size_t size)
+{
+  CInBufPair in;
+  unsigned i;
+  // (size >= 8)
+  p->id = GetUi32(data + 4);
+  in.ptr = data + 8;
+  in.len = size - 8;
+  if (in.len == 0)
+    return SZ_ERROR_DATA;
+  RINOK(Huf_DecodeTable(&p->huf, &in))
+  /* the tables are stored in (OF, ML, LL) order, and
+     they use same format as FSE_Compressed_Mode tables in blocks */
+  if (in.len == 0)
+    return SZ_ERROR_DATA;
+  RINOK(FSE_Decode_SeqTable(p->fse.of, &in, 5, &p->of_accuracy,
+      NUM_OFFSET_SYMBOLS_MAX, k_PredefRecords_OF, k_SeqMode_FSE))
+  RINOK(FSE_Decode_SeqTable(p->fse.ml, &in, 6, &p->ml_accuracy,
+      NUM_ML_SYMBOLS, k_PredefRecords_ML, k_SeqMode_FSE))
+  RINOK(FSE_Decode_SeqTable(p->fse.ll, &in, 6, &p->ll_accuracy,
+      NUM_LL_SYMBOLS, k_PredefRecords_LL, k_SeqMode_FSE))
+  if (in.len < 3 * 4)
+    return SZ_ERROR_DATA;
+  p->content = in.ptr + 3 * 4;
+  p->contentSize = in.len - 3 * 4;
+  for (i = 0; i < 3; i++)
+  {
+    const UInt32 rep = GetUi32(in.ptr + i * 4);
+    if (rep == 0 || rep > p->contentSize)
+      return SZ_ERROR_DATA;
+    p->reps[i] = (CZstdDecOffset)rep;
+  }
+  p->entropy_Defined = True;
+  return SZ_OK;
+}
+
+
+SRes ZstdDecDict_Create(CZstdDecDictHandle *res, const void *data, size_t size, ISzAllocPtr alloc)
+{
+  CZstdDecDict *p;
+  Byte *buf;
+  *res = NULL;
+  if (size > ((size_t)1 << (MAX_WINDOW_SIZE_LOG - 1)))
+    return SZ_ERROR_UNSUPPORTED;
+  p = (CZstdDecDict *)ISzAlloc_Alloc(alloc, sizeof(CZstdDecDict) + size);
+  if (!p)
+    return SZ_ERROR_MEM;
+  p->alloc = alloc;
+  p->id = 0;
+  p->entropy_Defined = False;
+  buf = (Byte *)(void *)(p + 1);
+  if (size)
+    memcpy(buf, data, size);
+  // raw content dictionary, if there is no signature
+  p->content = buf;
+  p->contentSize = size;
+  if (size >= 8 && GetUi32(buf) == k_ZstdDict_Signature)
+  {
+    const SRes sres = ZstdDecDict_Parse(p, buf, size);
+    if (sres != SZ_OK)
+    {
+      ISzAlloc_Free(alloc, p);
+      return sres;
+    }
+  }
+  *res = p;
+  return SZ_OK;
+}
+
+void ZstdDecDict_Destroy(CZstdDecDictHandle p)
+{
+  if (p)
+    ISzAlloc_Free(p->alloc, p);
+}
+
+UInt32 ZstdDecDict_GetId(const CZstdDecDict *p)
+{
+  return p->id;
+}
+
+
+static void ZstdDec1_SetDict(CZstdDec1 * const p, const CZstdDecDict * const dict)
+{
+  p->totalOutCheck = dict->contentSize;
+  if (dict->entropy_Defined)
+  {
+    p->reps[0] = dict->reps[0];
+    p->reps[1] = dict->reps[1];
+    p->reps[2] = dict->reps[2];
+    p->ll_accuracy = dict->ll_accuracy;
+    p->of_accuracy = dict->of_accuracy;
+    p->ml_accuracy = dict->ml_accuracy;
+    // we copy only used parts of tables
+    memcpy(p->fse.ll, dict->fse.ll, sizeof(CFseRecord) << dict->ll_accuracy);
+    memcpy(p->fse.of, dict->fse.of, sizeof(CFseRecord) << dict->of_accuracy);
+    memcpy(p->fse.ml, dict->fse.ml, sizeof(CFseRecord) << dict->ml_accuracy);
+    memcpy(&p->huf, &dict->huf, sizeof(p->huf));
+    p->litHuf_wasSet = True;
+  }
+}
+
+
+
 #ifdef MY_CPU_LE_UNALIGN
   #define Z7_ZSTD_DEC_USE_UNALIGNED_COPY
 #endif
@@ -2769,6 +2893,12 @@ struct CZstdDec
   SizeT winBufSize_Allocated;
   Byte *win_Base;
 
+  const CZstdDecDict *dict;
+  /* (win_Dict) is dictionary whose content is stored in window
+     just before (win_DictPos) from previous frame */
+  const CZstdDecDict *win_Dict;
+  SizeT win_DictPos;
+
   ISzAllocPtr alloc_Small;
   ISzAllocPtr alloc_Big;
 
@@ -2787,6 +2917,7 @@ static void ZstdDec_FreeWindow(CZstdDec * const p)
   {
     ISzAlloc_Free(p->alloc_Big, p->win_Base);
     p->win_Base = NULL;
+    p->win_Dict = NULL;
     // p->decoder.win = NULL;
     p->winBufSize_Allocated = 0;
   }
@@ -2805,10 +2936,18 @@ CZstdDecHandle ZstdDec_Create(ISzAllocPtr alloc_Small, ISzAllocPtr alloc_Big)
   p->win_Base = NULL;
   p->winBufSize_Allocated = 0;
   p->disableHash = False;
+  p->dict = NULL;
+  p->win_Dict = NULL;
   ZstdDec1_Construct(&p->decoder);
   return p;
 }
 
+void ZstdDec_SetDict(CZstdDecHandle p, const CZstdDecDict *dict)
+{
+  p->dict = dict;
+  p->win_Dict = NULL;
+}
+
 void ZstdDec_Destroy(CZstdDecHandle p)
 {
   #ifdef SHOW_STAT
@@ -3676,6 +3815,7 @@ SRes ZstdDec_Decode(CZstdDecHandle dec, CZstdDecState *p)
           if (winPos >= delta)
             return SZ_ERROR_FAIL;
           memmove(dec->decoder.win, dec->decoder.win + delta, winPos);
+          dec->win_Dict = NULL;
           // printf("\nmemmove processed=%8x winPos=%8x\n", (unsigned)p->outProcessed, (unsigned)dec->decoder.winPos);
           STAT_INC(g_Num_Wrap_memmove_Num)
           STAT_UPDATE(g_Num_Wrap_memmove_Bytes += (unsigned)winPos;)
@@ -3792,9 +3932,23 @@ SRes ZstdDec_Decode(CZstdDecHandle dec, CZstdDecState *p)
     {
       BoolInt useCyclic = False;
       size_t cycSize;
+      const CZstdDecDict *dict = dec->dict;
+      size_t dictPos = 0; // the position of frame data after dictionary content in window
 
       // p->status = ZSTD_STATUS_NOT_FINISHED;
-      if (dec->dictionaryId != 0)
+      if (dict)
+      {
+        /* original-zstd also uses the dictionary for frames without dictionaryId.
+           We don't support dictionary in (outBuf_fromCaller) mode,
+           because we need dictionary content before output data in window. */
+        if ((dec->dictionaryId != 0 && dec->dictionaryId != dict->id)
+            || p->outBuf_fromCaller)
+          return SZ_ERROR_UNSUPPORTED;
+        // we align frame data start for xxh64 blocks
+        dictPos = (dict->contentSize + (Z7_XXH64_BLOCK_SIZE - 1))
+            & ~(size_t)(Z7_XXH64_BLOCK_SIZE - 1);
+      }
+      else if (dec->dictionaryId != 0)
       {
         /* actually we can try to decode some data,
            because it's possible that some data doesn't use dictionary */
@@ -3858,6 +4012,15 @@ SRes ZstdDec_Decode(CZstdDecHandle dec, CZstdDecState *p)
         */
         dec->decoder.winSize = (winSize < kBlockSizeMax) ? (size_t)winSize: cycSize;
         // note: (CZstdDec1::winSize > cycSize) is possible, if (!useCyclic)
+        if (dict)
+        {
+          /* match offsets can refer to the whole dictionary content.
+             So we keep dictionary content in window before frame data. */
+          dec->decoder.winSize += dict->contentSize;
+          cycSize += dictPos;
+          if (cycSize < dictPos)
+            return SZ_ERROR_MEM;
+        }
       }
 
       RINOK(ZstdDec_AllocateMisc(dec))
@@ -4001,6 +4164,26 @@ SRes ZstdDec_Decode(CZstdDecHandle dec, CZstdDecState *p)
         p->win = dec->decoder.win;
         // p->cycSize = dec->decoder.cycSize;
         dec->isCyclicMode = (Byte)useCyclic;
+
+        if (dict)
+        {
+          /* frame data after (dictPos) doesn't overwrite dictionary content.
+             So we don't copy same content again for next frames,
+             if the window was not reallocated or wrapped. */
+          if (dec->win_Dict != dict || dec->win_DictPos != dictPos)
+          {
+            memcpy(dec->decoder.win + dictPos - dict->contentSize,
+                dict->content, dict->contentSize);
+            dec->win_Dict = dict;
+            dec->win_DictPos = dictPos;
+          }
+          dec->decoder.winPos = dictPos;
+          p->wrPos = dictPos;
+          p->winPos = dictPos;
+          ZstdDec1_SetDict(&dec->decoder, dict);
+        }
+        else
+          dec->win_Dict = NULL;
       } // (!p->outBuf_fromCaller) end
       
       // p->winPos = dec->decoder.winPos;
@@ -33,6 +33,36 @@ typedef Byte enum_ZstdStatus;
 
 void ZstdDec_Init(CZstdDecHandle p);
 
+
+/* ---------- Dictionary ---------- */
+
+typedef struct CZstdDecDict CZstdDecDict;
+typedef CZstdDecDict * CZstdDecDictHandle;
+
+/*
+ZstdDecDict_Create() digests the dictionary:
+  it builds Huffman and FSE tables, if (data) is zstd dictionary (with signature 0xEC30A437).
+  Another (data) is used as raw content dictionary with (dictionaryId == 0).
+  The object keeps own copy of (data).
+  One digested dictionary can be used by any number of decoders at same time,
+  because the decoders don't change it.
+return:
+  SZ_OK, SZ_ERROR_MEM, SZ_ERROR_DATA, SZ_ERROR_UNSUPPORTED
+*/
+SRes ZstdDecDict_Create(CZstdDecDictHandle *res, const void *data, size_t size, ISzAllocPtr alloc);
+void ZstdDecDict_Destroy(CZstdDecDictHandle p);
+UInt32 ZstdDecDict_GetId(const CZstdDecDict *p);
+
+/*
+ZstdDec_SetDict() sets the dictionary for next frames.
+  (dict == NULL) removes the dictionary.
+  The caller must keep (dict) object until the end of decoding.
+  The decoder uses (dict) for frames with same dictionaryId or (dictionaryId == 0).
+  The frame with another non-zero dictionaryId returns SZ_ERROR_UNSUPPORTED.
+  (outBuf_fromCaller) mode is not supported with dictionary.
+*/
+void ZstdDec_SetDict(CZstdDecHandle p, const CZstdDecDict *dict);
+
 typedef struct
 {
   UInt64 num_Blocks;
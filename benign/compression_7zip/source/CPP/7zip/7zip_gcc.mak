@@ -478,6 +478,8 @@ $O/ProgressUtils.o: ../../Common/ProgressUtils.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/PropId.o: ../../Common/PropId.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/StageStats.o: ../../Common/StageStats.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/StreamBinder.o: ../../Common/StreamBinder.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/StreamObjects.o: ../../Common/StreamObjects.cpp
@@ -506,6 +508,8 @@ $O/Base64Handler.o: ../../Archive/Base64Handler.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/Bz2Handler.o: ../../Archive/Bz2Handler.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/CasHandler.o: ../../Archive/CasHandler.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/ComHandler.o: ../../Archive/ComHandler.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/CpioHandler.o: ../../Archive/CpioHandler.cpp
@@ -781,6 +785,8 @@ $O/LzOutWindow.o: ../../Compress/LzOutWindow.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/LzxDecoder.o: ../../Compress/LzxDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/LzxEncoder.o: ../../Compress/LzxEncoder.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/PpmdDecoder.o: ../../Compress/PpmdDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/PpmdEncoder.o: ../../Compress/PpmdEncoder.cpp
@@ -807,6 +813,8 @@ $O/ShrinkDecoder.o: ../../Compress/ShrinkDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/XpressDecoder.o: ../../Compress/XpressDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/XpressEncoder.o: ../../Compress/XpressEncoder.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/XzDecoder.o: ../../Compress/XzDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/XzEncoder.o: ../../Compress/XzEncoder.cpp
@@ -914,6 +922,8 @@ $O/SortUtils.o: ../../UI/Common/SortUtils.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/TempFiles.o: ../../UI/Common/TempFiles.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/TrainDict.o: ../../UI/Common/TrainDict.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/Update.o: ../../UI/Common/Update.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/UpdateAction.o: ../../UI/Common/UpdateAction.cpp
@@ -1197,6 +1207,12 @@ $O/LzFind.o: ../../../../C/LzFind.c
 $O/LzFindMt.o: ../../../../C/LzFindMt.c
 	$(CC) $(CFLAGS) $<
 
+$O/MemBudget.o: ../../../../C/MemBudget.c
+	$(CC) $(CFLAGS) $<
+
+$O/ThreadPool.o: ../../../../C/ThreadPool.c
+	$(CC) $(CFLAGS) $<
+
 $O/Threads.o: ../../../../C/Threads.c
 	$(CC) $(CFLAGS) $<
 # endif
@@ -126,6 +126,8 @@ public:
   UInt64 Pos;
 
   #ifdef USE_MIXER_MT
+  // if (ReadAt) is defined, the pack streams are read in parallel without CriticalSection
+  CMyComPtr<IInStreamReadAt> ReadAt;
   NWindows::NSynchronization::CCriticalSection CriticalSection;
   #endif
 };
@@ -151,6 +153,16 @@ public:
 
 Z7_COM7F_IMF(CLockedSequentialInStreamMT::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
+  if (_glob->ReadAt)
+  {
+    UInt32 realProcessedSize = 0;
+    const HRESULT res = _glob->ReadAt->ReadAt(_pos, data, size, &realProcessedSize);
+    _pos += realProcessedSize;
+    if (processedSize)
+      *processedSize = realProcessedSize;
+    return res;
+  }
+
   NWindows::NSynchronization::CCriticalSectionLock lock(_glob->CriticalSection);
 
   if (_pos != _glob->Pos)
@@ -351,6 +363,27 @@ HRESULT CDecoder::Decode(
 
   #if !defined(Z7_ST)
   bool mt_wasUsed = false;
+  UInt32 numThreads_Aes = numThreads;
+  UInt32 numThreads_Main = numThreads;
+  if (mtMode)
+  {
+    bool aesWasFound = false;
+    for (i = 0; i < folderInfo.Coders.Size(); i++)
+      if (folderInfo.Coders[i].MethodID == k_AES)
+        aesWasFound = true;
+    if (aesWasFound && folderInfo.Coders.Size() > 1)
+    {
+      /* AES decoder and main decoder work in different threads of CMixerMT.
+         So we split the number of threads between them, and AES decoder
+         gets smaller part, because AES decoding is much faster than decompression. */
+      numThreads_Aes = numThreads / 4;
+      if (numThreads_Aes == 0)
+        numThreads_Aes = 1;
+      numThreads_Main = numThreads - numThreads_Aes;
+      if (numThreads_Main == 0)
+        numThreads_Main = 1;
+    }
+  }
   #endif
 
   for (i = 0; i < folderInfo.Coders.Size(); i++)
@@ -374,7 +407,18 @@ HRESULT CDecoder::Decode(
     */
 
     #if !defined(Z7_ST)
-    if (!mt_wasUsed)
+    if (mtMode && coderInfo.MethodID == k_AES)
+    {
+      /* AES decoder splits only big buffers to threads, and its threads are idle
+         most of the time. So we don't count it as (mt_wasUsed) coder. */
+      Z7_DECL_CMyComPtr_QI_FROM(ICompressSetCoderMt,
+          setCoderMt, decoder)
+      if (setCoderMt)
+      {
+        RINOK(setCoderMt->SetNumberOfThreads(numThreads_Aes))
+      }
+    }
+    else if (!mt_wasUsed)
     {
       if (mtMode)
       {
@@ -383,7 +427,7 @@ HRESULT CDecoder::Decode(
         if (setCoderMt)
         {
           mt_wasUsed = true;
-          RINOK(setCoderMt->SetNumberOfThreads(numThreads))
+          RINOK(setCoderMt->SetNumberOfThreads(numThreads_Main))
         }
       }
       // if (memUsage != 0)
@@ -529,6 +573,11 @@ HRESULT CDecoder::Decode(
     if (!needMtLock && _mixer->IsThere_ExternalCoder_in_PackTree(_mixer->MainCoderIndex))
       needMtLock = true;
     #endif
+
+    #ifdef USE_MIXER_ST
+    if (needMtLock)
+    #endif
+      inStream->QueryInterface(IID_IInStreamReadAt, (void **)&lockedInStream->ReadAt);
     #endif
   }
 
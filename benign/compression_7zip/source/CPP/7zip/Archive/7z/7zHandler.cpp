@@ -436,7 +436,21 @@ HRESULT CHandler::SetMethodToProp(CNum folderIndex, PROPVARIANT *prop) const
     char s[32];
     s[0] = 0;
     
-    if (id64 <= (UInt32)0xFFFFFFFF)
+    if (id64 == k_PPMD_Block)
+    {
+      name = "PPMD";
+      if (propsSize == 9)
+      {
+        char *dest = s;
+        *dest++ = 'o';
+        dest = ConvertUInt32ToString(*props, dest);
+        dest = MyStpCpy(dest, ":mem");
+        dest = GetStringForSizeValue(dest, GetUi32(props + 1));
+        dest = MyStpCpy(dest, ":c");
+        GetStringForSizeValue(dest, GetUi32(props + 5));
+      }
+    }
+    else if (id64 <= (UInt32)0xFFFFFFFF)
     {
       const UInt32 id = (UInt32)id64;
       if (id == k_LZMA)
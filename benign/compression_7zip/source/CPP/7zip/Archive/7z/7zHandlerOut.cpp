@@ -136,6 +136,10 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
     CMethodFull &methodFull = methodMode.Methods.AddNew();
     RINOK(PropsMethod_To_FullMethod(methodFull, oneMethodInfo))
 
+    if (methodFull.Id == k_PPMD
+        && oneMethodInfo.GetProp_BlockSize(NCoderPropID::kBlockSize) != 0)
+      methodFull.Id = k_PPMD_Block;
+
 #ifndef Z7_ST
     methodFull.Set_NumThreads = true;
     methodFull.NumThreads = methodMode.NumThreads;
@@ -149,7 +153,8 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
     {
       case k_LZMA:
       case k_LZMA2: dicSize = oneMethodInfo.Get_Lzma_DicSize(); break;
-      case k_PPMD: dicSize = oneMethodInfo.Get_Ppmd_MemSize(); break;
+      case k_PPMD:
+      case k_PPMD_Block: dicSize = oneMethodInfo.Get_Ppmd_MemSize(); break;
       case k_Deflate: dicSize = (UInt32)1 << 15; break;
       case k_Deflate64: dicSize = (UInt32)1 << 16; break;
       case k_BZip2: dicSize = oneMethodInfo.Get_BZip2_BlockSize(); break;
@@ -275,6 +280,29 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
       numSolidBytes = (UInt64)dicSize << 7;
       if (numSolidBytes > kSolidBytes_Max)
           numSolidBytes = kSolidBytes_Max;
+
+      #ifndef Z7_ST
+      const UInt64 ppmdBlockSize = oneMethodInfo.GetProp_BlockSize(NCoderPropID::kBlockSize);
+      if (methodFull.Id == k_PPMD_Block
+          && !numThreads_WasSpecifiedInMethod
+          && !methodMode.NumThreads_WasForced)
+      {
+        /* block mode of PPMd encoder: each thread uses its own model and buffers for blocks.
+           (MemoryUsageLimit) is default limit for RAM size, if (-mmemuse) was not specified.
+           We use that limit even if RAM size is unknown, because model is big. */
+        const UInt32 numThreads_Original = methodMode.NumThreads;
+        UInt32 numThreads = numThreads_Original;
+        for (; numThreads > 1; numThreads--)
+        {
+          const UInt64 numBlocks = numThreads + (numThreads / 8) + 1;
+          const UInt64 size = numThreads * (dicSize + ppmdBlockSize) + numBlocks * ppmdBlockSize;
+          if (size <= methodMode.MemoryUsageLimit)
+            break;
+        }
+        if (numThreads != numThreads_Original)
+          CMultiMethodProps::SetMethodThreadsTo_Replace(methodFull, numThreads);
+      }
+      #endif
     }
 
     if (_numSolidBytesDefined)
@@ -109,6 +109,8 @@ const UInt32 k_SWAP4 = 0x20304;
 
 const UInt32 k_LZMA  = 0x30101;
 const UInt32 k_PPMD  = 0x30401;
+// block mode of PPMd encoder (private ID: random developer ID + method 0001)
+const UInt64 k_PPMD_Block = 0x3F3A256ED3C00001;
 
 const UInt32 k_Deflate   = 0x40108;
 const UInt32 k_Deflate64 = 0x40109;
@@ -414,6 +414,120 @@ static BoolInt Parse_WAV(const Byte *buf, size_t size, CFilterMode *filterMode)
 }
 
 
+/* ---------- Statistics of data ----------
+  If there is no known header, we estimate the data itself:
+    - relative CALL/JMP offsets in x86 code,
+    - order-0 entropy of byte differences for Delta filter.
+*/
+
+static const size_t kStatsMinSize = 1 << 12;
+
+static BoolInt Parse_X86_Code(const Byte *buf, size_t size, CFilterMode *filterMode)
+{
+  if (size < kStatsMinSize)
+    return False;
+  UInt32 numCalls = 0;
+  UInt32 numNear = 0;
+  for (size_t i = 0; i + 5 <= size; i++)
+  {
+    // E8 (CALL) and E9 (JMP) with rel32
+    if ((buf[i] & 0xFE) != 0xE8)
+      continue;
+    numCalls++;
+    // most of relative offsets in code are small: high byte is 0x00 or 0xFF
+    const Byte b = buf[i + 4];
+    if (b == 0 || b == 0xFF)
+    {
+      numNear++;
+      i += 4;
+    }
+  }
+  /* random data contains (size / 128) of E8/E9 bytes,
+     and only (1 / 128) of them have near offset. */
+  if (numNear < (size >> 9) || numNear * 2 < numCalls)
+    return False;
+  filterMode->Id = k_X86;
+  return True;
+}
+
+// it returns (log2(v) * 64) for (v != 0)
+static UInt32 GetLog2_x64(UInt32 v)
+{
+  unsigned n = 0;
+  while ((v >> n) >= 2)
+    n++;
+  // x is (v / 2^n) in 16-bit fixed point : [1 << 15, 1 << 16)
+  UInt32 x = (n <= 15) ? (v << (15 - n)) : (v >> (n - 15));
+  UInt32 r = n;
+  for (unsigned i = 0; i < 6; i++)
+  {
+    x = (x * x) >> 15;
+    r <<= 1;
+    if (x >= (1u << 16))
+    {
+      x >>= 1;
+      r++;
+    }
+  }
+  return r;
+}
+
+// it returns the size of data in (1/64 bit) units for order-0 model
+static UInt64 GetEntropy_x64(const UInt32 *counts, UInt32 total)
+{
+  UInt64 sum = (UInt64)total * GetLog2_x64(total);
+  for (unsigned i = 0; i < 256; i++)
+  {
+    const UInt32 c = counts[i];
+    if (c != 0)
+      sum -= (UInt64)c * GetLog2_x64(c);
+  }
+  return sum;
+}
+
+static BoolInt Parse_Delta_Stats(const Byte *buf, size_t size, CFilterMode *filterMode)
+{
+  if (size < kStatsMinSize)
+    return False;
+  UInt32 counts[256];
+  unsigned i;
+  size_t k;
+  for (i = 0; i < 256; i++)
+    counts[i] = 0;
+  for (k = 0; k < size; k++)
+    counts[buf[k]]++;
+  const UInt64 raw = GetEntropy_x64(counts, (UInt32)size);
+  /* Delta filter helps for raw multimedia data with high entropy (audio, images).
+     LZ coder works better without Delta for data with lower entropy. */
+  if (raw < (UInt64)size * (6 * 64))
+    return False;
+
+  static const Byte kStrides[] = { 1, 2, 3, 4, 6, 8 };
+  UInt64 best = raw;
+  unsigned bestStride = 0;
+  for (unsigned s = 0; s < Z7_ARRAY_SIZE(kStrides); s++)
+  {
+    const unsigned stride = kStrides[s];
+    for (i = 0; i < 256; i++)
+      counts[i] = 0;
+    for (k = stride; k < size; k++)
+      counts[(Byte)(buf[k] - buf[k - stride])]++;
+    const UInt64 cur = GetEntropy_x64(counts, (UInt32)(size - stride));
+    if (best > cur)
+    {
+      best = cur;
+      bestStride = stride;
+    }
+  }
+  // we require big gain, because Delta breaks LZ matches in some data
+  if (bestStride == 0 || best > raw / 8 * 7)
+    return False;
+  filterMode->Id = k_Delta;
+  filterMode->Delta = bestStride;
+  return True;
+}
+
+
 /*
   filterMode->Delta will be set as:
     = delta value : [1, 256] : for k_Delta
@@ -426,7 +540,9 @@ static BoolInt ParseFile(const Byte *buf, size_t size, CFilterMode *filterMode)
   if (Parse_EXE(buf, size, filterMode)) return True;
   if (Parse_ELF(buf, size, filterMode)) return True;
   if (Parse_MACH(buf, size, filterMode)) return True;
-  return Parse_WAV(buf, size, filterMode);
+  if (Parse_WAV(buf, size, filterMode)) return True;
+  if (Parse_X86_Code(buf, size, filterMode)) return True;
+  return Parse_Delta_Stats(buf, size, filterMode);
 }
 
 
@@ -586,12 +702,8 @@ static HRESULT WriteRange(IInStream *inStream, ISequentialOutStream *outStream,
     UInt64 position, UInt64 size, ICompressProgressInfo *progress)
 {
   RINOK(InStream_SeekSet(inStream, position))
-  CMyComPtr2_Create<ISequentialInStream, CLimitedSequentialInStream> streamSpec;
-  streamSpec->SetStream(inStream);
-  streamSpec->Init(size);
-  CMyComPtr2_Create<ICompressCoder, NCompress::CCopyCoder> copyCoder;
-  RINOK(copyCoder.Interface()->Code(streamSpec, outStream, NULL, NULL, progress))
-  return (copyCoder->TotalSize == size ? S_OK : E_FAIL);
+  // CCopyCoder reads no more than (size) bytes, and it can use OS-level copying for files
+  return NCompress::CopyStream_ExactSize(inStream, outStream, size, progress);
 }
 
 /*
@@ -1040,181 +1152,372 @@ struct CAnalysis
       */
   {}
 
+  bool NeedReadFile(const CUpdateItem &ui, bool &probablyIsSameIsa) const;
+  HRESULT OpenStream(UInt32 index, CMyComPtr<ISequentialInStream> &stream);
   HRESULT GetFilterGroup(UInt32 index, const CUpdateItem &ui, CFilterMode &filterMode);
+  HRESULT GetFilterGroups(const CObjectVector<CUpdateItem> &updateItems,
+      CRecordVector<CFilterMode> &filterModes, UInt32 numThreads);
 };
 
 static const size_t kAnalysisBufSize = 1 << 14;
 
-HRESULT CAnalysis::GetFilterGroup(UInt32 index, const CUpdateItem &ui, CFilterMode &filterMode)
+bool CAnalysis::NeedReadFile(const CUpdateItem &ui, bool &probablyIsSameIsa) const
 {
-  filterMode.Id = 0;
-  filterMode.Delta = 0;
-  filterMode.Offset = 0;
-
-  CFilterMode filterModeTemp = filterMode;
-
   const int slashPos = ui.Name.ReverseFind_PathSepar();
   const int dotPos = ui.Name.ReverseFind_Dot();
 
-  // if (dotPos > slashPos)
-  {
-    bool needReadFile = ParseAll;
-    /* if (Callback) is not supported by client,
-       we still try to use file name extension to detect executable file */
-    bool probablyIsSameIsa = false;
+  bool needReadFile = ParseAll;
+  /* if (Callback) is not supported by client,
+     we still try to use file name extension to detect executable file */
+  probablyIsSameIsa = false;
 
-    if (!needReadFile || !Callback)
+  if (!needReadFile || !Callback)
+  {
+    const wchar_t *ext = NULL;
+    if (dotPos > slashPos)
+      ext = ui.Name.Ptr((unsigned)(dotPos + 1));
+    // 7-zip stores posix attributes in high 16 bits and sets (0x8000) flag
+    if (ui.Attrib & 0x8000)
     {
-      const wchar_t *ext = NULL;
-      if (dotPos > slashPos)
-        ext = ui.Name.Ptr((unsigned)(dotPos + 1));
-      // 7-zip stores posix attributes in high 16 bits and sets (0x8000) flag
-      if (ui.Attrib & 0x8000)
+      const unsigned st_mode = ui.Attrib >> 16;
+      /* note: executable ".so" can be without execute permission,
+         and symbolic link to such ".so" file is possible */
+      // st_mode = 00111; // for debug
+      /* in Linux we expect such permissions:
+           0755 : for most executables
+           0644 : for some ".so" files
+           0777 : in WSL for all files.
+                  We can try to exclude some such 0777 cases from analysis,
+                  if there is non-executable extension.
+      */
+
+      if ((st_mode & (
+            MY_LIN_S_IXUSR |
+            MY_LIN_S_IXGRP |
+            MY_LIN_S_IXOTH)) != 0
+          && MY_LIN_S_ISREG(st_mode)
+          && (ui.Size >= (1u << 11)))
       {
-        const unsigned st_mode = ui.Attrib >> 16;
-        /* note: executable ".so" can be without execute permission,
-           and symbolic link to such ".so" file is possible */
-        // st_mode = 00111; // for debug
-        /* in Linux we expect such permissions:
-             0755 : for most executables
-             0644 : for some ".so" files
-             0777 : in WSL for all files.
-                    We can try to exclude some such 0777 cases from analysis,
-                    if there is non-executable extension.
-        */
+        #ifndef _WIN32
+        probablyIsSameIsa = true;
+        #endif
+        needReadFile = true;
+      }
+    }
 
-        if ((st_mode & (
-              MY_LIN_S_IXUSR |
-              MY_LIN_S_IXGRP |
-              MY_LIN_S_IXOTH)) != 0
-            && MY_LIN_S_ISREG(st_mode)
-            && (ui.Size >= (1u << 11)))
+    if (!needReadFile)
+    {
+      if (!ext)
+        needReadFile = ParseNoExt;
+      else
+      {
+        bool isUnixExt = false;
+        if (ParseExeUnix)
+          isUnixExt = IsExt_ExeUnix_NumericAllowed(ui.Name);
+        if (isUnixExt)
         {
+          needReadFile = true;
           #ifndef _WIN32
-          probablyIsSameIsa = true;
+            probablyIsSameIsa = true;
           #endif
-          needReadFile = true;
         }
-      }
-
-      if (!needReadFile)
-      {
-        if (!ext)
-          needReadFile = ParseNoExt;
-        else
+        else if (IsExt_Exe(ext))
         {
-          bool isUnixExt = false;
-          if (ParseExeUnix)
-            isUnixExt = IsExt_ExeUnix_NumericAllowed(ui.Name);
-          if (isUnixExt)
-          {
-            needReadFile = true;
-            #ifndef _WIN32
-              probablyIsSameIsa = true;
-            #endif
-          }
-          else if (IsExt_Exe(ext))
-          {
-            needReadFile = ParseExe;
-            #ifdef _WIN32
-              probablyIsSameIsa = true;
-            #endif
-          }
-          else if (StringsAreEqualNoCase_Ascii(ext, "wav"))
-          {
-            if (!needReadFile)
-              needReadFile = ParseWav;
-          }
+          needReadFile = ParseExe;
+          #ifdef _WIN32
+            probablyIsSameIsa = true;
+          #endif
+        }
+        else if (StringsAreEqualNoCase_Ascii(ext, "wav"))
+        {
+          if (!needReadFile)
+            needReadFile = ParseWav;
         }
       }
     }
+  }
+  return needReadFile;
+}
+
+
+HRESULT CAnalysis::OpenStream(UInt32 index, CMyComPtr<ISequentialInStream> &stream)
+{
+  stream.Release();
+  const HRESULT result = Callback->GetStream2(index, &stream, NUpdateNotifyOp::kAnalyze);
+  /*
+  if (result == S_OK && stream && Need_ATime)
+  {
+    // access time could be changed in analysis pass
+    CMyComPtr<IStreamGetProps> getProps;
+    stream.QueryInterface(IID_IStreamGetProps, (void **)&getProps);
+    if (getProps)
+      if (getProps->GetProps(NULL, NULL, &ATime, NULL, NULL) == S_OK)
+        ATime_Defined = true;
+  }
+  */
+  if (result != S_OK)
+    stream.Release();
+  return result;
+}
 
-    if (needReadFile)
+
+/* it sets (filterMode) from parsed file data.
+   (buf == NULL) means that the data was not read */
+static void SetFilterMode_from_Data(const CUpdateItem &ui,
+    const Byte *buf, size_t size, bool probablyIsSameIsa, CFilterMode &filterMode)
+{
+  CFilterMode filterModeTemp;
+  filterModeTemp.ClearFilterMode();
+
+  BoolInt parseRes = false;
+  if (buf)
+    parseRes = ParseFile(buf, size, &filterModeTemp);
+  else if (probablyIsSameIsa)
+  {
+    #ifdef MY_CPU_X86_OR_AMD64
+      filterModeTemp.Id = k_X86;
+    #endif
+    #ifdef MY_CPU_ARM64
+      filterModeTemp.Id = k_ARM64;
+    #endif
+    #ifdef MY_CPU_RISCV
+      filterModeTemp.Id = k_RISCV;
+    #endif
+    #ifdef MY_CPU_SPARC
+      filterModeTemp.Id = k_SPARC;
+    #endif
+    parseRes = true;
+  }
+
+  if (parseRes
+      && filterModeTemp.Id != k_Delta
+      && filterModeTemp.Delta == 0)
+  {
+    /* ParseFile() sets (filterModeTemp.Delta == 0) for all
+       methods except of k_Delta. */
+    // it's not k_Delta
+    // So we call SetDelta() to set Delta
+    filterModeTemp.SetDelta();
+    if (filterModeTemp.Delta > 1)
     {
-      BoolInt parseRes = false;
-      if (Callback)
+      /* If file Size is not aligned, then branch filter
+         will not work for next file in solid block.
+         Maybe we should allow filter for non-aligned-size file in non-solid archives ?
+      */
+      if (ui.Size % filterModeTemp.Delta != 0)
+        parseRes = false;
+      // windows exe files are not aligned for 4 KiB.
+      /*
+      else if (filterModeTemp.Id == k_ARM64 && filterModeTemp.Offset != 0)
       {
-        if (Buffer.Size() != kAnalysisBufSize)
-          Buffer.Alloc(kAnalysisBufSize);
-        CMyComPtr<ISequentialInStream> stream;
-        HRESULT result = Callback->GetStream2(index, &stream, NUpdateNotifyOp::kAnalyze);
-        if (result == S_OK && stream)
+        if (ui.Size % (1 << 12) != 0)
         {
-          /*
-          if (Need_ATime)
-          {
-            // access time could be changed in analysis pass
-            CMyComPtr<IStreamGetProps> getProps;
-            stream.QueryInterface(IID_IStreamGetProps, (void **)&getProps);
-            if (getProps)
-              if (getProps->GetProps(NULL, NULL, &ATime, NULL, NULL) == S_OK)
-                ATime_Defined = true;
-          }
-          */
-          size_t size = kAnalysisBufSize;
-          result = ReadStream(stream, Buffer, &size);
-          stream.Release();
-          // RINOK(Callback->SetOperationResult2(index, NUpdate::NOperationResult::kOK));
-          if (result == S_OK)
-          {
-            parseRes = ParseFile(Buffer, size, &filterModeTemp);
-          }
+          // If Size is not aligned for 4 KiB, then Offset will not work for next file in solid block.
+          // so we place such file in group with (Offset==0).
+          filterModeTemp.Offset = 0;
         }
-      } // Callback
-      else if (probablyIsSameIsa)
-      {
-        #ifdef MY_CPU_X86_OR_AMD64
-          filterModeTemp.Id = k_X86;
-        #endif
-        #ifdef MY_CPU_ARM64
-          filterModeTemp.Id = k_ARM64;
-        #endif
-        #ifdef MY_CPU_RISCV
-          filterModeTemp.Id = k_RISCV;
-        #endif
-        #ifdef MY_CPU_SPARC
-          filterModeTemp.Id = k_SPARC;
-        #endif
-        parseRes = true;
       }
+      */
+    }
+  }
+  if (!parseRes)
+    filterModeTemp.ClearFilterMode();
+  filterMode = filterModeTemp;
+}
 
-      if (parseRes
-          && filterModeTemp.Id != k_Delta
-          && filterModeTemp.Delta == 0)
-      {
-        /* ParseFile() sets (filterModeTemp.Delta == 0) for all
-           methods except of k_Delta. */
-        // it's not k_Delta
-        // So we call SetDelta() to set Delta
-        filterModeTemp.SetDelta();
-        if (filterModeTemp.Delta > 1)
-        {
-          /* If file Size is not aligned, then branch filter
-             will not work for next file in solid block.
-             Maybe we should allow filter for non-aligned-size file in non-solid archives ?
-          */
-          if (ui.Size % filterModeTemp.Delta != 0)
-            parseRes = false;
-          // windows exe files are not aligned for 4 KiB.
-          /*
-          else if (filterModeTemp.Id == k_ARM64 && filterModeTemp.Offset != 0)
-          {
-            if (ui.Size % (1 << 12) != 0)
-            {
-              // If Size is not aligned for 4 KiB, then Offset will not work for next file in solid block.
-              // so we place such file in group with (Offset==0).
-              filterModeTemp.Offset = 0;
-            }
-          }
-          */
-        }
-      }
-      if (!parseRes)
-        filterModeTemp.ClearFilterMode();
+
+HRESULT CAnalysis::GetFilterGroup(UInt32 index, const CUpdateItem &ui, CFilterMode &filterMode)
+{
+  bool probablyIsSameIsa;
+  if (!NeedReadFile(ui, probablyIsSameIsa))
+  {
+    filterMode.ClearFilterMode();
+    return S_OK;
+  }
+  const Byte *buf = NULL;
+  size_t size = 0;
+  if (Callback)
+  {
+    if (Buffer.Size() != kAnalysisBufSize)
+      Buffer.Alloc(kAnalysisBufSize);
+    CMyComPtr<ISequentialInStream> stream;
+    if (OpenStream(index, stream) == S_OK && stream)
+    {
+      size = kAnalysisBufSize;
+      const HRESULT result = ReadStream(stream, Buffer, &size);
+      stream.Release();
+      // RINOK(Callback->SetOperationResult2(index, NUpdate::NOperationResult::kOK));
+      if (result == S_OK)
+        buf = Buffer;
+    }
+    probablyIsSameIsa = false;
+  }
+  SetFilterMode_from_Data(ui, buf, size, probablyIsSameIsa, filterMode);
+  return S_OK;
+}
+
+
+#ifndef Z7_ST
+
+/*
+The analysis pass reads the heads of many small files.
+The main thread opens the streams of next batch of files via callback,
+and the reader threads read the data from these streams in parallel.
+The streams are released in main thread.
+*/
+
+static const unsigned kAnalysisBatchSize = 64;
+static const UInt32 kAnalysisThreadsMax = 8;
+
+struct CAnalysisBatchItem
+{
+  CMyComPtr<ISequentialInStream> Stream;
+  CByteBuffer Buf;
+  size_t Size;
+  HRESULT Result;
+};
+
+struct CAnalysisBatch
+{
+  CObjectVector<CAnalysisBatchItem> Items;
+  unsigned NumItems;
+  unsigned NextItem;
+  NWindows::NSynchronization::CCriticalSection CS;
+
+  void ReadItems();
+};
+
+void CAnalysisBatch::ReadItems()
+{
+  for (;;)
+  {
+    unsigned i;
+    {
+      NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+      if (NextItem >= NumItems)
+        return;
+      i = NextItem++;
     }
+    CAnalysisBatchItem &item = Items[i];
+    if (!item.Stream)
+      continue;
+    size_t size = kAnalysisBufSize;
+    item.Result = ReadStream(item.Stream, item.Buf, &size);
+    item.Size = size;
+  }
+}
+
+class CAnalysisThread Z7_final: public CVirtThread
+{
+public:
+  CAnalysisBatch *Batch;
+  ~CAnalysisThread() { CVirtThread::WaitThreadFinish(); }
+private:
+  virtual void Execute() Z7_override
+  {
+    try { Batch->ReadItems(); }
+    catch(...) {}
   }
+};
+
+#endif
+
+
+/* it sets (filterModes[i]) for all items that need analysis.
+   The reading of the file data can be performed in (numThreads) threads. */
+
+HRESULT CAnalysis::GetFilterGroups(const CObjectVector<CUpdateItem> &updateItems,
+    CRecordVector<CFilterMode> &filterModes, UInt32 numThreads)
+{
+  filterModes.ClearAndSetSize(updateItems.Size());
+  CRecordVector<UInt32> readIndexes;
   
-  filterMode = filterModeTemp;
+  FOR_VECTOR (i, updateItems)
+  {
+    CFilterMode &fm = filterModes[i];
+    fm.ClearFilterMode();
+    const CUpdateItem &ui = updateItems[i];
+    if (!ui.NewData || !ui.HasStream())
+      continue;
+    #ifndef Z7_ST
+    if (Callback && numThreads > 1)
+    {
+      bool probablyIsSameIsa;
+      if (NeedReadFile(ui, probablyIsSameIsa))
+        readIndexes.Add(i);
+      continue;
+    }
+    #endif
+    RINOK(GetFilterGroup(i, ui, fm))
+  }
+
+  #ifndef Z7_ST
+  
+  if (readIndexes.IsEmpty())
+    return S_OK;
+  
+  if (numThreads > kAnalysisThreadsMax)
+    numThreads = kAnalysisThreadsMax;
+
+  CAnalysisBatch batch;
+  unsigned i;
+  for (i = 0; i < kAnalysisBatchSize; i++)
+    batch.Items.AddNew().Buf.Alloc(kAnalysisBufSize);
+  
+  // the main thread also reads the data, so we create (numThreads - 1) threads
+  CObjectVector<CAnalysisThread> threads;
+  for (i = 0; i + 1 < numThreads; i++)
+  {
+    CAnalysisThread &t = threads.AddNew();
+    t.Batch = &batch;
+    if (t.Create() != 0)
+    {
+      threads.DeleteBack();
+      break;
+    }
+  }
+
+  for (unsigned start = 0; start < readIndexes.Size();)
+  {
+    unsigned num = readIndexes.Size() - start;
+    if (num > kAnalysisBatchSize)
+      num = kAnalysisBatchSize;
+    for (i = 0; i < num; i++)
+    {
+      CAnalysisBatchItem &item = batch.Items[i];
+      item.Size = 0;
+      item.Result = S_FALSE;
+      // the errors in analysis pass are not critical
+      OpenStream(readIndexes[start + i], item.Stream);
+    }
+    batch.NumItems = num;
+    batch.NextItem = 0;
+    
+    unsigned numStarted = 0;
+    while (numStarted < threads.Size() && threads[numStarted].Start() == 0)
+      numStarted++;
+    batch.ReadItems();
+    for (i = 0; i < numStarted; i++)
+      threads[i].WaitExecuteFinish();
+
+    for (i = 0; i < num; i++)
+    {
+      CAnalysisBatchItem &item = batch.Items[i];
+      const bool wasRead = (item.Stream && item.Result == S_OK);
+      item.Stream.Release();
+      const UInt32 index = readIndexes[start + i];
+      SetFilterMode_from_Data(updateItems[index],
+          wasRead ? (const Byte *)item.Buf : NULL, item.Size,
+          false, // probablyIsSameIsa
+          filterModes[index]);
+    }
+    start += num;
+  }
+  
+  #else
+  UNUSED_VAR(numThreads)
+  #endif
+
   return S_OK;
 }
 
@@ -2120,6 +2423,7 @@ HRESULT Update(
 
   {
     CAnalysis analysis;
+    CRecordVector<CFilterMode> filterModes;
     // analysis.Need_ATime = options.Need_ATime;
     int analysisLevel = options.AnalysisLevel;
     // (analysisLevel < 0) means default level (5)
@@ -2146,6 +2450,15 @@ HRESULT Update(
     // ---------- Split files to groups ----------
 
     const CCompressionMethodMode &method = *options.Method;
+
+    if (useFilters)
+    {
+      UInt32 numThreads = 1;
+      #ifndef Z7_ST
+      numThreads = method.NumThreads;
+      #endif
+      RINOK(analysis.GetFilterGroups(updateItems, filterModes, numThreads))
+    }
     
     FOR_VECTOR (i, updateItems)
     {
@@ -2155,17 +2468,7 @@ HRESULT Update(
 
       CFilterMode2 fm;
       if (useFilters)
-      {
-        // analysis.ATime_Defined = false;
-        RINOK(analysis.GetFilterGroup(i, ui, fm))
-        /*
-        if (analysis.ATime_Defined)
-        {
-          ui.ATime = FILETIME_To_UInt64(analysis.ATime);
-          ui.ATime_WasReadByAnalysis = true;
-        }
-        */
-      }
+        static_cast<CFilterMode &>(fm) = filterModes[i];
       fm.Encrypted = method.PasswordIsDefined;
 
       const unsigned groupIndex = GetGroup(filters, fm);
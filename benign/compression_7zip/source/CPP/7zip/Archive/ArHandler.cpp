@@ -124,24 +124,25 @@ struct CItem
 
 class CInArchive
 {
-  CMyComPtr<IInStream> m_Stream;
+  CMyComPtr<ISequentialInStream> m_Stream;
   
 public:
   UInt64 Position;
   ESubType SubType;
   
   HRESULT GetNextItem(CItem &itemInfo, bool &filled);
-  HRESULT Open(IInStream *inStream);
-  HRESULT SkipData(UInt64 dataSize)
+  // (inStream) must be at the start of archive
+  HRESULT Open(ISequentialInStream *inStream);
+  HRESULT SkipData(IInStream *inStream, UInt64 dataSize)
   {
-    return m_Stream->Seek((Int64)(dataSize + (dataSize & 1)), STREAM_SEEK_CUR, &Position);
+    return inStream->Seek((Int64)(dataSize + (dataSize & 1)), STREAM_SEEK_CUR, &Position);
   }
 };
 
-HRESULT CInArchive::Open(IInStream *inStream)
+HRESULT CInArchive::Open(ISequentialInStream *inStream)
 {
   SubType = kSubType_None;
-  RINOK(InStream_GetPos(inStream, Position))
+  Position = 0;
   char signature[kSignatureLen];
   RINOK(ReadStream_FALSE(inStream, signature, kSignatureLen))
   Position += kSignatureLen;
@@ -271,13 +272,15 @@ HRESULT CInArchive::GetNextItem(CItem &item, bool &filled)
 }
 
 
-Z7_CLASS_IMP_CHandler_IInArchive_1(
-  IInArchiveGetStream
+Z7_CLASS_IMP_CHandler_IInArchive_2(
+    IArchiveOpenSeq
+  , IInArchiveGetStream
 )
   bool _isArc;
   CObjectVector<CItem> _items;
   CMyComPtr<IInStream> _stream;
   UInt64 _phySize;
+  bool _phySize_Defined; // it's false in sequential mode until the end of archive
   Int32 _mainSubfile;
 
   EType _type;
@@ -294,6 +297,24 @@ Z7_CLASS_IMP_CHandler_IInArchive_1(
   int FindItem(UInt32 offset) const;
   HRESULT AddFunc(UInt32 offset, const Byte *data, size_t size, size_t &pos);
   HRESULT ParseLibSymbols(IInStream *stream, unsigned fileIndex);
+
+  /* sequential mode (OpenSeq): we keep only the latest item header and
+     the list of long file names. Library symbols, deb type detection and
+     renaming of duplicate names are not supported in that mode. */
+  CMyComPtr<ISequentialInStream> _seqStream;
+  UInt32 _curIndex;
+  bool _latestIsRead;
+  CItem _latestItem;
+  UInt64 _latestDataRem; // the size of data of latest item that was not read from _seqStream
+  CByteBuffer _longNames;
+  CInArchive _arc;
+
+  CMyComPtr2_Create<ICompressCoder, NCompress::CCopyCoder> copyCoder;
+
+  HRESULT SkipPadding(UInt64 dataSize);
+  HRESULT SkipLatestData();
+  HRESULT ReadLatestItem();
+  HRESULT SkipTo(UInt32 index);
 };
 
 void CHandler::UpdateErrorMessage(const char *s)
@@ -321,6 +342,33 @@ static const Byte kProps[] =
 IMP_IInArchive_Props
 IMP_IInArchive_ArcProps
 
+// it replaces "/N" reference by the name from long file names list
+
+static HRESULT ResolveLongName(AString &name, const Byte *p, size_t size)
+{
+  if (name[0] != '/')
+    return S_OK;
+  const char *ptr = name.Ptr(1);
+  const char *end;
+  UInt32 pos = ConvertStringToUInt32(ptr, &end);
+  if (*end != 0 || end == ptr)
+    return S_OK;
+  if (pos >= size)
+    return S_OK;
+  UInt32 start = pos;
+  for (;;)
+  {
+    if (pos >= size)
+      return S_FALSE;
+    const Byte c = p[pos];
+    if (c == 0 || c == 0x0A)
+      break;
+    pos++;
+  }
+  name.SetFrom((const char *)(p + start), (unsigned)(pos - start));
+  return S_OK;
+}
+
 HRESULT CHandler::ParseLongNames(IInStream *stream)
 {
   unsigned i;
@@ -342,27 +390,7 @@ HRESULT CHandler::ParseLongNames(IInStream *stream)
   
   for (i = 0; i < _items.Size(); i++)
   {
-    CItem &item2 = _items[i];
-    if (item2.Name[0] != '/')
-      continue;
-    const char *ptr = item2.Name.Ptr(1);
-    const char *end;
-    UInt32 pos = ConvertStringToUInt32(ptr, &end);
-    if (*end != 0 || end == ptr)
-      continue;
-    if (pos >= size)
-      continue;
-    UInt32 start = pos;
-    for (;;)
-    {
-      if (pos >= size)
-        return S_FALSE;
-      const Byte c = p[pos];
-      if (c == 0 || c == 0x0A)
-        break;
-      pos++;
-    }
-    item2.Name.SetFrom((const char *)(p + start), (unsigned)(pos - start));
+    RINOK(ResolveLongName(_items[i].Name, p, size))
   }
   
   _longNames_FileIndex = (int)fileIndex;
@@ -579,7 +607,7 @@ Z7_COM7F_IMF(CHandler::Open(IInStream *stream,
       if (!filled)
         break;
       _items.Add(item);
-      arc.SkipData(item.Size);
+      arc.SkipData(stream, item.Size);
       if (callback && (_items.Size() & 0xFF) == 0)
       {
         const UInt64 numFiles = _items.Size();
@@ -632,6 +660,7 @@ Z7_COM7F_IMF(CHandler::Open(IInStream *stream,
 
     _stream = stream;
     _phySize = arc.Position;
+    _phySize_Defined = true;
 
     /*
     if (fileSize < _phySize)
@@ -642,10 +671,115 @@ Z7_COM7F_IMF(CHandler::Open(IInStream *stream,
   COM_TRY_END
 }
 
+Z7_COM7F_IMF(CHandler::OpenSeq(ISequentialInStream *stream))
+{
+  COM_TRY_BEGIN
+  Close();
+  RINOK(_arc.Open(stream))
+  _seqStream = stream;
+  _phySize = _arc.Position;
+  _isArc = true;
+  return S_OK;
+  COM_TRY_END
+}
+
+HRESULT CHandler::SkipPadding(UInt64 dataSize)
+{
+  if (dataSize & 1)
+  {
+    // the padding byte can be missing at the end of archive
+    Byte b;
+    size_t processed = 1;
+    RINOK(ReadStream(_seqStream, &b, &processed))
+    _arc.Position += processed;
+  }
+  _phySize = _arc.Position;
+  return S_OK;
+}
+
+HRESULT CHandler::SkipLatestData()
+{
+  const UInt64 rem = _latestDataRem;
+  RINOK(copyCoder.Interface()->Code(_seqStream, NULL, &rem, &rem, NULL))
+  _arc.Position += copyCoder->TotalSize;
+  _phySize = _arc.Position;
+  _latestIsRead = false;
+  _curIndex++;
+  if (copyCoder->TotalSize != rem)
+  {
+    UpdateErrorMessage("Unexpected end of archive");
+    return S_FALSE;
+  }
+  _latestDataRem = 0;
+  return SkipPadding(_latestItem.Size);
+}
+
+/* ReadLatestItem() reads next item header in sequential mode.
+   It returns E_INVALIDARG, if there are no more items. */
+
+HRESULT CHandler::ReadLatestItem()
+{
+  for (;;)
+  {
+    bool filled;
+    RINOK(_arc.GetNextItem(_latestItem, filled))
+    if (!filled)
+    {
+      _phySize_Defined = true;
+      return E_INVALIDARG;
+    }
+    _phySize = _arc.Position;
+    if (!_latestItem.Name.IsEqualTo("//"))
+      break;
+    if (_longNames.Size() != 0 || _latestItem.Size > ((UInt32)1 << 24))
+      break;
+    const size_t size = (size_t)_latestItem.Size;
+    _longNames.Alloc(size);
+    size_t processed = size;
+    RINOK(ReadStream(_seqStream, _longNames, &processed))
+    _arc.Position += processed;
+    _phySize = _arc.Position;
+    if (processed != size)
+    {
+      UpdateErrorMessage("Unexpected end of archive");
+      return E_INVALIDARG;
+    }
+    RINOK(SkipPadding(size))
+  }
+  if (ResolveLongName(_latestItem.Name, _longNames, _longNames.Size()) != S_OK)
+    UpdateErrorMessage("Long file names parsing error");
+  _latestDataRem = _latestItem.Size;
+  _latestIsRead = true;
+  return S_OK;
+}
+
+HRESULT CHandler::SkipTo(UInt32 index)
+{
+  while (_curIndex < index || !_latestIsRead)
+  {
+    if (_latestIsRead)
+    {
+      RINOK(SkipLatestData())
+    }
+    else
+    {
+      RINOK(ReadLatestItem())
+    }
+  }
+  return S_OK;
+}
+
 Z7_COM7F_IMF(CHandler::Close())
 {
   _isArc = false;
   _phySize = 0;
+  _phySize_Defined = false;
+
+  _seqStream.Release();
+  _curIndex = 0;
+  _latestIsRead = false;
+  _latestDataRem = 0;
+  _longNames.Free();
 
   _errorMessage.Empty();
   _stream.Release();
@@ -665,7 +799,7 @@ Z7_COM7F_IMF(CHandler::Close())
 
 Z7_COM7F_IMF(CHandler::GetNumberOfItems(UInt32 *numItems))
 {
-  *numItems = _items.Size();
+  *numItems = (_stream ? _items.Size() : (UInt32)(Int32)-1);
   return S_OK;
 }
 
@@ -675,7 +809,7 @@ Z7_COM7F_IMF(CHandler::GetArchiveProperty(PROPID propID, PROPVARIANT *value))
   NCOM::CPropVariant prop;
   switch (propID)
   {
-    case kpidPhySize: prop = _phySize; break;
+    case kpidPhySize: if (_phySize_Defined) prop = _phySize; break;
     case kpidMainSubfile: if (_mainSubfile >= 0) prop = (UInt32)_mainSubfile; break;
     case kpidExtension: prop = k_TypeExtionsions[(unsigned)_type]; break;
     case kpidShortComment:
@@ -706,7 +840,17 @@ Z7_COM7F_IMF(CHandler::GetProperty(UInt32 index, PROPID propID, PROPVARIANT *val
 {
   COM_TRY_BEGIN
   NWindows::NCOM::CPropVariant prop;
-  const CItem &item = _items[index];
+  const CItem *itemPtr;
+  if (_stream)
+    itemPtr = &_items[index];
+  else
+  {
+    if (index < _curIndex)
+      return E_INVALIDARG;
+    RINOK(SkipTo(index))
+    itemPtr = &_latestItem;
+  }
+  const CItem &item = *itemPtr;
   switch (propID)
   {
     case kpidPath:
@@ -744,10 +888,11 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     Int32 testMode, IArchiveExtractCallback *extractCallback))
 {
   COM_TRY_BEGIN
+  const bool seqMode = (_stream == NULL);
   const bool allFilesMode = (numItems == (UInt32)(Int32)-1);
   if (allFilesMode)
     numItems = _items.Size();
-  if (numItems == 0)
+  if (!seqMode && numItems == 0)
     return S_OK;
   UInt64 totalSize = 0;
   UInt32 i;
@@ -762,35 +907,54 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 
   UInt64 currentTotalSize = 0;
   
-  CMyComPtr2_Create<ICompressCoder, NCompress::CCopyCoder> copyCoder;
   CMyComPtr2_Create<ICompressProgressInfo, CLocalProgress> lps;
   lps->Init(extractCallback, false);
 
   CMyComPtr2_Create<ISequentialInStream, CLimitedSequentialInStream> inStream;
-  inStream->SetStream(_stream);
+  if (seqMode)
+    inStream->SetStream(_seqStream);
+  else
+    inStream->SetStream(_stream);
 
   for (i = 0;; i++)
   {
     lps->InSize = lps->OutSize = currentTotalSize;
     RINOK(lps->SetCur())
-    if (i >= numItems)
+    if (i >= numItems && !seqMode)
       break;
     Int32 opRes;
+    bool unexpectedEnd = false;
    {
     CMyComPtr<ISequentialOutStream> realOutStream;
-    const Int32 askMode = testMode ?
+    Int32 askMode = testMode ?
         NExtract::NAskMode::kTest :
         NExtract::NAskMode::kExtract;
     const UInt32 index = allFilesMode ? i : indices[i];
-    const CItem &item = _items[index];
+    const CItem *itemPtr;
+    if (seqMode)
+    {
+      const HRESULT res = SkipTo(index);
+      // (S_FALSE) : unexpected end of archive in data of skipped item. Error message is set.
+      if (res == E_INVALIDARG || res == S_FALSE)
+        break;
+      RINOK(res)
+      itemPtr = &_latestItem;
+    }
+    else
+      itemPtr = &_items[index];
+    const CItem &item = *itemPtr;
     RINOK(extractCallback->GetStream(index, &realOutStream, askMode))
     currentTotalSize += (item.TextFileIndex >= 0) ?
         (UInt64)_libFiles[(unsigned)item.TextFileIndex].Len() : item.Size;
     
     if (!testMode && !realOutStream)
-      continue;
+    {
+      if (!seqMode)
+        continue;
+      askMode = NExtract::NAskMode::kSkip;
+    }
     RINOK(extractCallback->PrepareOperation(askMode))
-    if (testMode)
+    if (testMode && !seqMode)
     {
       RINOK(extractCallback->SetOperationResult(NExtract::NOperationResult::kOK))
       continue;
@@ -802,6 +966,24 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
       if (realOutStream)
         RINOK(WriteStream(realOutStream, f, f.Len()))
     }
+    else if (seqMode)
+    {
+      inStream->Init(item.Size);
+      RINOK(copyCoder.Interface()->Code(inStream, realOutStream, NULL, NULL, lps))
+      _arc.Position += copyCoder->TotalSize;
+      _latestDataRem -= copyCoder->TotalSize;
+      if (copyCoder->TotalSize != item.Size)
+        opRes = NExtract::NOperationResult::kUnexpectedEnd;
+      // it skips the padding byte
+      const HRESULT res = SkipLatestData();
+      if (res == S_FALSE)
+      {
+        unexpectedEnd = true;
+        opRes = NExtract::NOperationResult::kUnexpectedEnd;
+      }
+      else
+        RINOK(res)
+    }
     else
     {
       RINOK(InStream_SeekSet(_stream, item.GetDataPos()))
@@ -812,6 +994,8 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     }
    }
     RINOK(extractCallback->SetOperationResult(opRes))
+    if (unexpectedEnd)
+      break;
   }
   return S_OK;
   COM_TRY_END
@@ -820,6 +1004,9 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 Z7_COM7F_IMF(CHandler::GetStream(UInt32 index, ISequentialInStream **stream))
 {
   COM_TRY_BEGIN
+  *stream = NULL;
+  if (!_stream)
+    return S_FALSE;
   const CItem &item = _items[index];
   if (item.TextFileIndex >= 0)
   {
@@ -0,0 +1,1249 @@
+// CasHandler.cpp
+
+#include "StdAfx.h"
+
+#include <string.h>
+
+#include "../../../C/7zCrc.h"
+#include "../../../C/Alloc.h"
+#include "../../../C/CpuArch.h"
+#include "../../../C/LzmaDec.h"
+#include "../../../C/LzmaEnc.h"
+#ifndef Z7_ST
+#include "../../../C/MemBudget.h"
+#endif
+#include "../../../C/Sha256.h"
+
+#include "../../Common/ComTry.h"
+#include "../../Common/DynamicBuffer.h"
+#include "../../Common/IntToString.h"
+#include "../../Common/MyBuffer2.h"
+#include "../../Common/StringConvert.h"
+#include "../../Common/UTFConvert.h"
+
+#include "../../Windows/FileDir.h"
+#include "../../Windows/FileFind.h"
+#include "../../Windows/FileIO.h"
+#include "../../Windows/FileName.h"
+#include "../../Windows/PropVariant.h"
+#include "../../Windows/System.h"
+
+#ifndef Z7_ST
+#include "../../Windows/Synchronization.h"
+#include "../../Windows/Thread.h"
+#endif
+
+#include "../Common/CWrappers.h"
+#include "../Common/MethodProps.h"
+#include "../Common/ProgressUtils.h"
+#include "../Common/RegisterArc.h"
+#include "../Common/StreamUtils.h"
+
+#include "Common/ItemNameUtils.h"
+
+/*
+  The "cas" archive is a small manifest (snapshot) that refers to chunks
+  in a shared chunk store directory. Each chunk is stored in a separate file
+  that is named by SHA-256 of chunk data:
+    store/hh/<64 hex digits of SHA-256>
+  So repeated backups to the same store write only new chunks.
+  File data is split to chunks with content-defined chunking (gear hash),
+  so an insertion in a file changes only the chunks near the insertion.
+
+  manifest:
+    Byte   Signature[6]
+    Byte   Version[2]
+    UInt32 CRC of body
+    UInt64 body size
+    body:
+      UInt32 size + UTF-8 store dir
+      UInt32 numItems
+      items[numItems]:
+        Byte   flags
+        UInt32 Attrib  (if kFlag_Attrib)
+        UInt64 MTime   (if kFlag_MTime)
+        UInt64 Size
+        UInt32 size + UTF-8 name
+        UInt32 numChunks
+        chunks[numChunks]:
+          Byte   SHA-256[32]
+          UInt32 Size
+
+  chunk file:
+    Byte   method (0 - copy, 1 - LZMA)
+    Byte   Reserved[3]
+    UInt32 unpack size
+    Byte   LzmaProps[5] (if LZMA)
+    packed data
+*/
+
+using namespace NWindows;
+using namespace NFile;
+
+namespace NArchive {
+namespace NCas {
+
+static const Byte kSignature[] = { '7', 'z', 'C', 'A', 'S', 0x1A };
+static const unsigned kSignatureSize = sizeof(kSignature);
+static const Byte kVer_Major = 0;
+static const Byte kVer_Minor = 1;
+static const unsigned kHeaderSize = kSignatureSize + 2 + 4 + 8;
+static const UInt32 kBodySizeMax = (UInt32)1 << 30;
+
+static const Byte kFlag_Dir    = 1 << 0;
+static const Byte kFlag_Attrib = 1 << 1;
+static const Byte kFlag_MTime  = 1 << 2;
+
+static const unsigned kHashSize = SHA256_DIGEST_SIZE;
+
+static const UInt32 kChunkSizeMin = (UInt32)1 << 14;
+static const UInt32 kChunkSizeMax = (UInt32)1 << 18;
+// 16 bits of gear hash give the average chunk size of about (kChunkSizeMin + 64 KB)
+static const UInt64 kChunkMask = (UInt64)0xFFFF << 48;
+
+static const size_t kInBufSize = (size_t)1 << 21;
+
+static const unsigned kChunkHeaderSize = 8;
+static const unsigned kChunkPackBufSize = kChunkHeaderSize + LZMA_PROPS_SIZE + kChunkSizeMax;
+
+namespace NMethod
+{
+  const Byte kCopy = 0;
+  const Byte kLZMA = 1;
+}
+
+static const unsigned kNumSlotsMax = 64;
+
+static UInt64 g_Gear[256];
+
+static struct CGearTableInit
+{
+  CGearTableInit()
+  {
+    // fixed table: chunk boundaries must not change between program versions
+    UInt64 x = 0x9E3779B97F4A7C15;
+    for (unsigned i = 0; i < 256; i++)
+    {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      g_Gear[i] = x;
+    }
+  }
+} g_GearTableInit;
+
+// it returns the size of the first chunk in (data)
+static size_t FindChunkBoundary(const Byte *data, size_t size)
+{
+  if (size <= kChunkSizeMin)
+    return size;
+  if (size > kChunkSizeMax)
+    size = kChunkSizeMax;
+  UInt64 h = 0;
+  for (size_t i = kChunkSizeMin; i < size; i++)
+  {
+    h = (h << 1) + g_Gear[data[i]];
+    if ((h & kChunkMask) == 0)
+      return i + 1;
+  }
+  return size;
+}
+
+
+struct CChunkRef
+{
+  Byte Hash[kHashSize];
+  UInt32 Size;
+};
+
+struct CItem
+{
+  AString Name; // UTF-8 with '/' separators
+  UInt64 Size;
+  UInt64 MTime;
+  UInt32 Attrib;
+  unsigned ChunkStart;
+  unsigned NumChunks;
+  bool IsDir;
+  bool MTime_Defined;
+  bool Attrib_Defined;
+
+  CItem():
+      Size(0),
+      MTime(0),
+      Attrib(0),
+      ChunkStart(0),
+      NumChunks(0),
+      IsDir(false),
+      MTime_Defined(false),
+      Attrib_Defined(false)
+      {}
+};
+
+struct CSlot
+{
+  CMidBuffer Data;
+  CMidBuffer Packed;
+  const Byte *Out;    // unpacked data after decoding
+  UInt32 Size;        // unpacked size
+  unsigned ChunkIndex;
+  Int32 OpRes;        // result of decoding
+  HRESULT Res;
+  Byte Hash[kHashSize];
+  CAlignedBuffer1 Sha;
+
+  CSlot(): Out(NULL), Size(0), ChunkIndex(0), OpRes(0), Res(S_OK), Sha(sizeof(CSha256)) {}
+  bool Alloc()
+  {
+    Data.Alloc(kChunkSizeMax);
+    Packed.Alloc(kChunkPackBufSize);
+    return Data.IsAllocated() && Packed.IsAllocated();
+  }
+  void CalcHash(const Byte *data, size_t size, Byte *digest)
+  {
+    CSha256 *sha = (CSha256 *)(void *)(Byte *)Sha;
+    Sha256_Init(sha);
+    Sha256_Update(sha, data, size);
+    Sha256_Final(sha, digest);
+  }
+};
+
+class CHandler;
+
+#ifndef Z7_ST
+
+struct CCasThread
+{
+  NWindows::CPoolThread Thread;
+  NWindows::NSynchronization::CAutoResetEvent StartEvent;
+  NWindows::NSynchronization::CAutoResetEvent FinishedEvent;
+  CHandler *Handler;
+  unsigned ThreadIndex;
+  bool Exit;
+
+  void ThreadFunc();
+  WRes Create();
+
+  CCasThread(): Handler(NULL), ThreadIndex(0), Exit(false) {}
+  ~CCasThread()
+  {
+    if (Thread.IsCreated())
+    {
+      Exit = true;
+      StartEvent.Set();
+      Thread.Wait_Close();
+    }
+  }
+};
+
+#endif
+
+
+Z7_CLASS_IMP_CHandler_IInArchive_2(
+  IOutArchive,
+  ISetProperties
+)
+  CObjectVector<CItem> _items;
+  CRecordVector<CChunkRef> _chunks;
+  UInt64 _phySize;
+  bool _isArc;
+  bool _storeDir_Forced;
+  UString _storeDir;
+  FString _storePrefix;
+  UInt32 _level;
+  UInt32 _numThreads;
+
+  // jobs for worker threads
+  bool _encodeMode;
+  unsigned _numActiveSlots;
+  unsigned _numJobThreads;
+  CObjectVector<CSlot> _slots;
+ #ifndef Z7_ST
+  CObjectVector<CCasThread> _threads;
+  // the slots are kept allocated, and their memory is reserved in memory budget
+  UInt64 _slotsMemUnit;
+  unsigned _slotsMemNum;
+ #endif
+
+  void InitProps();
+  HRESULT ReadManifest(IInStream *stream);
+  HRESULT PrepareStore(bool create);
+  HRESULT PrepareSlots(unsigned numSlots, bool encodeMode);
+  FString GetChunkPath(const Byte *hash, bool dirOnly) const;
+  void EncodeSlot(CSlot &slot, unsigned slotIndex);
+  void DecodeSlot(CSlot &slot);
+  void RunJobs();
+  HRESULT FlushSlots(CRecordVector<CChunkRef> &chunks);
+  HRESULT AddStream(ISequentialInStream *stream, CItem &item,
+      CRecordVector<CChunkRef> &chunks, CLocalProgress *lps);
+public:
+  // the thread with (threadIndex) processes slots (threadIndex + numJobThreads * k)
+  void RunJob(unsigned threadIndex);
+  CHandler():
+      _phySize(0),
+      _isArc(false),
+      _encodeMode(false),
+      _numActiveSlots(0),
+      _numJobThreads(1)
+     #ifndef Z7_ST
+      , _slotsMemUnit(0)
+      , _slotsMemNum(0)
+     #endif
+    { InitProps(); }
+ #ifndef Z7_ST
+  ~CHandler()
+  {
+    _threads.Clear();
+    MemBudget_Release(_slotsMemUnit, _slotsMemNum);
+  }
+ #endif
+};
+
+
+#ifndef Z7_ST
+
+void CCasThread::ThreadFunc()
+{
+  for (;;)
+  {
+    if (StartEvent.Lock() != 0 || Exit)
+      return;
+    Handler->RunJob(ThreadIndex);
+    FinishedEvent.Set();
+  }
+}
+
+static THREAD_FUNC_DECL CasThreadFunc(void *p)
+{
+  ((CCasThread *)p)->ThreadFunc();
+  return 0;
+}
+
+WRes CCasThread::Create()
+{
+  WRes             wres = StartEvent.CreateIfNotCreated_Reset();
+  if (wres == 0) { wres = FinishedEvent.CreateIfNotCreated_Reset();
+  if (wres == 0) { wres = Thread.Create(CasThreadFunc, this); }}
+  return wres;
+}
+
+#endif
+
+
+void CHandler::InitProps()
+{
+  _storeDir_Forced = false;
+  _level = 5;
+  _numThreads = 1;
+ #ifndef Z7_ST
+  _numThreads = NSystem::GetNumberOfProcessors();
+ #endif
+}
+
+static const Byte kProps[] =
+{
+  kpidPath,
+  kpidIsDir,
+  kpidSize,
+  kpidMTime,
+  kpidAttrib,
+  kpidNumBlocks
+};
+
+static const Byte kArcProps[] =
+{
+  kpidNumBlocks
+};
+
+IMP_IInArchive_Props
+IMP_IInArchive_ArcProps
+
+Z7_COM7F_IMF(CHandler::GetArchiveProperty(PROPID propID, PROPVARIANT *value))
+{
+  NCOM::CPropVariant prop;
+  switch (propID)
+  {
+    case kpidPhySize: if (_isArc) prop = _phySize; break;
+    case kpidNumBlocks: if (_isArc) prop = (UInt64)_chunks.Size(); break;
+    default: break;
+  }
+  prop.Detach(value);
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CHandler::GetNumberOfItems(UInt32 *numItems))
+{
+  *numItems = _items.Size();
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CHandler::GetProperty(UInt32 index, PROPID propID, PROPVARIANT *value))
+{
+  COM_TRY_BEGIN
+  NCOM::CPropVariant prop;
+  const CItem &item = _items[index];
+  switch (propID)
+  {
+    case kpidPath:
+    {
+      UString s;
+      ConvertUTF8ToUnicode(item.Name, s);
+      prop = NItemName::GetOsPath(s);
+      break;
+    }
+    case kpidIsDir: prop = item.IsDir; break;
+    case kpidSize: if (!item.IsDir) prop = item.Size; break;
+    case kpidMTime:
+      if (item.MTime_Defined)
+      {
+        FILETIME ft;
+        ft.dwLowDateTime = (DWORD)item.MTime;
+        ft.dwHighDateTime = (DWORD)(item.MTime >> 32);
+        prop = ft;
+      }
+      break;
+    case kpidAttrib: if (item.Attrib_Defined) prop = item.Attrib; break;
+    case kpidNumBlocks: if (!item.IsDir) prop = (UInt32)item.NumChunks; break;
+    default: break;
+  }
+  prop.Detach(value);
+  return S_OK;
+  COM_TRY_END
+}
+
+
+class CBodyReader
+{
+  const Byte *_p;
+  size_t _rem;
+public:
+  bool Error;
+  CBodyReader(const Byte *p, size_t size): _p(p), _rem(size), Error(false) {}
+  const Byte *Skip(size_t size)
+  {
+    if (Error || size > _rem)
+    {
+      Error = true;
+      return NULL;
+    }
+    const Byte *p = _p;
+    _p += size;
+    _rem -= size;
+    return p;
+  }
+  Byte ReadByte() { const Byte *p = Skip(1); return p ? *p : (Byte)0; }
+  UInt32 ReadUInt32() { const Byte *p = Skip(4); return p ? GetUi32(p) : 0; }
+  UInt64 ReadUInt64() { const Byte *p = Skip(8); return p ? GetUi64(p) : 0; }
+  void ReadString(AString &s)
+  {
+    const UInt32 len = ReadUInt32();
+    const Byte *p = Skip(len);
+    if (p)
+      s.SetFrom_CalcLen((const char *)p, len);
+    if (s.Len() != len)
+      Error = true;
+  }
+  bool IsFinished() const { return !Error && _rem == 0; }
+};
+
+HRESULT CHandler::ReadManifest(IInStream *stream)
+{
+  Byte header[kHeaderSize];
+  RINOK(ReadStream_FALSE(stream, header, kHeaderSize))
+  if (memcmp(header, kSignature, kSignatureSize) != 0
+      || header[kSignatureSize] != kVer_Major)
+    return S_FALSE;
+  const UInt32 crc = GetUi32(header + kSignatureSize + 2);
+  const UInt64 bodySize = GetUi64(header + kSignatureSize + 2 + 4);
+  if (bodySize > kBodySizeMax)
+    return S_FALSE;
+  CByteBuffer body((size_t)bodySize);
+  RINOK(ReadStream_FALSE(stream, body, (size_t)bodySize))
+  if (CrcCalc(body, (size_t)bodySize) != crc)
+    return S_FALSE;
+
+  CBodyReader r(body, (size_t)bodySize);
+  AString storeDir;
+  r.ReadString(storeDir);
+  const UInt32 numItems = r.ReadUInt32();
+  for (UInt32 i = 0; i < numItems && !r.Error; i++)
+  {
+    CItem item;
+    const Byte flags = r.ReadByte();
+    item.IsDir = (flags & kFlag_Dir) != 0;
+    item.Attrib_Defined = (flags & kFlag_Attrib) != 0;
+    item.MTime_Defined = (flags & kFlag_MTime) != 0;
+    if (item.Attrib_Defined)
+      item.Attrib = r.ReadUInt32();
+    if (item.MTime_Defined)
+      item.MTime = r.ReadUInt64();
+    item.Size = r.ReadUInt64();
+    r.ReadString(item.Name);
+    const UInt32 numChunks = r.ReadUInt32();
+    // each chunk reference takes (kHashSize + 4) bytes
+    if (numChunks > (kBodySizeMax / (kHashSize + 4)))
+      return S_FALSE;
+    item.ChunkStart = _chunks.Size();
+    item.NumChunks = numChunks;
+    UInt64 size = 0;
+    for (UInt32 k = 0; k < numChunks; k++)
+    {
+      CChunkRef ref;
+      const Byte *p = r.Skip(kHashSize);
+      if (!p)
+        return S_FALSE;
+      memcpy(ref.Hash, p, kHashSize);
+      ref.Size = r.ReadUInt32();
+      if (ref.Size == 0 || ref.Size > kChunkSizeMax)
+        return S_FALSE;
+      size += ref.Size;
+      _chunks.Add(ref);
+    }
+    if (r.Error || size != item.Size || (item.IsDir && numChunks != 0))
+      return S_FALSE;
+    _items.Add(item);
+  }
+  if (!r.IsFinished())
+    return S_FALSE;
+
+  if (!_storeDir_Forced)
+    ConvertUTF8ToUnicode(storeDir, _storeDir);
+  _phySize = kHeaderSize + bodySize;
+  _isArc = true;
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CHandler::Open(IInStream *stream, const UInt64 *, IArchiveOpenCallback *))
+{
+  COM_TRY_BEGIN
+  Close();
+  const HRESULT res = ReadManifest(stream);
+  if (res != S_OK)
+    Close();
+  return res;
+  COM_TRY_END
+}
+
+Z7_COM7F_IMF(CHandler::Close())
+{
+  _items.Clear();
+  _chunks.Clear();
+  _phySize = 0;
+  _isArc = false;
+  if (!_storeDir_Forced)
+    _storeDir.Empty();
+  return S_OK;
+}
+
+
+HRESULT CHandler::PrepareStore(bool create)
+{
+  if (_storeDir.IsEmpty())
+    return E_INVALIDARG;
+  FString path = us2fs(_storeDir);
+  if (create)
+  {
+    if (!NDir::CreateComplexDir(path))
+      return GetLastError_noZero_HRESULT();
+  }
+  if (!NDir::MyGetFullPathName(path, _storePrefix))
+    return GetLastError_noZero_HRESULT();
+  NName::NormalizeDirPathPrefix(_storePrefix);
+  return S_OK;
+}
+
+HRESULT CHandler::PrepareSlots(unsigned numSlots, bool encodeMode)
+{
+  if (numSlots > kNumSlotsMax)
+    numSlots = kNumSlotsMax;
+  if (numSlots == 0)
+    numSlots = 1;
+  if (_slots.Size() < numSlots)
+  {
+   #ifndef Z7_ST
+    /* we reserve the memory for new slots.
+       The first slot always gets the reservation.
+       The unit is selected at first allocation, because the slots are reused. */
+    unsigned num;
+    if (_slots.IsEmpty())
+    {
+      _slotsMemUnit = kChunkSizeMax + kChunkPackBufSize;
+      if (encodeMode && _level != 0)
+      {
+        CLzmaEncProps props;
+        LzmaEncProps_Init(&props);
+        props.level = (int)_level;
+        props.dictSize = kChunkSizeMax;
+        props.reduceSize = kChunkSizeMax;
+        props.numThreads = 1;
+        _slotsMemUnit += LzmaEncProps_GetMemUsage(&props);
+      }
+      num = MemBudget_Reserve(_slotsMemUnit, numSlots);
+    }
+    else
+      num = MemBudget_Reserve_Optional(_slotsMemUnit, numSlots - _slots.Size());
+    _slotsMemNum += num;
+    numSlots = _slots.Size() + num;
+   #else
+    UNUSED_VAR(encodeMode)
+   #endif
+    while (_slots.Size() < numSlots)
+    {
+      if (!_slots.AddNew().Alloc())
+      {
+        _slots.DeleteBack();
+        break;
+      }
+    }
+   #ifndef Z7_ST
+    MemBudget_Release(_slotsMemUnit, numSlots - _slots.Size());
+    _slotsMemNum -= numSlots - _slots.Size();
+   #endif
+    if (_slots.IsEmpty())
+      return E_OUTOFMEMORY;
+  }
+
+ #ifndef Z7_ST
+  const unsigned numThreads = _numThreads < _slots.Size() ? (unsigned)_numThreads : _slots.Size();
+  if (numThreads > 1)
+  {
+    while (_threads.Size() < numThreads)
+    {
+      CCasThread &t = _threads.AddNew();
+      t.Handler = this;
+      t.ThreadIndex = _threads.Size() - 1;
+      if (t.Create() != 0)
+      {
+        _threads.DeleteBack();
+        break;
+      }
+    }
+  }
+ #endif
+  return S_OK;
+}
+
+FString CHandler::GetChunkPath(const Byte *hash, bool dirOnly) const
+{
+  char s[kHashSize * 2 + 1];
+  ConvertDataToHex_Lower(s, hash, kHashSize);
+  FString path = _storePrefix;
+  path += (FChar)s[0];
+  path += (FChar)s[1];
+  if (!dirOnly)
+  {
+    path.Add_PathSepar();
+    path += fas2fs(s);
+  }
+  return path;
+}
+
+void CHandler::RunJob(unsigned threadIndex)
+{
+  for (unsigned i = threadIndex; i < _numActiveSlots; i += _numJobThreads)
+  {
+    CSlot &slot = _slots[i];
+    if (_encodeMode)
+      EncodeSlot(slot, i);
+    else
+      DecodeSlot(slot);
+  }
+}
+
+void CHandler::RunJobs()
+{
+  _numJobThreads = 1;
+ #ifndef Z7_ST
+  if (_threads.Size() > 1)
+  {
+    /* the threads are from process-wide pool.
+       We reserve them from the limit of pool for each group of slots,
+       because the handler can wait for input data for long time between groups. */
+    const unsigned numReserved = ThreadPool_Reserve(_threads.Size());
+    if (numReserved > 1)
+    {
+      _numJobThreads = numReserved;
+      unsigned i;
+      for (i = 0; i < numReserved; i++)
+        _threads[i].StartEvent.Set();
+      for (i = 0; i < numReserved; i++)
+        _threads[i].FinishedEvent.Lock();
+      ThreadPool_Release(numReserved);
+      return;
+    }
+    ThreadPool_Release(numReserved);
+  }
+ #endif
+  RunJob(0);
+}
+
+
+void CHandler::EncodeSlot(CSlot &slot, unsigned slotIndex)
+{
+  slot.Res = S_OK;
+  slot.CalcHash(slot.Data, slot.Size, slot.Hash);
+  const FString path = GetChunkPath(slot.Hash, false);
+  if (NFind::DoesFileExist_Raw(path))
+    return;
+
+  Byte *p = slot.Packed;
+  p[0] = NMethod::kCopy;
+  p[1] = 0;
+  p[2] = 0;
+  p[3] = 0;
+  SetUi32(p + 4, slot.Size)
+  size_t packSize = 0;
+
+  if (_level != 0)
+  {
+    CLzmaEncProps props;
+    LzmaEncProps_Init(&props);
+    props.level = (int)_level;
+    props.dictSize = kChunkSizeMax;
+    props.reduceSize = slot.Size;
+    props.numThreads = 1;
+    SizeT propsSize = LZMA_PROPS_SIZE;
+    // packed chunk must be smaller than unpacked chunk
+    SizeT destLen = slot.Size - 1;
+    const SRes sres = LzmaEncode(p + kChunkHeaderSize + LZMA_PROPS_SIZE, &destLen,
+        slot.Data, slot.Size, &props, p + kChunkHeaderSize, &propsSize, 0,
+        NULL, &g_Alloc, &g_BigAlloc);
+    if (sres == SZ_OK && propsSize == LZMA_PROPS_SIZE)
+    {
+      p[0] = NMethod::kLZMA;
+      packSize = LZMA_PROPS_SIZE + destLen;
+    }
+    else if (sres != SZ_OK && sres != SZ_ERROR_OUTPUT_EOF)
+    {
+      slot.Res = SResToHRESULT(sres);
+      return;
+    }
+  }
+
+  // each slot uses its own temp file, because identical chunks can be in different slots
+  AString suffix (".");
+  suffix.Add_UInt32(slotIndex);
+  suffix += ".tmp";
+  FString tempPath = path;
+  tempPath += fas2fs(suffix);
+
+  NIO::COutFile file;
+  if (!file.Create_ALWAYS(tempPath))
+  {
+    if (!NDir::CreateComplexDir(GetChunkPath(slot.Hash, true))
+        || !file.Create_ALWAYS(tempPath))
+    {
+      slot.Res = GetLastError_noZero_HRESULT();
+      return;
+    }
+  }
+  bool ok;
+  if (packSize != 0)
+    ok = file.WriteFull(p, kChunkHeaderSize + packSize);
+  else
+    ok = file.WriteFull(p, kChunkHeaderSize)
+      && file.WriteFull(slot.Data, slot.Size);
+  if (!ok)
+    slot.Res = GetLastError_noZero_HRESULT();
+  if (!file.Close() && ok)
+  {
+    ok = false;
+    slot.Res = GetLastError_noZero_HRESULT();
+  }
+  if (ok && !NDir::MyMoveFile(tempPath, path))
+  {
+    /* another slot in the same window can contain the same chunk,
+       and it can create the chunk file before us. MyMoveFile() in Windows
+       doesn't replace existing file. The files for same hash are identical,
+       so we just delete our temp file in that case. */
+    const HRESULT hres = GetLastError_noZero_HRESULT();
+    ok = false;
+    if (!NFind::DoesFileExist_Raw(path))
+      slot.Res = hres;
+  }
+  if (!ok)
+    NDir::DeleteFileAlways(tempPath);
+}
+
+
+void CHandler::DecodeSlot(CSlot &slot)
+{
+  slot.Res = S_OK;
+  slot.Out = NULL;
+  const CChunkRef &ref = _chunks[slot.ChunkIndex];
+  slot.Size = ref.Size;
+  slot.OpRes = NExtract::NOperationResult::kUnavailable;
+  NIO::CInFile file;
+  if (!file.Open(GetChunkPath(ref.Hash, false)))
+    return;
+  slot.OpRes = NExtract::NOperationResult::kDataError;
+  UInt64 fileSize;
+  if (!file.GetLength(fileSize))
+  {
+    slot.Res = GetLastError_noZero_HRESULT();
+    return;
+  }
+  if (fileSize < kChunkHeaderSize || fileSize > kChunkPackBufSize)
+    return;
+  size_t processed;
+  if (!file.ReadFull(slot.Packed, (size_t)fileSize, processed))
+  {
+    slot.Res = GetLastError_noZero_HRESULT();
+    return;
+  }
+  if (processed != fileSize)
+    return;
+  const Byte *p = slot.Packed;
+  if (GetUi32(p + 4) != ref.Size)
+    return;
+  const size_t packSize = (size_t)fileSize - kChunkHeaderSize;
+  if (p[0] == NMethod::kCopy)
+  {
+    if (packSize != ref.Size)
+      return;
+    slot.Out = p + kChunkHeaderSize;
+  }
+  else if (p[0] == NMethod::kLZMA)
+  {
+    if (packSize < LZMA_PROPS_SIZE)
+      return;
+    SizeT destLen = ref.Size;
+    SizeT srcLen = packSize - LZMA_PROPS_SIZE;
+    ELzmaStatus status;
+    const SRes sres = LzmaDecode(slot.Data, &destLen,
+        p + kChunkHeaderSize + LZMA_PROPS_SIZE, &srcLen,
+        p + kChunkHeaderSize, LZMA_PROPS_SIZE, LZMA_FINISH_END, &status, &g_Alloc);
+    if (sres == SZ_ERROR_MEM)
+    {
+      slot.Res = E_OUTOFMEMORY;
+      return;
+    }
+    if (sres != SZ_OK || destLen != ref.Size || srcLen != packSize - LZMA_PROPS_SIZE)
+      return;
+    slot.Out = slot.Data;
+  }
+  else
+  {
+    slot.OpRes = NExtract::NOperationResult::kUnsupportedMethod;
+    return;
+  }
+  slot.CalcHash(slot.Out, ref.Size, slot.Hash);
+  if (memcmp(slot.Hash, ref.Hash, kHashSize) != 0)
+  {
+    slot.Out = NULL;
+    slot.OpRes = NExtract::NOperationResult::kCRCError;
+    return;
+  }
+  slot.OpRes = NExtract::NOperationResult::kOK;
+}
+
+
+Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
+    Int32 testMode, IArchiveExtractCallback *extractCallback))
+{
+  COM_TRY_BEGIN
+  const bool allFilesMode = (numItems == (UInt32)(Int32)-1);
+  if (allFilesMode)
+    numItems = _items.Size();
+  if (numItems == 0)
+    return S_OK;
+  UInt64 totalSize = 0;
+  UInt32 i;
+
+  /* (plan) is the list of chunks in extraction order.
+     Worker threads decode a window of chunks from (plan),
+     and the main thread writes the decoded chunks to output streams. */
+  CRecordVector<unsigned> plan;
+  for (i = 0; i < numItems; i++)
+  {
+    const CItem &item = _items[allFilesMode ? i : indices[i]];
+    totalSize += item.Size;
+    for (unsigned k = 0; k < item.NumChunks; k++)
+      plan.Add(item.ChunkStart + k);
+  }
+  RINOK(extractCallback->SetTotal(totalSize))
+
+  if (!plan.IsEmpty())
+  {
+    RINOK(PrepareStore(false))
+    RINOK(PrepareSlots(_numThreads * 2, false))
+  }
+
+  CMyComPtr2_Create<ICompressProgressInfo, CLocalProgress> lps;
+  lps->Init(extractCallback, false);
+
+  _encodeMode = false;
+  unsigned planPos = 0;
+  unsigned winStart = 0;
+  _numActiveSlots = 0;
+  UInt64 currentTotalSize = 0;
+
+  for (i = 0;; i++)
+  {
+    lps->InSize = lps->OutSize = currentTotalSize;
+    RINOK(lps->SetCur())
+    if (i >= numItems)
+      break;
+    CMyComPtr<ISequentialOutStream> realOutStream;
+    const Int32 askMode = testMode ?
+        NExtract::NAskMode::kTest :
+        NExtract::NAskMode::kExtract;
+    const UInt32 index = allFilesMode ? i : indices[i];
+    const CItem &item = _items[index];
+    RINOK(extractCallback->GetStream(index, &realOutStream, askMode))
+    currentTotalSize += item.Size;
+
+    if (!testMode && !realOutStream)
+    {
+      planPos += item.NumChunks;
+      continue;
+    }
+    RINOK(extractCallback->PrepareOperation(askMode))
+    Int32 opRes = NExtract::NOperationResult::kOK;
+
+    for (unsigned k = 0; k < item.NumChunks; k++, planPos++)
+    {
+      if (planPos >= winStart + _numActiveSlots)
+      {
+        winStart = planPos;
+        unsigned num = plan.Size() - planPos;
+        if (num > _slots.Size())
+          num = _slots.Size();
+        for (unsigned s = 0; s < num; s++)
+          _slots[s].ChunkIndex = plan[planPos + s];
+        _numActiveSlots = num;
+        RunJobs();
+      }
+      const CSlot &slot = _slots[planPos - winStart];
+      RINOK(slot.Res)
+      if (opRes != NExtract::NOperationResult::kOK)
+        continue;
+      if (slot.OpRes != NExtract::NOperationResult::kOK)
+      {
+        opRes = slot.OpRes;
+        continue;
+      }
+      if (realOutStream)
+        RINOK(WriteStream(realOutStream, slot.Out, slot.Size))
+      lps->InSize = lps->OutSize = lps->OutSize + slot.Size;
+      RINOK(lps->SetCur())
+    }
+    realOutStream.Release();
+    RINOK(extractCallback->SetOperationResult(opRes))
+  }
+  return S_OK;
+  COM_TRY_END
+}
+
+
+Z7_COM7F_IMF(CHandler::GetFileTimeType(UInt32 *type))
+{
+  *type = NFileTimeType::kWindows;
+  return S_OK;
+}
+
+static HRESULT GetPropBool(IArchiveUpdateCallback *callback, UInt32 index, PROPID propId, bool &res)
+{
+  NCOM::CPropVariant prop;
+  RINOK(callback->GetProperty(index, propId, &prop))
+  if (prop.vt == VT_EMPTY)
+    res = false;
+  else if (prop.vt == VT_BOOL)
+    res = VARIANT_BOOLToBool(prop.boolVal);
+  else
+    return E_INVALIDARG;
+  return S_OK;
+}
+
+HRESULT CHandler::FlushSlots(CRecordVector<CChunkRef> &chunks)
+{
+  if (_numActiveSlots == 0)
+    return S_OK;
+  RunJobs();
+  for (unsigned i = 0; i < _numActiveSlots; i++)
+  {
+    const CSlot &slot = _slots[i];
+    RINOK(slot.Res)
+    memcpy(chunks[slot.ChunkIndex].Hash, slot.Hash, kHashSize);
+  }
+  _numActiveSlots = 0;
+  return S_OK;
+}
+
+HRESULT CHandler::AddStream(ISequentialInStream *stream, CItem &item,
+    CRecordVector<CChunkRef> &chunks, CLocalProgress *lps)
+{
+  CMidBuffer buf;
+  buf.Alloc(kInBufSize);
+  if (!buf.IsAllocated())
+    return E_OUTOFMEMORY;
+  size_t bufPos = 0;
+  size_t bufSize = 0;
+  bool eof = false;
+
+  for (;;)
+  {
+    if (!eof && bufSize - bufPos < kChunkSizeMax)
+    {
+      bufSize -= bufPos;
+      if (bufSize != 0)
+        memmove(buf, buf + bufPos, bufSize);
+      bufPos = 0;
+      const size_t rem = kInBufSize - bufSize;
+      size_t processed = rem;
+      RINOK(ReadStream(stream, buf + bufSize, &processed))
+      bufSize += processed;
+      eof = (processed != rem);
+    }
+    if (bufPos == bufSize)
+      return S_OK;
+    const size_t size = FindChunkBoundary(buf + bufPos, bufSize - bufPos);
+
+    if (_numActiveSlots == _slots.Size())
+    {
+      RINOK(FlushSlots(chunks))
+    }
+    CSlot &slot = _slots[_numActiveSlots++];
+    memcpy(slot.Data, buf + bufPos, size);
+    slot.Size = (UInt32)size;
+    slot.ChunkIndex = chunks.Size();
+    {
+      CChunkRef ref;
+      memset(ref.Hash, 0, kHashSize);
+      ref.Size = (UInt32)size;
+      chunks.Add(ref);
+    }
+    item.NumChunks++;
+    item.Size += size;
+    bufPos += size;
+
+    lps->InSize += size;
+    RINOK(lps->SetCur())
+  }
+}
+
+Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outStream, UInt32 numItems,
+    IArchiveUpdateCallback *callback))
+{
+  COM_TRY_BEGIN
+  if (!callback)
+    return E_FAIL;
+
+  UInt64 complexity = 0;
+  UInt32 i;
+  for (i = 0; i < numItems; i++)
+  {
+    Int32 newData, newProps;
+    UInt32 indexInArc;
+    RINOK(callback->GetUpdateItemInfo(i, &newData, &newProps, &indexInArc))
+    if (IntToBool(newData))
+    {
+      NCOM::CPropVariant prop;
+      RINOK(callback->GetProperty(i, kpidSize, &prop))
+      if (prop.vt == VT_UI8)
+        complexity += prop.uhVal.QuadPart;
+    }
+  }
+  RINOK(callback->SetTotal(complexity))
+
+  RINOK(PrepareStore(true))
+  RINOK(PrepareSlots(_numThreads * 2, true))
+  _encodeMode = true;
+  _numActiveSlots = 0;
+
+  CMyComPtr2_Create<ICompressProgressInfo, CLocalProgress> lps;
+  lps->Init(callback, true);
+
+  CObjectVector<CItem> items;
+  CRecordVector<CChunkRef> chunks;
+
+  for (i = 0; i < numItems; i++)
+  {
+    Int32 newData, newProps;
+    UInt32 indexInArc;
+    RINOK(callback->GetUpdateItemInfo(i, &newData, &newProps, &indexInArc))
+    CItem item;
+
+    if (IntToBool(newProps))
+    {
+      RINOK(GetPropBool(callback, i, kpidIsDir, item.IsDir))
+      {
+        NCOM::CPropVariant prop;
+        RINOK(callback->GetProperty(i, kpidPath, &prop))
+        if (prop.vt != VT_BSTR)
+          return E_INVALIDARG;
+        UString name (prop.bstrVal);
+        NItemName::ReplaceSlashes_OsToUnix(name);
+        ConvertUnicodeToUTF8(name, item.Name);
+      }
+      {
+        NCOM::CPropVariant prop;
+        RINOK(callback->GetProperty(i, kpidMTime, &prop))
+        if (prop.vt == VT_FILETIME)
+        {
+          item.MTime = prop.filetime.dwLowDateTime | ((UInt64)prop.filetime.dwHighDateTime << 32);
+          item.MTime_Defined = true;
+        }
+        else if (prop.vt != VT_EMPTY)
+          return E_INVALIDARG;
+      }
+      {
+        NCOM::CPropVariant prop;
+        RINOK(callback->GetProperty(i, kpidAttrib, &prop))
+        if (prop.vt == VT_UI4)
+        {
+          item.Attrib = prop.ulVal;
+          item.Attrib_Defined = true;
+        }
+        else if (prop.vt != VT_EMPTY)
+          return E_INVALIDARG;
+      }
+    }
+    else
+    {
+      if (indexInArc >= _items.Size())
+        return E_INVALIDARG;
+      item = _items[indexInArc];
+    }
+
+    item.ChunkStart = chunks.Size();
+
+    if (!IntToBool(newData))
+    {
+      if (indexInArc >= _items.Size())
+        return E_INVALIDARG;
+      const CItem &old = _items[indexInArc];
+      item.Size = old.Size;
+      item.NumChunks = old.NumChunks;
+      for (unsigned k = 0; k < old.NumChunks; k++)
+        chunks.Add(_chunks[old.ChunkStart + k]);
+    }
+    else
+    {
+      item.Size = 0;
+      item.NumChunks = 0;
+      if (!item.IsDir)
+      {
+        CMyComPtr<ISequentialInStream> fileInStream;
+        const HRESULT res = callback->GetStream(i, &fileInStream);
+        if (res == S_FALSE)
+          continue;
+        RINOK(res)
+        if (fileInStream)
+          RINOK(AddStream(fileInStream, item, chunks, lps.ClsPtr()))
+      }
+      RINOK(callback->SetOperationResult(NUpdate::NOperationResult::kOK))
+    }
+    items.Add(item);
+  }
+  RINOK(FlushSlots(chunks))
+
+  CByteDynamicBuffer body;
+  {
+    Byte temp[8];
+    AString s;
+    ConvertUnicodeToUTF8(fs2us(_storePrefix), s);
+    SetUi32(temp, s.Len())
+    body.AddData(temp, 4);
+    body.AddData((const Byte *)s.Ptr(), s.Len());
+    SetUi32(temp, items.Size())
+    body.AddData(temp, 4);
+    FOR_VECTOR (k, items)
+    {
+      const CItem &item = items[k];
+      Byte flags = 0;
+      if (item.IsDir) flags |= kFlag_Dir;
+      if (item.Attrib_Defined) flags |= kFlag_Attrib;
+      if (item.MTime_Defined) flags |= kFlag_MTime;
+      body.AddData(&flags, 1);
+      if (item.Attrib_Defined)
+      {
+        SetUi32(temp, item.Attrib)
+        body.AddData(temp, 4);
+      }
+      if (item.MTime_Defined)
+      {
+        SetUi64(temp, item.MTime)
+        body.AddData(temp, 8);
+      }
+      SetUi64(temp, item.Size)
+      body.AddData(temp, 8);
+      SetUi32(temp, item.Name.Len())
+      body.AddData(temp, 4);
+      body.AddData((const Byte *)item.Name.Ptr(), item.Name.Len());
+      SetUi32(temp, item.NumChunks)
+      body.AddData(temp, 4);
+      for (unsigned c = 0; c < item.NumChunks; c++)
+      {
+        const CChunkRef &ref = chunks[item.ChunkStart + c];
+        body.AddData(ref.Hash, kHashSize);
+        SetUi32(temp, ref.Size)
+        body.AddData(temp, 4);
+      }
+    }
+  }
+
+  const size_t bodySize = body.GetPos();
+  if (bodySize > kBodySizeMax)
+    return E_FAIL;
+  Byte header[kHeaderSize];
+  memcpy(header, kSignature, kSignatureSize);
+  header[kSignatureSize] = kVer_Major;
+  header[kSignatureSize + 1] = kVer_Minor;
+  SetUi32(header + kSignatureSize + 2, CrcCalc(body, bodySize))
+  SetUi64(header + kSignatureSize + 2 + 4, bodySize)
+  RINOK(WriteStream(outStream, header, kHeaderSize))
+  return WriteStream(outStream, body, bodySize);
+  COM_TRY_END
+}
+
+
+Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVARIANT *values, UInt32 numProps))
+{
+  InitProps();
+
+  for (UInt32 i = 0; i < numProps; i++)
+  {
+    UString name = names[i];
+    name.MakeLower_Ascii();
+    if (name.IsEmpty())
+      return E_INVALIDARG;
+    const PROPVARIANT &prop = values[i];
+
+    if (name[0] == L'x')
+    {
+      UInt32 level = 9;
+      RINOK(ParsePropToUInt32(name.Ptr(1), prop, level))
+      if (level > 9)
+        return E_INVALIDARG;
+      _level = level;
+    }
+    else if (name.IsPrefixedBy_Ascii_NoCase("mt"))
+    {
+     #ifndef Z7_ST
+      RINOK(ParseMtProp(name.Ptr(2), prop, NSystem::GetNumberOfProcessors(), _numThreads))
+     #endif
+    }
+    else if (name.IsEqualTo("store"))
+    {
+      if (prop.vt != VT_BSTR)
+        return E_INVALIDARG;
+      _storeDir = prop.bstrVal;
+      _storeDir_Forced = !_storeDir.IsEmpty();
+    }
+    else
+      return E_INVALIDARG;
+  }
+  return S_OK;
+}
+
+
+REGISTER_ARC_IO(
+  "Cas", "cas", NULL, 0xBE,
+  kSignature, 0,
+  0,
+  TIME_PREC_TO_ARC_FLAGS_MASK (NFileTimeType::kWindows)
+  | TIME_PREC_TO_ARC_FLAGS_TIME_DEFAULT (NFileTimeType::kWindows),
+  NULL)
+
+}}
@@ -2,6 +2,8 @@
 
 #include "StdAfx.h"
 
+#include "../../Common/StageStats.h"
+
 #include "CoderMixer2.h"
 
 #ifdef USE_MIXER_ST
@@ -901,6 +903,14 @@ void CCoderMT::Code(ICompressProgressInfo *progress)
   */
 
   CReleaser releaser(*this);
+
+  /* the time of waiting in CStreamBinder (the pipes between coders)
+     is excluded from stage time by NStageStats::CWaitTimer. */
+  NStageStats::CTimer stageTimer(
+      IsFilter ? NStageStats::kStage_Filter :
+      EncodeMode ? NStageStats::kStage_Encode : NStageStats::kStage_Decode);
+  if (UnpackSizePointer)
+    stageTimer.Size = *UnpackSizePointer;
   
   if (Coder)
     Result = Coder->Code(InStreamPointers[0], OutStreamPointers[0],
@@ -937,6 +947,7 @@ void CMixerMT::AddCoder(const CCreatedCoder &cod)
   c2.Coder = cod.Coder;
   c2.Coder2 = cod.Coder2;
   c2.EncodeMode = EncodeMode;
+  c2.IsFilter = cod.IsFilter;
 }
 
 CCoder &CMixerMT::GetCoder(unsigned index)
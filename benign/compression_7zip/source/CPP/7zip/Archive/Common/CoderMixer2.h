@@ -368,6 +368,7 @@ private:
   virtual void Execute() Z7_override;
 public:
   bool EncodeMode;
+  bool IsFilter;
   HRESULT Result;
   CObjectVector< CMyComPtr<ISequentialInStream> > InStreams;
   CObjectVector< CMyComPtr<ISequentialOutStream> > OutStreams;
@@ -392,7 +393,7 @@ public:
     ~CReleaser() { _c.Release(); }
   };
 
-  CCoderMT(): EncodeMode(false) {}
+  CCoderMT(): EncodeMode(false), IsFilter(false) {}
   ~CCoderMT() Z7_DESTRUCTOR_override
   {
     /* WaitThreadFinish() will be called in ~CVirtThread().
@@ -4,45 +4,71 @@
 
 #include "MultiStream.h"
 
-Z7_COM7F_IMF(CMultiStream::Read(void *data, UInt32 size, UInt32 *processedSize))
-{
-  if (processedSize)
-    *processedSize = 0;
-  if (size == 0)
-    return S_OK;
-  if (_pos >= _totalLength)
-    return S_OK;
+// (pos < _totalLength) is required. (mid) is the index to check first.
 
+unsigned CMultiStream::FindStream(UInt64 pos, unsigned mid) const
+{
+  unsigned left = 0, right = Streams.Size();
+  for (;;)
   {
-    unsigned left = 0, mid = _streamIndex, right = Streams.Size();
-    for (;;)
-    {
-      CSubStreamInfo &m = Streams[mid];
-      if (_pos < m.GlobalOffset)
-        right = mid;
-      else if (_pos >= m.GlobalOffset + m.Size)
-        left = mid + 1;
-      else
-        break;
-      mid = (left + right) / 2;
-    }
-    _streamIndex = mid;
-  }
-  
-  CSubStreamInfo &s = Streams[_streamIndex];
-  UInt64 localPos = _pos - s.GlobalOffset;
-  if (localPos != s.LocalPos)
-  {
-    RINOK(s.Stream->Seek((Int64)localPos, STREAM_SEEK_SET, &s.LocalPos))
+    const CSubStreamInfo &m = Streams[mid];
+    if (pos < m.GlobalOffset)
+      right = mid;
+    else if (pos >= m.GlobalOffset + m.Size)
+      left = mid + 1;
+    else
+      return mid;
+    mid = (left + right) / 2;
   }
+}
+
+HRESULT CMultiStream::ReadFromStream(CSubStreamInfo &s, UInt64 pos, void *data, UInt32 size, UInt32 *processedSize)
+{
+  const UInt64 localPos = pos - s.GlobalOffset;
   {
     const UInt64 rem = s.Size - localPos;
     if (size > rem)
       size = (UInt32)rem;
   }
+ #ifndef Z7_ST
+  NWindows::NSynchronization::CCriticalSectionLock lock(s.CS);
+ #endif
+  if (localPos != s.LocalPos)
+  {
+    RINOK(s.Stream->Seek((Int64)localPos, STREAM_SEEK_SET, &s.LocalPos))
+  }
   const HRESULT result = s.Stream->Read(data, size, &size);
-  _pos += size;
   s.LocalPos += size;
+  *processedSize = size;
+  return result;
+}
+
+Z7_COM7F_IMF(CMultiStream::Read(void *data, UInt32 size, UInt32 *processedSize))
+{
+  if (processedSize)
+    *processedSize = 0;
+  if (size == 0)
+    return S_OK;
+  if (_pos >= _totalLength)
+    return S_OK;
+  _streamIndex = FindStream(_pos, _streamIndex);
+  const HRESULT result = ReadFromStream(Streams[_streamIndex], _pos, data, size, &size);
+  _pos += size;
+  if (processedSize)
+    *processedSize = size;
+  return result;
+}
+
+Z7_COM7F_IMF(CMultiStream::ReadAt(UInt64 pos, void *data, UInt32 size, UInt32 *processedSize))
+{
+  if (processedSize)
+    *processedSize = 0;
+  if (size == 0)
+    return S_OK;
+  if (pos >= _totalLength)
+    return S_OK;
+  const unsigned index = FindStream(pos, Streams.Size() / 2);
+  const HRESULT result = ReadFromStream(Streams[index], pos, data, size, &size);
   if (processedSize)
     *processedSize = size;
   return result;
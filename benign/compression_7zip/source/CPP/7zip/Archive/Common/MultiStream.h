@@ -6,12 +6,30 @@
 #include "../../../Common/MyCom.h"
 #include "../../../Common/MyVector.h"
 
+#ifndef Z7_ST
+#include "../../../Windows/Synchronization.h"
+#endif
+
 #include "../../IStream.h"
 #include "../../Archive/IArchive.h"
 
-Z7_CLASS_IMP_IInStream(
-  CMultiStream
-)
+/*
+CMultiStream joins the volumes to one stream.
+  The volume for offset is found with binary search in (GlobalOffset) values.
+  ReadAt() (IInStreamReadAt) can be called from different threads:
+  each volume is protected by its own lock, so the threads that read
+  different volumes don't wait each other.
+*/
+
+Z7_class_final(CMultiStream):
+    public IInStream
+  , public IInStreamReadAt
+  , public CMyUnknownImp
+{
+  Z7_IFACES_IMP_UNK_3(
+    IInStream,
+    ISequentialInStream,
+    IInStreamReadAt)
 
   unsigned _streamIndex;
   UInt64 _pos;
@@ -25,9 +43,17 @@ public:
     UInt64 Size;
     UInt64 GlobalOffset;
     UInt64 LocalPos;
+   #ifndef Z7_ST
+    NWindows::NSynchronization::CCriticalSection CS;
+   #endif
     CSubStreamInfo(): Size(0), GlobalOffset(0), LocalPos(0) {}
   };
 
+private:
+  unsigned FindStream(UInt64 pos, unsigned mid) const;
+  HRESULT ReadFromStream(CSubStreamInfo &s, UInt64 pos, void *data, UInt32 size, UInt32 *processedSize);
+public:
+
   CMyComPtr<IArchiveUpdateCallbackFile> updateCallbackFile;
   CObjectVector<CSubStreamInfo> Streams;
  
@@ -487,12 +487,16 @@ HRESULT CInArchive::GetNextItem()
 
 
 
-Z7_CLASS_IMP_CHandler_IInArchive_1(
-  IInArchiveGetStream
+static const unsigned kSymLinkDataSize_Max = 1 << 12;
+
+Z7_CLASS_IMP_CHandler_IInArchive_2(
+    IArchiveOpenSeq
+  , IInArchiveGetStream
 )
   CObjectVector<CItem> _items;
   CMyComPtr<IInStream> _stream;
   UInt64 _phySize;
+  bool _phySize_Defined; // it's false in sequential mode until the end of archive
   EType _type;
   EErrorType _error;
   bool _isArc;
@@ -500,6 +504,21 @@ Z7_CLASS_IMP_CHandler_IInArchive_1(
   bool _numLinks_Error;
   bool _pad_Error;
   bool _symLink_Error;
+
+  /* sequential mode (OpenSeq): we keep only the latest item header,
+     so the memory usage doesn't depend on the number of items */
+  CMyComPtr<ISequentialInStream> _seqStream;
+  UInt32 _curIndex;
+  bool _latestIsRead;
+  UInt64 _latestDataRem; // the size of data of latest item that was not read from _seqStream
+  CInArchive _arc;
+
+  CMyComPtr2_Create<ICompressCoder, NCompress::CCopyCoder> copyCoder;
+
+  HRESULT ReadSymLinkData(ISequentialInStream *stream, CItem &item, bool &unexpectedEnd);
+  HRESULT ReadLatestItem();
+  HRESULT SkipLatestData();
+  HRESULT SkipTo(UInt32 index);
 };
 
 static const Byte kArcProps[] =
@@ -538,8 +557,12 @@ Z7_COM7F_IMF(CHandler::GetArchiveProperty(PROPID propID, PROPVARIANT *value))
   NCOM::CPropVariant prop;
   switch (propID)
   {
-    case kpidSubType: prop = k_Types[(unsigned)_type]; break;
-    case kpidPhySize: prop = _phySize; break;
+    case kpidSubType:
+      // in sequential mode the type is known after first header only
+      if (_stream || _latestIsRead || _curIndex != 0)
+        prop = k_Types[(unsigned)_type];
+      break;
+    case kpidPhySize: if (_phySize_Defined) prop = _phySize; break;
     case kpidINode: prop = true; break;
     case kpidErrorFlags:
     {
@@ -602,6 +625,35 @@ static int CompareItems(const unsigned *p1, const unsigned *p2, void *param)
 }
 
 
+HRESULT CHandler::ReadSymLinkData(ISequentialInStream *stream, CItem &item, bool &unexpectedEnd)
+{
+  const UInt64 dataSize = item.GetPackSize();
+  size_t cur = (size_t)dataSize;
+  CByteBuffer buf;
+  buf.Alloc(cur);
+  RINOK(ReadStream(stream, buf, &cur))
+  unexpectedEnd = (cur != dataSize);
+  if (unexpectedEnd)
+    return S_OK;
+  size_t i;
+  
+  for (i = (size_t)item.Size; i < dataSize; i++)
+    if (buf[i] != 0)
+      break;
+  if (i != dataSize)
+    _pad_Error = true;
+
+  for (i = 0; i < (size_t)item.Size; i++)
+    if (buf[i] == 0)
+      break;
+  if (i != (size_t)item.Size)
+    _symLink_Error = true;
+  else
+    item.Data.CopyFrom(buf, (size_t)item.Size);
+  return S_OK;
+}
+
+
 Z7_COM7F_IMF(CHandler::Open(IInStream *stream, const UInt64 *, IArchiveOpenCallback *callback))
 {
   COM_TRY_BEGIN
@@ -660,32 +712,15 @@ Z7_COM7F_IMF(CHandler::Open(IInStream *stream, const UInt64 *, IArchiveOpenCallb
         break;
       }
         
-      if (item.Is_SymLink() && dataSize <= (1 << 12) && item.Size != 0)
+      if (item.Is_SymLink() && dataSize <= kSymLinkDataSize_Max && item.Size != 0)
       {
-        size_t cur = (size_t)dataSize;
-        CByteBuffer buf;
-        buf.Alloc(cur);
-        RINOK(ReadStream(stream, buf, &cur))
-        if (cur != dataSize)
+        bool unexpectedEnd;
+        RINOK(ReadSymLinkData(stream, _items.Back(), unexpectedEnd))
+        if (unexpectedEnd)
         {
           _error = k_ErrorType_UnexpectedEnd;
           break;
         }
-        size_t i;
-        
-        for (i = (size_t)item.Size; i < dataSize; i++)
-          if (buf[i] != 0)
-            break;
-        if (i != dataSize)
-          _pad_Error = true;
-
-        for (i = 0; i < (size_t)item.Size; i++)
-          if (buf[i] == 0)
-            break;
-        if (i != (size_t)item.Size)
-          _symLink_Error = true;
-        else
-          _items.Back().Data.CopyFrom(buf, (size_t)item.Size);
       }
       else if (dataSize != 0)
       {
@@ -703,6 +738,7 @@ Z7_COM7F_IMF(CHandler::Open(IInStream *stream, const UInt64 *, IArchiveOpenCallb
     }
 
     _phySize = arc.Processed;
+    _phySize_Defined = true;
   }
 
   {
@@ -850,11 +886,109 @@ Z7_COM7F_IMF(CHandler::Open(IInStream *stream, const UInt64 *, IArchiveOpenCallb
 }
 
 
+Z7_COM7F_IMF(CHandler::OpenSeq(ISequentialInStream *stream))
+{
+  Close();
+  _seqStream = stream;
+  _arc.Stream = stream;
+  _arc.Processed = 0;
+  _isArc = true;
+  return S_OK;
+}
+
+
+/* ReadLatestItem() reads next item header in sequential mode.
+   It returns E_INVALIDARG, if there are no more items. */
+
+HRESULT CHandler::ReadLatestItem()
+{
+  CItem &item = _arc.item;
+  item.Data.Free();
+  item.HeaderPos = _arc.Processed;
+  RINOK(_arc.GetNextItem())
+  _error = _arc.errorType;
+  if (_error == k_ErrorType_OK)
+  {
+    if (_curIndex == 0)
+      _type = item.Type;
+    else if (_type != item.Type)
+      _error = k_ErrorType_Corrupted;
+  }
+  if (_error != k_ErrorType_OK || item.IsTrailer())
+  {
+    if (_curIndex == 0 && _error != k_ErrorType_OK)
+      _isArc = false;
+    _phySize = item.HeaderPos;
+    if (_error == k_ErrorType_UnexpectedEnd || item.IsTrailer())
+      _phySize = _arc.Processed;
+    _phySize_Defined = true;
+    return E_INVALIDARG;
+  }
+  item.MainIndex_ForInode = _curIndex;
+  _latestDataRem = item.GetPackSize();
+  if (item.Is_SymLink() && _latestDataRem <= kSymLinkDataSize_Max && item.Size != 0)
+  {
+    bool unexpectedEnd;
+    RINOK(ReadSymLinkData(_seqStream, item, unexpectedEnd))
+    if (unexpectedEnd)
+    {
+      _error = k_ErrorType_UnexpectedEnd;
+      return E_INVALIDARG;
+    }
+    _arc.Processed += _latestDataRem;
+    _latestDataRem = 0;
+  }
+  _phySize = _arc.Processed + _latestDataRem;
+  _latestIsRead = true;
+  return S_OK;
+}
+
+
+HRESULT CHandler::SkipLatestData()
+{
+  const UInt64 rem = _latestDataRem;
+  RINOK(copyCoder.Interface()->Code(_seqStream, NULL, &rem, &rem, NULL))
+  _arc.Processed += copyCoder->TotalSize;
+  if (copyCoder->TotalSize != rem)
+  {
+    _error = k_ErrorType_UnexpectedEnd;
+    return S_FALSE;
+  }
+  _latestDataRem = 0;
+  _latestIsRead = false;
+  _curIndex++;
+  return S_OK;
+}
+
+
+HRESULT CHandler::SkipTo(UInt32 index)
+{
+  while (_curIndex < index || !_latestIsRead)
+  {
+    if (_latestIsRead)
+    {
+      RINOK(SkipLatestData())
+    }
+    else
+    {
+      RINOK(ReadLatestItem())
+    }
+  }
+  return S_OK;
+}
+
+
 Z7_COM7F_IMF(CHandler::Close())
 {
   _items.Clear();
   _stream.Release();
+  _seqStream.Release();
+  _arc.Stream = NULL;
+  _curIndex = 0;
+  _latestIsRead = false;
+  _latestDataRem = 0;
   _phySize = 0;
+  _phySize_Defined = false;
   _type = k_Type_BinLe;
   _isArc = false;
   _moreThanOneHardLinks_Error = false;
@@ -867,7 +1001,7 @@ Z7_COM7F_IMF(CHandler::Close())
 
 Z7_COM7F_IMF(CHandler::GetNumberOfItems(UInt32 *numItems))
 {
-  *numItems = _items.Size();
+  *numItems = (_stream ? _items.Size() : (UInt32)(Int32)-1);
   return S_OK;
 }
 
@@ -875,7 +1009,17 @@ Z7_COM7F_IMF(CHandler::GetProperty(UInt32 index, PROPID propID, PROPVARIANT *val
 {
   COM_TRY_BEGIN
   NCOM::CPropVariant prop;
-  const CItem &item = _items[index];
+  const CItem *itemPtr;
+  if (_stream)
+    itemPtr = &_items[index];
+  else
+  {
+    if (index < _curIndex)
+      return E_INVALIDARG;
+    RINOK(SkipTo(index))
+    itemPtr = &_arc.item;
+  }
+  const CItem &item = *itemPtr;
 
   switch (propID)
   {
@@ -893,7 +1037,8 @@ Z7_COM7F_IMF(CHandler::GetProperty(UInt32 index, PROPID propID, PROPVARIANT *val
     case kpidIsDir: prop = item.IsDir(); break;
 
     case kpidSize:
-      prop = (UInt64)_items[item.MainIndex_ForInode].Size;
+      // in sequential mode we don't know the data of next hard links
+      prop = (UInt64)(_stream ? _items[item.MainIndex_ForInode].Size : item.Size);
       break;
     
     case kpidPackSize:
@@ -1011,10 +1156,11 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     Int32 testMode, IArchiveExtractCallback *extractCallback))
 {
   COM_TRY_BEGIN
+  const bool seqMode = (_stream == NULL);
   const bool allFilesMode = (numItems == (UInt32)(Int32)-1);
   if (allFilesMode)
     numItems = _items.Size();
-  if (numItems == 0)
+  if (!seqMode && numItems == 0)
     return S_OK;
   UInt64 totalSize = 0;
   UInt32 i;
@@ -1027,11 +1173,13 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
   }
   RINOK(extractCallback->SetTotal(totalSize))
 
-  CMyComPtr2_Create<ICompressCoder, NCompress::CCopyCoder> copyCoder;
   CMyComPtr2_Create<ICompressProgressInfo, CLocalProgress> lps;
   lps->Init(extractCallback, false);
   CMyComPtr2_Create<ISequentialInStream, CLimitedSequentialInStream> inStream;
-  inStream->SetStream(_stream);
+  if (seqMode)
+    inStream->SetStream(_seqStream);
+  else
+    inStream->SetStream(_stream);
   CMyComPtr2_Create<ISequentialOutStream, COutStreamWithSum> outStreamSum;
 
   UInt64 total_PackSize = 0;
@@ -1042,14 +1190,30 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     lps->InSize = total_PackSize;
     lps->OutSize = total_UnpackSize;
     RINOK(lps->SetCur())
-    if (i >= numItems)
+    if (i >= numItems && !seqMode)
       break;
-    const Int32 askMode = testMode ?
+    Int32 askMode = testMode ?
         NExtract::NAskMode::kTest :
         NExtract::NAskMode::kExtract;
     const UInt32 index = allFilesMode ? i : indices[i];
-    const CItem &item2 = _items[index];
-    const CItem &item = _items[item2.MainIndex_ForInode];
+    const CItem *item2Ptr;
+    const CItem *itemPtr;
+    if (seqMode)
+    {
+      const HRESULT res = SkipTo(index);
+      // (S_FALSE) : unexpected end of archive in data of skipped item. (_error) is set.
+      if (res == E_INVALIDARG || res == S_FALSE)
+        break;
+      RINOK(res)
+      item2Ptr = itemPtr = &_arc.item;
+    }
+    else
+    {
+      item2Ptr = &_items[index];
+      itemPtr = &_items[item2Ptr->MainIndex_ForInode];
+    }
+    const CItem &item2 = *item2Ptr;
+    const CItem &item = *itemPtr;
     {
       CMyComPtr<ISequentialOutStream> outStream;
       RINOK(extractCallback->GetStream(index, &outStream, askMode))
@@ -1064,23 +1228,59 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
         continue;
       }
       if (!testMode && !outStream)
-        continue;
+      {
+        if (!seqMode)
+          continue;
+        askMode = NExtract::NAskMode::kSkip;
+      }
       outStreamSum->Init(item.IsCrcFormat());
       outStreamSum->SetStream(outStream);
       RINOK(extractCallback->PrepareOperation(askMode))
     }
-    RINOK(InStream_SeekSet(_stream, item.GetDataPosition()))
-    inStream->Init(item.Size);
-    RINOK(copyCoder.Interface()->Code(inStream, outStreamSum, NULL, NULL, lps))
+    UInt64 processed;
+    if (seqMode && _latestDataRem == 0)
+    {
+      // symbolic link data was read already in ReadLatestItem()
+      processed = item.Data.Size();
+      if (processed != 0)
+        RINOK(WriteStream(outStreamSum, item.Data, item.Data.Size()))
+    }
+    else
+    {
+      if (!seqMode)
+        RINOK(InStream_SeekSet(_stream, item.GetDataPosition()))
+      inStream->Init(item.Size);
+      RINOK(copyCoder.Interface()->Code(inStream, outStreamSum, NULL, NULL, lps))
+      processed = copyCoder->TotalSize;
+      if (seqMode)
+      {
+        _arc.Processed += processed;
+        _latestDataRem -= processed;
+      }
+    }
     outStreamSum->ReleaseStream();
+    bool unexpectedEnd = false;
+    if (seqMode)
+    {
+      // we skip alignment padding
+      const HRESULT res2 = SkipLatestData();
+      if (res2 == S_FALSE)
+        unexpectedEnd = true;
+      else
+        RINOK(res2)
+    }
     Int32 res = NExtract::NOperationResult::kDataError;
-    if (copyCoder->TotalSize == item.Size)
+    if (unexpectedEnd)
+      res = NExtract::NOperationResult::kUnexpectedEnd;
+    else if (processed == item.Size)
     {
       res = NExtract::NOperationResult::kOK;
       if (item.IsCrcFormat() && item.ChkSum != outStreamSum->GetChecksum())
         res = NExtract::NOperationResult::kCRCError;
     }
     RINOK(extractCallback->SetOperationResult(res))
+    if (unexpectedEnd)
+      break;
   }
   return S_OK;
   COM_TRY_END
@@ -1089,6 +1289,9 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 Z7_COM7F_IMF(CHandler::GetStream(UInt32 index, ISequentialInStream **stream))
 {
   COM_TRY_BEGIN
+  *stream = NULL;
+  if (!_stream)
+    return S_FALSE;
   const CItem &item2 = _items[index];
   const CItem &item = _items[item2.MainIndex_ForInode];
   return CreateLimitedInStream(_stream, item.GetDataPosition(), item.Size, stream);
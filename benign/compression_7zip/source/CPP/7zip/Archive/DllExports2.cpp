@@ -13,6 +13,10 @@
 
 #include "../../Windows/NtCheck.h"
 #include "../../Windows/PropVariant.h"
+#ifndef Z7_ST
+#include "../../../C/MemBudget.h"
+#include "../../Windows/Thread.h"
+#endif
 
 #include "../ICoder.h"
 #include "../IPassword.h"
@@ -116,6 +120,61 @@ STDAPI SetLargePageMode()
   return S_OK;
 }
 
+/*
+  SetThreadPoolLimit(numThreads) enables reusing of worker threads
+  and sets the limit for the number of running worker threads in process.
+  (numThreads == 0) : it terminates idle worker threads and disables the pool.
+  The caller must not call it while any archive operation is running.
+*/
+STDAPI SetThreadPoolLimit(UInt32 numThreads);
+STDAPI SetThreadPoolLimit(UInt32 numThreads)
+{
+  #ifndef Z7_ST
+  if (numThreads == 0)
+    ThreadPool_Free();
+  else
+    return HRESULT_FROM_WIN32(ThreadPool_Create(numThreads));
+  #else
+  UNUSED_VAR(numThreads)
+  #endif
+  return S_OK;
+}
+
+/*
+  SetMemoryBudget(limit) sets the limit for total size of memory
+  that is reserved by multithreaded coders in process.
+  (limit == 0) : no limit, but the statistics is collected.
+  The caller must call it before the first archive operation.
+*/
+STDAPI SetMemoryBudget(UInt64 limit);
+STDAPI SetMemoryBudget(UInt64 limit)
+{
+  #ifndef Z7_ST
+  return HRESULT_FROM_WIN32(MemBudget_Create(limit));
+  #else
+  UNUSED_VAR(limit)
+  return S_OK;
+  #endif
+}
+
+// it returns S_FALSE, if SetMemoryBudget() was not called
+STDAPI GetMemoryBudgetStat(UInt64 *reserved, UInt64 *peak);
+STDAPI GetMemoryBudgetStat(UInt64 *reserved, UInt64 *peak)
+{
+  *reserved = 0;
+  *peak = 0;
+  #ifndef Z7_ST
+  CMemBudgetStat st;
+  if (MemBudget_GetStat(&st))
+  {
+    *reserved = st.Reserved;
+    *peak = st.Peak;
+    return S_OK;
+  }
+  #endif
+  return S_FALSE;
+}
+
 extern bool g_CaseSensitive;
 
 STDAPI SetCaseSensitive(Int32 caseSensitive);
@@ -3,6 +3,7 @@
 #include "StdAfx.h"
 
 #include "../../Common/ComTry.h"
+#include "../../Common/MyBuffer2.h"
 
 #include "../Common/LimitedStreams.h"
 #include "../Common/ProgressUtils.h"
@@ -239,6 +240,59 @@ Z7_COM7F_IMF(CHandlerImgProgress::SetRatioInfo(const UInt64 *inSize, const UInt6
 }
   
 
+HRESULT CHandlerImg::CopyToSparse(ISequentialInStream *inStream, IOutStreamSparse *sparseStream,
+    ISequentialOutStream *outStream, ICompressProgressInfo *progress, UInt64 &processed)
+{
+  processed = 0;
+  Z7_DECL_CMyComPtr_QI_FROM(IInStream, seekStream, inStream)
+  if (!seekStream)
+    return E_NOTIMPL;
+  const size_t kBufSize = (size_t)1 << 20;
+  CMidBuffer buf;
+  buf.Alloc(kBufSize);
+  if (!buf.IsAllocated())
+    return E_OUTOFMEMORY;
+
+  /* Get_Region() can scan the whole allocation table from (pos).
+     So we call it only at the start of each region, and not for each buffer */
+  UInt64 size = 0;
+  bool isHole = false;
+
+  while (processed < _size)
+  {
+    if (size == 0)
+    {
+      size = Get_Region(processed, isHole);
+      if (size == 0)
+        return E_FAIL;
+      if (size > _size - processed)
+        size = _size - processed;
+    }
+    if (isHole)
+    {
+      RINOK(sparseStream->WriteHole(size))
+      RINOK(seekStream->Seek((Int64)size, STREAM_SEEK_CUR, NULL))
+      processed += size;
+      size = 0;
+    }
+    else
+    {
+      size_t cur = kBufSize;
+      if (cur > size)
+        cur = (size_t)size;
+      RINOK(ReadStream(inStream, buf, &cur))
+      if (cur == 0)
+        return S_OK;
+      RINOK(WriteStream(outStream, buf, cur))
+      processed += cur;
+      size -= cur;
+    }
+    RINOK(progress->SetRatioInfo(&processed, &processed))
+  }
+  return S_OK;
+}
+
+
 Z7_COM7F_IMF(CHandlerImg::Extract(const UInt32 *indices, UInt32 numItems,
     Int32 testMode, IArchiveExtractCallback *extractCallback))
 {
@@ -282,12 +336,23 @@ Z7_COM7F_IMF(CHandlerImg::Extract(const UInt32 *indices, UInt32 numItems,
       progress = imgProgress;
     }
 
-    CMyComPtr2_Create<ICompressCoder, NCompress::CCopyCoder> copyCoder;
-
-    hres = copyCoder.Interface()->Code(inStream, outStream, NULL, &_size, progress);
+    UInt64 totalSize = 0;
+    hres = E_NOTIMPL;
+    if (outStream)
+    {
+      Z7_DECL_CMyComPtr_QI_FROM(IOutStreamSparse, sparseStream, outStream)
+      if (sparseStream)
+        hres = CopyToSparse(inStream, sparseStream, outStream, progress, totalSize);
+    }
+    if (hres == E_NOTIMPL && totalSize == 0)
+    {
+      CMyComPtr2_Create<ICompressCoder, NCompress::CCopyCoder> copyCoder;
+      hres = copyCoder.Interface()->Code(inStream, outStream, NULL, &_size, progress);
+      totalSize = copyCoder->TotalSize;
+    }
     if (hres == S_OK)
     {
-      if (copyCoder->TotalSize == _size)
+      if (totalSize == _size)
         opRes = NExtract::NOperationResult::kOK;
       
       if (_stream_unavailData)
@@ -296,7 +361,7 @@ Z7_COM7F_IMF(CHandlerImg::Extract(const UInt32 *indices, UInt32 numItems,
         opRes = NExtract::NOperationResult::kUnsupportedMethod;
       else if (_stream_dataError)
         opRes = NExtract::NOperationResult::kDataError;
-      else if (copyCoder->TotalSize < _size)
+      else if (totalSize < _size)
         opRes = NExtract::NOperationResult::kUnexpectedEnd;
     }
   }
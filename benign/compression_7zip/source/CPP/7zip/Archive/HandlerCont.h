@@ -5,6 +5,8 @@
 
 #include "../../Common/MyCom.h"
 
+#include "../ICoder.h"
+
 #include "IArchive.h"
 
 namespace NArchive {
@@ -114,6 +116,21 @@ protected:
   {
     return false;
   }
+
+  /* Get_Region() returns the size of region that starts from (pos < _size)
+     and where all bytes have same allocation state.
+     (isHole == true) means that the region is not allocated in image,
+     and Read() returns zeros for that region without reading.
+     Extract() doesn't write such regions to output stream that supports
+     IOutStreamSparse. The size can exceed (_size - pos). */
+  virtual UInt64 Get_Region(UInt64 pos, bool &isHole)
+  {
+    isHole = false;
+    return _size - pos;
+  }
+
+  HRESULT CopyToSparse(ISequentialInStream *inStream, IOutStreamSparse *sparseStream,
+      ISequentialOutStream *outStream, ICompressProgressInfo *progress, UInt64 &processed);
 public:
   virtual bool Get_PackSizeProcessed(UInt64 &size)
   {
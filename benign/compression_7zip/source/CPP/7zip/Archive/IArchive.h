@@ -714,6 +714,9 @@ extern "C"
 
   typedef HRESULT (WINAPI *Func_SetCaseSensitive)(Int32 caseSensitive);
   typedef HRESULT (WINAPI *Func_SetLargePageMode)();
+  typedef HRESULT (WINAPI *Func_SetThreadPoolLimit)(UInt32 numThreads);
+  typedef HRESULT (WINAPI *Func_SetMemoryBudget)(UInt64 limit);
+  typedef HRESULT (WINAPI *Func_GetMemoryBudgetStat)(UInt64 *reserved, UInt64 *peak);
   // typedef HRESULT (WINAPI *Func_SetClientVersion)(UInt32 version);
 
   typedef IOutArchive * (*Func_CreateOutArchive)();
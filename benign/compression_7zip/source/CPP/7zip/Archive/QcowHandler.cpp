@@ -84,12 +84,42 @@ Z7_class_CHandler_final: public CHandlerImg
     return Seek2(0);
   }
 
+  bool IsClusterAllocated(UInt64 cluster) const;
   HRESULT Open2(IInStream *stream, IArchiveOpenCallback *openCallback) Z7_override;
+  UInt64 Get_Region(UInt64 pos, bool &isHole) Z7_override;
 };
 
 
 static const UInt32 kEmptyDirItem = (UInt32)0 - 1;
 
+// it returns (false), if Read() returns zeros for cluster without reading
+bool CHandler::IsClusterAllocated(UInt64 cluster) const
+{
+  const UInt64 high = cluster >> _numMidBits;
+  if (high >= _dir.Size())
+    return false;
+  const UInt32 tabl = _dir[(size_t)high];
+  if (tabl == kEmptyDirItem)
+    return false;
+  const size_t midBits = (size_t)cluster & (((size_t)1 << _numMidBits) - 1);
+  const UInt64 v = Get64(_table + ((((size_t)tabl << _numMidBits) + midBits) << 3));
+  if (v == 0)
+    return false;
+  // version_3 supports zero clusters
+  return (v & _compressedFlag) != 0 || ((UInt32)v & 511) != 1;
+}
+
+UInt64 CHandler::Get_Region(UInt64 pos, bool &isHole)
+{
+  UInt64 cluster = pos >> _clusterBits;
+  const bool allocated = IsClusterAllocated(cluster);
+  isHole = !allocated;
+  for (cluster++; (cluster << _clusterBits) < _size; cluster++)
+    if (IsClusterAllocated(cluster) != allocated)
+      break;
+  return (cluster << _clusterBits) - pos;
+}
+
 Z7_COM7F_IMF(CHandler::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
   if (processedSize)
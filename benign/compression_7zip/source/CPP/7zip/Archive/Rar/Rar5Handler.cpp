@@ -1030,8 +1030,15 @@ struct CUnpacker
 
   CByteBuffer _tempBuf;
   CLinkFile *linkFile;
+ #ifndef Z7_ST
+  UInt32 NumThreads;
+ #endif
 
-  CUnpacker(): linkFile(NULL) { SolidAllowed = false; NeedCrc = true; }
+  CUnpacker(): linkFile(NULL) { SolidAllowed = false; NeedCrc = true;
+     #ifndef Z7_ST
+      NumThreads = 1;
+     #endif
+    }
 
   HRESULT Create(DECL_EXTERNAL_CODECS_LOC_VARS
       const CItem &item, bool isSolid, bool &wrongPassword);
@@ -1077,6 +1084,16 @@ HRESULT CUnpacker::Create(DECL_EXTERNAL_CODECS_LOC_VARS
       RINOK(CreateCoder_Id(EXTERNAL_CODECS_LOC_VARS methodID, false, lzCoder))
       if (!lzCoder)
         return E_NOTIMPL;
+     #ifndef Z7_ST
+      {
+        CMyComPtr<ICompressSetCoderMt> setCoderMt;
+        lzCoder.QueryInterface(IID_ICompressSetCoderMt, &setCoderMt);
+        if (setCoderMt)
+        {
+          RINOK(setCoderMt->SetNumberOfThreads(NumThreads))
+        }
+      }
+     #endif
     }
 
     CMyComPtr<ICompressSetDecoderProperties2> csdp;
@@ -1105,7 +1122,13 @@ HRESULT CUnpacker::Create(DECL_EXTERNAL_CODECS_LOC_VARS
       filterStream = filterStreamSpec;
     }
 
-    cryptoDecoder.Create_if_Empty();
+    if (!cryptoDecoder.IsDefined())
+    {
+      cryptoDecoder.Create_if_Empty();
+     #ifndef Z7_ST
+      RINOK(cryptoDecoder->SetNumberOfThreads(NumThreads))
+     #endif
+    }
 
     RINOK(cryptoDecoder->SetDecoderProps(item.Extra + (unsigned)cryptoOffset, cryptoSize, true, item.IsService()))
 
@@ -3034,6 +3057,9 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 
   CUnpacker unpacker;
   unpacker.NeedCrc = _needChecksumCheck;
+ #ifndef Z7_ST
+  unpacker.NumThreads = _numThreads;
+ #endif
   CMyComPtr2_Create<ISequentialInStream, CVolsInStream> volsInStream;
   CMyComPtr2_Create<ICompressProgressInfo, CLocalProgress> lps;
   lps->Init(extractCallback, false);
@@ -3340,6 +3366,9 @@ void CHandler::InitDefaults()
   _needChecksumCheck = true;
   _memUsage_WasSet = false;
   _memUsage_Decompress = (UInt64)1 << 32;
+ #ifndef Z7_ST
+  _numThreads = NWindows::NSystem::GetNumberOfProcessors();
+ #endif
 }
 
 Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVARIANT *values, UInt32 numProps))
@@ -3357,6 +3386,9 @@ Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVAR
 
     if (name.IsPrefixedBy_Ascii_NoCase("mt"))
     {
+     #ifndef Z7_ST
+      RINOK(ParseMtProp(name.Ptr(2), prop, NWindows::NSystem::GetNumberOfProcessors(), _numThreads))
+     #endif
     }
     else if (name.IsPrefixedBy_Ascii_NoCase("memx"))
     {
@@ -141,6 +141,7 @@ Z7_class_CHandler_final: public CHandlerImg
   }
 
   HRESULT Open2(IInStream *stream, IArchiveOpenCallback *openCallback) Z7_override;
+  UInt64 Get_Region(UInt64 pos, bool &isHole) Z7_override;
   HRESULT ReadPhy(UInt64 offset, void *data, UInt32 size, UInt32 &processed);
 };
 
@@ -444,6 +445,31 @@ HRESULT CHandler::ReadPhy(UInt64 offset, void *data, UInt32 size, UInt32 &proces
 }
 
 
+UInt64 CHandler::Get_Region(UInt64 pos, bool &isHole)
+{
+  isHole = false;
+  if (pos >= _virtSize_fromChunks || Chunks.Size() < 2)
+    return _size - pos;
+  const UInt32 blockIndex = (UInt32)(pos >> _blockSizeLog);
+  unsigned left = 0, right = Chunks.Size() - 1;
+  for (;;)
+  {
+    const unsigned mid = (unsigned)(((size_t)left + (size_t)right) / 2);
+    if (mid == left)
+      break;
+    if (blockIndex < Chunks[mid].VirtBlock)
+      right = mid;
+    else
+      left = mid;
+  }
+  const CChunk &c = Chunks[left];
+  isHole = (c.PhyOffset == MY_CHUNK_TYPE_DONT_CARE
+      || (c.PhyOffset == MY_CHUNK_TYPE_FILL
+        && (c.Fill[0] | c.Fill[1] | c.Fill[2] | c.Fill[3]) == 0));
+  return ((UInt64)Chunks[left + 1].VirtBlock << _blockSizeLog) - pos;
+}
+
+
 Z7_COM7F_IMF(CHandler::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
   if (processedSize)
@@ -333,10 +333,9 @@ Z7_COM7F_IMF(CHandler::GetStream(UInt32 index, ISequentialInStream **stream))
   CMyComPtr<ISequentialInStream> streamTemp = streamSpec;
   FOR_VECTOR (i, _streams)
   {
-    CMultiStream::CSubStreamInfo subStreamInfo;
+    CMultiStream::CSubStreamInfo &subStreamInfo = streamSpec->Streams.AddNew();
     subStreamInfo.Stream = _streams[i];
     subStreamInfo.Size = _sizes[i];
-    streamSpec->Streams.Add(subStreamInfo);
   }
   streamSpec->Init();
   *stream = streamTemp.Detach();
@@ -828,8 +828,17 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
         {
           RINOK(InStream_SeekSet(_stream, item->Get_DataPos()))
         }
-        inStream->Init(item->Get_PackSize_Aligned());
-        RINOK(copyCoder.Interface()->Code(inStream2, outStreamSpec, NULL, NULL, lps))
+        if (!seqMode && !item->Is_Sparse() && !skipMode
+            && item->Get_PackSize_Aligned() >= unpackSize)
+        {
+          // CCopyCoder can use OS-level copying, if the archive and output are files
+          RINOK(copyCoder.Interface()->Code(_stream, outStreamSpec, NULL, &unpackSize, lps))
+        }
+        else
+        {
+          inStream->Init(item->Get_PackSize_Aligned());
+          RINOK(copyCoder.Interface()->Code(inStream2, outStreamSpec, NULL, NULL, lps))
+        }
       }
       if (outStreamSpec->GetRem() != 0)
         opRes = NExtract::NOperationResult::kDataError;
@@ -106,7 +106,15 @@ Z7_class_CHandler_final: public CHandlerImg
     return Seek2(0);
   }
 
+  bool IsClusterAllocated(UInt64 cluster) const
+  {
+    if (cluster >= (_table.Size() >> 2))
+      return false;
+    return IS_CLUSTER_ALLOCATED(Get32((const Byte *)_table + ((size_t)cluster << 2)));
+  }
+
   HRESULT Open2(IInStream *stream, IArchiveOpenCallback *openCallback) Z7_override;
+  UInt64 Get_Region(UInt64 pos, bool &isHole) Z7_override;
 
 public:
   Z7_IFACE_COM7_IMP(IInArchive_Img)
@@ -116,6 +124,17 @@ public:
 };
 
 
+UInt64 CHandler::Get_Region(UInt64 pos, bool &isHole)
+{
+  UInt64 cluster = pos >> k_ClusterBits;
+  const bool allocated = IsClusterAllocated(cluster);
+  isHole = !allocated;
+  for (cluster++; (cluster << k_ClusterBits) < _size; cluster++)
+    if (IsClusterAllocated(cluster) != allocated)
+      break;
+  return (cluster << k_ClusterBits) - pos;
+}
+
 Z7_COM7F_IMF(CHandler::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
   if (processedSize)
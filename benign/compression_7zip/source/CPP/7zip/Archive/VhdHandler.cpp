@@ -307,6 +307,7 @@ Z7_class_CHandler_final: public CHandlerImg
     return Open2(stream, NULL, openArchiveCallback, 0);
   }
   void CloseAtError() Z7_override;
+  UInt64 Get_Region(UInt64 pos, bool &isHole) Z7_override;
 
 public:
   Z7_IFACE_COM7_IMP(IInArchive_Img)
@@ -527,6 +528,22 @@ HRESULT CHandler::Open3()
   return S_OK;
 }
 
+UInt64 CHandler::Get_Region(UInt64 pos, bool &isHole)
+{
+  isHole = false;
+  // unused blocks of differencing disk are read from parent
+  if (Footer.IsFixed() || ParentStream)
+    return Footer.CurrentSize - pos;
+  UInt32 blockIndex = (UInt32)(pos >> Dyn.BlockSizeLog);
+  if (blockIndex >= Bat.Size())
+    return Footer.CurrentSize - pos;
+  isHole = (Bat[blockIndex] == kUnusedBlock);
+  for (blockIndex++; blockIndex < Bat.Size(); blockIndex++)
+    if ((Bat[blockIndex] == kUnusedBlock) != isHole)
+      break;
+  return ((UInt64)blockIndex << Dyn.BlockSizeLog) - pos;
+}
+
 Z7_COM7F_IMF(CHandler::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
   if (processedSize)
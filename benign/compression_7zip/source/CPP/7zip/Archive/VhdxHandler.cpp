@@ -755,6 +755,8 @@ Z7_class_CHandler_final: public CHandlerImg
   HRESULT Open2(IInStream *stream, IArchiveOpenCallback *openArchiveCallback) Z7_override;
   HRESULT OpenParent(IArchiveOpenCallback *openArchiveCallback, bool &_parentFileWasOpen);
   virtual void CloseAtError() Z7_override;
+  bool IsBlockHole(size_t blockIndex) const;
+  UInt64 Get_Region(UInt64 pos, bool &isHole) Z7_override;
 
 public:
   Z7_IFACE_COM7_IMP(IInArchive_Img)
@@ -1380,6 +1382,30 @@ static struct CCounter { ~CCounter()
 } } g_Counter;
 */
 
+// it returns (true), if Read() returns zeros for block without reading
+bool CHandler::IsBlockHole(size_t blockIndex) const
+{
+  const size_t chunkIndex = blockIndex >> ChunkRatio_Log;
+  const size_t chunkRatio = (size_t)1 << ChunkRatio_Log;
+  const size_t blockIndex2 = chunkIndex * (chunkRatio + 1) + (blockIndex & (chunkRatio - 1));
+  const UInt32 blockState = BAT_GET_STATE(Bat.GetItem(blockIndex2));
+  if (blockState == PAYLOAD_BLOCK_FULLY_PRESENT
+      || blockState == PAYLOAD_BLOCK_PARTIALLY_PRESENT)
+    return false;
+  // differencing VHDX reads such blocks from parent
+  return !(blockState == PAYLOAD_BLOCK_NOT_PRESENT && IsDiff());
+}
+
+UInt64 CHandler::Get_Region(UInt64 pos, bool &isHole)
+{
+  size_t blockIndex = (size_t)(pos >> Meta.BlockSize_Log);
+  isHole = IsBlockHole(blockIndex);
+  for (blockIndex++; ((UInt64)blockIndex << Meta.BlockSize_Log) < Meta.VirtualDiskSize; blockIndex++)
+    if (IsBlockHole(blockIndex) != isHole)
+      break;
+  return ((UInt64)blockIndex << Meta.BlockSize_Log) - pos;
+}
+
 Z7_COM7F_IMF(CHandler::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
   // g_NumCalls++;
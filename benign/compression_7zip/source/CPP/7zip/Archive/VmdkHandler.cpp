@@ -464,6 +464,7 @@ Z7_class_CHandler_final: public CHandlerImg
 
   virtual HRESULT Open2(IInStream *stream, IArchiveOpenCallback *openCallback) Z7_override;
   virtual void CloseAtError() Z7_override;
+  virtual UInt64 Get_Region(UInt64 pos, bool &isHole) Z7_override;
 public:
   Z7_IFACE_COM7_IMP(IInArchive_Img)
 
@@ -472,6 +473,68 @@ public:
 };
 
 
+static bool IsGrainHole(const CExtent &extent, UInt64 cluster)
+{
+  const UInt64 high = cluster >> k_NumMidBits;
+  if (high >= extent.Tables.Size())
+    return true;
+  const CByteBuffer &table = extent.Tables[(unsigned)high];
+  if (table.Size() == 0)
+    return true;
+  const size_t midBits = (size_t)cluster & ((1 << k_NumMidBits) - 1);
+  const UInt32 v = Get32((const Byte *)table + (midBits << 2));
+  return v == 0 || v == extent.ZeroSector;
+}
+
+UInt64 CHandler::Get_Region(UInt64 pos, bool &isHole)
+{
+  isHole = false;
+  unsigned extentIndex;
+  {
+    unsigned left = 0, right = _extents.Size();
+    for (;;)
+    {
+      unsigned mid = (left + right) / 2;
+      if (mid == left)
+        break;
+      if (pos < _extents[mid].StartOffset)
+        right = mid;
+      else
+        left = mid;
+    }
+    extentIndex = left;
+  }
+  if (extentIndex >= _extents.Size())
+    return _size - pos;
+  const CExtent &extent = _extents[extentIndex];
+  const UInt64 vir = pos - extent.StartOffset;
+  if (vir >= extent.NumBytes || vir >= extent.VirtSize)
+    return _size - pos;
+  const UInt64 lim = MyMin(extent.NumBytes, extent.VirtSize);
+
+  // zero extents have no (Stream).
+  // Read() reports errors for unavailable extents, so we don't skip them
+  if (extent.IsZero)
+  {
+    isHole = true;
+    return lim - vir;
+  }
+  if (!extent.IsOK || !extent.Stream || extent.Unsupported)
+    return lim - vir;
+  if (extent.IsFlat)
+    return lim - vir;
+
+  const unsigned clusterBits = extent.ClusterBits;
+  UInt64 cluster = vir >> clusterBits;
+  isHole = IsGrainHole(extent, cluster);
+  for (cluster++; (cluster << clusterBits) < lim; cluster++)
+    if (IsGrainHole(extent, cluster) != isHole)
+      break;
+  const UInt64 end = cluster << clusterBits;
+  return (end < lim ? end : lim) - vir;
+}
+
+
 Z7_COM7F_IMF(CHandler::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
   if (processedSize)
@@ -553,7 +616,7 @@ Z7_COM7F_IMF(CHandler::Read(void *data, UInt32 size, UInt32 *processedSize))
         _stream_unsupportedMethod = true;
         return S_FALSE;
       }
-      if (!extent.IsOK || !extent.Stream)
+      if (!extent.IsZero && (!extent.IsOK || !extent.Stream))
       {
         _stream_unavailData = true;
         return S_FALSE;
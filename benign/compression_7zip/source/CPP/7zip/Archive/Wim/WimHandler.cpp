@@ -1205,8 +1205,24 @@ Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVAR
       RINOK(ParsePropToUInt32(L"", prop, image))
       _defaultImageNumber = (int)image;
     }
+    else if (name.IsEqualTo("m"))
+    {
+      if (prop.vt != VT_BSTR)
+        return E_INVALIDARG;
+      // LZMS compression is not supported
+      unsigned m;
+      for (m = 0; m < NMethod::kLZMS; m++)
+        if (StringsAreEqualNoCase_Ascii(prop.bstrVal, k_Methods[m]))
+          break;
+      if (m == NMethod::kLZMS)
+        return E_INVALIDARG;
+      _method = (int)m;
+    }
     else if (name.IsPrefixedBy_Ascii_NoCase("mt"))
     {
+     #ifndef Z7_ST
+      RINOK(ParseMtProp(name.Ptr(2), prop, NWindows::NSystem::GetNumberOfProcessors(), _numThreads))
+     #endif
     }
     else if (name.IsPrefixedBy_Ascii_NoCase("memuse"))
     {
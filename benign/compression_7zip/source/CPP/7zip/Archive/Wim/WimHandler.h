@@ -47,6 +47,12 @@ Z7_CLASS_IMP_CHandler_IInArchive_5(
   bool _keepMode_ShowImageNumber;
   bool _disable_Sha1Check;
 
+  // method for new data streams: (-1) means the method of updated archive or no compression
+  int _method;
+ #ifndef Z7_ST
+  UInt32 _numThreads;
+ #endif
+
   UInt64 _phySize;
   Int32 _firstVolumeIndex;
 
@@ -58,6 +64,10 @@ Z7_CLASS_IMP_CHandler_IInArchive_5(
     _set_use_ShowImageNumber = false;
     _set_showImageNumber = false;
     _defaultImageNumber = -1;
+    _method = -1;
+   #ifndef Z7_ST
+    _numThreads = NWindows::NSystem::GetNumberOfProcessors();
+   #endif
     _timeOptions.Init();
   }
 
@@ -2,6 +2,10 @@
 
 #include "StdAfx.h"
 
+#ifndef Z7_ST
+#include "../../../../C/MemBudget.h"
+#endif
+
 #include "../../../Common/ComTry.h"
 #include "../../../Common/IntToString.h"
 #include "../../../Common/MyBuffer2.h"
@@ -12,16 +16,22 @@
 #include "../../../Windows/PropVariant.h"
 #include "../../../Windows/TimeUtils.h"
 
+#ifndef Z7_ST
+#include "../../../Windows/Synchronization.h"
+#include "../../../Windows/Thread.h"
+#endif
+
 #include "../../Common/LimitedStreams.h"
 #include "../../Common/ProgressUtils.h"
 #include "../../Common/StreamUtils.h"
 #include "../../Common/UniqBlocks.h"
 
+#include "../../Compress/LzxEncoder.h"
+#include "../../Compress/XpressEncoder.h"
+
 #include "../../Crypto/RandGen.h"
 #include "../../Crypto/Sha1Cls.h"
 
-#include "../Common/OutStreamWithSha1.h"
-
 #include "WimHandler.h"
 
 using namespace NWindows;
@@ -658,17 +668,25 @@ static void AddTag_String_IfEmpty(CXmlItem &parentItem, const char *name, const
 }
 
 
-void CHeader::SetDefaultFields(bool useLZX)
+void CHeader::SetMethod(unsigned method)
 {
-  Version = k_Version_NonSolid;
-  Flags = NHeaderFlags::kReparsePointFixup;
-  ChunkSize = 0;
-  if (useLZX)
+  Flags &= ~(NHeaderFlags::kCompression | NHeaderFlags::kMethodMask);
+  if (method != 0)
   {
-    Flags |= NHeaderFlags::kCompression | NHeaderFlags::kLZX;
+    Flags |= NHeaderFlags::kCompression |
+        (method == NMethod::kLZX ? NHeaderFlags::kLZX : NHeaderFlags::kXPRESS);
     ChunkSize = kChunkSize;
     ChunkSizeBits = kChunkSizeBits;
   }
+}
+
+
+void CHeader::SetDefaultFields(unsigned method)
+{
+  Version = k_Version_NonSolid;
+  Flags = NHeaderFlags::kReparsePointFixup;
+  ChunkSize = 0;
+  SetMethod(method);
   MY_RAND_GEN(Guid, 16);
   PartNumber = 1;
   NumParts = 1;
@@ -688,6 +706,421 @@ static void AddTrees(CObjectVector<CDir> &trees, CObjectVector<CMetaItem> &metaI
 }
 
 
+/* CStreamPacker reads data stream by blocks.
+   SHA-1 of each block is calculated by separate job,
+   and the chunks of block are compressed by coder jobs,
+   while the main thread reads next block from input stream.
+   In multithreaded mode each job is executed by its own thread from process-wide pool.
+   The number of coders is limited by the number of threads reserved from pool
+   and by memory budget of process.
+   The block buffers (3 blocks) don't depend on the number of threads,
+   so they are not reserved in memory budget. */
+
+static const unsigned kNumChunksInBlock = 32;
+static const size_t kBlockSize = (size_t)kNumChunksInBlock << kChunkSizeBits;
+static const unsigned kNumCodersMax = kNumChunksInBlock;
+// the estimated size of match finder and buffer of one chunk coder
+static const UInt64 kCoderMemUsage = (UInt64)1 << 20;
+
+struct CChunkCoder
+{
+  NCompress::NXpress::CEncoder XpressEncoder;
+  NCompress::NLzx::CEncoder LzxEncoder;
+  HRESULT Res;
+
+  CChunkCoder(): Res(S_OK) {}
+};
+
+class CStreamPacker;
+
+#ifndef Z7_ST
+
+struct CPackThread
+{
+  NWindows::CPoolThread Thread;
+  NWindows::NSynchronization::CAutoResetEvent StartEvent;
+  NWindows::NSynchronization::CAutoResetEvent FinishedEvent;
+  CStreamPacker *Packer;
+  unsigned JobIndex;
+  bool Exit;
+
+  void ThreadFunc();
+  WRes Create();
+
+  CPackThread(): Packer(NULL), JobIndex(0), Exit(false) {}
+  ~CPackThread()
+  {
+    if (Thread.IsCreated())
+    {
+      Exit = true;
+      StartEvent.Set();
+      Thread.Wait_Close();
+    }
+  }
+};
+
+#endif
+
+class CStreamPacker
+{
+  unsigned _method;
+  unsigned _numCoders;
+  CMidBuffer _bufs[2];
+  CMidBuffer _packBuf;
+  CByteBuffer _table;
+  size_t _packSizes[kNumChunksInBlock];
+  CAlignedBuffer1 _sha;
+  const Byte *_data;
+  size_t _dataSize;
+  CObjectVector<CChunkCoder> _coders;
+ #ifndef Z7_ST
+  bool _mtMode;
+  unsigned _numStartedJobs;
+  unsigned _memBudgetNum;
+  unsigned _numReservedThreads;
+  CObjectVector<CPackThread> _threads;
+ #endif
+
+  CSha1 *Sha() { return (CSha1 *)(void *)(Byte *)_sha; }
+  void StartJobs(bool compress);
+  void WaitJobs();
+  HRESULT WriteChunks(ISequentialOutStream *outStream, UInt64 &chunkIndex, unsigned entrySizeShifts);
+public:
+  UInt64 UnpackSize;
+  UInt64 PackSize;
+  bool Compressed;
+  bool SizeError;
+
+  // (jobIndex == 0) is SHA-1 job, other jobs are coder jobs
+  void RunJob(unsigned jobIndex);
+
+  CStreamPacker():
+      _method(0),
+      _numCoders(0),
+      _sha(sizeof(CSha1))
+     #ifndef Z7_ST
+      , _mtMode(false)
+      , _numStartedJobs(0)
+      , _memBudgetNum(0)
+      , _numReservedThreads(0)
+     #endif
+      {}
+ #ifndef Z7_ST
+  ~CStreamPacker()
+  {
+    _threads.Clear();
+    ThreadPool_Release(_numReservedThreads);
+    MemBudget_Release(kCoderMemUsage, _memBudgetNum);
+  }
+ #endif
+
+  // (method == 0) means no compression
+  HRESULT Init(unsigned method, UInt32 numThreads);
+  
+  /* Code() reads data from (inStream) and calculates SHA-1 of data.
+     If (outStream) is not NULL, it writes data to (outStream):
+       if (compress) is true, the chunk table and compressed chunks are written.
+       It requires that data size is equal to (expectedSize).
+       Otherwise (SizeError) is set, and the caller must rewrite the stream. */
+  HRESULT Code(ISequentialInStream *inStream, IOutStream *outStream,
+      bool compress, UInt64 expectedSize, ICompressProgressInfo *progress);
+  
+  void GetDigest(Byte *digest) { Sha1_Final(Sha(), digest); }
+};
+
+#ifndef Z7_ST
+
+void CPackThread::ThreadFunc()
+{
+  for (;;)
+  {
+    if (StartEvent.Lock() != 0 || Exit)
+      return;
+    Packer->RunJob(JobIndex);
+    FinishedEvent.Set();
+  }
+}
+
+static THREAD_FUNC_DECL PackThreadFunc(void *p)
+{
+  ((CPackThread *)p)->ThreadFunc();
+  return 0;
+}
+
+WRes CPackThread::Create()
+{
+  WRes             wres = StartEvent.CreateIfNotCreated_Reset();
+  if (wres == 0) { wres = FinishedEvent.CreateIfNotCreated_Reset();
+  if (wres == 0) { wres = Thread.Create(PackThreadFunc, this); }}
+  return wres;
+}
+
+#endif
+
+HRESULT CStreamPacker::Init(unsigned method, UInt32 numThreads)
+{
+  _method = method;
+  _bufs[0].Alloc(kBlockSize);
+  _bufs[1].Alloc(kBlockSize);
+  if (!_bufs[0].IsAllocated() || !_bufs[1].IsAllocated())
+    return E_OUTOFMEMORY;
+  
+  unsigned numCoders = 0;
+  if (method != 0)
+  {
+    _packBuf.Alloc(kBlockSize);
+    if (!_packBuf.IsAllocated())
+      return E_OUTOFMEMORY;
+    numCoders = numThreads > kNumCodersMax ? kNumCodersMax : (unsigned)numThreads;
+    if (numCoders == 0)
+      numCoders = 1;
+  }
+
+ #ifndef Z7_ST
+  ThreadPool_Release(_numReservedThreads);
+  _numReservedThreads = 0;
+  if (numThreads > 1)
+  {
+    // SHA-1 job and coder jobs
+    _numReservedThreads = ThreadPool_Reserve(numCoders + 1);
+    if (numCoders != 0)
+    {
+      if (_numReservedThreads < 2)
+      {
+        // there is no thread for coder job. So we use single-thread mode.
+        ThreadPool_Release(_numReservedThreads);
+        _numReservedThreads = 0;
+      }
+      else if (numCoders >= _numReservedThreads)
+        numCoders = _numReservedThreads - 1;
+    }
+  }
+ #endif
+
+  if (method != 0)
+  {
+   #ifndef Z7_ST
+    MemBudget_Release(kCoderMemUsage, _memBudgetNum);
+    _memBudgetNum = MemBudget_Reserve(kCoderMemUsage, numCoders);
+    numCoders = _memBudgetNum;
+   #endif
+  }
+  while (_coders.Size() < numCoders)
+    _coders.AddNew();
+  _numCoders = numCoders;
+
+ #ifndef Z7_ST
+  _mtMode = false;
+  if (_numReservedThreads != 0)
+  {
+    const unsigned numJobs = numCoders + 1;
+    while (_threads.Size() < numJobs)
+    {
+      CPackThread &t = _threads.AddNew();
+      t.Packer = this;
+      t.JobIndex = _threads.Size() - 1;
+      if (t.Create() != 0)
+      {
+        _threads.DeleteBack();
+        break;
+      }
+    }
+    _mtMode = (_threads.Size() >= numJobs);
+  }
+ #endif
+  return S_OK;
+}
+
+void CStreamPacker::RunJob(unsigned jobIndex)
+{
+  if (jobIndex == 0)
+  {
+    Sha1_Update(Sha(), _data, _dataSize);
+    return;
+  }
+  CChunkCoder &coder = _coders[jobIndex - 1];
+  const unsigned numChunks = (unsigned)((_dataSize + kChunkSize - 1) >> kChunkSizeBits);
+  HRESULT res = S_OK;
+  for (unsigned i = jobIndex - 1; i < numChunks; i += _numCoders)
+  {
+    const size_t offset = (size_t)i << kChunkSizeBits;
+    size_t size = _dataSize - offset;
+    if (size > kChunkSize)
+      size = kChunkSize;
+    // packed chunk must be smaller than unpacked chunk
+    if (_method == NMethod::kLZX)
+      res = coder.LzxEncoder.Encode(_data + offset, size, _packBuf + offset, size - 1, _packSizes[i]);
+    else
+      res = coder.XpressEncoder.Encode(_data + offset, size, _packBuf + offset, size - 1, _packSizes[i]);
+    if (res != S_OK)
+      break;
+  }
+  coder.Res = res;
+}
+
+void CStreamPacker::StartJobs(bool compress)
+{
+  const unsigned numJobs = compress ? _numCoders + 1 : 1;
+ #ifndef Z7_ST
+  if (_mtMode)
+  {
+    for (unsigned i = 0; i < numJobs; i++)
+      _threads[i].StartEvent.Set();
+    _numStartedJobs = numJobs;
+    return;
+  }
+ #endif
+  for (unsigned i = 0; i < numJobs; i++)
+    RunJob(i);
+}
+
+void CStreamPacker::WaitJobs()
+{
+ #ifndef Z7_ST
+  for (unsigned i = 0; i < _numStartedJobs; i++)
+    _threads[i].FinishedEvent.Lock();
+  _numStartedJobs = 0;
+ #endif
+}
+
+HRESULT CStreamPacker::WriteChunks(ISequentialOutStream *outStream, UInt64 &chunkIndex, unsigned entrySizeShifts)
+{
+  const size_t numEntries = _table.Size() >> entrySizeShifts;
+  for (size_t offset = 0; offset < _dataSize; offset += kChunkSize)
+  {
+    size_t size = _dataSize - offset;
+    if (size > kChunkSize)
+      size = kChunkSize;
+    const size_t packSize = _packSizes[offset >> kChunkSizeBits];
+    const Byte *data = _data + offset;
+    if (packSize != 0)
+    {
+      data = _packBuf + offset;
+      size = packSize;
+    }
+    RINOK(WriteStream(outStream, data, size))
+    PackSize += size;
+    if (chunkIndex < numEntries)
+    {
+      // the offset of next chunk relative to the end of chunk table
+      const UInt64 nextOffset = PackSize - _table.Size();
+      Byte *p = _table + ((size_t)chunkIndex << entrySizeShifts);
+      if (entrySizeShifts == 2)
+        SetUi32(p, (UInt32)nextOffset)
+      else
+        SetUi64(p, nextOffset)
+    }
+    chunkIndex++;
+  }
+  return S_OK;
+}
+
+HRESULT CStreamPacker::Code(ISequentialInStream *inStream, IOutStream *outStream,
+    bool compress, UInt64 expectedSize, ICompressProgressInfo *progress)
+{
+  UnpackSize = 0;
+  PackSize = 0;
+  Compressed = false;
+  SizeError = false;
+  Sha1_Init(Sha());
+
+  if (!outStream || _method == 0 || expectedSize == 0)
+    compress = false;
+  
+  unsigned entrySizeShifts = 2;
+  UInt64 tableOffset = 0;
+  
+  if (compress)
+  {
+    const UInt64 numChunks = (expectedSize + kChunkSize - 1) >> kChunkSizeBits;
+    if (expectedSize >= ((UInt64)1 << 32))
+      entrySizeShifts = 3;
+    const UInt64 tableSize64 = (numChunks - 1) << entrySizeShifts;
+    const size_t tableSize = (size_t)tableSize64;
+    if (tableSize != tableSize64)
+      return E_OUTOFMEMORY;
+    _table.Alloc(tableSize);
+    if (tableSize != 0)
+      memset(_table, 0, tableSize);
+    RINOK(outStream->Seek(0, STREAM_SEEK_CUR, &tableOffset))
+    RINOK(WriteStream(outStream, _table, tableSize))
+    PackSize = tableSize;
+    Compressed = true;
+  }
+
+  UInt64 chunkIndex = 0;
+  unsigned bufIndex = 0;
+  size_t size = kBlockSize;
+  RINOK(ReadStream(inStream, _bufs[0], &size))
+
+  while (size != 0)
+  {
+    _data = _bufs[bufIndex];
+    _dataSize = size;
+    StartJobs(compress);
+    
+    HRESULT readRes = S_OK;
+    size_t nextSize = 0;
+    if (size == kBlockSize)
+    {
+      nextSize = kBlockSize;
+      readRes = ReadStream(inStream, _bufs[bufIndex ^ 1], &nextSize);
+    }
+    
+    WaitJobs();
+    RINOK(readRes)
+    if (compress)
+      for (unsigned i = 0; i < _numCoders; i++)
+      {
+        RINOK(_coders[i].Res)
+      }
+    
+    UnpackSize += size;
+    if (outStream)
+    {
+      if (compress)
+      {
+        if (UnpackSize > expectedSize)
+        {
+          SizeError = true;
+          return S_OK;
+        }
+        RINOK(WriteChunks(outStream, chunkIndex, entrySizeShifts))
+      }
+      else
+      {
+        RINOK(WriteStream(outStream, _data, size))
+        PackSize += size;
+      }
+    }
+    
+    if (progress)
+    {
+      RINOK(progress->SetRatioInfo(&UnpackSize, outStream ? &PackSize : &UnpackSize))
+    }
+    
+    size = nextSize;
+    bufIndex ^= 1;
+  }
+
+  if (compress)
+  {
+    if (UnpackSize != expectedSize)
+    {
+      SizeError = true;
+      return S_OK;
+    }
+    RINOK(outStream->Seek((Int64)tableOffset, STREAM_SEEK_SET, NULL))
+    RINOK(WriteStream(outStream, _table, _table.Size()))
+    RINOK(outStream->Seek((Int64)(tableOffset + PackSize), STREAM_SEEK_SET, NULL))
+    // the single chunk that was stored without compression
+    if (chunkIndex == 1 && PackSize == UnpackSize)
+      Compressed = false;
+  }
+  return S_OK;
+}
+
+
 #define IS_LETTER_CHAR(c) (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z'))
 
 
@@ -1355,11 +1788,11 @@ Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outSeqStream, UInt32 nu
 
   complexity = 0;
 
-  // bool useResourceCompression = false;
-  // use useResourceCompression only if CHeader::Flags compression is also set
+  // the method for new data streams. (method == 0) means no compression
+  unsigned method = (_method > 0 ? (unsigned)_method : 0);
 
   CHeader header;
-  header.SetDefaultFields(false);
+  header.SetDefaultFields(method);
 
   if (isUpdate)
   {
@@ -1368,6 +1801,28 @@ Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outSeqStream, UInt32 nu
     header.Version = srcHeader.Version;
     header.ChunkSize = srcHeader.ChunkSize;
     header.ChunkSizeBits = srcHeader.ChunkSizeBits;
+    if (srcHeader.IsCompressed())
+    {
+      // all compressed resources in archive must use the method from header
+      const unsigned srcMethod = srcHeader.GetMethod();
+      method = 0;
+      if (_method != 0
+          && (_method < 0 || (unsigned)_method == srcMethod)
+          && (srcMethod == NMethod::kXPRESS || srcMethod == NMethod::kLZX)
+          && srcHeader.ChunkSizeBits == kChunkSizeBits)
+        method = srcMethod;
+    }
+    else
+      header.SetMethod(method);
+  }
+
+  CStreamPacker packer;
+  {
+    UInt32 numThreads = 1;
+   #ifndef Z7_ST
+    numThreads = _numThreads;
+   #endif
+    RINOK(packer.Init(method, numThreads))
   }
 
   CMyComPtr<IStreamSetRestriction> setRestriction;
@@ -1383,8 +1838,6 @@ Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outSeqStream, UInt32 nu
 
   UInt64 curPos = kHeaderSizeMax;
 
-  CMyComPtr2_Create<ISequentialInStream, CInStreamWithSha1> inShaStream;
-
   CLimitedSequentialInStream *inStreamLimitedSpec = NULL;
   CMyComPtr<ISequentialInStream> inStreamLimited;
   if (_volumes.Size() == 2)
@@ -1647,26 +2100,8 @@ Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outSeqStream, UInt32 nu
       }
       else
       {
-        inShaStream->SetStream(fileInStream);
-
         CMyComPtr<IInStream> inSeekStream;
         fileInStream.QueryInterface(IID_IInStream, (void **)&inSeekStream);
-        
-        fileInStream.Release();
-        inShaStream->Init();
-        UInt64 offsetBlockSize = 0;
-        /*
-        if (useResourceCompression)
-        {
-          for (UInt64 t = kChunkSize; t < size; t += kChunkSize)
-          {
-            Byte buf[8];
-            SetUi32(buf, (UInt32)t);
-            RINOK(WriteStream(outStream, buf, 4));
-            offsetBlockSize += 4;
-          }
-        }
-        */
 
         // 22.02: we use additional read-only pass to calculate SHA-1
         bool needWritePass = true;
@@ -1674,14 +2109,14 @@ Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outSeqStream, UInt32 nu
         
         if (inSeekStream /* && !sortedHashes.IsEmpty() */)
         {
-          RINOK(copyCoder.Interface()->Code(inShaStream, NULL, NULL, NULL, lps))
-          size = copyCoder->TotalSize;
+          RINOK(packer.Code(fileInStream, NULL, false, 0, lps))
+          size = packer.UnpackSize;
           if (size == 0)
             needWritePass = false;
           else
           {
             Byte hash[kHashSize];
-            inShaStream->Final(hash);
+            packer.GetDigest(hash);
 
             index = AddUniqHash(streams.ConstData(), sortedHashes, hash, -1);
             if (index != -1)
@@ -1692,24 +2127,34 @@ Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outSeqStream, UInt32 nu
             else
             {
               RINOK(InStream_SeekToBegin(inSeekStream))
-              inShaStream->Init();
             }
           }
         }
         
         if (needWritePass)
         {
-          RINOK(copyCoder.Interface()->Code(inShaStream, outStream, NULL, NULL, lps))
-          size = copyCoder->TotalSize;
+          // the chunk table requires the size of stream that is known after read-only pass
+          RINOK(packer.Code(fileInStream, outStream, inSeekStream != NULL, size, lps))
+          if (packer.SizeError)
+          {
+            // the file was changed after read-only pass
+            RINOK(InStream_SeekToBegin(inSeekStream))
+            RINOK(outStream->Seek((Int64)curPos, STREAM_SEEK_SET, NULL))
+            RINOK(outStream->SetSize(curPos))
+            RINOK(packer.Code(fileInStream, outStream, false, 0, lps))
+          }
+          size = packer.UnpackSize;
         }
+
+        fileInStream.Release();
        
         if (size != 0)
         {
           if (needWritePass)
           {
             Byte hash[kHashSize];
-            const UInt64 packSize = offsetBlockSize + size;
-            inShaStream->Final(hash);
+            const UInt64 packSize = packer.PackSize;
+            packer.GetDigest(hash);
             
             index = AddUniqHash(streams.ConstData(), sortedHashes, hash, (int)streams.Size());
             
@@ -1726,11 +2171,7 @@ Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outSeqStream, UInt32 nu
               s.Resource.PackSize = packSize;
               s.Resource.Offset = curPos;
               s.Resource.UnpackSize = size;
-              s.Resource.Flags = 0;
-              /*
-              if (useResourceCompression)
-              s.Resource.Flags = NResourceFlags::Compressed;
-              */
+              s.Resource.Flags = (Byte)(packer.Compressed ? NResourceFlags::kCompressed : 0);
               s.PartNumber = 1;
               s.RefCount = 1;
               memcpy(s.Hash, hash, kHashSize);
@@ -267,7 +267,9 @@ struct CHeader
   CResource MetadataResource;
   CResource IntegrityResource;
 
-  void SetDefaultFields(bool useLZX);
+  // (method == 0) means no compression
+  void SetMethod(unsigned method);
+  void SetDefaultFields(unsigned method);
 
   void WriteTo(Byte *p) const;
   HRESULT Parse(const Byte *p, UInt64 &phySize);
@@ -2,17 +2,27 @@
 
 #include "StdAfx.h"
 
+#ifndef Z7_ST
+#include "../../../../C/MemBudget.h"
+#endif
+
 #include "../../../Common/ComTry.h"
 #include "../../../Common/StringConvert.h"
 
 #include "../../../Windows/PropVariant.h"
 #include "../../../Windows/PropVariantUtils.h"
 #include "../../../Windows/TimeUtils.h"
+#ifndef Z7_ST
+#include "../../../Windows/Thread.h"
+#endif
 
 #include "../../IPassword.h"
 
 #include "../../Common/FilterCoder.h"
 #include "../../Common/LimitedStreams.h"
+#ifndef Z7_ST
+#include "../../Common/LockedStream.h"
+#endif
 #include "../../Common/ProgressUtils.h"
 #include "../../Common/StreamObjects.h"
 #include "../../Common/StreamUtils.h"
@@ -869,9 +879,13 @@ public:
       lzmaDecoderSpec(NULL)
     {}
 
+  // worker threads of CMtExtract use the password that was received by main thread
+  void SetGetTextPassword(ICryptoGetTextPassword *p) { getTextPassword = p; }
+
   HRESULT Decode(
     DECL_EXTERNAL_CODECS_LOC_VARS
     CInArchive &archive, const CItemEx &item,
+    ISequentialInStream *posPackStream,
     ISequentialOutStream *realOutStream,
     IArchiveExtractCallback *extractCallback,
     ICompressProgressInfo *compressProgress,
@@ -972,6 +986,7 @@ Z7_COM7F_IMF(COutStreamWithPadPKCS7::Write(const void *data, UInt32 size, UInt32
 HRESULT CZipDecoder::Decode(
     DECL_EXTERNAL_CODECS_LOC_VARS
     CInArchive &archive, const CItemEx &item,
+    ISequentialInStream *posPackStream,
     ISequentialOutStream *realOutStream,
     IArchiveExtractCallback *extractCallback,
     ICompressProgressInfo *compressProgress,
@@ -1043,7 +1058,13 @@ HRESULT CZipDecoder::Decode(
         return S_OK;
       packSize -= NCrypto::NWzAes::kMacSize;
     }
-    RINOK(archive.GetItemStream(item, true, packStream))
+    // (posPackStream) is used instead of archive stream in multithreaded extraction
+    if (posPackStream)
+      packStream = posPackStream;
+    else
+    {
+      RINOK(archive.GetItemStream(item, true, packStream))
+    }
     if (!packStream)
     {
       res = NExtract::NOperationResult::kUnavailable;
@@ -1081,13 +1102,25 @@ HRESULT CZipDecoder::Decode(
       _zipCryptoDecoder.Create_if_Empty();
       cryptoFilter = _zipCryptoDecoder;
     }
+
+    #ifndef Z7_ST
+    {
+      // AES decoders split big buffers to threads
+      CMyComPtr<ICompressSetCoderMt> setCoderMt;
+      cryptoFilter.QueryInterface(IID_ICompressSetCoderMt, &setCoderMt);
+      if (setCoderMt)
+      {
+        RINOK(setCoderMt->SetNumberOfThreads(numThreads))
+      }
+    }
+    #endif
     
     CMyComPtr<ICryptoSetPassword> cryptoSetPassword;
     RINOK(cryptoFilter.QueryInterface(IID_ICryptoSetPassword, &cryptoSetPassword))
     if (!cryptoSetPassword)
       return E_FAIL;
     
-    if (!getTextPassword)
+    if (!getTextPassword && extractCallback)
       extractCallback->QueryInterface(IID_ICryptoGetTextPassword, (void **)&getTextPassword);
     
     if (getTextPassword)
@@ -1558,6 +1591,361 @@ HRESULT CZipDecoder::Decode(
 }
 
 
+#ifndef Z7_ST
+
+/*
+Multithreaded extraction:
+  The main thread reads local headers of all items before decoding.
+  Worker threads decode small items to memory buffers in order of items.
+  The main thread calls extract callback and writes the buffers in order of items.
+  Big items are decoded by the main thread.
+  Encrypted items are decoded by the main thread, if there is no password callback.
+  All threads read archive data by position via CLockedInStream.
+  The total size of buffers is limited. So worker threads can wait,
+  until the main thread releases the buffers.
+*/
+
+// it writes to the buffer of declared size of item.
+// If the decoder writes more data, we stop the decoder, and the main thread decodes the item again.
+
+Z7_CLASS_IMP_NOQIB_1(
+  CMtExtractBufStream
+  , ISequentialOutStream
+)
+public:
+  CByteBuffer Buf;
+  size_t Pos;
+
+  void Init(size_t size)
+  {
+    Buf.Alloc(size);
+    Pos = 0;
+  }
+};
+
+Z7_COM7F_IMF(CMtExtractBufStream::Write(const void *data, UInt32 size, UInt32 *processedSize))
+{
+  if (processedSize)
+    *processedSize = 0;
+  if (size > Buf.Size() - Pos)
+    return E_FAIL;
+  memcpy(Buf + Pos, data, size);
+  Pos += size;
+  if (processedSize)
+    *processedSize = size;
+  return S_OK;
+}
+
+
+struct CMtExtractItem
+{
+  CItemEx Item;
+  HRESULT LocalRes;
+  bool IsAvail;
+  bool HeadersError;
+  bool UseThread;
+  bool Finished;
+  Int32 OpRes;
+  HRESULT Result;
+  UInt64 BufSize;
+  unsigned BufSize_BudgetNum; // the number of (BufSize) units reserved in memory budget
+  CMyComPtr2<ISequentialOutStream, CMtExtractBufStream> OutBuf;
+
+  CMtExtractItem():
+      LocalRes(S_OK),
+      IsAvail(true),
+      HeadersError(false),
+      UseThread(false),
+      Finished(false),
+      OpRes(NExtract::NOperationResult::kDataError),
+      Result(S_OK),
+      BufSize(0),
+      BufSize_BudgetNum(0)
+    {}
+};
+
+
+class CMtExtract;
+
+Z7_CLASS_IMP_NOQIB_1(
+  CMtExtractProgress
+  , ICompressProgressInfo
+)
+public:
+  CMtExtract *Mt;
+};
+
+/* The password callback of extract callback must be called only from main thread.
+   So main thread gets the password before the start of worker threads,
+   and each worker thread has own object that returns that password. */
+
+Z7_CLASS_IMP_NOQIB_1(
+  CMtExtractPassword
+  , ICryptoGetTextPassword
+)
+public:
+  CMtExtract *Mt;
+};
+
+static THREAD_FUNC_DECL MtExtractThread(void *threadInfo);
+
+struct CMtExtractThread
+{
+  DECL_EXTERNAL_CODECS_LOC_VARS_DECL
+
+  CMtExtract *Mt;
+  NWindows::CThread Thread;
+  CZipDecoder Decoder;
+  CMyComPtr2_Create<ICompressProgressInfo, CMtExtractProgress> Progress;
+  CMyComPtr2_Create<ICryptoGetTextPassword, CMtExtractPassword> GetTextPassword;
+
+  void ThreadFunc();
+};
+
+
+class CMtExtract
+{
+public:
+  NWindows::NSynchronization::CCriticalSection CS;
+  NWindows::NSynchronization::CAutoResetEvent StartEvent;
+  NWindows::NSynchronization::CAutoResetEvent FinishEvent;
+
+  CMyComPtr2<IUnknown, CLockedInStream> LockedStream;
+  CInArchive *Archive;
+  bool TestMode;
+  bool Exit;
+  bool PasswordIsDefined;
+  UString_Wipe Password;
+
+  CObjectVector<CMtExtractItem> Items;
+  CRecordVector<unsigned> Jobs; // indexes of items that are decoded by worker threads
+  unsigned NextJob;
+  UInt64 BufSize;
+  UInt64 BufSizeMax;
+  UInt64 MemUsage;
+
+  CObjectVector<CMtExtractThread> Threads;
+
+  CMtExtract():
+      Archive(NULL),
+      TestMode(false),
+      Exit(false),
+      PasswordIsDefined(false),
+      NextJob(0),
+      BufSize(0),
+      BufSizeMax(0),
+      MemUsage(0)
+    {}
+  ~CMtExtract()
+  {
+    StopThreads();
+    FOR_VECTOR (i, Items)
+    {
+      const CMtExtractItem &mi = Items[i];
+      MemBudget_Release(mi.BufSize, mi.BufSize_BudgetNum);
+    }
+  }
+
+  HRESULT StartThreads(
+      DECL_EXTERNAL_CODECS_LOC_VARS
+      unsigned numThreads);
+  void StopThreads();
+
+  bool GetNextJob(unsigned &itemIndex);
+  void FinishJob(unsigned itemIndex, HRESULT res);
+  void WaitItem(unsigned itemIndex);
+  void FreeItem(unsigned itemIndex);
+
+  bool IsExitMode()
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+    return Exit;
+  }
+};
+
+
+Z7_COM7F_IMF(CMtExtractProgress::SetRatioInfo(const UInt64 * /* inSize */, const UInt64 * /* outSize */))
+{
+  return Mt->IsExitMode() ? E_ABORT : S_OK;
+}
+
+Z7_COM7F_IMF(CMtExtractPassword::CryptoGetTextPassword(BSTR *password))
+{
+  return StringToBstr(Mt->Password, password);
+}
+
+
+bool CMtExtract::GetNextJob(unsigned &itemIndex)
+{
+  for (;;)
+  {
+    {
+      NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+      if (Exit || NextJob == Jobs.Size())
+      {
+        // we wake up another waiting thread, so it also can exit
+        StartEvent.Set();
+        return false;
+      }
+      const unsigned index = Jobs[NextJob];
+      CMtExtractItem &mi = Items[index];
+      const UInt64 size = mi.BufSize;
+      /* the buffers are also reserved in memory budget of process.
+         The first buffer always gets the reservation. If another buffer
+         doesn't get the reservation, we wait until the main thread releases buffers. */
+      if (BufSize == 0 || BufSize + size <= BufSizeMax)
+      {
+        if (size != 0)
+          mi.BufSize_BudgetNum = (BufSize == 0 ?
+              MemBudget_Reserve(size, 1) :
+              MemBudget_Reserve_Optional(size, 1));
+        if (size == 0 || mi.BufSize_BudgetNum != 0)
+        {
+          BufSize += size;
+          NextJob++;
+          itemIndex = index;
+          // another thread can check next job
+          StartEvent.Set();
+          return true;
+        }
+      }
+    }
+    StartEvent.Lock();
+  }
+}
+
+
+void CMtExtract::FinishJob(unsigned itemIndex, HRESULT res)
+{
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+    CMtExtractItem &mi = Items[itemIndex];
+    mi.Result = res;
+    mi.Finished = true;
+  }
+  FinishEvent.Set();
+}
+
+
+void CMtExtract::WaitItem(unsigned itemIndex)
+{
+  for (;;)
+  {
+    {
+      NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+      if (Items[itemIndex].Finished)
+        return;
+    }
+    FinishEvent.Lock();
+  }
+}
+
+
+void CMtExtract::FreeItem(unsigned itemIndex)
+{
+  CMtExtractItem &mi = Items[itemIndex];
+  mi.OutBuf.SetFromCls(NULL);
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+    BufSize -= mi.BufSize;
+    MemBudget_Release(mi.BufSize, mi.BufSize_BudgetNum);
+    mi.BufSize_BudgetNum = 0;
+  }
+  StartEvent.Set();
+}
+
+
+HRESULT CMtExtract::StartThreads(
+    DECL_EXTERNAL_CODECS_LOC_VARS
+    unsigned numThreads)
+{
+  {
+    const WRes wres = StartEvent.CreateIfNotCreated_Reset();
+    if (wres != 0)
+      return HRESULT_FROM_WIN32(wres);
+  }
+  {
+    const WRes wres = FinishEvent.CreateIfNotCreated_Reset();
+    if (wres != 0)
+      return HRESULT_FROM_WIN32(wres);
+  }
+  Threads.ClearAndReserve(numThreads);
+  for (unsigned i = 0; i < numThreads; i++)
+  {
+    CMtExtractThread &t = Threads.AddNew();
+    #ifdef Z7_EXTERNAL_CODECS
+    t._externalCodecs = _externalCodecs;
+    #endif
+    t.Mt = this;
+    t.Progress->Mt = this;
+    t.GetTextPassword->Mt = this;
+    if (PasswordIsDefined)
+      t.Decoder.SetGetTextPassword(t.GetTextPassword);
+    const WRes wres = t.Thread.Create(MtExtractThread, &t);
+    if (wres != 0)
+      return HRESULT_FROM_WIN32(wres);
+  }
+  return S_OK;
+}
+
+
+void CMtExtract::StopThreads()
+{
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+    Exit = true;
+  }
+  if (StartEvent.IsCreated())
+    StartEvent.Set();
+  FOR_VECTOR (i, Threads)
+  {
+    CMtExtractThread &t = Threads[i];
+    if (t.Thread.IsCreated())
+      t.Thread.Wait_Close();
+  }
+  Threads.Clear();
+}
+
+
+void CMtExtractThread::ThreadFunc()
+{
+  unsigned itemIndex;
+  while (Mt->GetNextJob(itemIndex))
+  {
+    CMtExtractItem &mi = Mt->Items[itemIndex];
+    HRESULT res;
+    try
+    {
+      if (!Mt->TestMode)
+      {
+        mi.OutBuf.Create_if_Empty();
+        mi.OutBuf->Init((size_t)mi.Item.Size);
+      }
+      UInt64 pos = 0;
+      Mt->Archive->GetItemDataPos(mi.Item, pos);
+      CMyComPtr2_Create<ISequentialInStream, CLockedSequentialInStream> inStream;
+      inStream->Init(Mt->LockedStream.ClsPtr(), pos);
+      res = Decoder.Decode(
+          EXTERNAL_CODECS_LOC_VARS
+          *Mt->Archive, mi.Item, inStream,
+          mi.OutBuf, NULL, Progress,
+          1, Mt->MemUsage,
+          mi.OpRes);
+    }
+    catch(...) { res = E_OUTOFMEMORY; }
+    Mt->FinishJob(itemIndex, res);
+  }
+}
+
+static THREAD_FUNC_DECL MtExtractThread(void *threadInfo)
+{
+  ((CMtExtractThread *)threadInfo)->ThreadFunc();
+  return 0;
+}
+
+#endif
+
+
 Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     Int32 testMode, IArchiveExtractCallback *extractCallback))
 {
@@ -1579,6 +1967,85 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 
   CZipDecoder myDecoder;
   UInt64 cur_Unpacked, cur_Packed;
+
+  #ifndef Z7_ST
+  CMtExtract mt;
+  bool useMt = false;
+  if (_props._numThreads > 1 && numItems > 1 && m_Archive.CanReadItemsByPos())
+  {
+    mt.Archive = &m_Archive;
+    mt.TestMode = (testMode != 0);
+    mt.MemUsage = _props._memUsage_Decompress / _props._numThreads;
+    UInt64 bufSizeMax = _props._memUsage_Decompress / 4;
+    const UInt64 kBufSizeMax = (UInt64)1 << (sizeof(size_t) > 4 ? 30 : 28);
+    if (bufSizeMax > kBufSizeMax)
+      bufSizeMax = kBufSizeMax;
+    mt.BufSizeMax = bufSizeMax;
+    const UInt64 itemSizeMax = bufSizeMax / _props._numThreads / 2;
+
+    CMyComPtr<ICryptoGetTextPassword> getTextPassword;
+    extractCallback->QueryInterface(IID_ICryptoGetTextPassword, (void **)&getTextPassword);
+
+    mt.Items.ClearAndReserve(numItems);
+    for (i = 0; i < numItems; i++)
+    {
+      CMtExtractItem &mi = mt.Items.AddNew();
+      mi.Item = m_Items[allFilesMode ? i : indices[i]];
+      CItemEx &item = mi.Item;
+      if (!m_Archive.IsLocalOffsetOK(item))
+        continue;
+      if (!item.FromLocal)
+      {
+        mi.LocalRes = m_Archive.Read_LocalItem_After_CdItem(item, mi.IsAvail, mi.HeadersError);
+        if (mi.LocalRes != S_OK)
+        {
+          if (mi.LocalRes != S_FALSE)
+            return mi.LocalRes;
+          continue;
+        }
+      }
+      if (item.IsDir())
+        continue;
+      UInt64 pos;
+      if (!m_Archive.GetItemDataPos(item, pos))
+      {
+        /* the main thread would read such item from base stream of archive
+           without CLockedInStream, while worker threads use that stream.
+           So we don't use multithreading for such archive. */
+        mt.Jobs.Clear();
+        break;
+      }
+      if ((item.IsEncrypted() && !getTextPassword)
+          || (item.FromLocal && item.HasDescriptor())
+          || item.Size > itemSizeMax)
+        continue;
+      if (item.IsEncrypted() && !mt.PasswordIsDefined)
+      {
+        /* sequential extraction also asks the password for first encrypted item,
+           and extract callback keeps the password for next items. */
+        CMyComBSTR_Wipe password;
+        RINOK(getTextPassword->CryptoGetTextPassword(&password))
+        if (password)
+          mt.Password.SetFromBstr(password);
+        mt.PasswordIsDefined = true;
+      }
+      mi.UseThread = true;
+      mi.BufSize = testMode ? 0 : item.Size;
+      mt.Jobs.Add(i);
+    }
+
+    if (mt.Jobs.Size() > 1)
+    {
+      mt.LockedStream.Create_if_Empty();
+      RINOK(mt.LockedStream->Init(m_Archive.GetBaseStream()))
+      unsigned numThreads = _props._numThreads;
+      if (numThreads > mt.Jobs.Size())
+        numThreads = mt.Jobs.Size();
+      RINOK(mt.StartThreads(EXTERNAL_CODECS_VARS numThreads))
+      useMt = true;
+    }
+  }
+  #endif
   
   CMyComPtr2_Create<ICompressProgressInfo, CLocalProgress> lps;
   lps->Init(extractCallback, false);
@@ -1592,6 +2059,10 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
       return S_OK;
     const UInt32 index = allFilesMode ? i : indices[i];
     CItemEx item = m_Items[index];
+    #ifndef Z7_ST
+    if (useMt)
+      item = mt.Items[i].Item;
+    #endif
     cur_Unpacked = item.Size;
     cur_Packed = item.PackSize;
 
@@ -1620,7 +2091,18 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     if (!item.FromLocal)
     {
       bool isAvail = true;
-      const HRESULT hres = m_Archive.Read_LocalItem_After_CdItem(item, isAvail, headersError);
+      HRESULT hres;
+      #ifndef Z7_ST
+      if (useMt)
+      {
+        const CMtExtractItem &mi = mt.Items[i];
+        isAvail = mi.IsAvail;
+        headersError = mi.HeadersError;
+        hres = mi.LocalRes;
+      }
+      else
+      #endif
+        hres = m_Archive.Read_LocalItem_After_CdItem(item, isAvail, headersError);
       if (hres == S_FALSE)
       {
         if (item.IsDir() || realOutStream || testMode)
@@ -1648,14 +2130,66 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
       continue;
     }
 
+    #ifndef Z7_ST
+    // the buffer of item can be released only after the end of decoding in worker thread
+    const bool useThread = (useMt && mt.Items[i].UseThread);
+    if (useThread)
+      mt.WaitItem(i);
+    #endif
+
     if (!testMode && !realOutStream)
+    {
+      #ifndef Z7_ST
+      if (useThread)
+        mt.FreeItem(i);
+      #endif
       continue;
+    }
 
     RINOK(extractCallback->PrepareOperation(askMode))
 
+    #ifndef Z7_ST
+    CMyComPtr<ISequentialInStream> posPackStream;
+    bool wasDecoded = false;
+    if (useMt)
+    {
+      if (useThread)
+      {
+        const CMtExtractItem &mi = mt.Items[i];
+        if (mi.Result == S_OK)
+        {
+          if (realOutStream && mi.OutBuf.IsDefined())
+          {
+            RINOK(WriteStream(realOutStream, mi.OutBuf->Buf, mi.OutBuf->Pos))
+          }
+          opRes = mi.OpRes;
+          wasDecoded = true;
+        }
+        /* else : the data is larger than declared size (CMtExtractBufStream returns E_FAIL),
+           or there was another error in worker thread. So we decode the item again here. */
+        mt.FreeItem(i);
+      }
+      // the main thread also reads archive by position, because worker threads use archive stream
+      UInt64 pos;
+      if (m_Archive.GetItemDataPos(item, pos))
+      {
+        CLockedSequentialInStream *posStreamSpec = new CLockedSequentialInStream;
+        posPackStream = posStreamSpec;
+        posStreamSpec->Init(mt.LockedStream.ClsPtr(), pos);
+      }
+    }
+    if (!wasDecoded)
+    #endif
+    {
     const HRESULT hres = myDecoder.Decode(
         EXTERNAL_CODECS_VARS
-        m_Archive, item, realOutStream, extractCallback,
+        m_Archive, item,
+        #ifndef Z7_ST
+        posPackStream,
+        #else
+        NULL,
+        #endif
+        realOutStream, extractCallback,
         lps,
         #ifndef Z7_ST
         _props._numThreads, _props._memUsage_Decompress,
@@ -1663,6 +2197,7 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
         opRes);
     
     RINOK(hres)
+    }
     // realOutStream.Release();
     
     if (opRes == NExtract::NOperationResult::kOK && headersError)
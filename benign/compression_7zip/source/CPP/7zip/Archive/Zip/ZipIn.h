@@ -425,6 +425,18 @@ public:
 
   IInStream *GetBaseStream() { return StreamRef; }
 
+  // the data of items can be read from base stream by position (multithreaded extraction)
+  bool CanReadItemsByPos() const { return !IsMultiVol; }
+  
+  // it's for single volume archive. It returns false, if the data is not available.
+  bool GetItemDataPos(const CItemEx &item, UInt64 &pos) const
+  {
+    if (UseDisk_in_SingleVol && item.Disk != EcdVolIndex)
+      return false;
+    pos = (UInt64)((Int64)(item.LocalHeaderPos + item.LocalFullHeaderSize) + ArcInfo.Base);
+    return true;
+  }
+
   bool CanUpdate() const
   {
     if (AreThereErrors()
@@ -12,6 +12,9 @@
 #endif
 
 #include "../../../../C/Alloc.h"
+#ifndef Z7_ST
+#include "../../../../C/MemBudget.h"
+#endif
 
 #include "../../../Common/AutoPtr.h"
 #include "../../../Common/Defs.h"
@@ -288,6 +291,10 @@ struct CThreadInfo
 
 void CThreadInfo::WaitAndCode()
 {
+  /* Update2() has reserved the memory in memory budget for each zip thread,
+     and that reservation includes the memory of one thread of encoder.
+     So multithreaded encoder (MtCoder) reserves only for its additional threads. */
+  MemBudget_SetThreadReserved(True);
   for (;;)
   {
     CompressEvent.Lock();
@@ -798,6 +805,28 @@ static const size_t kMemPerThread = (size_t)sizeof(size_t) << 23;
 // static const size_t kMemPerThread = (size_t)sizeof(size_t) << 16; // for debug
 // static const size_t kMemPerThread = (size_t)1 << 16; // for debug
 
+// it releases the reserved memory budget at the end of update
+class CMemBudgetReservation
+{
+  UInt64 _unitSize;
+  unsigned _num;
+public:
+  CMemBudgetReservation(): _unitSize(0), _num(0) {}
+  ~CMemBudgetReservation() { Release(); }
+  void Release()
+  {
+    MemBudget_Release(_unitSize, _num);
+    _num = 0;
+  }
+  unsigned Reserve(UInt64 unitSize, unsigned numWanted)
+  {
+    Release();
+    _unitSize = unitSize;
+    _num = MemBudget_Reserve_Optional(unitSize, numWanted);
+    return _num;
+  }
+};
+
 /*
 in:
    nt_Zip >= 1:  the starting maximum number of ZIP threads for search
@@ -1054,6 +1083,8 @@ static HRESULT Update2(
   */
 
   bool mtMode = (numThreads > 1);
+  UInt64 threadMemUsage = kMemPerThread;
+  CMemBudgetReservation memBudget;
 
   if (numFilesToCompress <= 1)
     mtMode = false;
@@ -1147,6 +1178,13 @@ static HRESULT Update2(
         numXzThreads = (int)t;
       }
       numThreads /= (unsigned)numXzThreads;
+      // the memory for one thread of xz encoder: nested MtCoder reserves for other threads
+      threadMemUsage = kMemPerThread + oneMethodMain->Get_Lzma_MemUsage(true);
+      {
+        const UInt64 blockSize = oneMethodMain->Get_Xz_BlockSize();
+        if (blockSize != (UInt64)(Int64)-1)
+          threadMemUsage += blockSize * 2;
+      }
     }
     /*
     else if (method == NFileHeader::NCompressionMethod::kZstdWz)
@@ -1162,16 +1200,16 @@ static HRESULT Update2(
         || method == NFileHeader::NCompressionMethod::kDeflate64
         || method == NFileHeader::NCompressionMethod::kPPMd)
     {
+      UInt64 methodMemUsage;
+      if (method == NFileHeader::NCompressionMethod::kPPMd)
+        methodMemUsage = oneMethodMain->Get_Ppmd_MemSize();
+      else
+        methodMemUsage = (4 << 20); // for deflate
+      threadMemUsage = kMemPerThread + methodMemUsage;
       if (numThreads > 1
           && options._memUsage_WasSet
           && !options._numThreads_WasForced)
       {
-        UInt64 methodMemUsage;
-        if (method == NFileHeader::NCompressionMethod::kPPMd)
-          methodMemUsage = oneMethodMain->Get_Ppmd_MemSize();
-        else
-          methodMemUsage = (4 << 20); // for deflate
-        const UInt64 threadMemUsage = kMemPerThread + methodMemUsage;
         const UInt64 numThreads64 = options._memUsage_Compress / threadMemUsage;
         if (numThreads64 < numThreads)
           numThreads = (UInt32)numThreads64;
@@ -1183,12 +1221,11 @@ static HRESULT Update2(
       const UInt32 numLZMAThreads = oneMethodMain->Get_Lzma_NumThreads();
       numThreads /= numLZMAThreads;
 
+      threadMemUsage = kMemPerThread + oneMethodMain->Get_Lzma_MemUsage(true);
       if (numThreads > 1
           && options._memUsage_WasSet
           && !options._numThreads_WasForced)
       {
-        const UInt64 methodMemUsage = oneMethodMain->Get_Lzma_MemUsage(true);
-        const UInt64 threadMemUsage = kMemPerThread + methodMemUsage;
         const UInt64 numThreads64 = options._memUsage_Compress / threadMemUsage;
         if (numThreads64 < numThreads)
           numThreads = (UInt32)numThreads64;
@@ -1198,8 +1235,13 @@ static HRESULT Update2(
 
     if (numThreads > numZipThreads_limit)
       numThreads = numZipThreads_limit;
+    // the memory budget of process can reduce the number of zip threads
+    if (numThreads > 1)
+      numThreads = memBudget.Reserve(threadMemUsage, numThreads);
     if (numThreads <= 1)
     {
+      // the encoder in main thread reserves the memory itself
+      memBudget.Release();
       mtMode = false;
       numThreads = 1;
     }
@@ -1646,10 +1688,11 @@ static const size_t kCacheBlockSize = 1 << 20;
 static const size_t kCacheSize = kCacheBlockSize << 2;
 static const size_t kCacheMask = kCacheSize - 1;
 
-Z7_CLASS_IMP_NOQIB_2(
+Z7_CLASS_IMP_NOQIB_3(
   CCacheOutStream
   , IOutStream
   , IStreamSetRestriction
+  , IOutStreamCopyFrom
 )
   Z7_IFACE_COM7_IMP(ISequentialOutStream)
 
@@ -2051,6 +2094,42 @@ Z7_COM7F_IMF(CCacheOutStream::SetRestriction(UInt64 begin, UInt64 end))
 }
 
 
+/* CopyFrom() is used for copying of unchanged items from old archive.
+   We flush the cache and then we pass the call to base stream,
+   if that stream supports OS-level copying. */
+
+Z7_COM7F_IMF(CCacheOutStream::CopyFrom(IInStream *inStream, UInt64 size, UInt64 *processedSize))
+{
+  *processedSize = 0;
+  if (_hres != S_OK)
+    return _hres;
+  // the data in restricted region can be rewritten, so it must be written via cache
+  if (_restrict_begin != _restrict_end)
+    return E_NOTIMPL;
+  Z7_DECL_CMyComPtr_QI_FROM(IOutStreamCopyFrom, copyFrom, _seqStream)
+  if (!copyFrom)
+    return E_NOTIMPL;
+  RINOK(FlushCache())
+  RINOK(SeekPhy(_virtPos))
+  if (_setRestriction)
+  {
+    _hres = _setRestriction->SetRestriction(_restrict_begin, _restrict_end);
+    RINOK(_hres)
+  }
+  const HRESULT res = copyFrom->CopyFrom(inStream, size, processedSize);
+  const UInt64 processed = *processedSize;
+  _virtPos += processed;
+  if (_virtSize < _virtPos)
+    _virtSize = _virtPos;
+  _phyPos += processed;
+  if (_phySize < _phyPos)
+    _phySize = _phyPos;
+  if (res != S_OK && res != E_NOTIMPL)
+    _hres = res;
+  return res;
+}
+
+
 
 HRESULT Update(
     DECL_EXTERNAL_CODECS_LOC_VARS
@@ -7,6 +7,8 @@
 
 #include "../../Common/ComTry.h"
 
+#include "../../Windows/FileIO.h"
+
 #include "../Common/MethodProps.h"
 #include "../Common/ProgressUtils.h"
 #include "../Common/RegisterArc.h"
@@ -155,6 +157,8 @@ class CHandler Z7_final:
   CZstdDecInfo _parsed_Info;
   CZstdDecInfo _decoded_Info;
 
+  CByteBuffer _dictData;
+
   CMyComPtr<IInStream> _stream;
   CMyComPtr<ISequentialInStream> _seqStream;
 
@@ -814,6 +818,7 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     decoder->FinishMode = true;
 #ifndef Z7_USE_ZSTD_ORIG_DECODER
     decoder->DisableHash = _disableHash;
+    RINOK(decoder->SetDictionary(_dictData, _dictData.Size()))
 #endif
     
     // _dataAfterEnd = false;
@@ -910,12 +915,35 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 
 
 
+static const UInt32 k_DictSizeMax = (UInt32)1 << 27;
+
+static HRESULT ReadDictFile(const FString &path, CByteBuffer &data)
+{
+  NFile::NIO::CInFile file;
+  if (!file.Open(path))
+    return GetLastError_noZero_HRESULT();
+  UInt64 fileSize;
+  if (!file.GetLength(fileSize))
+    return GetLastError_noZero_HRESULT();
+  if (fileSize == 0 || fileSize > k_DictSizeMax)
+    return E_INVALIDARG;
+  data.Alloc((size_t)fileSize);
+  size_t processed;
+  if (!file.ReadFull(data, (size_t)fileSize, processed))
+    return GetLastError_noZero_HRESULT();
+  if (processed != fileSize)
+    return E_FAIL;
+  return S_OK;
+}
+
+
 Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVARIANT *values, UInt32 numProps))
 {
   // return _props.SetProperties(names, values, numProps);
   // _smallMode = false;
   _disableHash = false;
   _parseMode = false;
+  _dictData.Free();
   // _parseMode = true; // for debug
 #ifdef Z7_USE_ZSTD_COMPRESSION
   _props.Init();
@@ -933,6 +961,14 @@ Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVAR
         _parseMode = parseMode;
       continue;
     }
+    if (name.IsEqualTo("dict"))
+    {
+      // zstd dictionary file or raw content dictionary file for decoding
+      if (value.vt != VT_BSTR)
+        return E_INVALIDARG;
+      RINOK(ReadDictFile(us2fs(value.bstrVal), _dictData))
+      continue;
+    }
     if (name.IsPrefixedBy_Ascii_NoCase("crc"))
     {
       name.Delete(0, 3);
@@ -790,6 +790,14 @@ SOURCE=..\..\Common\RegisterCodec.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Common\StageStats.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Common\StageStats.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Common\StreamBinder.cpp
 # End Source File
 # Begin Source File
@@ -1868,6 +1876,14 @@ SOURCE=..\..\UI\Common\TempFiles.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\UI\Common\TrainDict.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\UI\Common\TrainDict.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\UI\Common\Update.cpp
 # End Source File
 # Begin Source File
@@ -3237,6 +3253,54 @@ SOURCE=..\..\..\..\C\SwapBytes.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.c
+
+!IF  "$(CFG)" == "Alone - Win32 Release"
+
+# ADD CPP /O2
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ELSEIF  "$(CFG)" == "Alone - Win32 Debug"
+
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ELSEIF  "$(CFG)" == "Alone - Win32 ReleaseU"
+
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ELSEIF  "$(CFG)" == "Alone - Win32 DebugU"
+
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.c
+
+!IF  "$(CFG)" == "Alone - Win32 Release"
+
+# ADD CPP /O2
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ELSEIF  "$(CFG)" == "Alone - Win32 Debug"
+
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ELSEIF  "$(CFG)" == "Alone - Win32 ReleaseU"
+
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ELSEIF  "$(CFG)" == "Alone - Win32 DebugU"
+
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.c
 
 !IF  "$(CFG)" == "Alone - Win32 Release"
@@ -3261,6 +3325,14 @@ SOURCE=..\..\..\..\C\Threads.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.h
 # End Source File
 # Begin Source File
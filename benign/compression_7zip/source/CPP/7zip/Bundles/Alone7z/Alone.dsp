@@ -750,6 +750,14 @@ SOURCE=..\..\Common\RegisterCodec.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Common\StageStats.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Common\StageStats.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Common\StreamBinder.cpp
 # End Source File
 # Begin Source File
@@ -1238,6 +1246,14 @@ SOURCE=..\..\UI\Common\TempFiles.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\UI\Common\TrainDict.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\UI\Common\TrainDict.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\UI\Common\Update.cpp
 # End Source File
 # Begin Source File
@@ -2042,11 +2058,29 @@ SOURCE=..\..\..\..\C\SwapBytes.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.c
 # SUBTRACT CPP /YX /Yc /Yu
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.h
 # End Source File
 # End Group
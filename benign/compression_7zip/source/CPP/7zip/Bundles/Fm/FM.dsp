@@ -901,6 +901,14 @@ SOURCE=..\..\Common\PropId.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Common\StageStats.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Common\StageStats.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Common\StreamBinder.cpp
 # End Source File
 # Begin Source File
@@ -1185,11 +1193,29 @@ SOURCE=..\..\..\..\C\Sort.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.c
 # SUBTRACT CPP /YX /Yc /Yu
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.h
 # End Source File
 # Begin Source File
@@ -52,6 +52,7 @@ WIN_OBJS = \
   $O\ProgressMt.obj \
   $O\ProgressUtils.obj \
   $O\PropId.obj \
+  $O\StageStats.obj \
   $O\StreamBinder.obj \
   $O\StreamObjects.obj \
   $O\StreamUtils.obj \
@@ -65,6 +66,7 @@ AR_OBJS = \
   $O\ArjHandler.obj \
   $O\Base64Handler.obj \
   $O\Bz2Handler.obj \
+  $O\CasHandler.obj \
   $O\ComHandler.obj \
   $O\CpioHandler.obj \
   $O\CramfsHandler.obj \
@@ -221,6 +223,7 @@ COMPRESS_OBJS = \
   $O\LzmsDecoder.obj \
   $O\LzOutWindow.obj \
   $O\LzxDecoder.obj \
+  $O\LzxEncoder.obj \
   $O\PpmdDecoder.obj \
   $O\PpmdEncoder.obj \
   $O\PpmdRegister.obj \
@@ -234,6 +237,7 @@ COMPRESS_OBJS = \
   $O\RarCodecsRegister.obj \
   $O\ShrinkDecoder.obj \
   $O\XpressDecoder.obj \
+  $O\XpressEncoder.obj \
   $O\XzDecoder.obj \
   $O\XzEncoder.obj \
   $O\ZlibDecoder.obj \
@@ -292,6 +296,8 @@ C_OBJS = \
   $O\Sha512.obj \
   $O\Sha512Opt.obj \
   $O\SwapBytes.obj \
+  $O\MemBudget.obj \
+  $O\ThreadPool.obj \
   $O\Threads.obj \
   $O\Xxh64.obj \
   $O\Xz.obj \
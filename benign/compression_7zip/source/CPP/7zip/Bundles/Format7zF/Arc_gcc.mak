@@ -18,6 +18,8 @@ LOCAL_FLAGS_ST = -DZ7_ST
 
 ifdef IS_MINGW
 MT_OBJS = \
+  $O/MemBudget.o \
+  $O/ThreadPool.o \
   $O/Threads.o \
 
 endif
@@ -27,6 +29,8 @@ else
 MT_OBJS = \
   $O/LzFindMt.o \
   $O/LzFindOpt.o \
+  $O/MemBudget.o \
+  $O/ThreadPool.o \
   $O/Threads.o \
   $O/MemBlocks.o \
   $O/OutMemStream.o \
@@ -91,6 +95,7 @@ WIN_OBJS = \
   $O/OutBuffer.o \
   $O/ProgressUtils.o \
   $O/PropId.o \
+  $O/StageStats.o \
   $O/StreamObjects.o \
   $O/StreamUtils.o \
   $O/UniqBlocks.o \
@@ -102,6 +107,7 @@ AR_OBJS = \
   $O/ArjHandler.o \
   $O/Base64Handler.o \
   $O/Bz2Handler.o \
+  $O/CasHandler.o \
   $O/ComHandler.o \
   $O/CpioHandler.o \
   $O/CramfsHandler.o \
@@ -266,6 +272,7 @@ COMPRESS_OBJS = \
   $O/LzmsDecoder.o \
   $O/LzOutWindow.o \
   $O/LzxDecoder.o \
+  $O/LzxEncoder.o \
   $O/PpmdDecoder.o \
   $O/PpmdEncoder.o \
   $O/PpmdRegister.o \
@@ -273,6 +280,7 @@ COMPRESS_OBJS = \
   $O/QuantumDecoder.o \
   $O/ShrinkDecoder.o \
   $O/XpressDecoder.o \
+  $O/XpressEncoder.o \
   $O/XzDecoder.o \
   $O/XzEncoder.o \
   $O/ZlibDecoder.o \
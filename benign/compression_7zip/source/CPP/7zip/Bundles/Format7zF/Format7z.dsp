@@ -996,6 +996,24 @@ SOURCE=..\..\Compress\LzxDecoder.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Compress\LzxEncoder.cpp
+
+!IF  "$(CFG)" == "7z - Win32 Release"
+
+# ADD CPP /O2
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ELSEIF  "$(CFG)" == "7z - Win32 Debug"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Compress\LzxEncoder.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Compress\QuantumDecoder.cpp
 # End Source File
 # Begin Source File
@@ -1079,6 +1097,24 @@ SOURCE=..\..\Compress\XpressDecoder.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Compress\XpressEncoder.cpp
+
+!IF  "$(CFG)" == "7z - Win32 Release"
+
+# ADD CPP /O2
+# SUBTRACT CPP /YX /Yc /Yu
+
+!ELSEIF  "$(CFG)" == "7z - Win32 Debug"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Compress\XpressEncoder.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Compress\XzDecoder.cpp
 # End Source File
 # Begin Source File
@@ -1415,6 +1451,14 @@ SOURCE=..\..\Common\LimitedStreams.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Common\LockedStream.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Common\LockedStream.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Common\MemBlocks.cpp
 # End Source File
 # Begin Source File
@@ -1491,6 +1535,14 @@ SOURCE=..\..\Common\RegisterCodec.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Common\StageStats.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Common\StageStats.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Common\StreamBinder.cpp
 # End Source File
 # Begin Source File
@@ -2362,11 +2414,29 @@ SOURCE=..\..\..\..\C\SwapBytes.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.c
 # SUBTRACT CPP /YX /Yc /Yu
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.h
 # End Source File
 # Begin Source File
@@ -2971,6 +3041,10 @@ SOURCE=..\..\Archive\Bz2Handler.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Archive\CasHandler.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Archive\ComHandler.cpp
 # End Source File
 # Begin Source File
@@ -69,7 +69,8 @@ static const char * const kHelpString =
     "  -mt{N} : set number of CPU threads\n"
     "  -eos   : write end of stream marker\n"
     "  -si    : read data from stdin\n"
-    "  -so    : write data to stdout\n";
+    "  -so    : write data to stdout\n"
+    "  -ssm   : use memory mapped input file (non-Windows)\n";
 
 
 static const char * const kCantAllocate = "Cannot allocate memory";
@@ -96,7 +97,8 @@ enum Enum
   kEOS,
   kStdIn,
   kStdOut,
-  kFilter86
+  kFilter86,
+  kUseMmap
 };
 }
 
@@ -126,7 +128,8 @@ static const CSwitchForm kSwitchForms[] =
   { "EOS", SWFRM_SIMPLE },
   { "SI",  SWFRM_SIMPLE },
   { "SO",  SWFRM_SIMPLE },
-  { "F86",  NSwitchType::kChar, false, 0, "+" }
+  { "F86",  NSwitchType::kChar, false, 0, "+" },
+  { "SSM",  SWFRM_SIMPLE }
 };
 
 
@@ -479,6 +482,12 @@ static int main2(int numArgs, const char *args[])
 
   CMyComPtr<ISequentialInStream> inStream;
   CInFileStream *inStreamSpec = NULL;
+
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  // LZMA encoder reads memory mapped file directly without copying to its window
+  if (parser[NKey::kUseMmap].ThereIs)
+    g_InFileStream_UseMmap = true;
+ #endif
   
   if (stdInMode)
   {
@@ -10,6 +10,12 @@
 #include <errno.h>
 #include <grp.h>
 #include <pwd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#endif
 
 /*
 inclusion of <sys/sysmacros.h> by <sys/types.h> is deprecated since glibc 2.25.
@@ -34,6 +40,8 @@ you should undefine it after including <sys/types.h>
 
 #endif // _WIN32
 
+#include "../../../C/CpuArch.h"
+
 #include "../../Windows/FileFind.h"
 
 #ifdef Z7_DEVICE_FILE
@@ -44,6 +52,7 @@ you should undefine it after including <sys/types.h>
 #include "../PropID.h"
 
 #include "FileStreams.h"
+#include "StageStats.h"
 
 static inline HRESULT GetLastError_HRESULT()
 {
@@ -65,6 +74,12 @@ static inline HRESULT ConvertBoolToHRESULT(bool result)
 static const UInt32 kClusterSize = 1 << 18;
 #endif
 
+#ifdef Z7_FILE_STREAMS_USE_MMAP
+bool g_InFileStream_UseMmap = false;
+// read() is faster than mmap() + page faults for small files
+static const UInt32 kMmapMinSize = 1 << 16;
+#endif
+
 CInFileStream::CInFileStream():
  #ifdef Z7_DEVICE_FILE
   VirtPos(0),
@@ -72,6 +87,11 @@ CInFileStream::CInFileStream():
   Buf(NULL),
   BufSize(0),
  #endif
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  _mapData(NULL),
+  _mapSize(0),
+  _mapPos(0),
+ #endif
  #ifndef _WIN32
   _uid(0),
   _gid(0),
@@ -80,6 +100,9 @@ CInFileStream::CInFileStream():
  #endif
   _info_WasLoaded(false),
   SupportHardLinks(false),
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  UseMmap(g_InFileStream_UseMmap),
+ #endif
   Callback(NULL),
   CallbackRef(0)
 {
@@ -91,12 +114,17 @@ CInFileStream::~CInFileStream()
   MidFree(Buf);
   #endif
 
+  #ifdef Z7_FILE_STREAMS_USE_MMAP
+  UnmapFile();
+  #endif
+
   if (Callback)
     Callback->InFileStream_On_Destroy(this, CallbackRef);
 }
 
 Z7_COM7F_IMF(CInFileStream::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
+  NStageStats::CTimer stageTimer(NStageStats::kStage_Read, processedSize);
   // printf("\nCInFileStream::Read size=%d, VirtPos=%8d\n", (unsigned)size, (int)VirtPos);
 
   #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
@@ -208,6 +236,23 @@ Z7_COM7F_IMF(CInFileStream::Read(void *data, UInt32 size, UInt32 *processedSize)
   
   if (processedSize)
     *processedSize = 0;
+
+  #ifdef Z7_FILE_STREAMS_USE_MMAP
+  if (_mapData)
+  {
+    if (_mapPos >= _mapSize)
+      return S_OK;
+    const size_t rem = _mapSize - (size_t)_mapPos;
+    if (size > rem)
+      size = (UInt32)rem;
+    memcpy(data, _mapData + (size_t)_mapPos, size);
+    _mapPos += size;
+    if (processedSize)
+      *processedSize = size;
+    return S_OK;
+  }
+  #endif
+
   const ssize_t res = File.read_part(data, (size_t)size);
   if (res != -1)
   {
@@ -399,6 +444,25 @@ Z7_COM7F_IMF(CInFileStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPos
   return hres;
   
   #else
+
+  #ifdef Z7_FILE_STREAMS_USE_MMAP
+  if (_mapData)
+  {
+    switch (seekOrigin)
+    {
+      case STREAM_SEEK_SET: break;
+      case STREAM_SEEK_CUR: offset += (Int64)_mapPos; break;
+      case STREAM_SEEK_END: offset += (Int64)_mapSize; break;
+      default: return STG_E_INVALIDFUNCTION;
+    }
+    if (offset < 0)
+      return HRESULT_WIN32_ERROR_NEGATIVE_SEEK;
+    _mapPos = (UInt64)offset;
+    if (newPosition)
+      *newPosition = (UInt64)offset;
+    return S_OK;
+  }
+  #endif
   
   const off_t res = File.seek((off_t)offset, (int)seekOrigin);
   if (res == -1)
@@ -420,6 +484,113 @@ Z7_COM7F_IMF(CInFileStream::GetSize(UInt64 *size))
   return ConvertBoolToHRESULT(File.GetLength(*size));
 }
 
+Z7_COM7F_IMF(CInFileStream::GetFileHandle(UInt64 *handle, UInt64 *pos))
+{
+ #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
+  // OS-level copying is not used for Windows files
+  UNUSED_VAR(handle)
+  UNUSED_VAR(pos)
+  return S_FALSE;
+ #else
+  *handle = (UInt64)(unsigned)File.GetHandle();
+  // Seek() returns virtual position that is correct also in mmap mode
+  return Seek(0, STREAM_SEEK_CUR, pos);
+ #endif
+}
+
+
+#ifdef Z7_FILE_STREAMS_USE_MMAP
+
+void CInFileStream::UnmapFile()
+{
+  if (_mapData)
+  {
+    munmap(const_cast<Byte *>(_mapData), _mapSize);
+    _mapData = NULL;
+  }
+  _mapSize = 0;
+  _mapPos = 0;
+}
+
+/* MapFile() is called after Open().
+   If the file can't be mapped, we still use read() calls. */
+
+void CInFileStream::MapFile()
+{
+  UnmapFile();
+  struct stat st;
+  if (File.my_fstat(&st) != 0 || !S_ISREG(st.st_mode))
+    return;
+  const UInt64 size = (UInt64)st.st_size;
+  if (size < kMmapMinSize || size != (size_t)size)
+    return;
+  void *p = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, File.GetHandle(), 0);
+  if (p == MAP_FAILED)
+    return;
+ #ifdef MADV_SEQUENTIAL
+  madvise(p, (size_t)size, MADV_SEQUENTIAL);
+ #endif
+  _mapData = (const Byte *)p;
+  _mapSize = (size_t)size;
+  _mapPos = 0;
+}
+
+Z7_COM7F_IMF(CInFileStream::GetDirectBuf(const Byte **data, size_t *size))
+{
+  *data = NULL;
+  *size = 0;
+  if (!_mapData)
+    return S_FALSE;
+  size_t pos = _mapSize;
+  if (_mapPos < _mapSize)
+    pos = (size_t)_mapPos;
+  *data = _mapData + pos;
+  *size = _mapSize - pos;
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CInFileStream::SkipDirectBuf(size_t size))
+{
+  if (!_mapData)
+    return E_FAIL;
+  _mapPos += size;
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CInFileStream::ReadAt(UInt64 pos, void *data, UInt32 size, UInt32 *processedSize))
+{
+  NStageStats::CTimer stageTimer(NStageStats::kStage_Read, processedSize);
+  if (processedSize)
+    *processedSize = 0;
+  if (_mapData)
+  {
+    if (pos >= _mapSize)
+      return S_OK;
+    const size_t rem = _mapSize - (size_t)pos;
+    if (size > rem)
+      size = (UInt32)rem;
+    memcpy(data, _mapData + (size_t)pos, size);
+    if (processedSize)
+      *processedSize = size;
+    return S_OK;
+  }
+  const ssize_t res = File.pread_part(data, (size_t)size, pos);
+  if (res != -1)
+  {
+    if (processedSize)
+      *processedSize = (UInt32)res;
+    return S_OK;
+  }
+  const DWORD error = ::GetLastError();
+  if (Callback)
+    return Callback->InFileStream_On_Error(CallbackRef, error);
+  if (error == 0)
+    return E_FAIL;
+  return HRESULT_FROM_WIN32(error);
+}
+
+#endif
+
 #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
 
 Z7_COM7F_IMF(CInFileStream::GetProps(UInt64 *size, FILETIME *cTime, FILETIME *aTime, FILETIME *mTime, UInt32 *attrib))
@@ -796,16 +967,31 @@ Z7_COM7F_IMF(CInFileStream::ReloadProps())
 
 HRESULT COutFileStream::Close()
 {
-  return ConvertBoolToHRESULT(File.Close());
+  bool res = true;
+  if (_holeEnd != 0)
+  {
+    // the file can end with a hole that was skipped with Seek()
+    UInt64 len;
+    res = File.GetLength(len);
+    if (res && len < _holeEnd)
+      res = File.SetLength_KeepPosition(_holeEnd);
+    _holeEnd = 0;
+  }
+  if (!File.Close())
+    res = false;
+  return ConvertBoolToHRESULT(res);
 }
 
-Z7_COM7F_IMF(COutFileStream::Write(const void *data, UInt32 size, UInt32 *processedSize))
+HRESULT COutFileStream::WriteData(const void *data, UInt32 size, UInt32 *processedSize)
 {
   #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
 
   UInt32 realProcessedSize;
   const bool result = File.Write(data, size, realProcessedSize);
   ProcessedSize += realProcessedSize;
+  _pos += realProcessedSize;
+  if (_dataEnd < _pos)
+    _dataEnd = _pos;
   if (processedSize)
     *processedSize = realProcessedSize;
   return ConvertBoolToHRESULT(result);
@@ -817,6 +1003,9 @@ Z7_COM7F_IMF(COutFileStream::Write(const void *data, UInt32 size, UInt32 *proces
   size_t realProcessedSize;
   const ssize_t res = File.write_full(data, (size_t)size, realProcessedSize);
   ProcessedSize += realProcessedSize;
+  _pos += realProcessedSize;
+  if (_dataEnd < _pos)
+    _dataEnd = _pos;
   if (processedSize)
     *processedSize = (UInt32)realProcessedSize;
   if (res == -1)
@@ -825,6 +1014,179 @@ Z7_COM7F_IMF(COutFileStream::Write(const void *data, UInt32 size, UInt32 *proces
   
   #endif
 }
+
+static const UInt32 kZeroBlockSize = 1 << 12;
+
+static bool IsZeroBlock(const Byte *p)
+{
+  for (unsigned i = 0; i < kZeroBlockSize; i += 8)
+    if (GetUi64(p + i) != 0)
+      return false;
+  return true;
+}
+
+Z7_COM7F_IMF(COutFileStream::Write(const void *data, UInt32 size, UInt32 *processedSize))
+{
+  NStageStats::CTimer stageTimer(NStageStats::kStage_Write, processedSize);
+  if (!SkipZeroBlocks || !AllowHoles)
+    return WriteData(data, size, processedSize);
+
+  /* we split data to runs of aligned zero blocks and runs of another data.
+     The runs of zero blocks are written as holes. */
+  const Byte *p = (const Byte *)data;
+  UInt32 done = 0;
+  HRESULT res = S_OK;
+  while (done != size)
+  {
+    const UInt32 rem = size - done;
+    const UInt32 offset = (UInt32)_pos & (kZeroBlockSize - 1);
+    UInt32 cur = kZeroBlockSize - offset;
+    if (cur > rem)
+      cur = rem;
+    if (cur == kZeroBlockSize && IsZeroBlock(p + done))
+    {
+      while (rem - cur >= kZeroBlockSize && IsZeroBlock(p + done + cur))
+        cur += kZeroBlockSize;
+      res = WriteHole(cur);
+      if (res != S_OK)
+        break;
+      done += cur;
+      continue;
+    }
+    while (rem - cur >= kZeroBlockSize && !IsZeroBlock(p + done + cur))
+      cur += kZeroBlockSize;
+    UInt32 processed = 0;
+    res = WriteData(p + done, cur, &processed);
+    done += processed;
+    if (res != S_OK || processed != cur)
+      break;
+  }
+  if (processedSize)
+    *processedSize = done;
+  return res;
+}
+
+HRESULT COutFileStream::WriteZeros(UInt64 size)
+{
+  static const UInt32 kZerosSize = 1 << 14;
+  static const Byte k_Zeros[kZerosSize] = { 0 };
+  while (size != 0)
+  {
+    const UInt32 cur = size < kZerosSize ? (UInt32)size : kZerosSize;
+    UInt32 processed = 0;
+    RINOK(WriteData(k_Zeros, cur, &processed))
+    if (processed != cur)
+      return E_FAIL;
+    size -= cur;
+  }
+  return S_OK;
+}
+
+Z7_COM7F_IMF(COutFileStream::WriteHole(UInt64 size))
+{
+  if (size == 0)
+    return S_OK;
+  if (!AllowHoles)
+    return WriteZeros(size);
+  if (_pos < _dataEnd)
+  {
+    /* the region can contain old data.
+       So we must deallocate it, or we must write zeros there. */
+   #if !defined(Z7_FILE_STREAMS_USE_WIN_FILE) && defined(FALLOC_FL_PUNCH_HOLE)
+    UInt64 punchSize = _dataEnd - _pos;
+    if (punchSize > size)
+      punchSize = size;
+    if (fallocate(File.GetHandle(), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+        (off_t)_pos, (off_t)punchSize) != 0)
+   #endif
+      return WriteZeros(size);
+  }
+  UInt64 newPos;
+  RINOK(Seek((Int64)size, STREAM_SEEK_CUR, &newPos))
+  ProcessedSize += size;
+  _holeEnd = newPos;
+  return S_OK;
+}
+
+Z7_COM7F_IMF(COutFileStream::CopyFrom(IInStream *inStream, UInt64 size, UInt64 *processedSize))
+{
+  *processedSize = 0;
+ #if defined(Z7_FILE_STREAMS_USE_WIN_FILE) || !defined(__linux__) || !defined(__NR_copy_file_range)
+  UNUSED_VAR(inStream)
+  UNUSED_VAR(size)
+  return E_NOTIMPL;
+ #else
+  /* copy_file_range() writes the runs of zeros as data.
+     So the caller must use Write() that writes holes instead. */
+  if (SkipZeroBlocks && AllowHoles)
+    return E_NOTIMPL;
+  Z7_DECL_CMyComPtr_QI_FROM(IStreamGetFileHandle, getHandle, inStream)
+  if (!getHandle)
+    return E_NOTIMPL;
+  UInt64 handle = 0, inPos = 0;
+  if (getHandle->GetFileHandle(&handle, &inPos) != S_OK)
+    return E_NOTIMPL;
+  const int fdIn = (int)handle;
+  const int fdOut = File.GetHandle();
+  NStageStats::CTimer stageTimer(NStageStats::kStage_Write);
+  UInt64 done = 0;
+  HRESULT hres = S_OK;
+
+ #ifdef FICLONERANGE
+  {
+    /* reflink shares the extents of input file without copying.
+       It requires aligned offsets, so we clone the aligned part only. */
+    const UInt64 kCloneAlign = (UInt64)1 << 12;
+    const UInt64 cloneSize = size & ~(kCloneAlign - 1);
+    if (cloneSize != 0 && ((inPos | _pos) & (kCloneAlign - 1)) == 0)
+    {
+      struct file_clone_range range;
+      range.src_fd = fdIn;
+      range.src_offset = inPos;
+      range.src_length = cloneSize;
+      range.dest_offset = _pos;
+      if (ioctl(fdOut, FICLONERANGE, &range) == 0)
+        done = cloneSize;
+    }
+  }
+ #endif
+
+  while (done != size)
+  {
+    loff_t offIn = (loff_t)(inPos + done);
+    loff_t offOut = (loff_t)(_pos + done);
+    const UInt64 kStepMax = (UInt64)1 << 30;
+    const UInt64 rem = size - done;
+    const ssize_t res = (ssize_t)syscall(__NR_copy_file_range,
+        fdIn, &offIn, fdOut, &offOut, (size_t)(rem < kStepMax ? rem : kStepMax), 0u);
+    if (res < 0)
+    {
+      const int err = errno;
+      if (done == 0 && (err == EXDEV || err == EINVAL || err == ENOSYS
+          || err == EOPNOTSUPP || err == EBADF || err == EPERM))
+        return E_NOTIMPL;
+      hres = GetLastError_HRESULT();
+      break;
+    }
+    if (res == 0)
+      break;
+    done += (UInt64)res;
+  }
+
+  if (done != 0)
+  {
+    // copy_file_range() and FICLONERANGE don't change the positions of handles
+    RINOK(inStream->Seek((Int64)done, STREAM_SEEK_CUR, NULL))
+    RINOK(Seek((Int64)done, STREAM_SEEK_CUR, NULL))
+    ProcessedSize += done;
+    if (_dataEnd < _pos)
+      _dataEnd = _pos;
+  }
+  stageTimer.Size = done;
+  *processedSize = done;
+  return hres;
+ #endif
+}
   
 Z7_COM7F_IMF(COutFileStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition))
 {
@@ -835,6 +1197,7 @@ Z7_COM7F_IMF(COutFileStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPo
 
   UInt64 realNewPosition = 0;
   const bool result = File.Seek(offset, seekOrigin, realNewPosition);
+  _pos = realNewPosition;
   if (newPosition)
     *newPosition = realNewPosition;
   return ConvertBoolToHRESULT(result);
@@ -844,6 +1207,7 @@ Z7_COM7F_IMF(COutFileStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPo
   const off_t res = File.seek((off_t)offset, (int)seekOrigin);
   if (res == -1)
     return GetLastError_HRESULT();
+  _pos = (UInt64)res;
   if (newPosition)
     *newPosition = (UInt64)res;
   return S_OK;
@@ -853,6 +1217,10 @@ Z7_COM7F_IMF(COutFileStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPo
 
 Z7_COM7F_IMF(COutFileStream::SetSize(UInt64 newSize))
 {
+  if (_dataEnd > newSize)
+    _dataEnd = newSize;
+  if (_holeEnd > newSize)
+    _holeEnd = newSize;
   return ConvertBoolToHRESULT(File.SetLength_KeepPosition(newSize));
 }
 
@@ -5,6 +5,8 @@
 
 #ifdef _WIN32
 #define Z7_FILE_STREAMS_USE_WIN_FILE
+#else
+#define Z7_FILE_STREAMS_USE_MMAP
 #endif
 
 #include "../../Common/MyCom.h"
@@ -28,6 +30,16 @@ DECLARE_INTERFACE(IInFileStream_Callback)
 Z7_PURE_INTERFACES_END
 
 
+#ifdef Z7_FILE_STREAMS_USE_MMAP
+/* if (g_InFileStream_UseMmap) is set, new CInFileStream objects
+   map regular files to memory, and they support IStreamDirectBuf.
+   Note: the mapping is not safe, if another process truncates the file,
+   so it's not default mode.
+   CInFileStream also supports IInStreamReadAt via pread(). */
+extern bool g_InFileStream_UseMmap;
+#endif
+
+
 /*
 Z7_CLASS_IMP_COM_5(
   CInFileStream
@@ -36,6 +48,7 @@ Z7_CLASS_IMP_COM_5(
   , IStreamGetProps
   , IStreamGetProps2
   , IStreamGetProp
+  , IStreamGetFileHandle
 )
 */
 Z7_class_final(CInFileStream) :
@@ -44,15 +57,35 @@ Z7_class_final(CInFileStream) :
   public IStreamGetProps,
   public IStreamGetProps2,
   public IStreamGetProp,
+  public IStreamGetFileHandle,
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  public IStreamDirectBuf,
+  public IInStreamReadAt,
+ #endif
   public CMyUnknownImp
 {
-  Z7_COM_UNKNOWN_IMP_6(
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  Z7_COM_UNKNOWN_IMP_SPEC(
+    Z7_COM_QI_ENTRY_UNKNOWN(IInStream)
+    Z7_COM_QI_ENTRY(IInStream)
+    Z7_COM_QI_ENTRY(ISequentialInStream)
+    Z7_COM_QI_ENTRY(IStreamGetSize)
+    Z7_COM_QI_ENTRY(IStreamGetProps)
+    Z7_COM_QI_ENTRY(IStreamGetProps2)
+    Z7_COM_QI_ENTRY(IStreamGetProp)
+    Z7_COM_QI_ENTRY(IStreamGetFileHandle)
+    Z7_COM_QI_ENTRY(IStreamDirectBuf)
+    Z7_COM_QI_ENTRY(IInStreamReadAt))
+ #else
+  Z7_COM_UNKNOWN_IMP_7(
       IInStream,
       ISequentialInStream,
       IStreamGetSize,
       IStreamGetProps,
       IStreamGetProps2,
-      IStreamGetProp)
+      IStreamGetProp,
+      IStreamGetFileHandle)
+ #endif
 
   Z7_IFACE_COM7_IMP(ISequentialInStream)
   Z7_IFACE_COM7_IMP(IInStream)
@@ -63,9 +96,23 @@ private:
 public:
   Z7_IFACE_COM7_IMP(IStreamGetProps2)
   Z7_IFACE_COM7_IMP(IStreamGetProp)
+  Z7_IFACE_COM7_IMP(IStreamGetFileHandle)
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  Z7_IFACE_COM7_IMP(IStreamDirectBuf)
+  Z7_IFACE_COM7_IMP(IInStreamReadAt)
+ #endif
 
 private:
   NWindows::NFile::NIO::CInFile File;
+
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  const Byte *_mapData;
+  size_t _mapSize;
+  UInt64 _mapPos;
+
+  void MapFile();
+  void UnmapFile();
+ #endif
 public:
 
   #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
@@ -94,6 +141,9 @@ public:
 
   bool _info_WasLoaded;
   bool SupportHardLinks;
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  bool UseMmap;
+ #endif
   IInFileStream_Callback *Callback;
   UINT_PTR CallbackRef;
 
@@ -117,13 +167,23 @@ public:
   bool Open(CFSTR fileName)
   {
     _info_WasLoaded = false;
-    return File.Open(fileName);
+    const bool res = File.Open(fileName);
+   #ifdef Z7_FILE_STREAMS_USE_MMAP
+    if (res && UseMmap)
+      MapFile();
+   #endif
+    return res;
   }
   
   bool OpenShared(CFSTR fileName, bool shareForWrite)
   {
     _info_WasLoaded = false;
-    return File.OpenShared(fileName, shareForWrite);
+    const bool res = File.OpenShared(fileName, shareForWrite);
+   #ifdef Z7_FILE_STREAMS_USE_MMAP
+    if (res && UseMmap)
+      MapFile();
+   #endif
+    return res;
   }
 };
 
@@ -136,36 +196,61 @@ Z7_CLASS_IMP_NOQIB_1(
 };
 
 
-Z7_CLASS_IMP_COM_1(
+Z7_CLASS_IMP_COM_3(
   COutFileStream
   , IOutStream
+  , IOutStreamSparse
+  , IOutStreamCopyFrom
 )
   Z7_IFACE_COM7_IMP(ISequentialOutStream)
+
+  UInt64 _pos;
+  // the region after (_dataEnd) contains no written data (only zeros)
+  UInt64 _dataEnd;
+  // the end of latest hole: Close() extends the file to that size
+  UInt64 _holeEnd;
+
+  void InitPos(bool isNewFile)
+  {
+    ProcessedSize = 0;
+    _pos = 0;
+    _dataEnd = isNewFile ? 0 : (UInt64)(Int64)-1;
+    _holeEnd = 0;
+  }
+  HRESULT WriteData(const void *data, UInt32 size, UInt32 *processedSize);
+  HRESULT WriteZeros(UInt64 size);
 public:
 
   NWindows::NFile::NIO::COutFile File;
 
+  // WriteHole() can leave the region unallocated instead of writing of zeros
+  bool AllowHoles;
+  // Write() doesn't write aligned blocks of zeros, if (AllowHoles) is also set
+  bool SkipZeroBlocks;
+
+  COutFileStream(): AllowHoles(false), SkipZeroBlocks(false) { InitPos(true); }
+
   bool Create_NEW(CFSTR fileName)
   {
-    ProcessedSize = 0;
+    InitPos(true);
     return File.Create_NEW(fileName);
   }
 
   bool Create_ALWAYS(CFSTR fileName)
   {
-    ProcessedSize = 0;
+    InitPos(true);
     return File.Create_ALWAYS(fileName);
   }
 
   bool Open_EXISTING(CFSTR fileName)
   {
-    ProcessedSize = 0;
+    InitPos(false);
     return File.Open_EXISTING(fileName);
   }
 
   bool Create_ALWAYS_or_Open_ALWAYS(CFSTR fileName, bool createAlways)
   {
-    ProcessedSize = 0;
+    InitPos(createAlways);
     return File.Create_ALWAYS_or_Open_ALWAYS(fileName, createAlways);
   }
 
@@ -181,6 +266,7 @@ public:
 
   bool SeekToBegin_bool()
   {
+    _pos = 0;
     #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
     return File.SeekToBegin();
     #else
@@ -575,3 +575,8 @@ Z7_COM7F_IMF(CFilterCoder::ResetInitVector())
 
 Z7_COM7F_IMF(CFilterCoder::SetDecoderProperties2(const Byte *data, UInt32 size))
   { return _setDecoderProperties2->SetDecoderProperties2(data, size); }
+
+#ifndef Z7_ST
+Z7_COM7F_IMF(CFilterCoder::SetNumberOfThreads(UInt32 numThreads))
+  { return _setCoderMt->SetNumberOfThreads(numThreads); }
+#endif
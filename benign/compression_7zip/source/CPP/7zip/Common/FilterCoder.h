@@ -56,6 +56,9 @@ class CFilterCoder Z7_final :
   #endif
   
   public ICompressSetDecoderProperties2,
+  #ifndef Z7_ST
+  public ICompressSetCoderMt,
+  #endif
   public CMyUnknownImp,
   public CAlignedMidBuffer
 {
@@ -103,6 +106,9 @@ class CFilterCoder Z7_final :
   #endif
 
   CMyComPtr<ICompressSetDecoderProperties2> _setDecoderProperties2;
+  #ifndef Z7_ST
+  CMyComPtr<ICompressSetCoderMt> _setCoderMt;
+  #endif
 
 public:
   CMyComPtr<ICompressFilter> Filter;
@@ -159,6 +165,9 @@ private:
     #endif
 
     Z7_COM_QI_ENTRY_AG(ICompressSetDecoderProperties2, Filter, _setDecoderProperties2)
+    #ifndef Z7_ST
+    Z7_COM_QI_ENTRY_AG(ICompressSetCoderMt, Filter, _setCoderMt)
+    #endif
   Z7_COM_QI_END
   Z7_COM_ADDREF_RELEASE
   
@@ -194,6 +203,9 @@ private:
   
 public:
   Z7_IFACE_COM7_IMP(ICompressSetDecoderProperties2)
+  #ifndef Z7_ST
+  Z7_IFACE_COM7_IMP(ICompressSetCoderMt)
+  #endif
   
   HRESULT Init_NoSubFilterInit();
 };
@@ -262,6 +262,20 @@ Z7_COM7F_IMF(CLimitedSequentialOutStream::Write(const void *data, UInt32 size, U
   return result;
 }
 
+Z7_COM7F_IMF(CLimitedSequentialOutStream::CopyFrom(IInStream *inStream, UInt64 size, UInt64 *processedSize))
+{
+  *processedSize = 0;
+  // the overflow is processed by Write()
+  if (!_stream || size > _size)
+    return E_NOTIMPL;
+  Z7_DECL_CMyComPtr_QI_FROM(IOutStreamCopyFrom, copyFrom, _stream)
+  if (!copyFrom)
+    return E_NOTIMPL;
+  const HRESULT res = copyFrom->CopyFrom(inStream, size, processedSize);
+  _size -= *processedSize;
+  return res;
+}
+
 
 Z7_COM7F_IMF(CTailInStream::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
@@ -123,9 +123,10 @@ public:
 
 
 
-Z7_CLASS_IMP_COM_1(
+Z7_CLASS_IMP_COM_2(
   CLimitedSequentialOutStream
   , ISequentialOutStream
+  , IOutStreamCopyFrom
 )
   CMyComPtr<ISequentialOutStream> _stream;
   UInt64 _size;
@@ -1,3 +1,66 @@
 // LockedStream.cpp
 
 #include "StdAfx.h"
+
+#include <string.h>
+
+#include "StreamUtils.h"
+
+#include "LockedStream.h"
+
+HRESULT CLockedInStream::Init(IInStream *stream)
+{
+  _stream = stream;
+  _readAt.Release();
+  _directBuf = NULL;
+  _directSize = 0;
+  stream->QueryInterface(IID_IInStreamReadAt, (void **)&_readAt);
+  CMyComPtr<IStreamDirectBuf> directBuf;
+  stream->QueryInterface(IID_IStreamDirectBuf, (void **)&directBuf);
+  if (directBuf)
+  {
+    RINOK(InStream_SeekToBegin(stream))
+    const Byte *data;
+    size_t size;
+    if (directBuf->GetDirectBuf(&data, &size) == S_OK)
+    {
+      _directBuf = data;
+      _directSize = size;
+    }
+  }
+  return S_OK;
+}
+
+HRESULT CLockedInStream::Read(UInt64 startPos, void *data, UInt32 size, UInt32 *processedSize)
+{
+  if (_directBuf)
+  {
+    UInt32 cur = 0;
+    if (startPos < _directSize)
+    {
+      const size_t rem = _directSize - (size_t)startPos;
+      cur = size;
+      if (cur > rem)
+        cur = (UInt32)rem;
+      memcpy(data, _directBuf + (size_t)startPos, cur);
+    }
+    if (processedSize)
+      *processedSize = cur;
+    return S_OK;
+  }
+  if (_readAt)
+    return _readAt->ReadAt(startPos, data, size, processedSize);
+  NWindows::NSynchronization::CCriticalSectionLock lock(_criticalSection);
+  RINOK(InStream_SeekSet(_stream, startPos))
+  return _stream->Read(data, size, processedSize);
+}
+
+Z7_COM7F_IMF(CLockedSequentialInStream::Read(void *data, UInt32 size, UInt32 *processedSize))
+{
+  UInt32 realProcessedSize = 0;
+  const HRESULT result = _glob->Read(_pos, data, size, &realProcessedSize);
+  _pos += realProcessedSize;
+  if (processedSize)
+    *processedSize = realProcessedSize;
+  return result;
+}
@@ -3,4 +3,53 @@
 #ifndef ZIP7_INC_LOCKED_STREAM_H
 #define ZIP7_INC_LOCKED_STREAM_H
 
+#include "../../Common/MyCom.h"
+#include "../../Windows/Synchronization.h"
+
+#include "../IStream.h"
+
+/*
+CLockedInStream allows to read base IInStream from several threads.
+  Each Read() call specifies the position in base stream.
+  If base stream supports IStreamDirectBuf (memory mapped file),
+  the data is copied without locking.
+  If base stream supports IInStreamReadAt (multivolume stream, or
+  CInFileStream that uses pread()), the call uses ReadAt() without locking.
+  Otherwise the call locks the stream and uses Seek() + Read().
+*/
+
+Z7_CLASS_IMP_COM_0(
+  CLockedInStream
+)
+  CMyComPtr<IInStream> _stream;
+  CMyComPtr<IInStreamReadAt> _readAt;
+  const Byte *_directBuf;
+  size_t _directSize;
+  NWindows::NSynchronization::CCriticalSection _criticalSection;
+public:
+  CLockedInStream(): _directBuf(NULL), _directSize(0) {}
+  HRESULT Init(IInStream *stream);
+  HRESULT Read(UInt64 startPos, void *data, UInt32 size, UInt32 *processedSize);
+};
+
+
+/* sequential view of CLockedInStream that starts from (startPos).
+   Init() can be called from worker threads, so the object doesn't
+   hold the reference to (glob): the owner of CLockedInStream must
+   keep it alive while CLockedSequentialInStream objects are used. */
+
+Z7_CLASS_IMP_COM_1(
+  CLockedSequentialInStream
+  , ISequentialInStream
+)
+  CLockedInStream *_glob;
+  UInt64 _pos;
+public:
+  void Init(CLockedInStream *glob, UInt64 startPos)
+  {
+    _glob = glob;
+    _pos = startPos;
+  }
+};
+
 #endif
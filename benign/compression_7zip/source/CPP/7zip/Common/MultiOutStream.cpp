@@ -11,13 +11,24 @@
   #define PRF(x)
 #endif
 
+#include "../../../C/Alloc.h"
+#ifndef Z7_ST
+#include "../../../C/MemBudget.h"
+#endif
+
 #include "../../Common/ComTry.h"
 
 #include "../../Windows/FileDir.h"
 #include "../../Windows/FileFind.h"
 #include "../../Windows/System.h"
 
+#ifndef Z7_ST
+#include "../../Windows/Synchronization.h"
+#include "../../Windows/Thread.h"
+#endif
+
 #include "MultiOutStream.h"
+#include "StreamUtils.h"
 
 using namespace NWindows;
 using namespace NFile;
@@ -31,6 +42,356 @@ static const unsigned k_NumVols_MAX = k_VectorSizeMax - 1;
   { const HRESULT res2 = (x); if (hres == SZ_OK) hres = res2; }
 */
 
+#ifndef Z7_ST
+
+/*
+CVolWriteBehind : write-behind queue for volumes.
+  Write() copies data to blocks in queue, and worker threads write
+  these blocks to files. Finish() closes (and renames) volume in worker thread.
+  All jobs for one volume are processed by same thread in FIFO order,
+  and different volumes can be written and finished in parallel.
+  The worker threads are from process-wide pool. Their number is set by caller
+  (the number of threads of update), and it's reserved from the limit of pool.
+  The first error of worker thread is returned by later Write() / WaitAll() calls.
+  Each queued block is also reserved in memory budget of process.
+  The reference counter of COutFileStream is not thread-safe. So jobs use
+  raw pointers, and the main thread keeps the references to streams:
+  CMultiOutStream keeps open streams, and CVolWriteBehind::FinishedStreams
+  keeps finished streams until WaitAll().
+*/
+
+static const size_t k_WriteBehind_BlockSize = (size_t)1 << 20;
+static const unsigned k_WriteBehind_NumThreads_Max = 64;
+
+struct CVolJob
+{
+  CVolJob *Next;
+  COutFileStream *Stream;
+  Byte *Data;   // (Data == NULL) for Finish job
+  size_t Size;
+  UInt64 Pos;
+  bool NeedSync;
+  bool MTime_Defined;
+  CFiTime MTime;
+  FString TempPath;
+  FString FinalPath; // (FinalPath) is empty, if rename is not required
+
+  CVolJob(): Next(NULL), Stream(NULL), Data(NULL), Size(0), Pos(0),
+      NeedSync(false), MTime_Defined(false) {}
+  ~CVolJob() { MyFree(Data); }
+  HRESULT Process();
+};
+
+
+HRESULT CVolJob::Process()
+{
+  if (Data)
+  {
+    IOutStream *stream = Stream;
+    RINOK(stream->Seek((Int64)Pos, STREAM_SEEK_SET, NULL))
+    return WriteStream(stream, Data, Size);
+  }
+
+  HRESULT res = S_OK;
+  bool mtime_WasSet = false;
+  if (Stream)
+  {
+    if (MTime_Defined && Stream->SetMTime(&MTime))
+      mtime_WasSet = true;
+    if (NeedSync && !Stream->File.Sync())
+      res = GetLastError_noZero_HRESULT();
+    const HRESULT res2 = Stream->Close();
+    if (res == S_OK)
+      res = res2;
+  }
+  if (res != S_OK || FinalPath.IsEmpty())
+    return res;
+  if (MTime_Defined && !mtime_WasSet)
+    SetDirTime(TempPath, NULL, NULL, &MTime);
+  if (!MyMoveFile(TempPath, FinalPath))
+    return GetLastError_noZero_HRESULT();
+  return S_OK;
+}
+
+
+class CVolWriteBehind;
+
+struct CVolWriterThread
+{
+  CVolJob *Head;
+  CVolJob *Tail;
+  CVolWriteBehind *Owner;
+  NWindows::CPoolThread Thread;
+  NWindows::NSynchronization::CAutoResetEvent WakeEvent;
+
+  CVolWriterThread(): Head(NULL), Tail(NULL), Owner(NULL) {}
+  void ThreadFunc();
+};
+
+
+class CVolWriteBehind
+{
+  Z7_CLASS_NO_COPY(CVolWriteBehind)
+public:
+  NWindows::NSynchronization::CCriticalSection CS;
+  NWindows::NSynchronization::CAutoResetEvent MemEvent;
+  NWindows::NSynchronization::CManualResetEvent IdleEvent;
+  UInt64 MemLimit;
+  UInt64 MemUsed;
+  unsigned NumJobs; // the number of queued and running jobs
+  bool Exit;
+  HRESULT Result;
+  unsigned NumReservedThreads;
+  CObjArray2<CVolWriterThread> Threads;
+  CObjectVector< CMyComPtr<IOutStream> > FinishedStreams; // it's used only by main thread
+
+  CVolWriteBehind(): MemUsed(0), NumJobs(0), Exit(false), Result(S_OK), NumReservedThreads(0) {}
+  ~CVolWriteBehind();
+
+  WRes Create(UInt64 memLimit, UInt32 numThreads);
+  void AddJob(unsigned volIndex, CVolJob *job);
+  HRESULT Write(unsigned volIndex, COutFileStream *stream, UInt64 pos, const Byte *data, size_t size);
+  void Finish(unsigned volIndex, IOutStream *stream, COutFileStream *streamSpec,
+      bool needSync, const CFiTime *mTime, const FString &tempPath, const FString &finalPath);
+  HRESULT WaitAll();
+};
+
+
+void CVolWriterThread::ThreadFunc()
+{
+  CVolWriteBehind &wb = *Owner;
+  for (;;)
+  {
+    CVolJob *job;
+    {
+      NWindows::NSynchronization::CCriticalSectionLock lock(wb.CS);
+      job = Head;
+      if (job)
+      {
+        Head = job->Next;
+        if (!Head)
+          Tail = NULL;
+      }
+      else if (wb.Exit)
+        return;
+    }
+    if (!job)
+    {
+      if (WakeEvent.Lock() != 0)
+        return;
+      continue;
+    }
+    
+    HRESULT res;
+    try { res = job->Process(); }
+    catch(...) { res = E_FAIL; }
+    const bool isDataJob = (job->Data != NULL);
+    delete job;
+    {
+      NWindows::NSynchronization::CCriticalSectionLock lock(wb.CS);
+      if (wb.Result == S_OK)
+        wb.Result = res;
+      if (isDataJob)
+      {
+        wb.MemUsed -= k_WriteBehind_BlockSize;
+        MemBudget_Release(k_WriteBehind_BlockSize, 1);
+      }
+      if (--wb.NumJobs == 0)
+        wb.IdleEvent.Set();
+    }
+    wb.MemEvent.Set();
+  }
+}
+
+static THREAD_FUNC_DECL VolWriterThreadFunc(void *p)
+{
+  ((CVolWriterThread *)p)->ThreadFunc();
+  return 0;
+}
+
+
+WRes CVolWriteBehind::Create(UInt64 memLimit, UInt32 numThreads)
+{
+  if (memLimit < k_WriteBehind_BlockSize * 2)
+    memLimit = k_WriteBehind_BlockSize * 2;
+  MemLimit = memLimit;
+  RINOK_WRes(MemEvent.CreateIfNotCreated_Reset())
+  RINOK_WRes(IdleEvent.CreateIfNotCreated_Reset())
+  RINOK_WRes(IdleEvent.Set())
+  if (numThreads > k_WriteBehind_NumThreads_Max)
+    numThreads = k_WriteBehind_NumThreads_Max;
+  NumReservedThreads = ThreadPool_Reserve(numThreads == 0 ? 1 : (unsigned)numThreads);
+  Threads.SetSize(NumReservedThreads);
+  for (unsigned i = 0; i < Threads.Size(); i++)
+  {
+    CVolWriterThread &t = Threads[i];
+    t.Owner = this;
+    RINOK_WRes(t.WakeEvent.CreateIfNotCreated_Reset())
+    RINOK_WRes(t.Thread.Create(VolWriterThreadFunc, &t))
+  }
+  return 0;
+}
+
+
+CVolWriteBehind::~CVolWriteBehind()
+{
+  WaitAll();
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+    Exit = true;
+  }
+  unsigned i;
+  for (i = 0; i < Threads.Size(); i++)
+    if (Threads[i].Thread.IsCreated())
+      Threads[i].WakeEvent.Set();
+  for (i = 0; i < Threads.Size(); i++)
+    if (Threads[i].Thread.IsCreated())
+      Threads[i].Thread.Wait_Close();
+  ThreadPool_Release(NumReservedThreads);
+}
+
+
+// it must be called with locked (CS)
+void CVolWriteBehind::AddJob(unsigned volIndex, CVolJob *job)
+{
+  CVolWriterThread &t = Threads[volIndex % Threads.Size()];
+  if (t.Tail)
+    t.Tail->Next = job;
+  else
+    t.Head = job;
+  t.Tail = job;
+  if (NumJobs++ == 0)
+    IdleEvent.Reset();
+  t.WakeEvent.Set();
+}
+
+
+HRESULT CVolWriteBehind::Write(unsigned volIndex, COutFileStream *stream, UInt64 pos, const Byte *data, size_t size)
+{
+  CVolWriterThread &t = Threads[volIndex % Threads.Size()];
+  while (size != 0)
+  {
+    bool memIsReserved = false;
+    {
+      NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+      RINOK(Result)
+      CVolJob *last = t.Tail;
+      if (last && last->Data && last->Stream == stream
+          && last->Pos + last->Size == pos
+          && last->Size != k_WriteBehind_BlockSize)
+      {
+        // we append data to last queued block that was not taken by thread still
+        size_t cur = k_WriteBehind_BlockSize - last->Size;
+        if (cur > size)
+          cur = size;
+        memcpy(last->Data + last->Size, data, cur);
+        last->Size += cur;
+        pos += cur;
+        data += cur;
+        size -= cur;
+        continue;
+      }
+      if (MemUsed + k_WriteBehind_BlockSize <= MemLimit)
+      {
+        /* if the queue is empty, we always can use one block.
+           Otherwise we wait, until threads release the blocks of queue. */
+        if ((MemUsed == 0 ?
+            MemBudget_Reserve(k_WriteBehind_BlockSize, 1) :
+            MemBudget_Reserve_Optional(k_WriteBehind_BlockSize, 1)) != 0)
+        {
+          MemUsed += k_WriteBehind_BlockSize;
+          memIsReserved = true;
+        }
+      }
+    }
+    
+    if (!memIsReserved)
+    {
+      // (MemUsed != 0) here, so some thread will free memory and will set MemEvent
+      if (MemEvent.Lock() != 0)
+        return E_FAIL;
+      continue;
+    }
+
+    CVolJob *job = new CVolJob;
+    job->Data = (Byte *)MyAlloc(k_WriteBehind_BlockSize);
+    if (!job->Data)
+    {
+      delete job;
+      NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+      MemUsed -= k_WriteBehind_BlockSize;
+      MemBudget_Release(k_WriteBehind_BlockSize, 1);
+      return E_OUTOFMEMORY;
+    }
+    size_t cur = k_WriteBehind_BlockSize;
+    if (cur > size)
+      cur = size;
+    memcpy(job->Data, data, cur);
+    job->Size = cur;
+    job->Pos = pos;
+    job->Stream = stream;
+    pos += cur;
+    data += cur;
+    size -= cur;
+    {
+      NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+      AddJob(volIndex, job);
+    }
+  }
+  return S_OK;
+}
+
+
+void CVolWriteBehind::Finish(unsigned volIndex, IOutStream *stream, COutFileStream *streamSpec,
+    bool needSync, const CFiTime *mTime, const FString &tempPath, const FString &finalPath)
+{
+  if (stream)
+    FinishedStreams.AddNew() = stream;
+  CVolJob *job = new CVolJob;
+  if (stream)
+    job->Stream = streamSpec;
+  job->NeedSync = needSync;
+  if (mTime)
+  {
+    job->MTime = *mTime;
+    job->MTime_Defined = true;
+  }
+  job->TempPath = tempPath;
+  job->FinalPath = finalPath;
+  NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+  AddJob(volIndex, job);
+}
+
+
+HRESULT CVolWriteBehind::WaitAll()
+{
+  for (;;)
+  {
+    {
+      NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+      if (NumJobs == 0)
+        break;
+    }
+    if (IdleEvent.Lock() != 0)
+      return E_FAIL;
+  }
+  // worker threads don't use finished streams now
+  FinishedStreams.Clear();
+  return Result;
+}
+
+#endif
+
+HRESULT CMultiOutStream::WaitWriteBehind()
+{
+ #ifndef Z7_ST
+  if (_writeBehind)
+    return _writeBehind->WaitAll();
+ #endif
+  return S_OK;
+}
+
+
 HRESULT CMultiOutStream::Destruct()
 {
   COM_TRY_BEGIN
@@ -86,6 +447,17 @@ HRESULT CMultiOutStream::Destruct()
     hres = hres3;
   if (hres == S_OK && NumListItems != 0)
     hres = E_FAIL;
+
+ #ifndef Z7_ST
+  if (_writeBehind)
+  {
+    const HRESULT hres2 = _writeBehind->WaitAll();
+    if (hres == S_OK)
+      hres = hres2;
+    delete _writeBehind;
+    _writeBehind = NULL;
+  }
+ #endif
   return hres;
   COM_TRY_END
 }
@@ -197,7 +569,17 @@ HRESULT CMultiOutStream::CloseStream(unsigned index)
   CVolStream &s = Streams[index];
   if (s.Stream)
   {
-    RINOK(s.StreamSpec->Close())
+   #ifndef Z7_ST
+    if (_writeBehind)
+    {
+      _writeBehind->Finish(index, s.Stream, s.StreamSpec,
+          false, NULL, FString(), FString());
+    }
+    else
+   #endif
+    {
+      RINOK(s.StreamSpec->Close())
+    }
     // the following two commands must be called together:
     s.Stream.Release();
     RemoveFromLinkedList(index);
@@ -211,13 +593,15 @@ HRESULT CMultiOutStream::CloseStream_and_DeleteFile(unsigned index)
 {
   PRF(printf("\n====== %u, CloseStream_AndDelete \n", index))
   RINOK(CloseStream(index))
+  // the file must be closed by write-behind threads before deleting
+  const HRESULT wbRes = WaitWriteBehind();
   FString path = GetFilePath(index);
   path += Streams[index].Postfix;
   // we can checki that file exist
   // if (NFind::DoesFileExist_Raw(path))
   if (!DeleteFileAlways(path))
     return GetLastError_noZero_HRESULT();
-  return S_OK;
+  return wbRes;
 }
 
 
@@ -225,6 +609,31 @@ HRESULT CMultiOutStream::CloseStream_and_FinalRename(unsigned index)
 {
   PRF(printf("\n====== %u, CloseStream_and_FinalRename \n", index))
   CVolStream &s = Streams[index];
+
+ #ifndef Z7_ST
+  if (_writeBehind)
+  {
+    if (!s.Stream && s.Postfix.IsEmpty())
+      return S_OK;
+    FString path, tempPath;
+    if (!s.Postfix.IsEmpty())
+    {
+      path = GetFilePath(index);
+      tempPath = path;
+      tempPath += s.Postfix;
+    }
+    _writeBehind->Finish(index, s.Stream, s.StreamSpec,
+        SyncVolumes, MTime_Defined ? &MTime : NULL, tempPath, path);
+    if (s.Stream)
+    {
+      s.Stream.Release();
+      RemoveFromLinkedList(index);
+    }
+    s.Postfix.Empty();
+    return S_OK;
+  }
+ #endif
+
   // HRESULT res = S_OK;
   bool mtime_WasSet = false;
   if (MTime_Defined && s.Stream)
@@ -233,6 +642,9 @@ HRESULT CMultiOutStream::CloseStream_and_FinalRename(unsigned index)
       mtime_WasSet = true;
     // else res = GetLastError_noZero_HRESULT();
   }
+  if (SyncVolumes && s.Stream)
+    if (!s.StreamSpec->File.Sync())
+      return GetLastError_noZero_HRESULT();
 
   RINOK(CloseStream(index))
   if (s.Postfix.IsEmpty()) // if Postfix is empty, the path is already final
@@ -361,6 +773,8 @@ HRESULT CMultiOutStream::CreateStreams_If_Required(unsigned streamIndex)
 HRESULT CMultiOutStream::ReOpenStream(unsigned streamIndex)
 {
   PRF(printf("\n====== %u, ReOpenStream \n", streamIndex))
+  // queued writes and renaming of that volume must be finished before reopening
+  RINOK(WaitWriteBehind())
   RINOK(PrepareToOpenNew())
   CVolStream &s = Streams[streamIndex];
 
@@ -415,6 +829,10 @@ HRESULT CMultiOutStream::OptReOpen_and_SetSize(unsigned index, UInt64 size)
   {
     RINOK(ReOpenStream(index))
   }
+  else
+  {
+    RINOK(WaitWriteBehind())
+  }
   PRF(printf("\n== %u, OptReOpen_and_SetSize, size =%u RealSize = %u\n", index, (unsigned)size, (unsigned)s.RealSize))
   // comment it to debug tail after data
   return s.SetSize2(size);
@@ -522,6 +940,11 @@ HRESULT CMultiOutStream::FinalFlush_and_CloseFiles(unsigned &numTotalVolumesRes)
     if (res == S_OK)
       res = res2;
   }
+  {
+    const HRESULT res2 = WaitWriteBehind();
+    if (res == S_OK)
+      res = res2;
+  }
   if (NumListItems != 0 && res == S_OK)
     res = E_FAIL;
   return res;
@@ -533,7 +956,7 @@ bool CMultiOutStream::SetMTime_Final(const CFiTime &mTime)
   // we will set mtime only if new value differs from previous
   if (!FinalVol_WasReopen && MTime_Defined && Compare_FiTime(&MTime, &mTime) == 0)
     return true;
-  bool res = true;
+  bool res = (WaitWriteBehind() == S_OK);
   FOR_VECTOR (i, Streams)
   {
     CVolStream &s = Streams[i];
@@ -602,6 +1025,20 @@ Z7_COM7F_IMF(CMultiOutStream::Write(const void *data, UInt32 size, UInt32 *proce
   PRF(printf("\n -- CMultiOutStream::Write() : _absPos = %6u, size =%6u \n",
       (unsigned)_absPos, (unsigned)size))
 
+#ifndef Z7_ST
+  if (WriteBehind_MemLimit != 0 && !_writeBehind)
+  {
+    CVolWriteBehind *wb = new CVolWriteBehind;
+    const WRes wres = wb->Create(WriteBehind_MemLimit, WriteBehind_NumThreads);
+    if (wres != 0)
+    {
+      delete wb;
+      return HRESULT_FROM_WIN32(wres);
+    }
+    _writeBehind = wb;
+  }
+#endif
+
   if (_absPos > _length)
   {
     // it create data only up to _absPos.
@@ -660,11 +1097,6 @@ Z7_COM7F_IMF(CMultiOutStream::Write(const void *data, UInt32 size, UInt32 *proce
     {
       RINOK(ReOpenStream(_streamIndex))
     }
-    if (_offsetPos != s.Pos)
-    {
-      RINOK(s.Stream->Seek((Int64)_offsetPos, STREAM_SEEK_SET, NULL))
-      s.Pos = _offsetPos;
-    }
 
     UInt32 curSize = size;
     {
@@ -674,8 +1106,27 @@ Z7_COM7F_IMF(CMultiOutStream::Write(const void *data, UInt32 size, UInt32 *proce
     }
     // curSize != 0
     UInt32 realProcessed = 0;
+    HRESULT hres;
     
-    HRESULT hres = s.Stream->Write(data, curSize, &realProcessed);
+   #ifndef Z7_ST
+    if (_writeBehind)
+    {
+      // the thread writes the data at (_offsetPos) later
+      RINOK(_writeBehind->Write(_streamIndex, s.StreamSpec, _offsetPos, (const Byte *)data, curSize))
+      s.Pos = _offsetPos;
+      realProcessed = curSize;
+      hres = S_OK;
+    }
+    else
+   #endif
+    {
+      if (_offsetPos != s.Pos)
+      {
+        RINOK(s.Stream->Seek((Int64)_offsetPos, STREAM_SEEK_SET, NULL))
+        s.Pos = _offsetPos;
+      }
+      hres = s.Stream->Write(data, curSize, &realProcessed);
+    }
     
     data = (const void *)((const Byte *)data + realProcessed);
     size -= realProcessed;
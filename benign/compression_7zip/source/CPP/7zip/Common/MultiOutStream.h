@@ -5,6 +5,10 @@
 
 #include "FileStreams.h"
 
+#ifndef Z7_ST
+class CVolWriteBehind;
+#endif
+
 Z7_CLASS_IMP_COM_2(
   CMultiOutStream
   , IOutStream
@@ -49,6 +53,11 @@ Z7_CLASS_IMP_COM_2(
 
   unsigned NumOpenFiles_AllowedMax;
 
+ #ifndef Z7_ST
+  CVolWriteBehind *_writeBehind;
+ #endif
+  HRESULT WaitWriteBehind();
+
   // ----- Double Linked List -----
 
   unsigned NumListItems;
@@ -143,8 +152,26 @@ public:
   bool MTime_Defined;
   bool FinalVol_WasReopen;
   bool NeedDelete;
-
-  CMultiOutStream() {}
+  bool SyncVolumes; // flush data of each finished volume to storage device before closing
+ #ifndef Z7_ST
+  /* if (WriteBehind_MemLimit != 0), Write() only copies data to queue,
+     and worker threads write data to volumes and finish the volumes.
+     (WriteBehind_MemLimit) limits the size of data in queue.
+     (WriteBehind_NumThreads) is the number of worker threads. */
+  UInt64 WriteBehind_MemLimit;
+  UInt32 WriteBehind_NumThreads;
+ #endif
+
+  CMultiOutStream():
+     #ifndef Z7_ST
+      _writeBehind(NULL),
+     #endif
+      SyncVolumes(false)
+     #ifndef Z7_ST
+      , WriteBehind_MemLimit(0)
+      , WriteBehind_NumThreads(1)
+     #endif
+      {}
   ~CMultiOutStream();
   void Init(const CRecordVector<UInt64> &sizes);
   bool SetMTime_Final(const CFiTime &mTime);
@@ -0,0 +1,362 @@
+// StageStats.cpp
+
+#include "StdAfx.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include "../../Common/IntToString.h"
+#include "../../Common/MyVector.h"
+
+#include "../../Windows/FileIO.h"
+#ifndef Z7_ST
+#include "../../Windows/Synchronization.h"
+#endif
+
+#include "StageStats.h"
+
+namespace NStageStats {
+
+bool g_Enabled = false;
+
+static bool g_TraceEnabled = false;
+
+// we limit the memory used for trace events: 32 bytes per event
+static const unsigned kNumTraceEvents_Max_PerThread = 1 << 18;
+
+static const char * const k_StageNames[kNumStages] =
+{
+    "read"
+  , "write"
+  , "decode"
+  , "encode"
+  , "filter"
+  , "hash"
+  , "callback"
+};
+
+struct CTraceEvent
+{
+  UInt32 Stage;
+  UInt64 StartTime;
+  UInt64 Duration;
+  UInt64 Size;
+};
+
+/* Each thread writes to its own CThreadStat object without locks.
+   The object is registered in (g_Threads) only once, for first event in thread.
+   The counters of all threads are merged in PrintStats() and WriteTrace(),
+   that are called after the end of operation. */
+
+struct CThreadStat
+{
+  UInt64 Counts[kNumStages];
+  UInt64 Times[kNumStages];
+  UInt64 Sizes[kNumStages];
+  UInt64 NumDroppedEvents;
+  UInt64 WaitTime; // total time of CWaitTimer blocks in thread
+  CRecordVector<CTraceEvent> Events;
+
+  CThreadStat(): NumDroppedEvents(0), WaitTime(0)
+  {
+    for (unsigned i = 0; i < kNumStages; i++)
+    {
+      Counts[i] = 0;
+      Times[i] = 0;
+      Sizes[i] = 0;
+    }
+  }
+};
+
+static CObjectVector<CThreadStat> g_Threads;
+static UInt64 g_BaseTime;
+
+#ifndef Z7_ST
+static NWindows::NSynchronization::CCriticalSection g_CS;
+#define STAGE_STATS_LOCK NWindows::NSynchronization::CCriticalSectionLock lock(g_CS);
+#else
+#define STAGE_STATS_LOCK
+#endif
+
+
+#ifdef _WIN32
+
+UInt64 GetTimeNs()
+{
+  static UInt64 g_Freq;
+  LARGE_INTEGER v;
+  if (g_Freq == 0)
+  {
+    if (!::QueryPerformanceFrequency(&v) || v.QuadPart == 0)
+      return (UInt64)::GetTickCount() * 1000000;
+    g_Freq = (UInt64)v.QuadPart;
+  }
+  ::QueryPerformanceCounter(&v);
+  const UInt64 t = (UInt64)v.QuadPart;
+  return t / g_Freq * 1000000000 + (t % g_Freq) * 1000000000 / g_Freq;
+}
+
+#else
+
+UInt64 GetTimeNs()
+{
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+    return 0;
+  return (UInt64)ts.tv_sec * 1000000000 + (UInt64)ts.tv_nsec;
+}
+
+#endif
+
+
+// the pointer to CThreadStat object of current thread is stored in thread local storage.
+
+#ifdef Z7_ST
+
+static CThreadStat *g_ThreadStat;
+
+static bool ThreadStat_CreateKey() { return true; }
+static CThreadStat *ThreadStat_Get() { return g_ThreadStat; }
+static void ThreadStat_Set(CThreadStat *t) { g_ThreadStat = t; }
+
+#elif defined(_WIN32)
+
+static DWORD g_TlsIndex = TLS_OUT_OF_INDEXES;
+
+static bool ThreadStat_CreateKey()
+{
+  if (g_TlsIndex == TLS_OUT_OF_INDEXES)
+    g_TlsIndex = ::TlsAlloc();
+  return g_TlsIndex != TLS_OUT_OF_INDEXES;
+}
+static CThreadStat *ThreadStat_Get() { return (CThreadStat *)::TlsGetValue(g_TlsIndex); }
+static void ThreadStat_Set(CThreadStat *t) { ::TlsSetValue(g_TlsIndex, t); }
+
+#else
+
+static pthread_key_t g_TlsKey;
+static bool g_TlsKey_Created;
+
+static bool ThreadStat_CreateKey()
+{
+  if (!g_TlsKey_Created)
+    g_TlsKey_Created = (pthread_key_create(&g_TlsKey, NULL) == 0);
+  return g_TlsKey_Created;
+}
+static CThreadStat *ThreadStat_Get() { return (CThreadStat *)pthread_getspecific(g_TlsKey); }
+static void ThreadStat_Set(CThreadStat *t) { pthread_setspecific(g_TlsKey, t); }
+
+#endif
+
+
+void Enable(bool needTrace)
+{
+  // Enable() is called before the start of other threads
+  if (!ThreadStat_CreateKey())
+    return;
+  g_BaseTime = GetTimeNs();
+  g_TraceEnabled = needTrace;
+  g_Enabled = true;
+}
+
+
+static CThreadStat *ThreadStat_GetOrCreate()
+{
+  CThreadStat *t = ThreadStat_Get();
+  if (!t)
+  {
+    {
+      STAGE_STATS_LOCK
+      t = &g_Threads.AddNew();
+    }
+    ThreadStat_Set(t);
+  }
+  return t;
+}
+
+
+UInt64 GetWaitTime()
+{
+  const CThreadStat *t = ThreadStat_Get();
+  return t ? t->WaitTime : 0;
+}
+
+
+void AddWaitTime(UInt64 startTime)
+{
+  const UInt64 finishTime = GetTimeNs();
+  ThreadStat_GetOrCreate()->WaitTime += finishTime - startTime;
+}
+
+
+void AddEvent(unsigned stage, UInt64 startTime, UInt64 waitTime, UInt64 size)
+{
+  const UInt64 finishTime = GetTimeNs();
+  CThreadStat *t = ThreadStat_GetOrCreate();
+  UInt64 duration = finishTime - startTime;
+  if (duration > waitTime)
+    duration -= waitTime;
+  else
+    duration = 0;
+  t->Counts[stage]++;
+  t->Times[stage] += duration;
+  t->Sizes[stage] += size;
+
+  if (g_TraceEnabled)
+  {
+    if (t->Events.Size() >= kNumTraceEvents_Max_PerThread)
+      t->NumDroppedEvents++;
+    else
+    {
+      CTraceEvent e;
+      e.Stage = stage;
+      e.StartTime = startTime;
+      e.Duration = duration;
+      e.Size = size;
+      t->Events.Add(e);
+    }
+  }
+}
+
+
+static void AddNumRight(AString &s, UInt64 val, unsigned size)
+{
+  char temp[32];
+  ConvertUInt64ToString(val, temp);
+  for (unsigned len = MyStringLen(temp); len < size; len++)
+    s.Add_Space();
+  s += temp;
+}
+
+static void AddNameLeft(AString &s, const char *name, unsigned size)
+{
+  s += name;
+  for (unsigned len = MyStringLen(name); len < size; len++)
+    s.Add_Space();
+}
+
+static const unsigned kFieldSize_Name = 10;
+static const unsigned kFieldSize_Num = 12;
+
+void PrintStats(AString &s)
+{
+  STAGE_STATS_LOCK
+  s.Add_LF();
+  AddNameLeft(s, "Stage", kFieldSize_Name);
+  s += "       Calls       MiB         ms  Threads";
+  s.Add_LF();
+  unsigned stage;
+  for (stage = 0; stage < kNumStages; stage++)
+  {
+    UInt64 count = 0, time = 0, size = 0;
+    unsigned numThreads = 0;
+    FOR_VECTOR (i, g_Threads)
+    {
+      const CThreadStat &t = g_Threads[i];
+      if (t.Counts[stage] == 0)
+        continue;
+      numThreads++;
+      count += t.Counts[stage];
+      time += t.Times[stage];
+      size += t.Sizes[stage];
+    }
+    if (count == 0)
+      continue;
+    AddNameLeft(s, k_StageNames[stage], kFieldSize_Name);
+    AddNumRight(s, count, kFieldSize_Num);
+    AddNumRight(s, size >> 20, 10);
+    AddNumRight(s, time / 1000000, 11);
+    AddNumRight(s, numThreads, 9);
+    s.Add_LF();
+  }
+
+  s.Add_LF();
+  AddNameLeft(s, "Thread", kFieldSize_Name);
+  for (stage = 0; stage < kNumStages; stage++)
+  {
+    s.Add_Space();
+    AddNameLeft(s, k_StageNames[stage], 9);
+  }
+  s += "(ms)";
+  s.Add_LF();
+  FOR_VECTOR (i, g_Threads)
+  {
+    const CThreadStat &t = g_Threads[i];
+    AddNumRight(s, i, 6);
+    AddNameLeft(s, "", kFieldSize_Name - 6);
+    for (stage = 0; stage < kNumStages; stage++)
+    {
+      char temp[32];
+      temp[0] = '-';
+      temp[1] = 0;
+      if (t.Counts[stage] != 0)
+        ConvertUInt64ToString(t.Times[stage] / 1000000, temp);
+      s.Add_Space();
+      AddNameLeft(s, temp, stage + 1 == kNumStages ? 0 : 9);
+    }
+    s.Add_LF();
+  }
+  UInt64 numDroppedEvents = 0;
+  FOR_VECTOR (i, g_Threads)
+    numDroppedEvents += g_Threads[i].NumDroppedEvents;
+  if (numDroppedEvents != 0)
+  {
+    s += "Dropped trace events: ";
+    s.Add_UInt64(numDroppedEvents);
+    s.Add_LF();
+  }
+}
+
+
+static void AddTimeUs(AString &s, UInt64 ns)
+{
+  s.Add_UInt64(ns / 1000);
+  s.Add_Dot();
+  char temp[32];
+  ConvertUInt32ToString((UInt32)(ns % 1000) + 1000, temp);
+  s += temp + 1;
+}
+
+bool WriteTrace(CFSTR path)
+{
+  NWindows::NFile::NIO::COutFile file;
+  if (!file.Create_ALWAYS(path))
+    return false;
+  STAGE_STATS_LOCK
+  AString s ("{\"traceEvents\":[\n");
+  bool isFirst = true;
+  FOR_VECTOR (t, g_Threads)
+  {
+    const CRecordVector<CTraceEvent> &events = g_Threads[t].Events;
+    FOR_VECTOR (i, events)
+    {
+      const CTraceEvent &e = events[i];
+      if (!isFirst)
+        s += ",\n";
+      isFirst = false;
+      s += "{\"name\":\"";
+      s += k_StageNames[e.Stage];
+      s += "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+      s.Add_UInt32(t);
+      s += ",\"ts\":";
+      AddTimeUs(s, e.StartTime >= g_BaseTime ? e.StartTime - g_BaseTime : 0);
+      s += ",\"dur\":";
+      AddTimeUs(s, e.Duration);
+      s += ",\"args\":{\"size\":";
+      s.Add_UInt64(e.Size);
+      s += "}}";
+      if (s.Len() >= (1 << 16))
+      {
+        if (!file.WriteFull(s.Ptr(), s.Len()))
+          return false;
+        s.Empty();
+      }
+    }
+  }
+  s += "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return file.WriteFull(s.Ptr(), s.Len());
+}
+
+}
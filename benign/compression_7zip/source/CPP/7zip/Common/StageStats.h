@@ -0,0 +1,99 @@
+// StageStats.h
+
+#ifndef ZIP7_INC_STAGE_STATS_H
+#define ZIP7_INC_STAGE_STATS_H
+
+#include "../../Common/MyString.h"
+
+/*
+  Opt-in per-stage instrumentation (-bts switch).
+  Each CTimer object adds its duration to the counters of current thread.
+  The time that thread spends in CWaitTimer blocks (waiting for other threads)
+  is excluded from the duration of all CTimer objects of that thread.
+  If (g_Enabled == false), CTimer doesn't call any time functions.
+  Also the events can be recorded for export in Chrome trace-event JSON format.
+*/
+
+namespace NStageStats {
+
+enum EStage
+{
+  kStage_Read,
+  kStage_Write,
+  kStage_Decode,
+  kStage_Encode,
+  kStage_Filter,
+  kStage_Hash,
+  kStage_Callback,
+
+  kNumStages
+};
+
+extern bool g_Enabled;
+
+UInt64 GetTimeNs();
+// (waitTime) is the time of CWaitTimer blocks inside the event
+void AddEvent(unsigned stage, UInt64 startTime, UInt64 waitTime, UInt64 size);
+UInt64 GetWaitTime();
+void AddWaitTime(UInt64 startTime);
+
+void Enable(bool needTrace);
+void PrintStats(AString &s);
+bool WriteTrace(CFSTR path);
+
+class CTimer
+{
+  UInt64 _startTime;
+  UInt64 _waitTime;
+  const UInt32 *_sizePtr;
+  unsigned _stage;
+  bool _enabled;
+public:
+  UInt64 Size;
+
+  CTimer(unsigned stage, const UInt32 *sizePtr = NULL):
+      _startTime(0),
+      _waitTime(0),
+      _sizePtr(sizePtr),
+      _stage(stage),
+      _enabled(g_Enabled),
+      Size(0)
+  {
+    if (_enabled)
+    {
+      _waitTime = GetWaitTime();
+      _startTime = GetTimeNs();
+    }
+  }
+
+  ~CTimer()
+  {
+    if (_enabled)
+      AddEvent(_stage, _startTime, GetWaitTime() - _waitTime, _sizePtr ? *_sizePtr : Size);
+  }
+};
+
+// CWaitTimer is used for blocks where the thread waits for data from another thread.
+class CWaitTimer
+{
+  UInt64 _startTime;
+  bool _enabled;
+public:
+  CWaitTimer():
+      _startTime(0),
+      _enabled(g_Enabled)
+  {
+    if (_enabled)
+      _startTime = GetTimeNs();
+  }
+
+  ~CWaitTimer()
+  {
+    if (_enabled)
+      AddWaitTime(_startTime);
+  }
+};
+
+}
+
+#endif
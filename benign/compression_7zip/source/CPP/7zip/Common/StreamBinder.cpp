@@ -4,6 +4,7 @@
 
 #include "../../Common/MyCom.h"
 
+#include "StageStats.h"
 #include "StreamBinder.h"
 
 Z7_CLASS_IMP_COM_1(
@@ -77,6 +78,8 @@ HRESULT CStreamBinder::Read(void *data, UInt32 size, UInt32 *processedSize)
   {
     if (_waitWrite)
     {
+      // the time of waiting for data from another coder is not included to stage times
+      NStageStats::CWaitTimer waitTimer;
       WRes wres = _canRead_Event.Lock();
       if (wres != 0)
         return HRESULT_FROM_WIN32(wres);
@@ -130,7 +133,10 @@ HRESULT CStreamBinder::Write(const void *data, UInt32 size, UInt32 *processedSiz
       _readingWasClosed2 = true;
     */
 
-    _canWrite_Semaphore.Lock();
+    {
+      NStageStats::CWaitTimer waitTimer;
+      _canWrite_Semaphore.Lock();
+    }
 
     // _bufSize : is remain size that was not read
     size -= _bufSize;
@@ -430,7 +430,12 @@ void CThreadInfo::EncodeBlock(const Byte *block, UInt32 blockSize)
 {
   // WriteBit2(0); // Randomised = false
   {
-    const UInt32 origPtr = BlockSort(m_BlockSorterIndex, block, blockSize);
+    UInt32 origPtr;
+    /* BlockSort() is slow for blocks with long repeated strings.
+       SA-IS sorting has linear time for such blocks. */
+    if (!BlockSort_IsRepetitive(m_BlockSorterIndex, block, blockSize)
+        || BlockSort_SaIs(m_BlockSorterIndex, block, blockSize, &origPtr, &g_BigAlloc) != SZ_OK)
+      origPtr = BlockSort(m_BlockSorterIndex, block, blockSize);
     // if (m_BlockSorterIndex[origPtr] != 0) throw 1;
     m_BlockSorterIndex[origPtr] = blockSize;
     WriteBits2(origPtr, kNumOrigBits + 1); // + 1 for additional high bit flag (Randomised = false)
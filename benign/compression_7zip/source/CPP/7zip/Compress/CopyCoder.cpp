@@ -25,14 +25,46 @@ Z7_COM7F_IMF(CCopyCoder::Code(ISequentialInStream *inStream,
     const UInt64 * /* inSize */, const UInt64 *outSize,
     ICompressProgressInfo *progress))
 {
+  TotalSize = 0;
+
+  /* if both streams are files, we try OS-level copying (reflink or copy_file_range())
+     that doesn't transfer the data through user-space buffers */
+  if (outSize && outStream)
+  {
+    Z7_DECL_CMyComPtr_QI_FROM(IOutStreamCopyFrom, copyFrom, outStream)
+    Z7_DECL_CMyComPtr_QI_FROM(IInStream, inSeekStream, inStream)
+    if (copyFrom && inSeekStream)
+    {
+      const UInt64 kStepSize = (UInt64)1 << 26;
+      while (TotalSize != *outSize)
+      {
+        UInt64 cur = *outSize - TotalSize;
+        if (cur > kStepSize)
+          cur = kStepSize;
+        UInt64 processed = 0;
+        const HRESULT res = copyFrom->CopyFrom(inSeekStream, cur, &processed);
+        TotalSize += processed;
+        if (res == E_NOTIMPL)
+          break;
+        RINOK(res)
+        if (processed != cur)
+          return S_OK;
+        if (progress)
+        {
+          RINOK(progress->SetRatioInfo(&TotalSize, &TotalSize))
+        }
+      }
+      if (TotalSize == *outSize)
+        return S_OK;
+    }
+  }
+
   if (!_buf)
   {
     _buf = (Byte *)::MidAlloc(kBufSize);
     if (!_buf)
       return E_OUTOFMEMORY;
   }
-
-  TotalSize = 0;
   
   for (;;)
   {
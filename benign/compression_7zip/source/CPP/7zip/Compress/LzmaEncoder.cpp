@@ -343,8 +343,23 @@ Z7_COM7F_IMF(CEncoder::Code(ISequentialInStream *inStream, ISequentialOutStream
   #endif
   
   
-  SRes res = LzmaEnc_Encode(_encoder, &outWrap.vt, &inWrap.vt,
-      progress ? &progressWrap.vt : NULL, &g_AlignedAlloc, &g_BigAlloc);
+  SRes res;
+  {
+    Z7_DECL_CMyComPtr_QI_FROM(IStreamDirectBuf, directBuf, inStream)
+    const Byte *src = NULL;
+    size_t srcLen = 0;
+    if (directBuf && directBuf->GetDirectBuf(&src, &srcLen) == S_OK)
+    {
+      // the match finder reads data from memory mapped file without copying
+      res = LzmaEnc_EncodeFromBuf(_encoder, &outWrap.vt, src, srcLen,
+          progress ? &progressWrap.vt : NULL, &g_AlignedAlloc, &g_BigAlloc);
+      RINOK(directBuf->SkipDirectBuf(srcLen))
+      inWrap.Processed = srcLen;
+    }
+    else
+      res = LzmaEnc_Encode(_encoder, &outWrap.vt, &inWrap.vt,
+          progress ? &progressWrap.vt : NULL, &g_AlignedAlloc, &g_BigAlloc);
+  }
 
   _inputProcessed = inWrap.Processed;
 
@@ -0,0 +1,442 @@
+// LzxEncoder.cpp
+
+#include "StdAfx.h"
+
+#include <string.h>
+
+#include "../../../C/Alloc.h"
+#include "../../../C/CpuArch.h"
+#include "../../../C/HuffEnc.h"
+
+#include "LzxEncoder.h"
+
+namespace NCompress {
+namespace NLzx {
+
+static const unsigned kWimNumPosSlots = 30;
+static const unsigned kWimNumPosLenSlots = kWimNumPosSlots * kNumLenSlots;
+
+static const UInt32 kWimTranslationSize = 12000000;
+
+/* formatted offset is (dist + kNumReps - 1).
+   The largest formatted offset for 30 position slots is (32768 - 1) */
+static const UInt32 kHistorySize = kWimChunkSize - kNumReps;
+
+// we don't look for better match at next position, if match is long enough
+static const unsigned kLazyLenMax = 32;
+
+static const unsigned kNumLevelHuffBits = (1 << kNumLevelBits) - 1;
+
+// the maximum number of bytes that can be written for one item
+static const unsigned kItemSizeMax = 8;
+
+
+class CBitWriter
+{
+  Byte *_buf;
+  const Byte *_lim;
+  UInt32 _value;
+  unsigned _bitPos;
+  bool _overflow;
+
+  void WriteWord(UInt32 w)
+  {
+    if (_buf >= _lim)
+    {
+      _overflow = true;
+      return;
+    }
+    SetUi16(_buf, (UInt16)w)
+    _buf += 2;
+  }
+public:
+  void Init(Byte *buf, size_t size)
+  {
+    _buf = buf;
+    _lim = buf + (size & ~(size_t)1);
+    _value = 0;
+    _bitPos = 0;
+    _overflow = false;
+  }
+
+  // (numBits <= 16)
+  void WriteBits(UInt32 value, unsigned numBits)
+  {
+    _value = (_value << numBits) | value;
+    _bitPos += numBits;
+    if (_bitPos >= 16)
+    {
+      _bitPos -= 16;
+      WriteWord(_value >> _bitPos);
+    }
+  }
+
+  void Flush()
+  {
+    if (_bitPos != 0)
+    {
+      WriteWord(_value << (16 - _bitPos));
+      _bitPos = 0;
+    }
+  }
+
+  bool IsOverflow() const { return _overflow; }
+  bool IsNearEnd() const { return _buf + kItemSizeMax > _lim; }
+  const Byte *GetPtr() const { return _buf; }
+};
+
+
+/* the encoder side of x86 translation in CDecoder::Flush().
+   The last 10 bytes are not translated. */
+
+static void x86_Translate(Byte *data, UInt32 size)
+{
+  if (size <= 10)
+    return;
+  const UInt32 lim = size - 10;
+  for (UInt32 i = 0; i < lim;)
+  {
+    if (data[i] != 0xe8)
+    {
+      i++;
+      continue;
+    }
+    const Int32 pos = (Int32)i;
+    const Int32 rel = (Int32)GetUi32(data + i + 1);
+    if (rel >= -pos && rel < (Int32)kWimTranslationSize)
+    {
+      const Int32 abs = (rel < (Int32)kWimTranslationSize - pos) ?
+          rel + pos :
+          rel - (Int32)kWimTranslationSize;
+      SetUi32(data + i + 1, (UInt32)abs)
+    }
+    i += 5;
+  }
+}
+
+
+static unsigned GetPosSlot(UInt32 formattedOffset)
+{
+  unsigned numBits = 0;
+  for (UInt32 v = formattedOffset; v > 1; v >>= 1)
+    numBits++;
+  // (formattedOffset >= kNumReps), so (numBits >= 1)
+  return numBits * 2 + (unsigned)((formattedOffset >> (numBits - 1)) & 1);
+}
+
+
+CEncoder::CEncoder():
+    _mfCreated(false)
+{
+  MatchFinder_Construct(&_mf);
+}
+
+CEncoder::~CEncoder()
+{
+  MatchFinder_Free(&_mf, &g_AlignedAlloc);
+}
+
+unsigned CEncoder::GetLongestMatch(UInt32 &dist)
+{
+  const size_t num = (size_t)(Bt3Zip_MatchFinder_GetMatches(&_mf, _distances) - _distances);
+  if (num == 0)
+    return 0;
+  dist = _distances[num - 1] + 1;
+  return (unsigned)_distances[num - 2];
+}
+
+
+/* items: literal is (byte),
+   and match is ((len << 20) | distValue),
+   where (distValue) is rep index (< kNumReps) or formatted offset. */
+
+void CEncoder::AddMatch(unsigned len, UInt32 distValue)
+{
+  _items.AddInReserved(((UInt32)len << 20) | distValue);
+  const unsigned posSlot = (distValue < kNumReps) ? (unsigned)distValue : GetPosSlot(distValue);
+  len -= kMatchMinLen;
+  if (len < kNumLenSlots - 1)
+    _mainFreqs[256 + posSlot * kNumLenSlots + len]++;
+  else
+  {
+    _mainFreqs[256 + posSlot * kNumLenSlots + kNumLenSlots - 1]++;
+    _lenFreqs[len - (kNumLenSlots - 1)]++;
+  }
+}
+
+#define ADD_LITERAL(b) \
+  { _items.AddInReserved(b);  _mainFreqs[b]++; }
+
+void CEncoder::Parse(const Byte *data, UInt32 size)
+{
+  _reps[0] = _reps[1] = _reps[2] = 1;
+  UInt32 pos = 0;
+  UInt32 dist = 0;
+  unsigned len = GetLongestMatch(dist);
+
+  for (;;)
+  {
+    // rep matches are cheaper than new matches with same length
+    {
+      const UInt32 rem = size - pos;
+      const unsigned lenLimit = rem < kMatchMaxLen ? (unsigned)rem : kMatchMaxLen;
+      unsigned repLen = 0;
+      unsigned repIndex = 0;
+      if (lenLimit >= kMatchMinLen)
+      {
+        const Byte *p = data + pos;
+        for (unsigned i = 0; i < kNumReps; i++)
+        {
+          const UInt32 rep = _reps[i];
+          if (rep > pos)
+            continue;
+          const Byte *p2 = p - rep;
+          if (p[0] != p2[0] || p[1] != p2[1])
+            continue;
+          unsigned k;
+          for (k = 2; k < lenLimit && p[k] == p2[k]; k++);
+          if (repLen < k)
+          {
+            repLen = k;
+            repIndex = i;
+          }
+        }
+      }
+      if (repLen != 0 && repLen + 1 >= len)
+      {
+        AddMatch(repLen, repIndex);
+        const UInt32 rep = _reps[repIndex];
+        _reps[repIndex] = _reps[0];
+        _reps[0] = rep;
+        Bt3Zip_MatchFinder_Skip(&_mf, repLen - 1);
+        pos += repLen;
+        if (pos == size)
+          return;
+        len = GetLongestMatch(dist);
+        continue;
+      }
+    }
+
+    // Bt3Zip match finder reports matches of 3 bytes or longer
+    if (len == 0)
+    {
+      ADD_LITERAL(data[pos])
+      if (++pos == size)
+        return;
+      len = GetLongestMatch(dist);
+      continue;
+    }
+
+    UInt32 numSkip = len - 1;
+    if (len < kLazyLenMax)
+    {
+      // (pos + 1 < size) here
+      UInt32 dist2 = 0;
+      const unsigned len2 = GetLongestMatch(dist2);
+      if (len2 > len)
+      {
+        ADD_LITERAL(data[pos])
+        pos++;
+        len = len2;
+        dist = dist2;
+        continue;
+      }
+      numSkip--;
+    }
+
+    {
+      unsigned i;
+      for (i = 0; i < kNumReps; i++)
+        if (_reps[i] == dist)
+          break;
+      if (i != kNumReps)
+      {
+        AddMatch(len, i);
+        _reps[i] = _reps[0];
+      }
+      else
+      {
+        AddMatch(len, dist + kNumReps - 1);
+        _reps[2] = _reps[1];
+        _reps[1] = _reps[0];
+      }
+      _reps[0] = dist;
+    }
+    Bt3Zip_MatchFinder_Skip(&_mf, numSkip);
+    pos += len;
+    if (pos == size)
+      return;
+    len = GetLongestMatch(dist);
+  }
+}
+
+
+/* WriteTable() writes the pretree and the levels of table.
+   The levels of previous table are zeros, because each chunk starts new block. */
+
+static void WriteTable(CBitWriter &bw, const Byte *levels, unsigned numLevels)
+{
+  Byte syms[kMaxTableSize];
+  Byte extra[kMaxTableSize];
+  unsigned numSyms = 0;
+  UInt32 freqs[kLevelTableSize];
+  UInt32 codes[kLevelTableSize];
+  Byte lens[kLevelTableSize];
+  memset(freqs, 0, sizeof(freqs));
+
+  for (unsigned i = 0; i < numLevels;)
+  {
+    const unsigned level = levels[i];
+    unsigned num = 1;
+    while (i + num < numLevels && levels[i + num] == level)
+      num++;
+
+    if (level == 0 && num >= kLevelSym_Zero1_Start)
+    {
+      unsigned sym = kLevelSym_Zero1;
+      unsigned start = kLevelSym_Zero1_Start;
+      if (num >= kLevelSym_Zero2_Start)
+      {
+        sym = kLevelSym_Zero2;
+        start = kLevelSym_Zero2_Start;
+        const unsigned numMax = kLevelSym_Zero2_Start + (1 << kLevelSym_Zero2_NumBits) - 1;
+        if (num > numMax)
+          num = numMax;
+      }
+      syms[numSyms] = (Byte)sym;
+      extra[numSyms++] = (Byte)(num - start);
+      freqs[sym]++;
+      i += num;
+      continue;
+    }
+
+    if (level != 0 && num >= kLevelSym_Same_Start)
+    {
+      const unsigned numMax = kLevelSym_Same_Start + (1 << kLevelSym_Same_NumBits) - 1;
+      if (num > numMax)
+        num = numMax;
+      syms[numSyms] = (Byte)kLevelSym_Same;
+      extra[numSyms++] = (Byte)(num - kLevelSym_Same_Start);
+      freqs[kLevelSym_Same]++;
+    }
+    else
+      num = 1;
+
+    // delta from previous level (0)
+    const unsigned sym = (kNumHuffmanBits + 1 - level) % (kNumHuffmanBits + 1);
+    syms[numSyms] = (Byte)sym;
+    extra[numSyms++] = 0;
+    freqs[sym]++;
+    i += num;
+  }
+
+  Huffman_Generate(freqs, codes, lens, kLevelTableSize, kNumLevelHuffBits);
+
+  unsigned i;
+  for (i = 0; i < kLevelTableSize; i++)
+    bw.WriteBits(lens[i], kNumLevelBits);
+
+  for (i = 0; i < numSyms; i++)
+  {
+    const unsigned sym = syms[i];
+    bw.WriteBits(codes[sym], lens[sym]);
+    if (sym == kLevelSym_Zero1)
+      bw.WriteBits(extra[i], kLevelSym_Zero1_NumBits);
+    else if (sym == kLevelSym_Zero2)
+      bw.WriteBits(extra[i], kLevelSym_Zero2_NumBits);
+    else if (sym == kLevelSym_Same)
+      bw.WriteBits(extra[i], kLevelSym_Same_NumBits);
+  }
+}
+
+
+HRESULT CEncoder::Encode(const Byte *in, size_t inSize, Byte *out, size_t outSize, size_t &packSize)
+{
+  packSize = 0;
+  if (inSize == 0 || inSize > kWimChunkSize)
+    return S_OK;
+
+  if (!_mfCreated)
+  {
+    _buf.Alloc(kWimChunkSize);
+    MatchFinder_SET_DIRECT_INPUT_BUF(&_mf, _buf, inSize)
+    _mf.btMode = 1;
+    _mf.numHashBytes = 3;
+    _mf.numHashBytes_Min = 3;
+    if (!MatchFinder_Create(&_mf, kHistorySize, 0, kMatchMaxLen, 0, &g_AlignedAlloc))
+      return E_OUTOFMEMORY;
+    _mfCreated = true;
+  }
+
+  const UInt32 size = (UInt32)inSize;
+  memcpy(_buf, in, size);
+  x86_Translate(_buf, size);
+
+  MatchFinder_SET_DIRECT_INPUT_BUF(&_mf, _buf, size)
+  MatchFinder_Init(&_mf);
+
+  _items.ClearAndReserve(size);
+  memset(_mainFreqs, 0, sizeof(_mainFreqs));
+  memset(_lenFreqs, 0, sizeof(_lenFreqs));
+  Parse(_buf, size);
+
+  const unsigned numMainSyms = 256 + kWimNumPosLenSlots;
+  Huffman_Generate(_mainFreqs, _mainCodes, _mainLevels, numMainSyms, kNumHuffmanBits);
+  Huffman_Generate(_lenFreqs, _lenCodes, _lenLevels, kNumLenSymbols, kNumHuffmanBits);
+
+  CBitWriter bw;
+  bw.Init(out, outSize);
+
+  bw.WriteBits(kBlockType_Verbatim, kBlockType_NumBits);
+  if (size == kWimChunkSize)
+    bw.WriteBits(1, 1);
+  else
+  {
+    bw.WriteBits(0, 1);
+    bw.WriteBits(size, 16);
+  }
+  WriteTable(bw, _mainLevels, 256);
+  WriteTable(bw, _mainLevels + 256, kWimNumPosLenSlots);
+  WriteTable(bw, _lenLevels, kNumLenSymbols);
+
+  const UInt32 *items = _items.ConstData();
+  const UInt32 *itemsLim = items + _items.Size();
+
+  for (; items != itemsLim; items++)
+  {
+    if (bw.IsNearEnd())
+      return S_OK;
+    const UInt32 v = *items;
+    if (v < 256)
+    {
+      bw.WriteBits(_mainCodes[v], _mainLevels[v]);
+      continue;
+    }
+    const UInt32 distValue = v & (((UInt32)1 << 20) - 1);
+    const unsigned len = (unsigned)(v >> 20) - kMatchMinLen;
+    const unsigned posSlot = (distValue < kNumReps) ? (unsigned)distValue : GetPosSlot(distValue);
+    {
+      const unsigned sym = 256 + posSlot * kNumLenSlots
+          + (len < kNumLenSlots - 1 ? len : kNumLenSlots - 1);
+      bw.WriteBits(_mainCodes[sym], _mainLevels[sym]);
+    }
+    if (len >= kNumLenSlots - 1)
+    {
+      const unsigned lenSym = len - (kNumLenSlots - 1);
+      bw.WriteBits(_lenCodes[lenSym], _lenLevels[lenSym]);
+    }
+    if (posSlot >= 4)
+    {
+      const unsigned numDirectBits = (posSlot >> 1) - 1;
+      bw.WriteBits(distValue & (((UInt32)1 << numDirectBits) - 1), numDirectBits);
+    }
+  }
+
+  bw.Flush();
+  if (bw.IsOverflow())
+    return S_OK;
+  packSize = (size_t)(bw.GetPtr() - out);
+  return S_OK;
+}
+
+}}
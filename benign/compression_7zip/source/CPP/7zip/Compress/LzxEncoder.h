@@ -0,0 +1,55 @@
+// LzxEncoder.h
+
+#ifndef ZIP7_INC_LZX_ENCODER_H
+#define ZIP7_INC_LZX_ENCODER_H
+
+#include "../../../C/LzFind.h"
+
+#include "../../Common/MyBuffer.h"
+#include "../../Common/MyVector.h"
+
+#include "Lzx.h"
+
+namespace NCompress {
+namespace NLzx {
+
+const unsigned kWimNumDictBits = 15;
+const UInt32 kWimChunkSize = (UInt32)1 << kWimNumDictBits;
+
+/* CEncoder compresses one block of data (WIM chunk) to LZX format
+   that is used in WIM archives (CDecoder::Set_WimMode(true)):
+     - the window size is 32 KB, and each chunk is compressed independently.
+     - x86 (E8) translation is always used with default translation size.
+   The encoder writes one verbatim block per chunk. */
+
+class CEncoder
+{
+  CMatchFinder _mf;
+  bool _mfCreated;
+  CByteBuffer _buf;
+  CRecordVector<UInt32> _items;
+  UInt32 _reps[kNumReps];
+
+  UInt32 _mainFreqs[kMainTableSize];
+  UInt32 _mainCodes[kMainTableSize];
+  Byte _mainLevels[kMainTableSize];
+  UInt32 _lenFreqs[kNumLenSymbols];
+  UInt32 _lenCodes[kNumLenSymbols];
+  Byte _lenLevels[kNumLenSymbols];
+  UInt32 _distances[kMatchMaxLen * 2 + 3];
+
+  unsigned GetLongestMatch(UInt32 &dist);
+  void AddMatch(unsigned len, UInt32 distValue);
+  void Parse(const Byte *data, UInt32 size);
+public:
+  CEncoder();
+  ~CEncoder();
+
+  /* (in) size must be <= kWimChunkSize.
+     (packSize == 0) is returned, if packed data doesn't fit to (outSize) */
+  HRESULT Encode(const Byte *in, size_t inSize, Byte *out, size_t outSize, size_t &packSize);
+};
+
+}}
+
+#endif
@@ -19,9 +19,12 @@ enum
   kStatus_NeedInit,
   kStatus_Normal,
   kStatus_Finished_With_Mark,
-  kStatus_Error
+  kStatus_Error,
+  kStatus_NeedBlockInit
 };
 
+static const unsigned kBlockHeaderSize = 8;
+
 CDecoder::~CDecoder()
 {
   ::MidFree(_outBuf);
@@ -34,6 +37,16 @@ Z7_COM7F_IMF(CDecoder::SetDecoderProperties2(const Byte *props, UInt32 size))
     return E_INVALIDARG;
   _order = props[0];
   const UInt32 memSize = GetUi32(props + 1);
+  _blockSize = 0;
+  if (_blockMode)
+  {
+    // block mode of PpmdEncoder
+    if (size != 9)
+      return E_NOTIMPL;
+    _blockSize = GetUi32(props + 5);
+    if (_blockSize == 0)
+      return E_NOTIMPL;
+  }
   if (_order < PPMD7_MIN_ORDER ||
       _order > PPMD7_MAX_ORDER ||
       memSize < PPMD7_MIN_MEM_SIZE ||
@@ -54,6 +67,100 @@ Z7_COM7F_IMF(CDecoder::SetDecoderProperties2(const Byte *props, UInt32 size))
       return (_res = (_inStream.Res != SZ_OK ? _inStream.Res: S_FALSE)); }
 
 
+HRESULT CDecoder::ReadBlockHeader()
+{
+  Byte header[kBlockHeaderSize];
+  for (unsigned i = 0; i < kBlockHeaderSize; i++)
+    header[i] = _inStream.ReadByte();
+  CHECK_EXTRA_ERROR
+  _blockPackSize = GetUi32(header);
+  _blockRem = GetUi32(header + 4);
+  if (_blockRem == 0)
+  {
+    // end marker
+    if (_blockPackSize != 0)
+    {
+      _status = kStatus_Error;
+      return (_res = S_FALSE);
+    }
+    _status = kStatus_Finished_With_Mark;
+    return S_OK;
+  }
+  if (_blockRem > _blockSize || _blockPackSize < 5)
+  {
+    _status = kStatus_Error;
+    return (_res = S_FALSE);
+  }
+  _status = kStatus_NeedBlockInit;
+  return S_OK;
+}
+
+
+HRESULT CDecoder::CodeBlocks(Byte *memStream, UInt32 size)
+{
+  if (_outSizeDefined)
+  {
+    const UInt64 rem = _outSize - _processedSize;
+    if (size > rem)
+      size = (UInt32)rem;
+  }
+
+  while (size != 0 && _status != kStatus_Finished_With_Mark)
+  {
+    if (_status == kStatus_NeedBlockInit)
+    {
+      _blockPackStart = _inStream.GetProcessed();
+      if (!Ppmd7z_RangeDec_Init(&MY_rangeDec))
+      {
+        _status = kStatus_Error;
+        return (_res = S_FALSE);
+      }
+      CHECK_EXTRA_ERROR
+      Ppmd7_Init(&_ppmd, _order);
+      _status = kStatus_Normal;
+    }
+
+    UInt32 cur = size;
+    if (cur > _blockRem)
+      cur = _blockRem;
+    int sym = 0;
+    Byte *buf = memStream;
+    const Byte *lim = buf + cur;
+    for (; buf != lim; buf++)
+    {
+      sym = Ppmd7z_DecodeSymbol(&_ppmd);
+      if (_inStream.Extra || sym < 0)
+        break;
+      *buf = (Byte)sym;
+    }
+    cur = (UInt32)(buf - memStream);
+    _processedSize += cur;
+    memStream += cur;
+    size -= cur;
+    _blockRem -= cur;
+
+    CHECK_EXTRA_ERROR
+    if (sym < 0)
+    {
+      _status = kStatus_Error;
+      return (_res = S_FALSE);
+    }
+
+    if (_blockRem == 0)
+    {
+      if (MY_rangeDec.Code != 0
+          || _inStream.GetProcessed() - _blockPackStart != _blockPackSize)
+      {
+        _status = kStatus_Error;
+        return (_res = S_FALSE);
+      }
+      RINOK(ReadBlockHeader())
+    }
+  }
+  return S_OK;
+}
+
+
 HRESULT CDecoder::CodeSpec(Byte *memStream, UInt32 size)
 {
   if (_res != S_OK)
@@ -65,6 +172,11 @@ HRESULT CDecoder::CodeSpec(Byte *memStream, UInt32 size)
     case kStatus_Error: return S_FALSE;
     case kStatus_NeedInit:
       _inStream.Init();
+      if (_blockSize != 0)
+      {
+        RINOK(ReadBlockHeader())
+        return CodeBlocks(memStream, size);
+      }
       if (!Ppmd7z_RangeDec_Init(&MY_rangeDec))
       {
         _status = kStatus_Error;
@@ -76,6 +188,9 @@ HRESULT CDecoder::CodeSpec(Byte *memStream, UInt32 size)
       break;
     default: break;
   }
+
+  if (_blockSize != 0)
+    return CodeBlocks(memStream, size);
   
   if (_outSizeDefined)
   {
@@ -62,6 +62,15 @@ class CDecoder Z7_final:
   UInt64 _outSize;
   UInt64 _processedSize;
 
+  // block mode: (_blockSize != 0)
+  bool _blockMode;
+  UInt32 _blockSize;
+  UInt32 _blockPackSize;
+  UInt32 _blockRem;
+  UInt64 _blockPackStart;
+
+  HRESULT ReadBlockHeader();
+  HRESULT CodeBlocks(Byte *memStream, UInt32 size);
   HRESULT CodeSpec(Byte *memStream, UInt32 size);
 
 public:
@@ -70,10 +79,12 @@ public:
   CMyComPtr<ISequentialInStream> InSeqStream;
  #endif
 
-  CDecoder():
+  CDecoder(bool blockMode = false):
       _outBuf(NULL),
       FinishStream(false),
-      _outSizeDefined(false)
+      _outSizeDefined(false),
+      _blockMode(blockMode),
+      _blockSize(0)
   {
     Ppmd7_Construct(&_ppmd);
     _ppmd.rc.dec.Stream = &_inStream.vt;
@@ -3,6 +3,7 @@
 #include "StdAfx.h"
 
 #include "../../../C/Alloc.h"
+#include "../../../C/CpuArch.h"
 
 #include "../Common/StreamUtils.h"
 
@@ -38,8 +39,56 @@ void CEncProps::Normalize(int level)
   if (Order == -1) Order = kOrders[(unsigned)level];
 }
 
+
+static void ByteOutMem_Write(const IByteOut *pp, Byte b) throw()
+{
+  CByteOutMem *p = Z7_CONTAINER_FROM_VTBL_CLS(pp, CByteOutMem, vt);
+  if (p->Pos == p->Size)
+  {
+    if (!p->Reserve(p->Size < (1 << 16) ? (1 << 16) : p->Size * 2))
+    {
+      p->Overflow = true;
+      return;
+    }
+  }
+  p->Buf[p->Pos++] = b;
+}
+
+CByteOutMem::CByteOutMem() throw(): Buf(NULL), Pos(0), Size(0), Overflow(false)
+{
+  vt.Write = ByteOutMem_Write;
+}
+
+void CByteOutMem::Free() throw()
+{
+  ::MidFree(Buf);
+  Buf = NULL;
+  Size = 0;
+}
+
+bool CByteOutMem::Reserve(size_t size) throw()
+{
+  if (size <= Size)
+    return true;
+  Byte *buf = (Byte *)::MidAlloc(size);
+  if (!buf)
+    return false;
+  if (Pos != 0)
+    memcpy(buf, Buf, Pos);
+  ::MidFree(Buf);
+  Buf = buf;
+  Size = size;
+  return true;
+}
+
+
 CEncoder::CEncoder():
-  _inBuf(NULL)
+  _inBuf(NULL),
+  _blockCoders(NULL),
+  _numBlockCoders(0)
+ #ifndef Z7_ST
+  , _mtCoder_WasConstructed(false)
+ #endif
 {
   _props.Normalize(-1);
   Ppmd7_Construct(&_ppmd);
@@ -48,6 +97,11 @@ CEncoder::CEncoder():
 
 CEncoder::~CEncoder()
 {
+ #ifndef Z7_ST
+  if (_mtCoder_WasConstructed)
+    MtCoder_Destruct(&_mtCoder);
+ #endif
+  AllocBlockCoders(0);
   ::MidFree(_inBuf);
   Ppmd7_Free(&_ppmd, &g_BigAlloc);
 }
@@ -62,6 +116,21 @@ Z7_COM7F_IMF(CEncoder::SetCoderProperties(const PROPID *propIDs, const PROPVARIA
     const PROPID propID = propIDs[i];
     if (propID > NCoderPropID::kReduceSize)
       continue;
+    if (propID == NCoderPropID::kBlockSize)
+    {
+      UInt64 v;
+      if (prop.vt == VT_UI8)
+        v = prop.uhVal.QuadPart;
+      else if (prop.vt == VT_UI4)
+        v = prop.ulVal;
+      else
+        return E_INVALIDARG;
+      // (BlockSize == 0) means single stream mode
+      if (v != 0 && (v < ((UInt32)1 << 16) || v > ((UInt32)1 << 31)))
+        return E_INVALIDARG;
+      props.BlockSize = (UInt32)v;
+      continue;
+    }
     if (propID == NCoderPropID::kReduceSize)
     {
       if (prop.vt == VT_UI8 && prop.uhVal.QuadPart < (UInt32)(Int32)-1)
@@ -117,11 +186,16 @@ Z7_COM7F_IMF(CEncoder::SetCoderProperties(const PROPID *propIDs, const PROPVARIA
           return E_INVALIDARG;
         props.Order = (Byte)v;
         break;
-      case NCoderPropID::kNumThreads: break;
+      case NCoderPropID::kNumThreads:
+        props.NumThreads = (v == 0 ? 1 : v);
+        break;
       case NCoderPropID::kLevel: level = (int)v; break;
       default: return E_INVALIDARG;
     }
   }
+  // in block mode each model sees only one block, so we don't need bigger model
+  if (props.BlockSize != 0 && props.ReduceSize > props.BlockSize)
+    props.ReduceSize = props.BlockSize;
   props.Normalize(level);
   _props = props;
   return S_OK;
@@ -129,16 +203,191 @@ Z7_COM7F_IMF(CEncoder::SetCoderProperties(const PROPID *propIDs, const PROPVARIA
 
 Z7_COM7F_IMF(CEncoder::WriteCoderProperties(ISequentialOutStream *outStream))
 {
-  const UInt32 kPropSize = 5;
-  Byte props[kPropSize];
+  Byte props[9];
   props[0] = (Byte)_props.Order;
   SetUi32(props + 1, _props.MemSize)
-  return WriteStream(outStream, props, kPropSize);
+  SetUi32(props + 5, _props.BlockSize)
+  // old decoders don't support block mode, so we write 5 bytes for single stream mode
+  return WriteStream(outStream, props, _props.BlockSize != 0 ? 9 : 5);
 }
 
+
+void CEncoder::AllocBlockCoders(unsigned num)
+{
+  if (_numBlockCoders == num)
+    return;
+  if (_blockCoders)
+  {
+    for (unsigned i = 0; i < _numBlockCoders; i++)
+      Ppmd7_Free(&_blockCoders[i], &g_BigAlloc);
+    delete []_blockCoders;
+    _blockCoders = NULL;
+    _numBlockCoders = 0;
+  }
+  if (num == 0)
+    return;
+  _blockCoders = new CPpmd7[num];
+  for (unsigned i = 0; i < num; i++)
+    Ppmd7_Construct(&_blockCoders[i]);
+  _numBlockCoders = num;
+}
+
+
+SRes CEncoder::EncodeBlock(unsigned coderIndex, unsigned outBufIndex,
+    const Byte *src, size_t srcSize, bool finished, ICompressProgressPtr progress)
+{
+  CByteOutMem &out = _blockOutBufs[outBufIndex];
+  out.Pos = 0;
+  out.Overflow = false;
+  if (!out.Reserve(srcSize + (srcSize >> 6) + kBlockHeaderSize * 2 + 64))
+    return SZ_ERROR_MEM;
+  if (srcSize != 0)
+  {
+    CPpmd7 *ppmd = &_blockCoders[coderIndex];
+    if (!Ppmd7_Alloc(ppmd, _props.MemSize, &g_BigAlloc))
+      return SZ_ERROR_MEM;
+    out.Pos = kBlockHeaderSize;
+    ppmd->rc.enc.Stream = &out.vt;
+    Ppmd7z_Init_RangeEnc(ppmd);
+    Ppmd7_Init(ppmd, (unsigned)_props.Order);
+    Ppmd7z_EncodeSymbols(ppmd, src, src + srcSize);
+    Ppmd7z_Flush_RangeEnc(ppmd);
+    if (out.Overflow)
+      return SZ_ERROR_MEM;
+    const size_t packSize = out.Pos - kBlockHeaderSize;
+    if (packSize > (UInt32)0xFFFFFFFF)
+      return SZ_ERROR_FAIL;
+    SetUi32(out.Buf, (UInt32)packSize)
+    SetUi32(out.Buf + 4, (UInt32)srcSize)
+  }
+  if (finished)
+  {
+    if (!out.Reserve(out.Pos + kBlockHeaderSize))
+      return SZ_ERROR_MEM;
+    memset(out.Buf + out.Pos, 0, kBlockHeaderSize);
+    out.Pos += kBlockHeaderSize;
+  }
+  if (progress)
+    return ICompressProgress_Progress(progress, srcSize, out.Pos);
+  return SZ_OK;
+}
+
+
+HRESULT CEncoder::CodeBlocks_ST(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    ICompressProgressInfo *progress)
+{
+  _blockInBuf.Alloc(_props.BlockSize);
+  if (!_blockInBuf.IsAllocated())
+    return E_OUTOFMEMORY;
+  UInt64 inProcessed = 0;
+  UInt64 outProcessed = 0;
+  for (;;)
+  {
+    size_t size = _props.BlockSize;
+    RINOK(ReadStream(inStream, _blockInBuf, &size))
+    const bool finished = (size != _props.BlockSize);
+    RINOK(SResToHRESULT(EncodeBlock(0, 0, _blockInBuf, size, finished, NULL)))
+    const CByteOutMem &out = _blockOutBufs[0];
+    RINOK(WriteStream(outStream, out.Buf, out.Pos))
+    inProcessed += size;
+    outProcessed += out.Pos;
+    if (progress)
+    {
+      RINOK(progress->SetRatioInfo(&inProcessed, &outProcessed))
+    }
+    if (finished)
+      return S_OK;
+  }
+}
+
+
+#ifndef Z7_ST
+
+static SRes PpmdEnc_MtCallback_Code(void *p, unsigned coderIndex, unsigned outBufIndex,
+    const Byte *src, size_t srcSize, int finished)
+{
+  CEncoder *me = (CEncoder *)p;
+  CMtProgressThunk progressThunk;
+  MtProgressThunk_CreateVTable(&progressThunk);
+  progressThunk.mtProgress = &me->_mtCoder.mtProgress;
+  MtProgressThunk_INIT(&progressThunk)
+  return me->EncodeBlock(coderIndex, outBufIndex, src, srcSize, finished != 0, &progressThunk.vt);
+}
+
+static SRes PpmdEnc_MtCallback_Write(void *p, unsigned outBufIndex)
+{
+  return ((CEncoder *)p)->WriteBlock(outBufIndex);
+}
+
+SRes CEncoder::WriteBlock(unsigned outBufIndex)
+{
+  const CByteOutMem &out = _blockOutBufs[outBufIndex];
+  return HRESULT_To_SRes(WriteStream(_mtOutStream, out.Buf, out.Pos), SZ_ERROR_WRITE);
+}
+
+
+HRESULT CEncoder::CodeBlocks_MT(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    ICompressProgressInfo *progress)
+{
+  if (!_mtCoder_WasConstructed)
+  {
+    _mtCoder_WasConstructed = true;
+    MtCoder_Construct(&_mtCoder);
+  }
+
+  IMtCoderCallback2 vt;
+  vt.Code = PpmdEnc_MtCallback_Code;
+  vt.Write = PpmdEnc_MtCallback_Write;
+
+  CSeqInStreamWrap inWrap;
+  CCompressProgressWrap progressWrap;
+  inWrap.Init(inStream);
+  progressWrap.Init(progress);
+  _mtOutStream = outStream;
+
+  _mtCoder.allocBig = &g_BigAlloc;
+  _mtCoder.progress = progress ? &progressWrap.vt : NULL;
+  _mtCoder.inStream = &inWrap.vt;
+  _mtCoder.inData = NULL;
+  _mtCoder.inDataSize = 0;
+  _mtCoder.mtCallback = &vt;
+  _mtCoder.mtCallbackObject = this;
+  _mtCoder.blockSize = _props.BlockSize;
+  _mtCoder.numThreadsMax = _numBlockCoders;
+  _mtCoder.numThreadGroups = 0;
+  _mtCoder.expectedDataSize = _props.ReduceSize == (UInt32)(Int32)-1 ?
+      (UInt64)(Int64)-1 : _props.ReduceSize;
+
+  const SRes res = MtCoder_Code(&_mtCoder);
+  _mtOutStream = NULL;
+  if (inWrap.Res != S_OK)
+    return inWrap.Res;
+  if (progressWrap.Res != S_OK)
+    return progressWrap.Res;
+  return SResToHRESULT(res);
+}
+
+#endif
+
 Z7_COM7F_IMF(CEncoder::Code(ISequentialInStream *inStream, ISequentialOutStream *outStream,
     const UInt64 * /* inSize */, const UInt64 * /* outSize */, ICompressProgressInfo *progress))
 {
+  if (_props.BlockSize != 0)
+  {
+    unsigned numThreads = 1;
+   #ifndef Z7_ST
+    numThreads = _props.NumThreads;
+    if (numThreads > MTCODER_THREADS_MAX)
+      numThreads = MTCODER_THREADS_MAX;
+   #endif
+    AllocBlockCoders(numThreads);
+   #ifndef Z7_ST
+    if (numThreads > 1)
+      return CodeBlocks_MT(inStream, outStream, progress);
+   #endif
+    return CodeBlocks_ST(inStream, outStream, progress);
+  }
+
   if (!_inBuf)
   {
     _inBuf = (Byte *)::MidAlloc(kBufSize);
@@ -3,8 +3,10 @@
 #ifndef ZIP7_INC_COMPRESS_PPMD_ENCODER_H
 #define ZIP7_INC_COMPRESS_PPMD_ENCODER_H
 
+#include "../../../C/MtCoder.h"
 #include "../../../C/Ppmd7.h"
 
+#include "../../Common/MyBuffer2.h"
 #include "../../Common/MyCom.h"
 
 #include "../ICoder.h"
@@ -14,16 +16,45 @@
 namespace NCompress {
 namespace NPpmd {
 
+/*
+  Block mode of PPMd encoder (BlockSize != 0):
+    props: Order (1 byte), MemSize (4 bytes), BlockSize (4 bytes)
+    stream: sequence of blocks:
+      PackSize (4 bytes), UnpackSize (4 bytes), PPMd7z range coded data of UnpackSize symbols
+    the stream is terminated by block header with (PackSize == 0) and (UnpackSize == 0).
+  Each block uses new PPMd model, so the blocks can be encoded by different threads.
+*/
+
+const unsigned kBlockHeaderSize = 8;
+
+struct CByteOutMem
+{
+  IByteOut vt;
+  Byte *Buf;
+  size_t Pos;
+  size_t Size;
+  bool Overflow;
+
+  CByteOutMem() throw();
+  ~CByteOutMem() { Free(); }
+  void Free() throw();
+  bool Reserve(size_t size) throw();
+};
+
 struct CEncProps
 {
   UInt32 MemSize;
   UInt32 ReduceSize;
+  UInt32 BlockSize; // (BlockSize != 0) : stream of independent blocks
+  UInt32 NumThreads;
   int Order;
   
   CEncProps()
   {
     MemSize = (UInt32)(Int32)-1;
     ReduceSize = (UInt32)(Int32)-1;
+    BlockSize = 0;
+    NumThreads = 1;
     Order = -1;
   }
   void Normalize(int level);
@@ -39,7 +70,30 @@ Z7_CLASS_IMP_COM_3(
   CByteOutBufWrap _outStream;
   CPpmd7 _ppmd;
   CEncProps _props;
+
+  CPpmd7 *_blockCoders;
+  unsigned _numBlockCoders;
+  CMidBuffer _blockInBuf;
+  CByteOutMem _blockOutBufs[MTCODER_BLOCKS_MAX];
+
+  void AllocBlockCoders(unsigned num);
+  HRESULT CodeBlocks_ST(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+      ICompressProgressInfo *progress);
+ #ifndef Z7_ST
+  bool _mtCoder_WasConstructed;
+  ISequentialOutStream *_mtOutStream;
+  HRESULT CodeBlocks_MT(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+      ICompressProgressInfo *progress);
+ #endif
 public:
+ #ifndef Z7_ST
+  CMtCoder _mtCoder;
+ #endif
+
+  SRes EncodeBlock(unsigned coderIndex, unsigned outBufIndex,
+      const Byte *src, size_t srcSize, bool finished, ICompressProgressPtr progress);
+  SRes WriteBlock(unsigned outBufIndex);
+
   CEncoder();
   ~CEncoder();
 };
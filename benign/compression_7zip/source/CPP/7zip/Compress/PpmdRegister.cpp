@@ -13,10 +13,26 @@
 namespace NCompress {
 namespace NPpmd {
 
-REGISTER_CODEC_E(PPMD,
-    CDecoder(),
-    CEncoder(),
-    0x30401,
-    "PPMD")
+REGISTER_CODEC_CREATE(CreateDec, CDecoder())
+REGISTER_CODEC_CREATE(CreateDec_Block, CDecoder(true))
+
+#ifdef Z7_EXTRACT_ONLY
+  #define PPMD_CODEC_ITEM(dec, id, name) { dec, NULL, id, name, 1, false }
+#else
+  REGISTER_CODEC_CREATE(CreateEnc, CEncoder())
+  #define PPMD_CODEC_ITEM(dec, id, name) { dec, CreateEnc, id, name, 1, false }
+#endif
+
+/* block mode stream (9 bytes of props) uses separate method ID from private range,
+   because old decoders of 0x30401 don't check the size of props.
+   The decoder for 0x30401 doesn't accept block mode. */
+
+REGISTER_CODECS_VAR
+{
+  PPMD_CODEC_ITEM(CreateDec, 0x30401, "PPMD"),
+  PPMD_CODEC_ITEM(CreateDec_Block, 0x3F3A256ED3C00001, "PPMD-B")
+};
+
+REGISTER_CODECS(PPMD)
 
 }}
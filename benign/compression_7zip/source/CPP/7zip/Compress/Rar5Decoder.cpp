@@ -683,6 +683,10 @@ static const size_t kWriteStep = (size_t)1 << 18;
 // static const unsigned kWinSize_Log_Min = 17;
 static const size_t kWinSize_Min = 1u << 18;
 
+#ifndef Z7_ST
+static const UInt64 k_Mt_UnpackSize_Min = 1 << 20;
+#endif
+
 CDecoder::CDecoder():
     _isSolid(false),
     _is_v7(false),
@@ -699,6 +703,12 @@ CDecoder::CDecoder():
     _filters(NULL),
     _winSize_Allocated(0),
     _inputBuf(NULL)
+   #ifndef Z7_ST
+    , _mtMode(false)
+    , _mtStop(false)
+    , _mtExit(false)
+    , _mtBuf(NULL)
+   #endif
 {
 #if 1
   memcpy(m_LenPlusTable, k_LenPlusTable, sizeof(k_LenPlusTable));
@@ -722,6 +732,19 @@ CDecoder::~CDecoder()
   printf("\n");
 #endif
 
+#ifndef Z7_ST
+  if (_mtThread.IsCreated())
+  {
+    {
+      NWindows::NSynchronization::CCriticalSectionLock lock(_mtCS);
+      _mtExit = true;
+    }
+    _mtStartEvent.Set();
+    _mtThread.Wait_Close();
+  }
+  z7_AlignedFree(_mtBuf);
+#endif
+
 #define Z7_RAR_FREE_WINDOW ::BigFree(_window);
   
   Z7_RAR_FREE_WINDOW
@@ -1013,30 +1036,21 @@ static UInt32 ReadUInt32(CBitDecoder &bi)
 
 static const unsigned MAX_UNPACK_FILTERS = 8192;
 
-HRESULT CDecoder::AddFilter(CBitDecoder &_bitStream)
-{
-  DeleteUnusedFilters();
-
-  if (_numFilters >= MAX_UNPACK_FILTERS)
-  {
-    RINOK(WriteBuf())
-    DeleteUnusedFilters();
-    if (_numFilters >= MAX_UNPACK_FILTERS)
-    {
-      _unsupportedFilter = true;
-      InitFilters();
-    }
-  }
+/* ReadFilter() reads filter record from stream.
+   (f.Start) is set relative to current position in output stream.
+   it returns false, if filter is not supported. */
 
+bool CDecoder::ReadFilter(CBitDecoder &_bitStream, CFilter &f)
+{
+  bool isSupported = true;
   _bitStream.Prepare();
 
-  CFilter f;
-  const UInt32 blockStart = ReadUInt32(_bitStream);
+  f.Start = ReadUInt32(_bitStream);
   f.Size = ReadUInt32(_bitStream);
 
   if (f.Size > k_Filter_BlockSize_MAX)
   {
-    _unsupportedFilter = true;
+    isSupported = false;
     f.Size = 0;  // unrar 5.5.5
   }
 
@@ -1044,14 +1058,33 @@ HRESULT CDecoder::AddFilter(CBitDecoder &_bitStream)
   f.Channels = 0;
   if (f.Type == FILTER_DELTA)
     f.Channels = (Byte)(_bitStream.ReadBits_9fix(5) + 1);
-  f.Start = _lzSize + _winPos + blockStart;
 
 #if 0
   static unsigned z_cnt = 0; if (z_cnt++ % 100 == 0)
     printf ("\nFilter %7u : %4u : %8p, st=%8x, size=%8x, type=%u ch=%2u",
       z_cnt, (unsigned)_filters.Size(), (void *)(size_t)(_lzSize + _winPos),
-      (unsigned)blockStart, (unsigned)f.Size, (unsigned)f.Type, (unsigned)f.Channels);
+      (unsigned)f.Start, (unsigned)f.Size, (unsigned)f.Type, (unsigned)f.Channels);
 #endif
+  return isSupported;
+}
+
+
+// (f.Start) is absolute position in lz stream here
+
+HRESULT CDecoder::AddFilter2(const CFilter &f)
+{
+  DeleteUnusedFilters();
+
+  if (_numFilters >= MAX_UNPACK_FILTERS)
+  {
+    RINOK(WriteBuf())
+    DeleteUnusedFilters();
+    if (_numFilters >= MAX_UNPACK_FILTERS)
+    {
+      _unsupportedFilter = true;
+      InitFilters();
+    }
+  }
 
   if (f.Start < _filterEnd)
     _unsupportedFilter = true;
@@ -1076,6 +1109,16 @@ HRESULT CDecoder::AddFilter(CBitDecoder &_bitStream)
 }
 
 
+HRESULT CDecoder::AddFilter(CBitDecoder &_bitStream)
+{
+  CFilter f;
+  if (!ReadFilter(_bitStream, f))
+    _unsupportedFilter = true;
+  f.Start += _lzSize + _winPos;
+  return AddFilter2(f);
+}
+
+
 #define RIF(x) { if (!(x)) return S_FALSE; }
 
 #if 1
@@ -1085,11 +1128,10 @@ HRESULT CDecoder::AddFilter(CBitDecoder &_bitStream)
   { static unsigned g_cnt = 0; if (g_cnt++ % skip == 0) printf("\n%16s:  %8u", name, g_cnt); }
 #endif
 
-HRESULT CDecoder::ReadTables(CBitDecoder &_bitStream)
+HRESULT CDecoder::UpdateProgress(UInt64 packSize)
 {
   if (_progress)
   {
-    const UInt64 packSize = _bitStream.GetProcessedSize();
     if (packSize - _progress_Pack >= (1u << 24)
         || _writtenFileSize - _progress_Unpack >= (1u << 26))
     {
@@ -1099,7 +1141,12 @@ HRESULT CDecoder::ReadTables(CBitDecoder &_bitStream)
     }
     // printf("\ntable read pos=%p packSize=%p _writtenFileSize = %p\n", (size_t)_winPos, (size_t)packSize, (size_t)_writtenFileSize);
   }
+  return S_OK;
+}
+
 
+HRESULT CDecoder::ReadTables(CBitDecoder &_bitStream)
+{
   // _bitStream is aligned already
   _bitStream.Prepare();
   {
@@ -1761,6 +1808,7 @@ HRESULT CDecoder::DecodeLZ()
               return _bitStream._hres;
               // break;
             }
+            RINOK(UpdateProgress(_bitStream.GetProcessedSize()))
             RINOK(ReadTables(_bitStream))
             continue;
           }
@@ -1797,6 +1845,503 @@ HRESULT CDecoder::DecodeLZ()
 }
 
 
+#ifndef Z7_ST
+
+/*
+  ParseLZ2() is the version of DecodeLZ2() for parse thread.
+  It writes commands and literals to (block) instead of window.
+  It stops decoding, if (block) is full.
+*/
+HRESULT CDecoder::ParseLZ2(CBitDecoder &bitStream, CMtBlock &block) throw()
+{
+  CBitDecoder _bitStream;
+  _bitStream.CopyFrom(bitStream);
+
+  size_t rep0 = _reps[0];
+  UInt32 *cmds = block.Cmds + block.NumCmds;
+  const UInt32 *cmdsLim = block.Cmds + k_MtBlock_NumCmds - 8;
+  Byte *lits = block.Lits + block.NumLits;
+  const Byte *litsLim = block.Lits + k_MtBlock_NumLits;
+  const Byte *litsStart = lits;
+  UInt64 lzPos = _mtLzPos;
+  HRESULT res = S_OK;
+  _exitType = Z7_RAR_EXIT_TYPE_NONE;
+
+  for (;;)
+  {
+    if (cmds >= cmdsLim || lits >= litsLim)
+      LZ_LOOP_BREAK_OK
+    if (_bitStream._buf >= _bitStream._bufCheck_Block)
+    {
+      if (_bitStream.InputEofError())
+        LZ_LOOP_BREAK_OK
+      if (_bitStream._buf >= _bitStream._bufCheck)
+      {
+        if (!_bitStream._wasFinished)
+          LZ_LOOP_BREAK_OK
+      }
+      const UInt64 processed = _bitStream.GetProcessedSize_Round();
+      if (processed >= _bitStream._blockEnd &&
+          (processed > _bitStream._blockEnd
+            || _bitStream.GetProcessedBits7() >= _bitStream._blockEndBits7))
+          LZ_LOOP_BREAK_OK
+      if (!_tableWasFilled)
+        LZ_LOOP_BREAK_ERROR
+    }
+
+    unsigned sym;
+    Z7_RAR_HUFF_DECODE_CHECK_break(sym, &m_MainDecoder, k_NumHufTableBits_Main, &_bitStream)
+
+    if (sym < 256)
+    {
+      *lits++ = (Byte)sym;
+      continue;
+    }
+
+    CLenType len;
+
+    if (sym < kSymbolRep + kNumReps)
+    {
+      if (sym >= kSymbolRep)
+      {
+        if (sym != kSymbolRep)
+        {
+          size_t dist = _reps[1];
+          _reps[1] = rep0;
+          rep0 = dist;
+          if (sym >= kSymbolRep + 2)
+          {
+            rep0 = _reps[(size_t)sym - kSymbolRep];
+            _reps[(size_t)sym - kSymbolRep] = _reps[2];
+            _reps[2] = dist;
+          }
+        }
+        Z7_RAR_HUFF_DECODE_CHECK_break(len, &m_LenDecoder, k_NumHufTableBits_Len, &_bitStream)
+        if (len >= 8)
+          len = SlotToLen(_bitStream, len);
+        len += 2;
+      }
+      else if (sym != 256)
+      {
+        len = (CLenType)_lastLen;
+        if (len == 0)
+          continue;
+      }
+      else
+      {
+        _exitType = Z7_RAR_EXIT_TYPE_ADD_FILTER;
+        LZ_LOOP_BREAK_OK
+      }
+    }
+    else
+    {
+      _reps[3] = _reps[2];
+      _reps[2] = _reps[1];
+      _reps[1] = rep0;
+      len = sym - (kSymbolRep + kNumReps);
+      if (len >= 8)
+        len = SlotToLen(_bitStream, len);
+      len += 2;
+
+      Z7_RAR_HUFF_DECODE_CHECK_break(rep0, &m_DistDecoder, k_NumHufTableBits_Dist, &_bitStream)
+
+      if (rep0 >= 4)
+      {
+        const unsigned numBits = ((unsigned)rep0 - 2) >> 1;
+        rep0 = (2 | (rep0 & 1)) << numBits;
+
+        const Byte *buf = _bitStream._buf;
+#ifdef Z7_RAR5_USE_64BIT
+        const UInt64 v = GetBe64(buf);
+#else
+        const UInt32 v = GetBe32(buf);
+#endif
+        if (numBits < kNumAlignBits)
+          rep0 += _bitStream.ReadBits_Big25(numBits, v);
+        else
+        {
+          len += k_LenPlusTable[numBits];
+          if (_useAlignBits)
+          {
+            rep0 += (_bitStream.ReadBits_Big25(numBits - kNumAlignBits, v) << kNumAlignBits);
+            unsigned a;
+            Z7_RAR_HUFF_DECODE_CHECK_break(a, &m_AlignDecoder, k_NumHufTableBits_Align, &_bitStream)
+            rep0 += a;
+          }
+          else
+            rep0 += _bitStream.ReadBits_Big(numBits, v);
+#ifndef Z7_RAR5_USE_64BIT
+          if (numBits >= 30) // we don't want 32-bit overflow case
+            rep0 = (size_t)0 - 1 - 1;
+#endif
+        }
+      }
+      rep0++;
+    }
+
+    _lastLen = (UInt32)len;
+    if (lits != litsStart)
+    {
+      *cmds++ = (UInt32)(lits - litsStart) << 2;
+      lzPos += (size_t)(lits - litsStart);
+      litsStart = lits;
+    }
+    lzPos += len;
+#ifdef Z7_RAR5_USE_64BIT
+    if (rep0 > 0xFFFFFFFF)
+    {
+      cmds[0] = ((UInt32)len << 2) | 3;
+      cmds[1] = (UInt32)rep0;
+      cmds[2] = (UInt32)(rep0 >> 32);
+      cmds += 3;
+      continue;
+    }
+#endif
+    cmds[0] = ((UInt32)len << 2) | 1;
+    cmds[1] = (UInt32)rep0;
+    cmds += 2;
+  }
+
+  goto finish;
+decode_error:
+  res = S_FALSE;
+finish:
+  if (lits != litsStart)
+  {
+    *cmds++ = (UInt32)(lits - litsStart) << 2;
+    lzPos += (size_t)(lits - litsStart);
+  }
+  _mtLzPos = lzPos;
+  _reps[0] = rep0;
+  block.NumCmds = (unsigned)(cmds - block.Cmds);
+  block.NumLits = (unsigned)(lits - block.Lits);
+  bitStream.RestoreFrom2(_bitStream);
+  return res;
+}
+
+
+/*
+  ParseLZ() fills (block) with commands.
+  It returns S_OK and (block.IsFinished == false), if (block) is full.
+  Otherwise it returns the result of stream decoding that is same as DecodeLZ() result.
+*/
+HRESULT CDecoder::ParseLZ(CBitDecoder &_bitStream, CMtBlock &block)
+{
+  block.NumCmds = 0;
+  block.NumLits = 0;
+  block.NumFilters = 0;
+  block.IsFinished = true;
+
+  for (;;)
+  {
+    if (block.IsFull())
+    {
+      block.IsFinished = false;
+      return S_OK;
+    }
+
+    if (_bitStream._buf >= _bitStream._bufCheck_Block)
+    {
+      if (_bitStream.InputEofError())
+        break;
+      _bitStream.Prepare();
+
+      const UInt64 processed = _bitStream.GetProcessedSize_Round();
+      if (processed >= _bitStream._blockEnd)
+      {
+        if (processed > _bitStream._blockEnd)
+          break;
+        {
+          const unsigned bits7 = _bitStream.GetProcessedBits7();
+          if (bits7 >= _bitStream._blockEndBits7)
+          {
+            if (bits7 > _bitStream._blockEndBits7)
+              _bitStream._minorError = true;
+            _bitStream.AlignToByte();
+            if (_isLastBlock)
+            {
+              if (_bitStream.InputEofError())
+                break;
+              if (_bitStream._minorError)
+                return S_FALSE;
+              return _bitStream._hres;
+            }
+            RINOK(ReadTables(_bitStream))
+            continue;
+          }
+        }
+      }
+      if (!_tableWasFilled)
+        break;
+    }
+
+    RINOK(ParseLZ2(_bitStream, block))
+    
+    if (_exitType == Z7_RAR_EXIT_TYPE_ADD_FILTER)
+    {
+      CFilter &f = block.Filters[block.NumFilters];
+      UInt32 cmd = ((UInt32)block.NumFilters << 3) | 2;
+      if (!ReadFilter(_bitStream, f))
+        cmd |= 4;
+      f.Start += _mtLzPos;
+      block.Cmds[block.NumCmds++] = cmd;
+      block.NumFilters++;
+    }
+  }
+
+  if (_bitStream._hres != S_OK)
+    return _bitStream._hres;
+  return S_FALSE;
+}
+
+
+void CDecoder::RunParseThread()
+{
+  for (;;)
+  {
+    if (_mtStartEvent.Lock() != 0 || Mt_IsExit())
+      return;
+
+    CBitDecoder _bitStream;
+    _bitStream._stream = _inStream;
+    _bitStream._bufBase = _inputBuf;
+    _bitStream.Init();
+
+    for (unsigned i = 0;; i = (i + 1) % k_Mt_NumBlocks)
+    {
+      _mtFreeSem.Lock();
+      CMtBlock &block = _mtBlocks[i];
+      if (Mt_IsStop())
+      {
+        block.NumCmds = 0;
+        block.IsFinished = true;
+        block.Res = S_FALSE;
+      }
+      else
+        block.Res = ParseLZ(_bitStream, block);
+      block.PackSize = _bitStream.GetProcessedSize();
+      const bool isFinished = block.IsFinished;
+      _mtFilledSem.Release();
+      if (isFinished)
+        break;
+    }
+  }
+}
+
+
+static THREAD_FUNC_DECL RunParseThread2(void *p)
+{
+  ((CDecoder *)p)->RunParseThread();
+  return 0;
+}
+
+
+HRESULT CDecoder::CreateMt()
+{
+  if (_mtThread.IsCreated())
+    return S_OK;
+  if (!_mtBuf)
+  {
+    const size_t blockSize = k_MtBlock_NumCmds * sizeof(UInt32) + k_MtBlock_NumLits;
+    _mtBuf = (Byte *)z7_AlignedAlloc(blockSize * k_Mt_NumBlocks);
+    if (!_mtBuf)
+      return E_OUTOFMEMORY;
+    for (unsigned i = 0; i < k_Mt_NumBlocks; i++)
+    {
+      CMtBlock &block = _mtBlocks[i];
+      block.Cmds = (UInt32 *)(void *)(_mtBuf + blockSize * i);
+      block.Lits = _mtBuf + blockSize * i + k_MtBlock_NumCmds * sizeof(UInt32);
+    }
+  }
+  WRes             wres = _mtStartEvent.CreateIfNotCreated_Reset();
+  if (wres == 0) { wres = _mtFreeSem.OptCreateInit(k_Mt_NumBlocks, k_Mt_NumBlocks);
+  if (wres == 0) { wres = _mtFilledSem.OptCreateInit(0, k_Mt_NumBlocks);
+  if (wres == 0) { wres = _mtThread.Create(RunParseThread2, this); }}}
+  return HRESULT_FROM_WIN32(wres);
+}
+
+
+/*
+  DecodeBlock_Mt() copies data from (block) to window.
+  It uses same (limit) steps for WriteBuf() calls as DecodeLZ().
+  It returns S_FALSE, if (_unpackSize) was exceeded.
+*/
+HRESULT CDecoder::DecodeBlock_Mt(const CMtBlock &block, size_t &winPos_, size_t &limit_)
+{
+  const UInt32 *cmds = block.Cmds;
+  const UInt32 *cmdsLim = cmds + block.NumCmds;
+  const Byte *lits = block.Lits;
+  size_t numLits = 0;
+  size_t winPos = winPos_;
+  size_t limit = limit_;
+  Byte *win = _window;
+
+  for (;;)
+  {
+    if (winPos >= limit)
+    {
+      _winPos = winPos < _winSize ? winPos : _winSize;
+      RINOK(WriteBuf())
+      if (_unpackSize_Defined && _writtenFileSize > _unpackSize)
+      {
+        _winPos = winPos;
+        return S_FALSE;
+      }
+      const size_t wp = _winPos;
+      size_t rem = _winSize - wp;
+      if (rem == 0)
+      {
+        _lzSize += wp;
+        winPos -= wp;
+        if (winPos)
+          memcpy(win, win + _winSize, winPos);
+        limit = _winSize;
+        if (limit >= kWriteStep)
+        {
+          limit = kWriteStep;
+          continue;
+        }
+        rem = _winSize - winPos;
+      }
+      if (rem > kWriteStep)
+          rem = kWriteStep;
+      limit = winPos + rem;
+      continue;
+    }
+
+    if (numLits != 0)
+    {
+      size_t cur = limit - winPos;
+      if (cur > numLits)
+        cur = numLits;
+      memcpy(win + winPos, lits, cur);
+      lits += cur;
+      winPos += cur;
+      numLits -= cur;
+      continue;
+    }
+
+    if (cmds == cmdsLim)
+      break;
+    const UInt32 cmd = *cmds++;
+    
+    if ((cmd & 3) == 0)
+    {
+      numLits = cmd >> 2;
+      continue;
+    }
+    
+    if ((cmd & 3) == 2)
+    {
+      if (cmd & 4)
+        _unsupportedFilter = true;
+      _winPos = winPos;
+      RINOK(AddFilter2(block.Filters[cmd >> 3]))
+      continue;
+    }
+
+    const size_t len = cmd >> 2;
+    size_t rep0 = cmds[0];
+    cmds++;
+#ifdef Z7_RAR5_USE_64BIT
+    if (cmd & 2)
+      rep0 |= (size_t)*cmds++ << 32;
+#endif
+
+    Byte *dest = win + winPos;
+    winPos += len;
+    if (rep0 <= _dictSize_forCheck)
+    {
+      const Byte *src;
+      const size_t winPos_temp = (size_t)(dest - win);
+      if (rep0 > winPos_temp)
+      {
+        if (_lzSize == 0)
+          goto error_dist;
+        size_t back = rep0 - winPos_temp;
+        src = dest + (_winSize - rep0);
+        if (back < len)
+        {
+          Z7_PRAGMA_OPT_DISABLE_LOOP_UNROLL_VECTORIZE
+          do
+            *dest++ = *src++;
+          while (--back);
+          src = dest - rep0;
+        }
+      }
+      else
+        src = dest - rep0;
+      CopyMatch(rep0, dest, src, win + winPos);
+      continue;
+    }
+
+error_dist:
+    _lzError = LZ_ERROR_TYPE_DIST;
+    do
+      *dest++ = 0;
+    while (dest < win + winPos);
+  }
+
+  winPos_ = winPos;
+  limit_ = limit;
+  return S_OK;
+}
+
+
+HRESULT CDecoder::DecodeLZ_Mt()
+{
+  RINOK(CreateMt())
+
+  size_t winPos = _winPos;
+  size_t limit;
+  {
+    size_t rem = _winSize - winPos;
+    if (rem > kWriteStep)
+        rem = kWriteStep;
+    limit = winPos + rem;
+  }
+
+  Mt_SetStop(false);
+  _mtLzPos = _lzSize + _winPos;
+  {
+    const WRes wres = _mtStartEvent.Set();
+    if (wres != 0)
+      return HRESULT_FROM_WIN32(wres);
+  }
+
+  HRESULT res = S_OK;
+
+  for (unsigned i = 0;; i = (i + 1) % k_Mt_NumBlocks)
+  {
+    _mtFilledSem.Lock();
+    const CMtBlock &block = _mtBlocks[i];
+    if (res == S_OK)
+    {
+      // DecodeBlock_Mt() sets (_winPos) itself, if it returns error
+      res = DecodeBlock_Mt(block, winPos, limit);
+      if (res == S_OK)
+      {
+        _winPos = winPos;
+        if (block.IsFinished)
+          res = block.Res;
+        else
+          res = UpdateProgress(block.PackSize);
+      }
+      // the parse thread will stop at next block
+      if (res != S_OK)
+        Mt_SetStop(true);
+    }
+    const bool isFinished = block.IsFinished;
+    _mtFreeSem.Release();
+    if (isFinished)
+      break;
+  }
+  return res;
+}
+
+#endif
+
+
 
 HRESULT CDecoder::CodeReal()
 {
@@ -1825,7 +2370,16 @@ HRESULT CDecoder::CodeReal()
   _lzFileStart = lzSize;
   _lzWritten = lzSize;
   
+#ifndef Z7_ST
+  HRESULT res;
+  // we don't use parse thread for small files
+  if (_mtMode && (!_unpackSize_Defined || _unpackSize >= k_Mt_UnpackSize_Min))
+    res = DecodeLZ_Mt();
+  else
+    res = DecodeLZ();
+#else
   HRESULT res = DecodeLZ();
+#endif
 
   HRESULT res2 = S_OK;
   if (!_writeError && res != E_OUTOFMEMORY)
@@ -2057,4 +2611,15 @@ Z7_COM7F_IMF(CDecoder::SetDecoderProperties2(const Byte *data, UInt32 size))
   return S_OK;
 }
 
+
+#ifndef Z7_ST
+
+Z7_COM7F_IMF(CDecoder::SetNumberOfThreads(UInt32 numThreads))
+{
+  _mtMode = (numThreads > 1);
+  return S_OK;
+}
+
+#endif
+
 }}
@@ -8,6 +8,11 @@
 #include "../../Common/MyBuffer2.h"
 #include "../../Common/MyCom.h"
 
+#ifndef Z7_ST
+#include "../../Windows/Synchronization.h"
+#include "../../Windows/Thread.h"
+#endif
+
 #include "../ICoder.h"
 
 #include "HuffmanDecoder.h"
@@ -44,11 +49,68 @@ const unsigned k_NumHufTableBits_Align = 6;
 
 const unsigned DICT_SIZE_BITS_MAX = 40;
 
-Z7_CLASS_IMP_NOQIB_2(
-  CDecoder
-  , ICompressCoder
-  , ICompressSetDecoderProperties2
-)
+#ifndef Z7_ST
+
+/*
+  In multithreaded mode the parse thread decodes Huffman symbols to
+  the sequence of commands and literals in CMtBlock,
+  and the caller thread copies matches to window, executes filters and writes data.
+  Command (UInt32) format:
+    (numLits << 2)                  : literals from (Lits)
+    (len << 2) | 1, dist            : match
+    (len << 2) | 3, dist, dist_high : match with (dist > 0xFFFFFFFF)
+    (filterIndex << 3) | 2          : filter from (Filters)
+    (filterIndex << 3) | 6          : unsupported filter from (Filters)
+*/
+
+const unsigned k_Mt_NumBlocks = 4;
+const unsigned k_MtBlock_NumCmds = 1 << 16;
+const unsigned k_MtBlock_NumLits = 1 << 18;
+const unsigned k_MtBlock_NumFilters = 64;
+
+struct CMtBlock
+{
+  UInt32 *Cmds;
+  Byte *Lits;
+  unsigned NumCmds;
+  unsigned NumLits;
+  unsigned NumFilters;
+  bool IsFinished; // the parse thread has finished the stream in this block
+  HRESULT Res;     // the result of stream parsing, if (IsFinished)
+  UInt64 PackSize;
+  CFilter Filters[k_MtBlock_NumFilters];
+
+  bool IsFull() const
+  {
+    return NumCmds >= k_MtBlock_NumCmds - 8
+        || NumLits >= k_MtBlock_NumLits
+        || NumFilters == k_MtBlock_NumFilters;
+  }
+};
+
+#endif
+
+class CDecoder Z7_final:
+  public ICompressCoder,
+  public ICompressSetDecoderProperties2,
+ #ifndef Z7_ST
+  public ICompressSetCoderMt,
+ #endif
+  public CMyUnknownImp
+{
+  Z7_COM_QI_BEGIN2(ICompressSetDecoderProperties2)
+ #ifndef Z7_ST
+  Z7_COM_QI_ENTRY(ICompressSetCoderMt)
+ #endif
+  Z7_COM_QI_END
+  Z7_COM_ADDREF_RELEASE
+
+  Z7_IFACE_COM7_IMP(ICompressCoder)
+  Z7_IFACE_COM7_IMP(ICompressSetDecoderProperties2)
+ #ifndef Z7_ST
+  Z7_IFACE_COM7_IMP(ICompressSetCoderMt)
+ #endif
+
   bool _useAlignBits;
   bool _isLastBlock;
   bool _unpackSize_Defined;
@@ -117,11 +179,53 @@ Z7_CLASS_IMP_NOQIB_2(
   HRESULT WriteData(const Byte *data, size_t size);
   HRESULT ExecuteFilter(const CFilter &f);
   HRESULT WriteBuf();
+  bool ReadFilter(CBitDecoder &_bitStream, CFilter &f);
+  HRESULT AddFilter2(const CFilter &f);
   HRESULT AddFilter(CBitDecoder &_bitStream);
+  HRESULT UpdateProgress(UInt64 packSize);
   HRESULT ReadTables(CBitDecoder &_bitStream);
   HRESULT DecodeLZ2(const CBitDecoder &_bitStream) throw();
   HRESULT DecodeLZ();
   HRESULT CodeReal();
+
+ #ifndef Z7_ST
+  bool _mtMode;
+  // (_mtStop) and (_mtExit) are shared by main thread and parse thread. They are accessed only under (_mtCS).
+  bool _mtStop;
+  bool _mtExit;
+  NWindows::NSynchronization::CCriticalSection _mtCS;
+  UInt64 _mtLzPos; // it's used by parse thread
+  Byte *_mtBuf;
+  NWindows::CThread _mtThread;
+  NWindows::NSynchronization::CAutoResetEvent _mtStartEvent;
+  NWindows::NSynchronization::CSemaphore _mtFreeSem;
+  NWindows::NSynchronization::CSemaphore _mtFilledSem;
+  CMtBlock _mtBlocks[k_Mt_NumBlocks];
+
+  HRESULT ParseLZ2(CBitDecoder &bitStream, CMtBlock &block) throw();
+  HRESULT ParseLZ(CBitDecoder &_bitStream, CMtBlock &block);
+  HRESULT DecodeBlock_Mt(const CMtBlock &block, size_t &winPos, size_t &limit);
+  HRESULT CreateMt();
+  HRESULT DecodeLZ_Mt();
+
+  void Mt_SetStop(bool stop)
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(_mtCS);
+    _mtStop = stop;
+  }
+  bool Mt_IsStop()
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(_mtCS);
+    return _mtStop;
+  }
+  bool Mt_IsExit()
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(_mtCS);
+    return _mtExit;
+  }
+public:
+  void RunParseThread();
+ #endif
 public:
   CDecoder();
   ~CDecoder();
@@ -0,0 +1,211 @@
+// XpressEncoder.cpp
+
+#include "StdAfx.h"
+
+#include <string.h>
+
+#include "../../../C/Alloc.h"
+#include "../../../C/CpuArch.h"
+#include "../../../C/HuffEnc.h"
+
+#include "XpressEncoder.h"
+
+namespace NCompress {
+namespace NXpress {
+
+static const unsigned kNumHuffBits = 15;
+static const unsigned kNumLenBits = 4;
+static const unsigned kLenMask = (1 << kNumLenBits) - 1;
+static const unsigned kNumPosSlots = 16;
+static const unsigned kNumSyms = 256 + (kNumPosSlots << kNumLenBits);
+static const unsigned kEndSym = 256;
+
+static const UInt32 kHistorySize = ((UInt32)1 << 16) - 1;
+// we don't look for better match at next position, if match is long enough
+static const unsigned kLazyLenMax = 32;
+
+// the maximum number of bytes that can be written for one item
+static const unsigned kItemSizeMax = 8;
+
+static unsigned GetNumDistBits(UInt32 dist)
+{
+  unsigned i;
+  for (i = 0; dist > 1; i++)
+    dist >>= 1;
+  return i;
+}
+
+CEncoder::CEncoder():
+    _mfCreated(false)
+{
+  MatchFinder_Construct(&_mf);
+}
+
+CEncoder::~CEncoder()
+{
+  MatchFinder_Free(&_mf, &g_AlignedAlloc);
+}
+
+unsigned CEncoder::GetLongestMatch(UInt32 &dist)
+{
+  const size_t num = (size_t)(Bt3Zip_MatchFinder_GetMatches(&_mf, _distances) - _distances);
+  if (num == 0)
+    return 0;
+  dist = _distances[num - 1] + 1;
+  return (unsigned)_distances[num - 2];
+}
+
+/* items: literal is (byte), and match is ((len << 16) | dist) */
+
+#define ADD_LITERAL(b) \
+  { _items.AddInReserved(b);  _freqs[b]++; }
+
+void CEncoder::Parse(const Byte *data, UInt32 size)
+{
+  UInt32 pos = 0;
+  UInt32 dist = 0;
+  unsigned len = GetLongestMatch(dist);
+
+  for (;;)
+  {
+    if (len < kMatchMinLen)
+    {
+      ADD_LITERAL(data[pos])
+      if (++pos == size)
+        return;
+      len = GetLongestMatch(dist);
+      continue;
+    }
+
+    UInt32 numSkip = len - 1;
+    if (len < kLazyLenMax)
+    {
+      // (pos + 1 < size) here, because (len >= kMatchMinLen)
+      UInt32 dist2 = 0;
+      const unsigned len2 = GetLongestMatch(dist2);
+      if (len2 > len)
+      {
+        ADD_LITERAL(data[pos])
+        pos++;
+        len = len2;
+        dist = dist2;
+        continue;
+      }
+      numSkip--;
+    }
+
+    {
+      const unsigned lenSlot = len - kMatchMinLen;
+      _items.AddInReserved(((UInt32)len << 16) | dist);
+      _freqs[256 + (GetNumDistBits(dist) << kNumLenBits)
+          + (lenSlot < kLenMask ? lenSlot : kLenMask)]++;
+    }
+    Bt3Zip_MatchFinder_Skip(&_mf, numSkip);
+    pos += len;
+    if (pos == size)
+      return;
+    len = GetLongestMatch(dist);
+  }
+}
+
+
+/* The bit stream consists of 16-bit little-endian words.
+   Additional bytes of match length are written to the position
+   that follows the words that the decoder has already loaded:
+   so we reserve two words (nextBits, nextBits2) before (nextByte). */
+
+#define WRITE_BITS(val, numBits) \
+{ \
+  bitBuf = (bitBuf << (numBits)) | (val); \
+  bitCount += (numBits); \
+  if (bitCount > 16) \
+  { \
+    bitCount -= 16; \
+    SetUi16(nextBits, (UInt16)(bitBuf >> bitCount)) \
+    nextBits = nextBits2; \
+    nextBits2 = nextByte; \
+    nextByte += 2; \
+  } \
+}
+
+HRESULT CEncoder::Encode(const Byte *in, size_t inSize, Byte *out, size_t outSize, size_t &packSize)
+{
+  packSize = 0;
+  if (inSize == 0 || inSize > ((UInt32)1 << 16)
+      || outSize < kNumSyms / 2 + 4 + kItemSizeMax)
+    return S_OK;
+
+  MatchFinder_SET_DIRECT_INPUT_BUF(&_mf, in, inSize)
+  if (!_mfCreated)
+  {
+    _mf.btMode = 1;
+    _mf.numHashBytes = 3;
+    _mf.numHashBytes_Min = 3;
+    if (!MatchFinder_Create(&_mf, kHistorySize, 0, kMatchMaxLen, 0, &g_AlignedAlloc))
+      return E_OUTOFMEMORY;
+    _mfCreated = true;
+  }
+  MatchFinder_Init(&_mf);
+
+  _items.ClearAndReserve((unsigned)inSize);
+  memset(_freqs, 0, sizeof(_freqs));
+  Parse(in, (UInt32)inSize);
+  _freqs[kEndSym]++;
+
+  Huffman_Generate(_freqs, _codes, _lens, kNumSyms, kNumHuffBits);
+
+  {
+    for (unsigned i = 0; i < kNumSyms / 2; i++)
+      out[i] = (Byte)(_lens[(size_t)i * 2] | (_lens[(size_t)i * 2 + 1] << 4));
+  }
+
+  Byte *nextBits = out + kNumSyms / 2;
+  Byte *nextBits2 = nextBits + 2;
+  Byte *nextByte = nextBits + 4;
+  const Byte *lim = out + outSize - kItemSizeMax;
+  UInt32 bitBuf = 0;
+  unsigned bitCount = 0;
+
+  const UInt32 *items = _items.ConstData();
+  const UInt32 *itemsLim = items + _items.Size();
+
+  for (; items != itemsLim; items++)
+  {
+    if (nextByte > lim)
+      return S_OK;
+    const UInt32 v = *items;
+    if (v < 256)
+    {
+      WRITE_BITS(_codes[v], _lens[v])
+      continue;
+    }
+    const UInt32 dist = v & 0xffff;
+    UInt32 len = (v >> 16) - kMatchMinLen;
+    const unsigned distBits = GetNumDistBits(dist);
+    {
+      const unsigned sym = 256 + (distBits << kNumLenBits) + (len < kLenMask ? (unsigned)len : kLenMask);
+      WRITE_BITS(_codes[sym], _lens[sym])
+    }
+    if (len >= kLenMask)
+    {
+      if (len - kLenMask < 0xff)
+        *nextByte++ = (Byte)(len - kLenMask);
+      else
+      {
+        nextByte[0] = 0xff;
+        SetUi16(nextByte + 1, (UInt16)len)
+        nextByte += 3;
+      }
+    }
+    if (distBits != 0)
+      WRITE_BITS(dist - ((UInt32)1 << distBits), distBits)
+  }
+
+  WRITE_BITS(_codes[kEndSym], _lens[kEndSym])
+  SetUi16(nextBits, (UInt16)(bitBuf << (16 - bitCount)))
+  SetUi16(nextBits2, 0)
+  packSize = (size_t)(nextByte - out);
+  return S_OK;
+}
+
+}}
@@ -0,0 +1,44 @@
+// XpressEncoder.h
+
+#ifndef ZIP7_INC_XPRESS_ENCODER_H
+#define ZIP7_INC_XPRESS_ENCODER_H
+
+#include "../../../C/LzFind.h"
+
+#include "../../Common/MyVector.h"
+
+namespace NCompress {
+namespace NXpress {
+
+const unsigned kMatchMinLen = 3;
+// the format allows longer matches, but the encoder doesn't use them
+const unsigned kMatchMaxLen = 258;
+
+/* CEncoder compresses one block of data (WIM chunk) to XPRESS Huffman format
+   that is supported by Decode_WithExceedWrite().
+   Each block is compressed independently (without history). */
+
+class CEncoder
+{
+  CMatchFinder _mf;
+  bool _mfCreated;
+  CRecordVector<UInt32> _items;
+  UInt32 _freqs[512];
+  UInt32 _codes[512];
+  Byte _lens[512];
+  UInt32 _distances[kMatchMaxLen * 2 + 3];
+
+  unsigned GetLongestMatch(UInt32 &dist);
+  void Parse(const Byte *data, UInt32 size);
+public:
+  CEncoder();
+  ~CEncoder();
+
+  /* (in) size must be <= (1 << 16).
+     (packSize == 0) is returned, if packed data is not smaller than (outSize) */
+  HRESULT Encode(const Byte *in, size_t inSize, Byte *out, size_t outSize, size_t &packSize);
+};
+
+}}
+
+#endif
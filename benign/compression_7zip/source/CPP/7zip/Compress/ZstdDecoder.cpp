@@ -6,6 +6,13 @@
 
 #include "../../../C/Alloc.h"
 
+#include "../../Common/MyBuffer.h"
+#include "../../Common/MyVector.h"
+
+#ifndef Z7_ST
+#include "../../Windows/Synchronization.h"
+#endif
+
 #include "../Common/CWrappers.h"
 #include "../Common/StreamUtils.h"
 
@@ -22,9 +29,89 @@ static const size_t k_Zstd_BlockSizeMax = 1 << 17;
     - Also it can be optimal to flush data after each block decoding.
 */
 
+
+struct CDictCacheItem
+{
+  CByteBuffer Data;
+  CZstdDecDictHandle Dict;
+  unsigned NumRefs;
+
+  CDictCacheItem(): Dict(NULL), NumRefs(0) {}
+  ~CDictCacheItem() { ZstdDecDict_Destroy(Dict); }
+  Z7_CLASS_NO_COPY(CDictCacheItem)
+};
+
+/* CDictCache keeps digested dictionaries for all decoders in the process.
+   Unused dictionaries stay in the cache for next decoders,
+   so each archive of set doesn't build same tables again. */
+
+class CDictCache
+{
+  CObjectVector<CDictCacheItem> _items;
+public:
+  HRESULT Get(const Byte *data, size_t size, CZstdDecDictHandle &dict);
+  void Release(CZstdDecDictHandle dict);
+};
+
+static const unsigned k_DictCache_NumUnusedMax = 8;
+
+HRESULT CDictCache::Get(const Byte *data, size_t size, CZstdDecDictHandle &dict)
+{
+  FOR_VECTOR (i, _items)
+  {
+    CDictCacheItem &item = _items[i];
+    if (item.Data.Size() == size && memcmp(item.Data, data, size) == 0)
+    {
+      item.NumRefs++;
+      dict = item.Dict;
+      if (i != 0)
+        _items.MoveToFront(i);
+      return S_OK;
+    }
+  }
+  CZstdDecDictHandle newDict;
+  const SRes sres = ZstdDecDict_Create(&newDict, data, size, &g_AlignedAlloc);
+  if (sres != SZ_OK)
+    return SResToHRESULT(sres);
+  CDictCacheItem &item = _items.InsertNew(0);
+  item.Dict = newDict;
+  item.NumRefs = 1;
+  item.Data.CopyFrom(data, size);
+  dict = newDict;
+  return S_OK;
+}
+
+void CDictCache::Release(CZstdDecDictHandle dict)
+{
+  unsigned numUnused = 0;
+  for (unsigned i = 0; i < _items.Size();)
+  {
+    CDictCacheItem &item = _items[i];
+    if (item.Dict == dict)
+      item.NumRefs--;
+    if (item.NumRefs == 0 && ++numUnused > k_DictCache_NumUnusedMax)
+    {
+      _items.Delete(i);
+      continue;
+    }
+    i++;
+  }
+}
+
+static CDictCache g_DictCache;
+
+#ifndef Z7_ST
+  static NWindows::NSynchronization::CCriticalSection g_DictCacheCriticalSection;
+  #define MT_LOCK NWindows::NSynchronization::CCriticalSectionLock lock(g_DictCacheCriticalSection);
+#else
+  #define MT_LOCK
+#endif
+
+
 CDecoder::CDecoder():
     _outStepMask(k_Zstd_BlockSizeMax - 1) // must be = (1 << x) - 1
     , _dec(NULL)
+    , _dict(NULL)
     , _inProcessed(0)
     , _inBufSize(1u << 19) // larger value will reduce the number of memcpy() calls in CZstdDec code
     , _inBuf(NULL)
@@ -39,10 +126,34 @@ CDecoder::~CDecoder()
 {
   if (_dec)
     ZstdDec_Destroy(_dec);
+  if (_dict)
+  {
+    MT_LOCK
+    g_DictCache.Release(_dict);
+  }
   MidFree(_inBuf);
 }
 
 
+HRESULT CDecoder::SetDictionary(const Byte *data, size_t size)
+{
+  CZstdDecDictHandle dict = NULL;
+  {
+    MT_LOCK
+    if (size != 0)
+    {
+      RINOK(g_DictCache.Get(data, size, dict))
+    }
+    if (_dict)
+      g_DictCache.Release(_dict);
+  }
+  if (_dec && _dict != dict)
+    ZstdDec_SetDict(_dec, dict);
+  _dict = dict;
+  return S_OK;
+}
+
+
 Z7_COM7F_IMF(CDecoder::SetInBufSize(UInt32 , UInt32 size))
   { _inBufSize = size;  return S_OK; }
 Z7_COM7F_IMF(CDecoder::SetOutBufSize(UInt32 , UInt32 size))
@@ -115,6 +226,8 @@ HRESULT CDecoder::Prepare(const UInt64 *outSize)
     _dec = ZstdDec_Create(&g_AlignedAlloc, &g_BigAlloc);
     if (!_dec)
       return E_OUTOFMEMORY;
+    if (_dict)
+      ZstdDec_SetDict(_dec, _dict);
   }
   if (!_inBuf || _inBufSize != _inBufSize_Allocated)
   {
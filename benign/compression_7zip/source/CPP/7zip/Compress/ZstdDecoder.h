@@ -63,6 +63,7 @@ class CDecoder Z7_final:
 
   UInt32 _outStepMask;
   CZstdDecHandle _dec;
+  CZstdDecDictHandle _dict;
 public:
   UInt64 _inProcessed;
   CZstdDecState _state;
@@ -89,6 +90,11 @@ public:
 
   HRESULT GetFinishResult();
 
+  /* SetDictionary() sets zstd dictionary or raw content dictionary.
+     The digested dictionaries are cached and shared by all decoders in the process.
+     (size == 0) removes the dictionary. */
+  HRESULT SetDictionary(const Byte *data, size_t size);
+
   CDecoder();
   ~CDecoder();
 };
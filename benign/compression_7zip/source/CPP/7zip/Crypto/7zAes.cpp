@@ -244,6 +244,17 @@ CDecoder::CDecoder()
   _aesFilter = new CAesCbcDecoder(kKeySize);
 }
 
+#ifndef Z7_ST
+Z7_COM7F_IMF(CDecoder::SetNumberOfThreads(UInt32 numThreads))
+{
+  Z7_DECL_CMyComPtr_QI_FROM(ICompressSetCoderMt,
+      setCoderMt, _aesFilter)
+  if (setCoderMt)
+    return setCoderMt->SetNumberOfThreads(numThreads);
+  return S_OK;
+}
+#endif
+
 Z7_COM7F_IMF(CDecoder::SetDecoderProperties2(const Byte *data, UInt32 size))
 {
   _key.ClearProps();
@@ -114,13 +114,23 @@ public:
 
 class CDecoder Z7_final:
   public CBaseCoder,
+ #ifndef Z7_ST
+  public ICompressSetCoderMt,
+ #endif
   public ICompressSetDecoderProperties2
 {
-  Z7_COM_UNKNOWN_IMP_3(
-      ICompressFilter,
-      ICryptoSetPassword,
-      ICompressSetDecoderProperties2)
+  Z7_COM_QI_BEGIN2(ICompressFilter)
+  Z7_COM_QI_ENTRY(ICryptoSetPassword)
+  Z7_COM_QI_ENTRY(ICompressSetDecoderProperties2)
+ #ifndef Z7_ST
+  Z7_COM_QI_ENTRY(ICompressSetCoderMt)
+ #endif
+  Z7_COM_QI_END
+  Z7_COM_ADDREF_RELEASE
   Z7_IFACE_COM7_IMP(ICompressSetDecoderProperties2)
+ #ifndef Z7_ST
+  Z7_IFACE_COM7_IMP(ICompressSetCoderMt)
+ #endif
 public:
   CDecoder();
 };
@@ -4,12 +4,97 @@
 
 #include "../../../C/CpuArch.h"
 
+#ifndef Z7_ST
+#include "../../Common/MyVector.h"
+#include "../../Windows/Synchronization.h"
+#include "../../Windows/Thread.h"
+#endif
+
 #include "MyAes.h"
 
 namespace NCrypto {
 
 static struct CAesTabInit { CAesTabInit() { AesGenTables();} } g_AesTabInit;
 
+#ifndef Z7_ST
+
+/* CBC decoding and CTR coding of big buffers are split to parts,
+   and each part is processed in separate thread with its own copy of (iv + keys).
+   The main thread processes the first part.
+   The threads are taken from process-wide pool, and the number of
+   additional threads is reserved from the limit of pool for each call. */
+
+static const size_t k_Mt_NumBlocks_Min = (1 << 17) / AES_BLOCK_SIZE;
+static const unsigned k_Mt_NumThreads_Max = 32;
+
+struct CAesThread
+{
+  NWindows::CPoolThread Thread;
+  NWindows::NSynchronization::CAutoResetEvent StartEvent;
+  NWindows::NSynchronization::CAutoResetEvent FinishedEvent;
+  CAlignedBuffer1 IvAes;
+  AES_CODE_FUNC CodeFunc;
+  Byte *Data;
+  size_t NumBlocks;
+  bool Exit;
+
+  UInt32 *Aes() { return (UInt32 *)(void *)(Byte *)IvAes; }
+
+  void ThreadFunc();
+  WRes Create();
+
+  CAesThread():
+      IvAes(AES_NUM_IVMRK_WORDS * 4),
+      CodeFunc(NULL),
+      Data(NULL),
+      NumBlocks(0),
+      Exit(false)
+      {}
+  ~CAesThread()
+  {
+    if (Thread.IsCreated())
+    {
+      Exit = true;
+      StartEvent.Set();
+      Thread.Wait_Close();
+    }
+    memset((Byte *)IvAes, 0, AES_NUM_IVMRK_WORDS * 4);
+  }
+};
+
+void CAesThread::ThreadFunc()
+{
+  for (;;)
+  {
+    if (StartEvent.Lock() != 0 || Exit)
+      return;
+    CodeFunc(Aes(), Data, NumBlocks);
+    FinishedEvent.Set();
+  }
+}
+
+static THREAD_FUNC_DECL AesThreadFunc(void *p)
+{
+  ((CAesThread *)p)->ThreadFunc();
+  return 0;
+}
+
+WRes CAesThread::Create()
+{
+  WRes             wres = StartEvent.CreateIfNotCreated_Reset();
+  if (wres == 0) { wres = FinishedEvent.CreateIfNotCreated_Reset();
+  if (wres == 0) { wres = Thread.Create(AesThreadFunc, this); }}
+  return wres;
+}
+
+class CAesCoderMt
+{
+public:
+  CObjectVector<CAesThread> Threads;
+};
+
+#endif
+
 CAesCoder::CAesCoder(
       // bool encodeMode,
       unsigned keySize
@@ -20,6 +105,12 @@ CAesCoder::CAesCoder(
   // _ctrMode(ctrMode),
   _keySize(keySize),
   // _ctrPos(0), // _ctrPos =0 will be set in Init()
+  _mtSupported(false),
+  _ctrMode(false),
+ #ifndef Z7_ST
+  _numThreads(1),
+  _mt(NULL),
+ #endif
   _aes(AES_NUM_IVMRK_WORDS * 4 + AES_BLOCK_SIZE * 2)
 {
   // _offset = ((0 - (unsigned)(ptrdiff_t)_aes) & 0xF) / sizeof(UInt32);
@@ -31,6 +122,115 @@ CAesCoder::CAesCoder(
   */
 }
 
+CAesCoder::~CAesCoder()
+{
+ #ifndef Z7_ST
+  delete _mt;
+ #endif
+}
+
+#ifndef Z7_ST
+
+Z7_COM7F_IMF(CAesCoder::SetNumberOfThreads(UInt32 numThreads))
+{
+  if (numThreads > k_Mt_NumThreads_Max)
+    numThreads = k_Mt_NumThreads_Max;
+  _numThreads = numThreads;
+  return S_OK;
+}
+
+bool CAesCoder::Code_Mt(Byte *data, size_t numBlocks)
+{
+  unsigned numThreads = _numThreads;
+  {
+    const size_t numParts = numBlocks / k_Mt_NumBlocks_Min;
+    if (numThreads > numParts)
+      numThreads = (unsigned)numParts;
+  }
+  if (numThreads < 2)
+    return false;
+  const unsigned numReserved = ThreadPool_Reserve(numThreads - 1);
+  numThreads = numReserved + 1;
+
+  if (!_mt)
+    _mt = new CAesCoderMt;
+  CObjectVector<CAesThread> &threads = _mt->Threads;
+  while (threads.Size() < numThreads - 1)
+  {
+    if (threads.AddNew().Create() != 0)
+    {
+      threads.DeleteBack();
+      break;
+    }
+  }
+  if (numThreads > threads.Size() + 1)
+    numThreads = threads.Size() + 1;
+  if (numThreads < 2)
+  {
+    ThreadPool_Release(numReserved);
+    return false;
+  }
+
+  UInt32 *p = Aes();
+  const size_t step = numBlocks / numThreads;
+  const UInt64 ctr = (UInt64)p[0] | ((UInt64)p[1] << 32);
+  
+  // the last encrypted block of data is the next IV for CBC decoding
+  Byte lastBlock[AES_BLOCK_SIZE];
+  memcpy(lastBlock, data + (numBlocks - 1) * AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+
+  unsigned i;
+  for (i = 1; i < numThreads; i++)
+  {
+    CAesThread &t = threads[i - 1];
+    UInt32 *tp = t.Aes();
+    const size_t offset = step * i;
+    memcpy(tp, p, AES_NUM_IVMRK_WORDS * 4);
+    if (_ctrMode)
+    {
+      const UInt64 v = ctr + offset;
+      tp[0] = (UInt32)v;
+      tp[1] = (UInt32)(v >> 32);
+    }
+    else
+      AesCbc_Init(tp, data + (offset - 1) * AES_BLOCK_SIZE);
+    t.CodeFunc = _codeFunc;
+    t.Data = data + offset * AES_BLOCK_SIZE;
+    t.NumBlocks = (i == numThreads - 1 ? numBlocks - offset : step);
+  }
+
+  for (i = 1; i < numThreads; i++)
+    threads[i - 1].StartEvent.Set();
+  
+  _codeFunc(p, data, step);
+  
+  for (i = 1; i < numThreads; i++)
+    threads[i - 1].FinishedEvent.Lock();
+  ThreadPool_Release(numReserved);
+
+  if (_ctrMode)
+  {
+    const UInt64 v = ctr + numBlocks;
+    p[0] = (UInt32)v;
+    p[1] = (UInt32)(v >> 32);
+  }
+  else
+    AesCbc_Init(p, lastBlock);
+  return true;
+}
+
+#endif
+
+void CAesCoder::CodeBlocks(Byte *data, size_t numBlocks)
+{
+ #ifndef Z7_ST
+  if (_numThreads > 1 && _mtSupported)
+    if (Code_Mt(data, numBlocks))
+      return;
+ #endif
+  _codeFunc(Aes(), data, numBlocks);
+}
+
 Z7_COM7F_IMF(CAesCoder::Init())
 {
   _ctrPos = 0;
@@ -50,7 +250,7 @@ Z7_COM7F_IMF2(UInt32, CAesCoder::Filter(Byte *data, UInt32 size))
   }
   size >>= 4;
   // (data) must be aligned for 16-bytes here
-  _codeFunc(Aes(), data, size);
+  CodeBlocks(data, size);
   return size << 4;
 }
 
@@ -143,7 +343,7 @@ Z7_COM7F_IMF2(UInt32, CAesCtrCoder::Filter(Byte *data, UInt32 size))
   
   size >>= 4;
   // (data) must be aligned for 16-bytes here
-  _codeFunc(Aes(), data, size);
+  CodeBlocks(data, size);
   return size << 4;
 }
 
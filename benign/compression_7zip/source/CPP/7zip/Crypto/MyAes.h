@@ -19,12 +19,18 @@ namespace NCrypto {
   virtual bool SetFunctions(UInt32 algo) x
 #endif
 
+#ifndef Z7_ST
+class CAesCoderMt;
+#endif
 
 class CAesCoder:
   public ICompressFilter,
   public ICryptoProperties,
  #ifndef Z7_EXTRACT_ONLY
   public ICompressSetCoderProperties,
+ #endif
+ #ifndef Z7_ST
+  public ICompressSetCoderMt,
  #endif
   public CMyUnknownImp
 {
@@ -32,6 +38,9 @@ class CAesCoder:
   Z7_COM_QI_ENTRY(ICryptoProperties)
  #ifndef Z7_EXTRACT_ONLY
   Z7_COM_QI_ENTRY(ICompressSetCoderProperties)
+ #endif
+ #ifndef Z7_ST
+  Z7_COM_QI_ENTRY(ICompressSetCoderMt)
  #endif
   Z7_COM_QI_END
   Z7_COM_ADDREF_RELEASE
@@ -43,6 +52,10 @@ private:
  #ifndef Z7_EXTRACT_ONLY
   Z7_IFACE_COM7_IMP(ICompressSetCoderProperties)
  #endif
+public:
+ #ifndef Z7_ST
+  Z7_IFACE_COM7_IMP(ICompressSetCoderMt)
+ #endif
 
 protected:
   bool _keyIsSet;
@@ -53,7 +66,16 @@ protected:
   unsigned _ctrPos; // we need _ctrPos here for Init() / SetInitVector()
   AES_CODE_FUNC _codeFunc;
   AES_SET_KEY_FUNC _setKeyFunc;
+  /* (_mtSupported) : blocks can be processed independently (CBC decoding and CTR),
+     so big data can be split to parts that are processed by different threads */
+  bool _mtSupported;
+  bool _ctrMode;
 private:
+ #ifndef Z7_ST
+  UInt32 _numThreads;
+  CAesCoderMt *_mt;
+  bool Code_Mt(Byte *data, size_t numBlocks);
+ #endif
   // UInt32 _aes[AES_NUM_IVMRK_WORDS + 3];
   CAlignedBuffer1 _aes;
 
@@ -62,6 +84,8 @@ private:
   // UInt32 *Aes() { return _aes + _offset; }
 protected:
   UInt32 *Aes() { return (UInt32 *)(void *)(Byte *)_aes; }
+  // (data) must be aligned for 16-bytes
+  void CodeBlocks(Byte *data, size_t numBlocks);
 
  Z7_IFACE_PURE(IAesCoderSetFunctions)
 
@@ -71,7 +95,7 @@ public:
       unsigned keySize
       // , bool ctrMode
       );
-  virtual ~CAesCoder() {}   // we need virtual destructor for derived classes
+  virtual ~CAesCoder();   // we need virtual destructor for derived classes
   void SetKeySize(unsigned size) { _keySize = size; }
 };
 
@@ -94,6 +118,7 @@ struct CAesCbcDecoder: public CAesCoder
   {
     _setKeyFunc = Aes_SetKey_Dec;
     _codeFunc = g_AesCbc_Decode;
+    _mtSupported = true;
   }
   Z7_IFACE_IMP(IAesCoderSetFunctions)
 };
@@ -112,6 +137,8 @@ public:
     _ctrPos = 0;
     _setKeyFunc = Aes_SetKey_Enc;
     _codeFunc = g_AesCtr_Code;
+    _mtSupported = true;
+    _ctrMode = true;
   }
   Z7_IFACE_IMP(IAesCoderSetFunctions)
 };
@@ -183,7 +183,23 @@ void CDecoder::Hmac_Convert_32Bytes(Byte *data) const
 }
 
 
-static CKey g_Key;
+/* RAR5 archives can use different salts for headers and for files,
+   and RAR can use new salt for each volume or file.
+   So we keep several recently derived keys, not only last key. */
+
+static const unsigned kNumCachedKeys = 16;
+static CKey g_Keys[kNumCachedKeys];
+
+static void MoveCachedKeyToFront(unsigned index)
+{
+  if (index == 0)
+    return;
+  CKey temp;
+  temp = g_Keys[index];
+  for (unsigned i = index; i != 0; i--)
+    g_Keys[i] = g_Keys[i - 1];
+  g_Keys[0] = temp;
+}
 
 #ifndef Z7_ST
   static NWindows::NSynchronization::CCriticalSection g_GlobalKeyCacheCriticalSection;
@@ -198,10 +214,18 @@ bool CDecoder::CalcKey_and_CheckPassword()
   {
     {
       MT_LOCK
-      if (!g_Key._needCalc && IsKeyEqualTo(g_Key))
+      for (unsigned i = 0; i < kNumCachedKeys; i++)
       {
-        CopyCalcedKeysFrom(g_Key);
-        _needCalc = false;
+        const CKey &cached = g_Keys[i];
+        if (cached._needCalc)
+          break;
+        if (IsKeyEqualTo(cached))
+        {
+          CopyCalcedKeysFrom(cached);
+          _needCalc = false;
+          MoveCachedKeyToFront(i);
+          break;
+        }
       }
     }
     
@@ -259,7 +283,9 @@ bool CDecoder::CalcKey_and_CheckPassword()
       _needCalc = false;
       {
         MT_LOCK
-        g_Key = *this;
+        // the oldest key (last slot) is replaced
+        MoveCachedKeyToFront(kNumCachedKeys - 1);
+        g_Keys[0] = *this;
       }
     }
   }
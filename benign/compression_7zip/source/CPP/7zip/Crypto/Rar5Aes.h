@@ -47,7 +47,7 @@ struct CKey: public CKeyBase
   unsigned _numIterationsLog;
   Byte _salt[kSaltSize];
   
-  bool IsKeyEqualTo(const CKey &key)
+  bool IsKeyEqualTo(const CKey &key) const
   {
     return _numIterationsLog == key._numIterationsLog
         && memcmp(_salt, key._salt, sizeof(_salt)) == 0
@@ -10,6 +10,12 @@ Note: you must include MyAes.cpp to project to initialize AES tables
 
 #include "../../../C/CpuArch.h"
 
+#include "../../Common/MyVector.h"
+
+#ifndef Z7_ST
+#include "../../Windows/Synchronization.h"
+#endif
+
 #include "../Common/StreamUtils.h"
 
 #include "Pbkdf2HmacSha1.h"
@@ -32,22 +38,117 @@ Z7_COM7F_IMF(CBaseCoder::CryptoSetPassword(const Byte *data, UInt32 size))
   return S_OK;
 }
 
+static const unsigned kDerivedKeySizeMax = 2 * kAesKeySizeMax + ((kPwdVerifSize + 3) & ~(unsigned)3);
+
+/* The derived key depends only on (KeySizeMode, Salt, Password).
+   Test/extract of the same archive (or password retries) derive the same keys
+   again, so we keep recently derived keys in global cache. */
+
+struct CDerivedKey
+{
+  EKeySizeMode KeySizeMode;
+  Byte Salt[kSaltSizeMax];
+  CByteBuffer Password;
+  Byte Key[kDerivedKeySizeMax];
+
+  bool IsEqualTo(const CKeyInfo &a) const
+  {
+    return KeySizeMode == a.KeySizeMode
+        && memcmp(Salt, a.Salt, a.GetSaltSize()) == 0
+        && Password == a.Password;
+  }
+
+  CDerivedKey(const CKeyInfo &a, const Byte *key):
+      KeySizeMode(a.KeySizeMode)
+  {
+    memcpy(Salt, a.Salt, sizeof(Salt));
+    Password.CopyFrom(a.Password, a.Password.Size());
+    memcpy(Key, key, sizeof(Key));
+  }
+
+  ~CDerivedKey()
+  {
+    Password.Wipe();
+    Z7_memset_0_ARRAY(Salt);
+    Z7_memset_0_ARRAY(Key);
+  }
+};
+
+class CDerivedKeyCache
+{
+  unsigned Size;
+  CObjectVector<CDerivedKey> Keys;
+public:
+  CDerivedKeyCache(unsigned size): Size(size) {}
+  bool GetKey(const CKeyInfo &keyInfo, Byte *key);
+  void Add(const CKeyInfo &keyInfo, const Byte *key);
+};
+
+bool CDerivedKeyCache::GetKey(const CKeyInfo &keyInfo, Byte *key)
+{
+  FOR_VECTOR (i, Keys)
+  {
+    const CDerivedKey &cached = Keys[i];
+    if (cached.IsEqualTo(keyInfo))
+    {
+      memcpy(key, cached.Key, kDerivedKeySizeMax);
+      if (i != 0)
+        Keys.MoveToFront(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+void CDerivedKeyCache::Add(const CKeyInfo &keyInfo, const Byte *key)
+{
+  FOR_VECTOR (i, Keys)
+    if (Keys[i].IsEqualTo(keyInfo))
+    {
+      if (i != 0)
+        Keys.MoveToFront(i);
+      return;
+    }
+  if (Keys.Size() >= Size)
+    Keys.DeleteBack();
+  Keys.Insert(0, CDerivedKey(keyInfo, key));
+}
+
+static CDerivedKeyCache g_GlobalKeyCache(64);
+
+#ifndef Z7_ST
+  static NWindows::NSynchronization::CCriticalSection g_GlobalKeyCacheCriticalSection;
+  #define MT_LOCK NWindows::NSynchronization::CCriticalSectionLock lock(g_GlobalKeyCacheCriticalSection);
+#else
+  #define MT_LOCK
+#endif
+
 void CBaseCoder::Init2()
 {
   _hmacOverCalc = 0;
-  const unsigned dkSizeMax32 = (2 * kAesKeySizeMax + kPwdVerifSize + 3) / 4;
-  Byte dk[dkSizeMax32 * 4];
+  MY_ALIGN (16)
+  Byte dk[kDerivedKeySizeMax];
 
   const unsigned keySize = _key.GetKeySize();
   const unsigned dkSize = 2 * keySize + ((kPwdVerifSize + 3) & ~(unsigned)3);
   
-  // for (unsigned ii = 0; ii < 1000; ii++)
+  bool finded;
+  {
+    MT_LOCK
+    finded = g_GlobalKeyCache.GetKey(_key, dk);
+  }
+
+  if (!finded)
   {
+    // we don't hold the lock here, so parallel extraction threads can derive keys concurrently
+    memset(dk, 0, sizeof(dk));
     NSha1::Pbkdf2Hmac(
         _key.Password, _key.Password.Size(),
         _key.Salt, _key.GetSaltSize(),
         kNumKeyGenIterations,
         dk, dkSize);
+    MT_LOCK
+    g_GlobalKeyCache.Add(_key, dk);
   }
 
   Hmac()->SetKey(dk + keySize, keySize);
@@ -58,7 +159,15 @@ void CBaseCoder::Init2()
   _aesCoderSpec->SetKeySize(keySize);
   if (_aesCoderSpec->SetKey(dk, keySize) != S_OK) throw 2;
   if (_aesCoderSpec->Init() != S_OK) throw 3;
+  Z7_memset_0_ARRAY(dk);
+}
+
+#ifndef Z7_ST
+Z7_COM7F_IMF(CBaseCoder::SetNumberOfThreads(UInt32 numThreads))
+{
+  return _aesCoderSpec->SetNumberOfThreads(numThreads);
 }
+#endif
 
 Z7_COM7F_IMF(CBaseCoder::Init())
 {
@@ -92,12 +92,23 @@ void AesCtr2_Code(CAesCtr2 *p, Byte *data, SizeT size);
 class CBaseCoder:
   public ICompressFilter,
   public ICryptoSetPassword,
+ #ifndef Z7_ST
+  public ICompressSetCoderMt,
+ #endif
   public CMyUnknownImp
 {
-  Z7_COM_UNKNOWN_IMP_1(ICryptoSetPassword)
+  Z7_COM_QI_BEGIN2(ICryptoSetPassword)
+ #ifndef Z7_ST
+  Z7_COM_QI_ENTRY(ICompressSetCoderMt)
+ #endif
+  Z7_COM_QI_END
+  Z7_COM_ADDREF_RELEASE
   Z7_COM7F_IMP(Init())
 public:
   Z7_IFACE_COM7_IMP(ICryptoSetPassword)
+ #ifndef Z7_ST
+  Z7_IFACE_COM7_IMP(ICompressSetCoderMt)
+ #endif
 protected:
   CKeyInfo _key;
 
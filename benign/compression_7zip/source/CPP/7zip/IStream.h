@@ -141,6 +141,43 @@ Z7_IFACE_CONSTR_STREAM(IStreamGetProps2, 0x09)
 Z7_IFACE_CONSTR_STREAM(IStreamGetProp, 0x0a)
 
 
+/*
+IStreamDirectBuf provides zero-copy access to stream data
+that is already available in memory (for example, memory mapped file).
+
+GetDirectBuf(const Byte **data, size_t *size)
+  returns:
+    S_OK    : (*data) points to data at current stream position,
+              (*size) is the number of bytes from current position to the end of stream.
+              The data is valid until the stream object is released.
+              The call doesn't change current stream position.
+    S_FALSE : direct access is not available now.
+              The caller must use ISequentialInStream::Read() in that case.
+
+SkipDirectBuf(size_t size)
+  moves current stream position forward by (size) bytes,
+  that were consumed by the caller via GetDirectBuf().
+*/
+
+#define Z7_IFACEM_IStreamDirectBuf(x) \
+  x(GetDirectBuf(const Byte **data, size_t *size)) \
+  x(SkipDirectBuf(size_t size))
+Z7_IFACE_CONSTR_STREAM(IStreamDirectBuf, 0x0b)
+
+
+/*
+IInStreamReadAt::ReadAt(UInt64 pos, void *data, UInt32 size, UInt32 *processedSize)
+  reads data from (pos) offset of stream.
+  The call doesn't use and doesn't change current stream position.
+  It can be called from different threads simultaneously.
+  (processedSize) has same meaning as in ISequentialInStream::Read().
+*/
+
+#define Z7_IFACEM_IInStreamReadAt(x) \
+  x(ReadAt(UInt64 pos, void *data, UInt32 size, UInt32 *processedSize))
+Z7_IFACE_CONSTR_STREAM(IInStreamReadAt, 0x0c)
+
+
 /*
 IStreamSetRestriction::SetRestriction(UInt64 begin, UInt64 end)
   
@@ -206,5 +243,52 @@ inputs:
 
 Z7_IFACE_CONSTR_STREAM(IStreamSetRestriction, 0x10)
 
+
+/*
+IOutStreamSparse::WriteHole(UInt64 size)
+  writes (size) zero bytes at current position of stream
+  and moves current position forward by (size) bytes.
+  The callee can leave that region unallocated (hole in sparse file)
+  instead of real writing of zero bytes.
+  The caller (archive handler) uses it for regions that are known
+  to be zeros without reading (unallocated regions of disk images).
+*/
+
+#define Z7_IFACEM_IOutStreamSparse(x) \
+  x(WriteHole(UInt64 size))
+Z7_IFACE_CONSTR_STREAM(IOutStreamSparse, 0x11)
+
+
+/*
+IStreamGetFileHandle::GetFileHandle(UInt64 *handle, UInt64 *pos)
+  returns the handle of OS file that contains the data of stream
+  (file descriptor in POSIX) and current position of stream in that file.
+  The caller must not change the position of that handle.
+  It returns S_FALSE, if the stream is not based on such file.
+*/
+
+#define Z7_IFACEM_IStreamGetFileHandle(x) \
+  x(GetFileHandle(UInt64 *handle, UInt64 *pos))
+Z7_IFACE_CONSTR_STREAM(IStreamGetFileHandle, 0x12)
+
+
+/*
+IOutStreamCopyFrom::CopyFrom(IInStream *inStream, UInt64 size, UInt64 *processedSize)
+  copies up to (size) bytes from current position of (inStream)
+  to current position of this stream, and moves both positions forward.
+  The callee uses OS-level copying (reflink or copy_file_range()),
+  so the data is not transferred through user-space buffers.
+  returns:
+    E_NOTIMPL : OS-level copying is not possible for these streams.
+                No data was copied. The caller must copy the data with Read()/Write().
+    S_OK      : (*processedSize) bytes were copied.
+                (*processedSize < size) means the end of input stream.
+    another error code : (*processedSize) bytes were copied before the error.
+*/
+
+#define Z7_IFACEM_IOutStreamCopyFrom(x) \
+  x(CopyFrom(IInStream *inStream, UInt64 size, UInt64 *processedSize))
+Z7_IFACE_CONSTR_STREAM(IOutStreamCopyFrom, 0x13)
+
 Z7_PURE_INTERFACES_END
 #endif
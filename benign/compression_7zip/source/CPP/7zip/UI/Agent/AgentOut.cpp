@@ -510,17 +510,18 @@ HRESULT CAgent::CreateFolder(ISequentialOutStream *outArchiveStream,
   di.Attrib = FILE_ATTRIBUTE_DIRECTORY;
   di.Size = 0;
   bool isAltStreamFolder = false;
+  UString name;
   if (_proxy2)
-    di.Name = _proxy2->GetDirPath_as_Prefix(_agentFolder->_proxyDirIndex, isAltStreamFolder);
+    name = _proxy2->GetDirPath_as_Prefix(_agentFolder->_proxyDirIndex, isAltStreamFolder);
   else
-    di.Name = _proxy->GetDirPath_as_Prefix(_agentFolder->_proxyDirIndex);
-  di.Name += folderName;
+    name = _proxy->GetDirPath_as_Prefix(_agentFolder->_proxyDirIndex);
+  name += folderName;
 
   FILETIME ft;
   NTime::GetCurUtcFileTime(ft);
   di.CTime = di.ATime = di.MTime = ft;
 
-  dirItems.Items.Add(di);
+  dirItems.AddItem(di, name);
 
   updateCallback->Callback = &updateCallbackAgent;
   updateCallback->DirItems = &dirItems;
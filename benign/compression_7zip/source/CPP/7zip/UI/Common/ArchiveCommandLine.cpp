@@ -29,12 +29,18 @@
 #include "../../../Windows/FileName.h"
 #include "../../../Windows/PropVariantConv.h"
 #include "../../../Windows/System.h"
+#ifndef Z7_ST
+#include "../../../../C/MemBudget.h"
+#include "../../../Windows/Thread.h"
+#endif
 #ifdef _WIN32
 #include "../../../Windows/FileMapping.h"
 #include "../../../Windows/MemoryLock.h"
 #include "../../../Windows/Synchronization.h"
 #endif
 
+#include "../../Common/FileStreams.h"
+
 #include "ArchiveCommandLine.h"
 #include "EnumDirItems.h"
 #include "Update.h"
@@ -131,6 +137,7 @@ enum Enum
   kDisableHeaders,
   kDisablePercents,
   kShowTime,
+  kShowStageStats,
   kLogLevel,
 
   kOutStream,
@@ -157,15 +164,19 @@ enum Enum
 
   kUpdate,
   kVolume,
+  kVolumeWriteBehind,
+  kVolumeSync,
   kRecursed,
 
   kAffinity,
+  kThreadPool,
   kSfx,
   kEmail,
   kHash,
   // kHashGenFile,
   kHashDir,
   kExtractMemLimit,
+  kMemBudget,
  
   kStdIn,
   kStdOut,
@@ -174,12 +185,15 @@ enum Enum
   kListfileCharSet,
   kConsoleCharSet,
   kTechMode,
+  kListJson,
   kListFields,
   kListPathSlash,
   kListTimestampUTC,
   
   kPreserveATime,
   kShareForWrite,
+  kSparseFiles,
+  kUseMmap,
   kStopAfterOpenError,
   kCaseSensitive,
   kArcNameMode,
@@ -282,6 +296,7 @@ static const CSwitchForm kSwitchForms[] =
   { "ba", SWFRM_SIMPLE },
   { "bd", SWFRM_SIMPLE },
   { "bt", SWFRM_SIMPLE },
+  { "bts", SWFRM_STRING_SINGL(0) },
   { "bb", SWFRM_STRING_SINGL(0) },
 
   { "bso", NSwitchType::kChar, false, 1, k_Stream_PostCharSet },
@@ -308,15 +323,19 @@ static const CSwitchForm kSwitchForms[] =
   
   { "u",  SWFRM_STRING_MULT(1) },
   { "v",  SWFRM_STRING_MULT(1) },
+  { "vwb", SWFRM_STRING_SINGL(1) },
+  { "vws", SWFRM_SIMPLE },
   { "r",  NSwitchType::kChar, false, 0, kRecursedPostCharSet },
   
   { "stm", SWFRM_STRING },
+  { "stp", SWFRM_STRING },
   { "sfx", SWFRM_STRING },
   { "seml", SWFRM_STRING_SINGL(0) },
   { "scrc", SWFRM_STRING_MULT(0) },
   // { "scrf", SWFRM_STRING_SINGL(1) },
   { "shd", SWFRM_STRING_SINGL(1) },
   { "smemx", SWFRM_STRING },
+  { "smb", SWFRM_STRING },
   
   { "si", SWFRM_STRING },
   { "so", SWFRM_SIMPLE },
@@ -325,12 +344,15 @@ static const CSwitchForm kSwitchForms[] =
   { "scs", SWFRM_STRING },
   { "scc", SWFRM_STRING },
   { "slt", SWFRM_SIMPLE },
+  { "slj", SWFRM_SIMPLE },
   { "slf", SWFRM_STRING_SINGL(1) },
   { "slsl", SWFRM_MINUS },
   { "slmu", SWFRM_MINUS },
 
   { "ssp", SWFRM_SIMPLE },
   { "ssw", SWFRM_SIMPLE },
+  { "ssf", SWFRM_MINUS },
+  { "ssm", SWFRM_SIMPLE },
   { "sse", SWFRM_SIMPLE },
   { "ssc", SWFRM_MINUS },
   { "sa",  NSwitchType::kChar, false, 1, k_ArcNameMode_PostCharSet },
@@ -447,6 +469,11 @@ static bool ParseArchiveCommand(const UString &commandString, CArcCommand &comma
     command.CommandType = (NCommandType::kRename);
     return true;
   }
+  if (s.Len() == 2 && s[0] == 't' && s[1] == 'd')
+  {
+    command.CommandType = (NCommandType::kTrainDict);
+    return true;
+  }
   return false;
 }
 
@@ -997,6 +1024,13 @@ static void SetAddCommandOptions(
       options.VolumesSizes.Add(size);
     }
   }
+  if (parser[NKey::kVolumeWriteBehind].ThereIs)
+  {
+    const UString &s = parser[NKey::kVolumeWriteBehind].PostStrings[0];
+    if (!ParseComplexSize(s, options.VolumesWriteBehind))
+      throw CArcCmdLineException("Incorrect write-behind memory size:", s);
+  }
+  options.VolumesSync = parser[NKey::kVolumeSync].ThereIs;
 }
 
 static void SetMethodOptions(const CParser &parser, CObjectVector<CProperty> &properties)
@@ -1066,7 +1100,18 @@ void CArcCmdLineParser::Parse1(const UStringVector &commandStrings,
   if (parser[NKey::kListTimestampUTC].ThereIs)
     g_Timestamp_Show_UTC = !parser[NKey::kListTimestampUTC].WithMinus;
   options.TechMode = parser[NKey::kTechMode].ThereIs;
+  options.ListJsonMode = parser[NKey::kListJson].ThereIs;
+  if (options.ListJsonMode)
+  {
+    // stdout must contain JSON records only
+    options.EnableHeaders = false;
+  }
   options.ShowTime = parser[NKey::kShowTime].ThereIs;
+  if (parser[NKey::kShowStageStats].ThereIs)
+  {
+    options.ShowStageStats = true;
+    options.StageTraceFile = parser[NKey::kShowStageStats].PostStrings[0];
+  }
 
   if (parser[NKey::kDisablePercents].ThereIs)
     options.DisablePercents = true;
@@ -1146,6 +1191,31 @@ void CArcCmdLineParser::Parse1(const UStringVector &commandStrings,
     #endif
   }
 
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  if (parser[NKey::kUseMmap].ThereIs)
+    g_InFileStream_UseMmap = true;
+ #endif
+
+ #ifndef Z7_ST
+  {
+    // -stp0 disables the pool. -stp{N} sets the limit for running worker threads
+    UInt32 numThreads = 0;
+    bool usePool = true;
+    if (parser[NKey::kThreadPool].ThereIs)
+    {
+      const UString &s = parser[NKey::kThreadPool].PostStrings[0];
+      if (!s.IsEmpty())
+      {
+        if (!StringToUInt32(s, numThreads))
+          throw CArcCmdLineException("Unsupported switch postfix for -stp", s);
+        usePool = (numThreads != 0);
+      }
+    }
+    if (usePool)
+      ThreadPool_Create(numThreads);
+  }
+ #endif
+
 
 #ifndef UNDER_CE
 
@@ -1352,6 +1422,19 @@ void CArcCmdLineParser::Parse2(CArcCmdLineOptions &options)
     if (!ParseSizeString(s, options.ExtractOptions.NtOptions.MemLimit))
       throw CArcCmdLineException("Unsupported -smemx:", s);
   }
+
+ #ifndef Z7_ST
+  if (parser[NKey::kMemBudget].ThereIs)
+  {
+    // -smb0 : no limit, but the statistics of reserved memory is collected
+    const UString &s = parser[NKey::kMemBudget].PostStrings[0];
+    UInt64 limit;
+    if (!ParseSizeString(s, limit))
+      throw CArcCmdLineException("Unsupported -smb:", s);
+    if (MemBudget_Create(limit) != 0)
+      throw CArcCmdLineException("Can't create memory budget");
+  }
+ #endif
   
   if (parser[NKey::kElimDup].ThereIs)
   {
@@ -1538,6 +1621,7 @@ void CArcCmdLineParser::Parse2(CArcCmdLineOptions &options)
         nt.PreserveATime = true;
       if (parser[NKey::kShareForWrite].ThereIs)
         nt.OpenShareForWrite = true;
+      SetBoolPair(parser, NKey::kSparseFiles, nt.SparseFiles);
     }
 
     if (parser[NKey::kZoneFile].ThereIs)
@@ -1749,6 +1833,31 @@ void CArcCmdLineParser::Parse2(CArcCmdLineOptions &options)
     hashOptions.AltStreamsMode = options.AltStreams.Val;
     hashOptions.SymLinks = options.SymLinks;
   }
+  else if (options.Command.CommandType == NCommandType::kTrainDict)
+  {
+    options.Censor.AddPathsToCensor(censorPathMode);
+    options.Censor.ExtendExclude();
+
+    CTrainDictOptions &dictOptions = options.TrainDictOptions;
+    dictOptions.PathMode = censorPathMode;
+    if (parser[NKey::kShareForWrite].ThereIs)
+      dictOptions.OpenShareForWrite = true;
+    dictOptions.SymLinks = options.SymLinks;
+    FOR_VECTOR (i, options.Properties)
+    {
+      // -md{Size} or -md={Size} : the size of dictionary
+      const CProperty &prop = options.Properties[i];
+      UString s (prop.Name);
+      if (!s.IsPrefixedBy_Ascii_NoCase("d"))
+        throw CArcCmdLineException("Unsupported property for dictionary training", prop.Name);
+      s.Delete(0);
+      s += prop.Value;
+      UInt64 size;
+      if (!ParseSizeString(s, size) || size < (1 << 10) || size > ((UInt32)1 << 27))
+        throw CArcCmdLineException("Incorrect dictionary size", prop.Name);
+      dictOptions.DictSize = (UInt32)size;
+    }
+  }
   else if (options.Command.CommandType == NCommandType::kInfo)
   {
   }
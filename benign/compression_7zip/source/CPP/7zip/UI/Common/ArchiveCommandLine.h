@@ -10,6 +10,7 @@
 
 #include "Extract.h"
 #include "HashCalc.h"
+#include "TrainDict.h"
 #include "Update.h"
 
 typedef CMessagePathException CArcCmdLineException;
@@ -26,7 +27,8 @@ namespace NCommandType { enum EEnum
   kBenchmark,
   kInfo,
   kHash,
-  kRename
+  kRename,
+  kTrainDict
 };}
 
 struct CArcCommand
@@ -66,7 +68,10 @@ struct CArcCmdLineOptions
   bool YesToAll;
   bool ShowDialog;
   bool TechMode;
+  bool ListJsonMode;
   bool ShowTime;
+  bool ShowStageStats;
+  UString StageTraceFile;
   CBoolPair ListPathSeparatorSlash;
 
   CBoolPair NtSecurity;
@@ -106,6 +111,7 @@ struct CArcCmdLineOptions
 
   CUpdateOptions UpdateOptions;
   CHashOptions HashOptions;
+  CTrainDictOptions TrainDictOptions;
   UString ArcType;
   UStringVector ExcludedArcTypes;
   
@@ -139,7 +145,9 @@ struct CArcCmdLineOptions
       YesToAll(false),
       ShowDialog(false),
       TechMode(false),
+      ListJsonMode(false),
       ShowTime(false),
+      ShowStageStats(false),
 
       ConsoleCodePage(-1),
 
@@ -29,6 +29,7 @@
 #endif
 
 #include "../../Common/FilePathAutoRename.h"
+#include "../../Common/StageStats.h"
 #include "../../Common/StreamUtils.h"
 
 #include "../../Archive/Common/ItemNameUtils.h"
@@ -1474,6 +1475,9 @@ HRESULT CArchiveExtractCallback::GetExtractStream(CMyComPtr<ISequentialOutStream
   
   _needSetAttrib = true;
 
+  _outFileStreamSpec->AllowHoles = !_ntOptions.SparseFiles.Def || _ntOptions.SparseFiles.Val;
+  _outFileStreamSpec->SkipZeroBlocks = _ntOptions.SparseFiles.Val;
+
   bool is_SymLink_in_Data = false;
 
   if (_curSize_Defined && _curSize && _curSize < k_LinkDataSize_LIMIT)
@@ -1587,6 +1591,7 @@ HRESULT CArchiveExtractCallback::GetItem(UInt32 index)
 Z7_COM7F_IMF(CArchiveExtractCallback::GetStream(UInt32 index, ISequentialOutStream **outStream, Int32 askExtractMode))
 {
   COM_TRY_BEGIN
+  NStageStats::CTimer stageTimer(NStageStats::kStage_Callback);
 
   *outStream = NULL;
 
@@ -1898,6 +1903,7 @@ Z7_COM7F_IMF(CArchiveExtractCallback::GetStream(UInt32 index, ISequentialOutStre
 Z7_COM7F_IMF(CArchiveExtractCallback::PrepareOperation(Int32 askExtractMode))
 {
   COM_TRY_BEGIN
+  NStageStats::CTimer stageTimer(NStageStats::kStage_Callback);
 
   #ifndef Z7_SFX
   // if (!_op_WasReported)
@@ -2673,6 +2679,7 @@ HRESULT CArchiveExtractCallback::SetSecurityInfo(UInt32 indexInArc, const FStrin
 Z7_COM7F_IMF(CArchiveExtractCallback::SetOperationResult(Int32 opRes))
 {
   COM_TRY_BEGIN
+  NStageStats::CTimer stageTimer(NStageStats::kStage_Callback);
 
   // printf("\nCArchiveExtractCallback::SetOperationResult: %d %s\n", opRes, GetAnsiString(_diskFilePath));
 
@@ -54,6 +54,11 @@ struct CExtractNtOptions
   CBoolPair SymLinks;
   CBoolPair HardLinks;
   CBoolPair AltStreams;
+  /* SparseFiles:
+       (Def == false) : holes reported by disk image handlers are not written
+       (Val == true)  : also aligned zero blocks from any handler are not written
+       (Val == false) : all zeros are written */
+  CBoolPair SparseFiles;
   bool ReplaceColonForAltStream;
   bool WriteToAltStreamIfColon;
 
@@ -122,11 +122,6 @@ public:
   COpenCallbackImp *OpenCallbackImp;
   CMyComPtr<IArchiveOpenCallback> OpenCallbackRef;
 
-  HRESULT EnsureOpen()
-  {
-    return OpenCallbackImp->Volumes.EnsureOpen(FileIndex);
-  }
-
   ~CInFileStreamVol()
   {
     if (OpenCallbackRef)
@@ -163,8 +158,15 @@ void CMultiStreams::RemoveFromList(CSubStream &s)
   NumListItems--;
 }
 
+#ifndef Z7_ST
+  #define VOLUMES_LOCK  NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+#else
+  #define VOLUMES_LOCK
+#endif
+
 void CMultiStreams::CloseFile(unsigned index)
 {
+  VOLUMES_LOCK
   CSubStream &s = Streams[index];
   if (s.Stream)
   {
@@ -204,13 +206,52 @@ HRESULT CMultiStreams::PrepareToOpenNew()
     return S_OK;
   if (Tail == -1)
     return E_FAIL;
-  CMultiStreams::CSubStream &tailStream = Streams[(unsigned)Tail];
-  RINOK(InStream_GetPos(tailStream.Stream, tailStream.LocalPos))
-  CloseFile((unsigned)Tail);
+  // we close the oldest file that is not used by another thread now
+  int index = Tail;
+  for (;;)
+  {
+    CMultiStreams::CSubStream &s = Streams[(unsigned)index];
+    if (s.NumUsers == 0)
+    {
+      RINOK(InStream_GetPos(s.Stream, s.LocalPos))
+      s.Stream.Release();
+      RemoveFromList(s);
+      return S_OK;
+    }
+    index = s.Prev;
+    if (index == -1)
+      return S_OK; // all open files are used, so we exceed the limit temporarily
+  }
+}
+
+HRESULT CMultiStreams::AddOpenedFile(CSubStream &s, unsigned &index)
+{
+  VOLUMES_LOCK
+  RINOK(PrepareToOpenNew())
+  index = Streams.Add(s);
+  InsertToList(index);
   return S_OK;
 }
 
 
+HRESULT CMultiStreams::UseStream(unsigned index, CMyComPtr<IInStream> &stream, CInFileStream **fileSpec)
+{
+  VOLUMES_LOCK
+  RINOK(EnsureOpen(index))
+  CSubStream &s = Streams[index];
+  s.NumUsers++;
+  stream = s.Stream;
+  if (fileSpec)
+    *fileSpec = s.FileSpec;
+  return S_OK;
+}
+
+void CMultiStreams::UnuseStream(unsigned index)
+{
+  VOLUMES_LOCK
+  Streams[index].NumUsers--;
+}
+
 HRESULT CMultiStreams::EnsureOpen(unsigned index)
 {
   CMultiStreams::CSubStream &s = Streams[index];
@@ -255,26 +296,36 @@ Z7_COM7F_IMF(CInFileStreamVol::Read(void *data, UInt32 size, UInt32 *processedSi
     *processedSize = 0;
   if (size == 0)
     return S_OK;
-  RINOK(EnsureOpen())
-  CMultiStreams::CSubStream &s = OpenCallbackImp->Volumes.Streams[FileIndex];
+  CMultiStreams &volumes = OpenCallbackImp->Volumes;
+  CMyComPtr<IInStream> stream;
+  RINOK(volumes.UseStream(FileIndex, stream, NULL))
   PRF(printf("\n== %u, Read =%u \n", FileIndex, size));
-  return s.Stream->Read(data, size, processedSize);
+  const HRESULT res = stream->Read(data, size, processedSize);
+  volumes.UnuseStream(FileIndex);
+  return res;
 }
 
 Z7_COM7F_IMF(CInFileStreamVol::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition))
 {
   // if (seekOrigin >= 3) return STG_E_INVALIDFUNCTION;
-  RINOK(EnsureOpen())
-  CMultiStreams::CSubStream &s = OpenCallbackImp->Volumes.Streams[FileIndex];
+  CMultiStreams &volumes = OpenCallbackImp->Volumes;
+  CMyComPtr<IInStream> stream;
+  RINOK(volumes.UseStream(FileIndex, stream, NULL))
   PRF(printf("\n-- %u, Seek seekOrigin=%u Seek =%u\n", FileIndex, seekOrigin, (unsigned)offset));
-  return s.Stream->Seek(offset, seekOrigin, newPosition);
+  const HRESULT res = stream->Seek(offset, seekOrigin, newPosition);
+  volumes.UnuseStream(FileIndex);
+  return res;
 }
 
 Z7_COM7F_IMF(CInFileStreamVol::GetSize(UInt64 *size))
 {
-  RINOK(EnsureOpen())
-  CMultiStreams::CSubStream &s = OpenCallbackImp->Volumes.Streams[FileIndex];
-  return s.FileSpec->GetSize(size);
+  CMultiStreams &volumes = OpenCallbackImp->Volumes;
+  CMyComPtr<IInStream> stream;
+  CInFileStream *fileSpec;
+  RINOK(volumes.UseStream(FileIndex, stream, &fileSpec))
+  const HRESULT res = fileSpec->GetSize(size);
+  volumes.UnuseStream(FileIndex);
+  return res;
 }
 
 
@@ -339,7 +390,6 @@ Z7_COM7F_IMF(COpenCallbackImp::GetStream(const wchar_t *name, IInStream **inStre
     CMyComPtr<IInStream> inStreamTemp = inFile;
     if (!inFile->Open(fullPath))
       return GetLastError_noZero_HRESULT();
-    RINOK(Volumes.PrepareToOpenNew())
     s.FileSpec = inFile;
     s.Stream = s.FileSpec;
     s.Path = fullPath;
@@ -347,8 +397,8 @@ Z7_COM7F_IMF(COpenCallbackImp::GetStream(const wchar_t *name, IInStream **inStre
     // s.IsOpen = true;
   }
 
-  const unsigned fileIndex = Volumes.Streams.Add(s);
-  Volumes.InsertToList(fileIndex);
+  unsigned fileIndex;
+  RINOK(Volumes.AddOpenedFile(s, fileIndex))
 
   FileSizes.Add(_fileInfo.Size);
   FileNames.Add(name2);
@@ -6,6 +6,9 @@
 #include "../../../Common/MyCom.h"
 
 #include "../../../Windows/FileFind.h"
+#ifndef Z7_ST
+#include "../../../Windows/Synchronization.h"
+#endif
 
 #include "../../Common/FileStreams.h"
 
@@ -52,6 +55,7 @@ public:
     FString Path;
     // UInt64 Size;
     UInt64 LocalPos;
+    unsigned NumUsers; // the file is not closed by PrepareToOpenNew(), if (NumUsers != 0)
     int Next; // next older
     int Prev; // prev newer
     // bool IsOpen;
@@ -60,6 +64,7 @@ public:
         FileSpec(NULL),
         // Size(0),
         LocalPos(0),
+        NumUsers(0),
         Next(-1),
         Prev(-1)
         // IsOpen(false)
@@ -68,20 +73,32 @@ public:
 
   CObjectVector<CSubStream> Streams;
 private:
-  // we must use critical section here, if we want to access from different volumnes simultaneously
   int Head; // newest
   int Tail; // oldest
   unsigned NumListItems;
   unsigned NumOpenFiles_AllowedMax;
+ #ifndef Z7_ST
+  // the volumes can be read from different threads simultaneously
+  NWindows::NSynchronization::CCriticalSection CS;
+ #endif
+
+  void InsertToList(unsigned index);
+  void RemoveFromList(CSubStream &s);
+  HRESULT PrepareToOpenNew();
+  HRESULT EnsureOpen(unsigned index);
 public:
 
   CMultiStreams();
   void Init();
-  HRESULT PrepareToOpenNew();
-  void InsertToList(unsigned index);
-  void RemoveFromList(CSubStream &s);
+  HRESULT AddOpenedFile(CSubStream &s, unsigned &index);
   void CloseFile(unsigned index);
-  HRESULT EnsureOpen(unsigned index);
+
+  /* UseStream() opens the file, if it was closed,
+     and locks it in open state until UnuseStream() call.
+     The caller can call the methods of (stream) without lock,
+     if the same volume is not used by another thread. */
+  HRESULT UseStream(unsigned index, CMyComPtr<IInStream> &stream, CInFileStream **fileSpec);
+  void UnuseStream(unsigned index);
 };
 
 
@@ -18,6 +18,10 @@
 #endif
 #endif // USE_POSIX_TIME
 
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+
 #ifdef _WIN32
 #define USE_ALLOCA
 #endif
@@ -32,6 +36,7 @@
 #endif
 
 #include "../../../../C/7zCrc.h"
+#include "../../../../C/7zVersion.h"
 #include "../../../../C/RotateDefs.h"
 #include "../../../../C/CpuArch.h"
 
@@ -3752,6 +3757,378 @@ static void Bench_BW_Print_Usage_Speed(IBenchPrintCallback &f,
 }
 
 
+/*
+  JSON benchmark matrix (-mjson):
+  it sweeps g_Bench[] coders and g_Hash[] hashers, that match method mask,
+  over the list of thread counts and over the list of data profiles,
+  and it writes one JSON object per test to (printCallback).
+*/
+
+static const UInt32 kJsonBenchInMs = 500;
+static const unsigned kJsonBenchSizeLog = 22;
+
+static const char * const k_JsonBench_Profiles[] =
+{
+    "text"
+  , "binary"
+  , "random"
+  , "repeat"
+  , "file"
+};
+
+static const char * const k_JsonBench_Words[] =
+{
+    "the", "of", "and", "to", "in", "is", "that", "for", "it", "with"
+  , "as", "was", "on", "be", "by", "data", "stream", "archive", "block", "method"
+  , "compression", "dictionary", "thread", "buffer", "file", "size", "level", "match", "header", "value"
+};
+
+static void JsonBench_GenerateText(Byte *buf, size_t size)
+{
+  CBaseRandomGenerator rg;
+  size_t pos = 0;
+  unsigned numWords = 0;
+  while (pos < size)
+  {
+    const UInt32 r = rg.GetRnd();
+    const char *w = k_JsonBench_Words[(r & 0xFFFF) % Z7_ARRAY_SIZE(k_JsonBench_Words)];
+    for (; *w != 0 && pos < size; w++)
+      buf[pos++] = (Byte)*w;
+    if (pos == size)
+      break;
+    char c = ' ';
+    if (++numWords >= 8 + ((r >> 16) & 7))
+    {
+      numWords = 0;
+      c = '\n';
+    }
+    else if (((r >> 20) & 0xF) == 0)
+      c = ',';
+    buf[pos++] = (Byte)c;
+  }
+}
+
+/* "repeat" profile: CSV-like lines with few different values of fields.
+   Such data has long repeated strings, that are slow for BWT sorting. */
+
+static void JsonBench_GenerateRepeat(Byte *buf, size_t size)
+{
+  CBaseRandomGenerator rg;
+  size_t pos = 0;
+  while (pos < size)
+  {
+    const UInt32 r = rg.GetRnd();
+    char line[128];
+    char *s = MyStpCpy(line, "2024-01-01,host");
+    s = ConvertUInt32ToString(r & 3, s);
+    s = MyStpCpy(s, ",status=OK,path=/api/v1/items,latency=");
+    s = ConvertUInt32ToString(100 + ((r >> 8) & 7), s);
+    *s++ = '\n';
+    for (const char *p = line; p != s && pos < size; p++)
+      buf[pos++] = (Byte)*p;
+  }
+}
+
+
+#ifdef __linux__
+
+static void JsonBench_ResetPeakMem()
+{
+  // "5" resets the peak resident set size (VmHWM) of the process
+  const int fd = ::open("/proc/self/clear_refs", O_WRONLY);
+  if (fd == -1)
+    return;
+  if (::write(fd, "5", 1) != 1)
+  {
+    // old kernels don't support it
+  }
+  ::close(fd);
+}
+
+static bool JsonBench_GetPeakMem(UInt64 &size)
+{
+  size = 0;
+  NFile::NIO::CInFile file;
+  if (!file.Open("/proc/self/status"))
+    return false;
+  char buf[1 << 12];
+  size_t processed;
+  if (!file.ReadFull(buf, sizeof(buf) - 1, processed))
+    return false;
+  buf[processed] = 0;
+  const char *s = strstr(buf, "VmHWM:");
+  if (!s)
+    return false;
+  s += 6;
+  while (*s == ' ' || *s == '\t')
+    s++;
+  const char *end;
+  size = ConvertStringToUInt64(s, &end) << 10;
+  return end != s;
+}
+#else
+static void JsonBench_ResetPeakMem() {}
+static bool JsonBench_GetPeakMem(UInt64 &size) { size = 0; return false; }
+#endif
+
+
+static void Json_AddString(AString &s, const char *name, const char *val)
+{
+  s += '\"';
+  s += name;
+  s += "\":\"";
+  for (; *val != 0; val++)
+  {
+    const char c = *val;
+    if (c == '\"' || c == '\\')
+      s += '\\';
+    if ((Byte)c < 0x20)
+      s += ' ';
+    else
+      s += c;
+  }
+  s += '\"';
+}
+
+static void Json_AddUInt64(AString &s, const char *name, UInt64 val)
+{
+  s += '\"';
+  s += name;
+  s += "\":";
+  s.Add_UInt64(val);
+}
+
+// it writes (val / 10^numDigits) as fixed-point number
+static void Json_AddFixed(AString &s, const char *name, UInt64 val, unsigned numDigits)
+{
+  s += '\"';
+  s += name;
+  s += "\":";
+  UInt64 div = 1;
+  for (unsigned i = 0; i < numDigits; i++)
+    div *= 10;
+  s.Add_UInt64(val / div);
+  s += '.';
+  char temp[32];
+  ConvertUInt64ToString(val % div + div, temp);
+  s += temp + 1;
+}
+
+static void Json_AddNull(AString &s, const char *name)
+{
+  s += '\"';
+  s += name;
+  s += "\":null";
+}
+
+
+struct CJsonBenchRes
+{
+  UInt64 EncSpeed;
+  UInt64 DecSpeed;
+  UInt64 Usage;
+  UInt64 UnpackSize;
+  UInt64 PackSize;
+};
+
+static void JsonBench_PrintRes(IBenchPrintCallback &f, bool &isFirst,
+    const char *methodName, bool isHash, const char *profile,
+    UInt32 numThreads, size_t dataSize,
+    const CJsonBenchRes &r, UInt64 encSpeed_1T)
+{
+  AString s;
+  s += isFirst ? "  {" : " ,{";
+  isFirst = false;
+  Json_AddString(s, "method", methodName);
+  s += ',';
+  Json_AddString(s, "type", isHash ? "hash" : "codec");
+  s += ',';
+  Json_AddString(s, "profile", profile);
+  s += ',';
+  Json_AddUInt64(s, "threads", numThreads);
+  s += ',';
+  Json_AddUInt64(s, "size", dataSize);
+  s += ',';
+  Json_AddFixed(s, "enc_mbps", r.EncSpeed / 1000, 3);
+  s += ',';
+  if (isHash)
+    Json_AddNull(s, "dec_mbps");
+  else
+    Json_AddFixed(s, "dec_mbps", r.DecSpeed / 1000, 3);
+  s += ',';
+  if (isHash || r.UnpackSize == 0)
+    Json_AddNull(s, "ratio");
+  else
+    Json_AddFixed(s, "ratio", MyMultDiv64(r.PackSize, 10000, r.UnpackSize), 4);
+  s += ',';
+  Json_AddUInt64(s, "usage", Benchmark_GetUsage_Percents(r.Usage));
+  s += ',';
+  UInt64 peakMem;
+  if (JsonBench_GetPeakMem(peakMem))
+    Json_AddUInt64(s, "peak_mem", peakMem);
+  else
+    Json_AddNull(s, "peak_mem");
+  s += ',';
+  // scaling efficiency in percents: (speed_N / (N * speed_1))
+  if (encSpeed_1T == 0)
+    Json_AddNull(s, "scaling");
+  else
+    Json_AddUInt64(s, "scaling", MyMultDiv64(r.EncSpeed, 100, encSpeed_1T * numThreads));
+  s += '}';
+  f.Print(s);
+  f.NewLine();
+}
+
+
+static HRESULT JsonBench(
+    DECL_EXTERNAL_CODECS_LOC_VARS
+    const AString &methodMask,
+    UInt64 complexInCommands,
+  #ifndef Z7_ST
+    const CAffinityMode *affinityMode,
+  #endif
+    const CUIntVector &numThreadsVector,
+    size_t dataSize,
+    const Byte *fileData, size_t fileDataSize,
+    IBenchPrintCallback &f)
+{
+  CBenchCallbackToPrint callback;
+  callback.Init();
+  callback._file = &f;
+  callback.NeedPrint = false;
+  bool isFirst = true;
+
+  for (unsigned profileIndex = 0; profileIndex < Z7_ARRAY_SIZE(k_JsonBench_Profiles); profileIndex++)
+  {
+    const char *profile = k_JsonBench_Profiles[profileIndex];
+    size_t size = dataSize;
+    const Byte *data;
+    CBenchRandomGenerator rg;
+
+    if (profileIndex == 4)
+    {
+      if (!fileData)
+        continue;
+      data = fileData;
+      size = fileDataSize;
+    }
+    else
+    {
+      ALLOC_WITH_HRESULT(&rg, size)
+      if (profileIndex == 0)
+        JsonBench_GenerateText((Byte *)rg, size);
+      else if (profileIndex == 1)
+        rg.GenerateLz(GetLogSize(size), 0);
+      else if (profileIndex == 2)
+        rg.GenerateSimpleRandom(0);
+      else
+        JsonBench_GenerateRepeat((Byte *)rg, size);
+      data = (const Byte *)rg;
+    }
+
+    for (unsigned i = 0; i < Z7_ARRAY_SIZE(g_Bench); i++)
+    {
+      const CBenchMethod &bench = g_Bench[i];
+      if (!DoesWildcardMatchName_NoCase(methodMask, bench.Name))
+        continue;
+      {
+        unsigned keySize = 32;
+             if (IsString1PrefixedByString2(bench.Name, "AES128")) keySize = 16;
+        else if (IsString1PrefixedByString2(bench.Name, "AES192")) keySize = 24;
+        callback.BenchProps.KeySize = keySize;
+      }
+      callback.BenchProps.DecComplexUnc = bench.DecComplexUnc;
+      callback.BenchProps.DecComplexCompr = bench.DecComplexCompr;
+      callback.BenchProps.EncComplex = bench.EncComplex;
+
+      COneMethodInfo method;
+      NCOM::CPropVariant propVariant;
+      propVariant = bench.Name;
+      RINOK(method.ParseMethodFromPROPVARIANT(UString(), propVariant))
+
+      UInt64 encSpeed_1T = 0;
+      FOR_VECTOR (ti, numThreadsVector)
+      {
+        RINOK(f.CheckBreak())
+        const UInt32 numThreads = numThreadsVector[ti];
+        JsonBench_ResetPeakMem();
+        const HRESULT res = MethodBench(
+            EXTERNAL_CODECS_LOC_VARS
+            complexInCommands,
+          #ifndef Z7_ST
+            false, numThreads, affinityMode,
+          #endif
+            method,
+            size, data,
+            bench.DictBits,
+            &f, &callback, &callback.BenchProps);
+        if (res == E_NOTIMPL)
+          break;
+        RINOK(res)
+        const CBenchInfo &enc = callback.BenchInfo_Results[0];
+        const CBenchInfo &dec = callback.BenchInfo_Results[1];
+        CJsonBenchRes r;
+        r.EncSpeed = enc.GetUnpackSizeSpeed();
+        r.DecSpeed = dec.GetUnpackSizeSpeed();
+        r.Usage = enc.GetUsage();
+        r.UnpackSize = enc.UnpackSize;
+        r.PackSize = enc.PackSize;
+        if (numThreads == 1)
+          encSpeed_1T = r.EncSpeed;
+        JsonBench_PrintRes(f, isFirst, bench.Name, false, profile,
+            numThreads, size, r, encSpeed_1T);
+      }
+    }
+
+    for (unsigned i = 0; i < Z7_ARRAY_SIZE(g_Hash); i++)
+    {
+      const CBenchHash &bench = g_Hash[i];
+      if (!DoesWildcardMatchName_NoCase(methodMask, bench.Name))
+        continue;
+
+      COneMethodInfo method;
+      NCOM::CPropVariant propVariant;
+      propVariant = bench.Name;
+      RINOK(method.ParseMethodFromPROPVARIANT(UString(), propVariant))
+
+      UInt64 encSpeed_1T = 0;
+      FOR_VECTOR (ti, numThreadsVector)
+      {
+        RINOK(f.CheckBreak())
+        const UInt32 numThreads = numThreadsVector[ti];
+        JsonBench_ResetPeakMem();
+        CJsonBenchRes r;
+        r.DecSpeed = 0;
+        r.UnpackSize = 0;
+        r.PackSize = 0;
+        const HRESULT res = CrcBench(
+            EXTERNAL_CODECS_LOC_VARS
+            complexInCommands,
+            numThreads, size, data,
+            r.EncSpeed, r.Usage,
+            bench.Complex, bench.Weight,
+            NULL, // checkSum
+            method,
+            &f,
+          #ifndef Z7_ST
+            affinityMode,
+          #endif
+            false, // showRating
+            NULL, false, 0);
+        if (res == E_NOTIMPL)
+          break;
+        RINOK(res)
+        if (numThreads == 1)
+          encSpeed_1T = r.EncSpeed;
+        JsonBench_PrintRes(f, isFirst, bench.Name, true, profile,
+            numThreads, size, r, encSpeed_1T);
+      }
+    }
+  }
+  return S_OK;
+}
+
+
 HRESULT Bench(
     DECL_EXTERNAL_CODECS_LOC_VARS
     IBenchPrintCallback *printCallback,
@@ -3818,11 +4195,16 @@ HRESULT Bench(
   CMidAlignedBuffer fileDataBuffer;
   bool use_fileData = false;
   bool isFixedDict = false;
+  bool jsonMode = false;
 
   {
   unsigned i;
 
-  if (printCallback)
+  for (i = 0; i < props.Size(); i++)
+    if (props[i].Name.IsEqualTo_Ascii_NoCase("json"))
+      jsonMode = true;
+
+  if (printCallback && !jsonMode)
   {
     for (i = 0; i < props.Size(); i++)
     {
@@ -3859,7 +4241,7 @@ HRESULT Bench(
         UInt64 len64;
         if (!file.GetLength(len64))
           return GetLastError_noZero_HRESULT();
-        if (printCallback)
+        if (printCallback && !jsonMode)
         {
           printCallback->Print("file size =");
           PrintNumber(*printCallback, len64, 0);
@@ -3885,6 +4267,9 @@ HRESULT Bench(
       continue;
     }
 
+    if (name.IsEqualTo("json"))
+      continue;
+
     NCOM::CPropVariant propVariant;
     if (!property.Value.IsEmpty())
       ParseNumberString(property.Value, propVariant);
@@ -3954,7 +4339,7 @@ HRESULT Bench(
         return E_INVALIDARG;
       specifiedFreq = (UInt64)freq32 * 1000000;
 
-      if (printCallback)
+      if (printCallback && !jsonMode)
       {
         printCallback->Print("freq=");
         PrintNumber(*printCallback, freq32, 0);
@@ -3985,6 +4370,123 @@ HRESULT Bench(
   }
   }
 
+  if (jsonMode)
+  {
+    if (!printCallback)
+      return E_INVALIDARG;
+    if (numThreadsSpecified < 1 || numThreadsSpecified > kNumThreadsMax)
+      return E_INVALIDARG;
+    IBenchPrintCallback &f = *printCallback;
+
+    if (!needSetComplexity)
+      testTimeMs = kJsonBenchInMs;
+    if (specifiedFreq != 0)
+      SetComplexCommandsMs(testTimeMs, true, specifiedFreq, complexInCommands);
+    else
+    {
+      const UInt64 numMilCommands = 1 << 6;
+      UInt64 mipsVal = 0;
+      for (unsigned jj = 0; jj < 2; jj++)
+      {
+        UInt64 start = ::GetTimeCount();
+        const UInt32 sum = CountCpuFreq((UInt32)start, (UInt32)(numMilCommands * 1000000 / kNumFreqCommands), g_BenchCpuFreqTemp);
+        if (sum == 0xF1541213)
+          f.Print("");
+        start = ::GetTimeCount() - start;
+        if (start == 0)
+          start = 1;
+        mipsVal = numMilCommands * GetFreq() / start;
+      }
+      SetComplexCommandsMs(testTimeMs, false, mipsVal * 1000000, complexInCommands);
+    }
+
+    CUIntVector numThreadsVector;
+    {
+      UInt32 nt = numThreads_Start;
+      if (nt < 1)
+        nt = 1;
+      #ifdef Z7_ST
+      numThreadsSpecified = 1;
+      #endif
+      for (; nt < numThreadsSpecified; nt *= 2)
+        numThreadsVector.Add(nt);
+      numThreadsVector.Add(numThreadsSpecified);
+    }
+
+    size_t dataSize = (size_t)1 << kJsonBenchSizeLog;
+    if (startDicLog_Defined)
+    {
+      if (startDicLog >= sizeof(size_t) * 8 - 1)
+        return E_INVALIDARG;
+      dataSize = (size_t)1 << startDicLog;
+    }
+
+    AString methodMask = method.MethodName;
+    if (methodMask.IsEmpty())
+      methodMask = "*";
+    else if (!method.PropsString.IsEmpty())
+    {
+      methodMask.Add_Colon();
+      methodMask += GetAnsiString(method.PropsString);
+    }
+
+    {
+      AString s;
+      s += "{";
+      f.Print(s);
+      f.NewLine();
+      s = " ";
+      Json_AddString(s, "version", MY_VERSION_CPU);
+      s += ',';
+      f.Print(s);
+      f.NewLine();
+      {
+        AString cpuName, registers;
+        GetCpuName_MultiLine(cpuName, registers);
+        cpuName.Replace('\n', ' ');
+        cpuName.Trim();
+        s = " ";
+        Json_AddString(s, "cpu", cpuName);
+        s += ',';
+        f.Print(s);
+        f.NewLine();
+      }
+      s = " ";
+      Json_AddUInt64(s, "hardware_threads", numCPUs);
+      s += ',';
+      if (ramSize_Defined)
+        Json_AddUInt64(s, "ram", ramSize);
+      else
+        Json_AddNull(s, "ram");
+      s += ',';
+      Json_AddUInt64(s, "time_ms", testTimeMs);
+      s += ',';
+      f.Print(s);
+      f.NewLine();
+      f.Print(" \"results\":[");
+      f.NewLine();
+    }
+
+    RINOK(JsonBench(
+        EXTERNAL_CODECS_LOC_VARS
+        methodMask,
+        complexInCommands,
+      #ifndef Z7_ST
+        &affinityMode,
+      #endif
+        numThreadsVector,
+        dataSize,
+        use_fileData ? (const Byte *)fileDataBuffer : NULL,
+        fileDataBuffer.Size(),
+        f))
+
+    f.Print(" ]");
+    f.NewLine();
+    f.Print("}");
+    f.NewLine();
+    return S_OK;
+  }
+
   if (printCallback)
   {
     AString s;
@@ -5024,3 +5526,197 @@ HRESULT Bench(
   }
   return S_OK;
 }
+
+
+
+// ---------- AutoTune ----------
+
+#define AUTO_TUNE_7Z    (1 << 0)
+#define AUTO_TUNE_ZIP   (1 << 1)
+// the speed of method in 7z archive scales with number of threads
+#define AUTO_TUNE_MT_7Z (1 << 2)
+
+struct CAutoTuneMethod
+{
+  const char *Name;
+  Byte Level;
+  Byte Flags;
+};
+
+// the levels of each method are sorted from fast to strong
+static const CAutoTuneMethod g_AutoTune[] =
+{
+  { "Copy",    0, AUTO_TUNE_7Z | AUTO_TUNE_ZIP | AUTO_TUNE_MT_7Z },
+  { "Deflate", 1, AUTO_TUNE_7Z | AUTO_TUNE_ZIP },
+  { "Deflate", 5, AUTO_TUNE_7Z | AUTO_TUNE_ZIP },
+  { "Deflate", 9, AUTO_TUNE_ZIP },
+  { "LZMA2",   1, AUTO_TUNE_7Z | AUTO_TUNE_MT_7Z },
+  { "LZMA2",   3, AUTO_TUNE_7Z | AUTO_TUNE_MT_7Z },
+  { "LZMA2",   5, AUTO_TUNE_7Z | AUTO_TUNE_MT_7Z },
+  { "LZMA2",   7, AUTO_TUNE_7Z | AUTO_TUNE_MT_7Z },
+  { "LZMA2",   9, AUTO_TUNE_7Z | AUTO_TUNE_MT_7Z },
+  { "LZMA",    5, AUTO_TUNE_ZIP },
+  { "PPMd",    5, AUTO_TUNE_7Z | AUTO_TUNE_ZIP },
+  { "PPMd",    9, AUTO_TUNE_7Z | AUTO_TUNE_ZIP }
+};
+
+
+/* it compresses (data) in one thread, and it checks the result with decoder.
+   (encodeTime) is in GetFreq() units. */
+
+static HRESULT AutoTune_Trial(
+    DECL_EXTERNAL_CODECS_LOC_VARS
+    const Byte *data, size_t size,
+    const CAutoTuneMethod &m,
+    UInt64 &packSize, UInt64 &encodeTime)
+{
+  CMethodId methodId;
+  UInt32 numStreams;
+  bool isFilter;
+  if (FindMethod_Index(EXTERNAL_CODECS_LOC_VARS
+      AString(m.Name), true, methodId, numStreams, isFilter) < 0
+      || isFilter || numStreams != 1)
+    return E_NOTIMPL;
+
+  CMyComPtr<ICompressCoder> encoder;
+  CMyComPtr<ICompressCoder> decoder;
+  RINOK(CreateCoder_Id(EXTERNAL_CODECS_LOC_VARS methodId, true, encoder))
+  RINOK(CreateCoder_Id(EXTERNAL_CODECS_LOC_VARS methodId, false, decoder))
+  if (!encoder || !decoder)
+    return E_NOTIMPL;
+
+  COneMethodInfo method;
+  method.MethodName = m.Name;
+  if (m.Level != 0)
+    method.AddProp_Level(m.Level);
+  // we test one thread of LZMA and LZMA2 encoders
+  if (methodId == 0x030101 || methodId == 0x21)
+    method.AddProp_NumThreads(1);
+
+  {
+    CMyComPtr<ICompressSetCoderProperties> scp;
+    encoder.QueryInterface(IID_ICompressSetCoderProperties, &scp);
+    if (scp)
+    {
+      const UInt64 reduceSize = size;
+      RINOK(method.SetCoderProps(scp, &reduceSize))
+    }
+  }
+
+  CMyComPtr2_Create<ISequentialOutStream, CDynBufSeqOutStream> propStream;
+  {
+    CMyComPtr<ICompressWriteCoderProperties> writeCoderProps;
+    encoder.QueryInterface(IID_ICompressWriteCoderProperties, &writeCoderProps);
+    if (writeCoderProps)
+    {
+      RINOK(writeCoderProps->WriteCoderProperties(propStream))
+    }
+  }
+
+  CMyComPtr2_Create<ISequentialInStream, CBenchmarkInStream> inStream;
+  CMyComPtr2_Create<ISequentialOutStream, CDynBufSeqOutStream> outStream;
+  {
+    // fast methods are repeated to reduce the timer error
+    const UInt64 minTime = GetFreq() / 8;
+    UInt64 numIterations = 0;
+    const UInt64 startTime = GetTimeCount();
+    do
+    {
+      inStream->Init(data, size);
+      outStream->Init();
+      RINOK(encoder->Code(inStream, outStream, NULL, NULL, NULL))
+      encodeTime = GetTimeCount() - startTime;
+    }
+    while (++numIterations < 16 && encodeTime < minTime);
+    encodeTime /= numIterations;
+  }
+  packSize = outStream->GetSize();
+
+  {
+    CMyComPtr<ICompressSetDecoderProperties2> setDecProps;
+    decoder.QueryInterface(IID_ICompressSetDecoderProperties2, &setDecProps);
+    if (setDecProps)
+    {
+      RINOK(setDecProps->SetDecoderProperties2(
+          propStream->GetBuffer(), (UInt32)propStream->GetSize()))
+    }
+  }
+  CMyComPtr2_Create<ISequentialOutStream, CCrcOutStream> crcStream;
+  crcStream->Init();
+  inStream->Init(outStream->GetBuffer(), outStream->GetSize());
+  const UInt64 outSize = size;
+  RINOK(decoder->Code(inStream, crcStream, NULL, &outSize, NULL))
+  if (crcStream->Pos != size
+      || CRC_GET_DIGEST(crcStream->Crc) != CrcCalc(data, size))
+    return S_FALSE;
+  return S_OK;
+}
+
+
+HRESULT AutoTune_Method(
+    DECL_EXTERNAL_CODECS_LOC_VARS
+    const Byte *data, size_t size,
+    const CAutoTuneParams &params,
+    CAutoTuneResult &res)
+{
+  const unsigned mask = params.ZipMode ? AUTO_TUNE_ZIP : AUTO_TUNE_7Z;
+  const UInt64 freq = GetFreq();
+  bool found = false;   // (res) meets the target
+  bool defined = false;
+  const char *skipName = NULL;
+  res.Level = 0;
+  res.Speed = 0;
+  res.PackSize = 0;
+  res.UnpackSize = size;
+
+  for (unsigned i = 0; i < Z7_ARRAY_SIZE(g_AutoTune); i++)
+  {
+    const CAutoTuneMethod &m = g_AutoTune[i];
+    if ((m.Flags & mask) == 0)
+      continue;
+    // the next levels of slow method are slower
+    if (skipName && strcmp(skipName, m.Name) == 0)
+      continue;
+    skipName = NULL;
+    
+    UInt64 packSize = 0, encodeTime = 0;
+    const HRESULT hres = AutoTune_Trial(EXTERNAL_CODECS_LOC_VARS
+        data, size, m, packSize, encodeTime);
+    if (hres == E_NOTIMPL || hres == S_FALSE)
+      continue;
+    RINOK(hres)
+
+    if (encodeTime == 0)
+      encodeTime = 1;
+    UInt64 speed = MyMultDiv64(size, freq, encodeTime);
+    if (params.ZipMode || (m.Flags & AUTO_TUNE_MT_7Z))
+      speed *= params.NumThreads;
+
+    bool ok;
+    bool better;
+    if (params.Ratio != 0)
+    {
+      ok = (packSize * 100 <= (UInt64)size * params.Ratio);
+      better = ok ? (!found || speed > res.Speed) : (!found && packSize < res.PackSize);
+    }
+    else
+    {
+      ok = (speed >= params.Speed);
+      better = ok ? (!found || packSize < res.PackSize) : (!found && speed > res.Speed);
+      if (!ok)
+        skipName = m.Name;
+    }
+    if (!defined || better)
+    {
+      res.MethodName = m.Name;
+      res.Level = m.Level;
+      res.Speed = speed;
+      res.PackSize = packSize;
+      res.UnpackSize = size;
+      if (ok)
+        found = true;
+      defined = true;
+    }
+  }
+  return defined ? S_OK : E_NOTIMPL;
+}
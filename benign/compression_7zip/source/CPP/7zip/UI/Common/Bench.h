@@ -106,6 +106,39 @@ HRESULT Bench(
     bool multiDict,
     IBenchFreqCallback *freqCallback = NULL);
 
+/*
+AutoTune_Method() runs trial compressions of (data) sample with
+some methods and levels, and it selects the method for archive:
+  (Speed != 0) : the best ratio, if speed >= (Speed) bytes/sec
+  (Ratio != 0) : the fastest method, if (packSize <= unpackSize * Ratio / 100)
+If no method reaches the target, it selects the fastest method or the best ratio.
+*/
+
+struct CAutoTuneParams
+{
+  UInt64 Speed;
+  UInt32 Ratio;
+  UInt32 NumThreads;
+  bool ZipMode;
+
+  CAutoTuneParams(): Speed(0), Ratio(0), NumThreads(1), ZipMode(false) {}
+};
+
+struct CAutoTuneResult
+{
+  AString MethodName;
+  UInt32 Level;
+  UInt64 Speed;       // estimated speed for (NumThreads) threads
+  UInt64 PackSize;    // for sample
+  UInt64 UnpackSize;  // for sample
+};
+
+HRESULT AutoTune_Method(
+    DECL_EXTERNAL_CODECS_LOC_VARS
+    const Byte *data, size_t size,
+    const CAutoTuneParams &params,
+    CAutoTuneResult &res);
+
 AString GetProcessThreadsInfo(const NWindows::NSystem::CProcessAffinity &ti);
 
 void GetSysInfo(AString &s1, AString &s2);
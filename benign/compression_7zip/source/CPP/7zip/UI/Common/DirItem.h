@@ -228,19 +228,28 @@ struct CArcTime
 };
 
 
+/*
+CDirItem doesn't own heap memory.
+The name of item is stored in the shared buffer of names (CDirItems::Names),
+and reparse data is stored in (CDirItems::ReparseBufs).
+So CDirItems::Items is one array of items without per-item allocations.
+The fields of CFileInfoBase (times, dev/ino/rdev) are still stored in each item,
+because the code of update callbacks uses CDirItem as CFileInfoBase.
+*/
+
 struct CDirItem: public NWindows::NFile::NFind::CFileInfoBase
 {
-  UString Name;
-  
+  UInt32 NameOffset;  // offset of name in (CDirItems::Names)
+
  #ifndef UNDER_CE
-  CByteBuffer ReparseData;
+  int ReparseIndex;   // index in (CDirItems::ReparseBufs) or (-1)
 
  #ifdef _WIN32
   // UString ShortName;
-  CByteBuffer ReparseData2; // fixed (reduced) absolute links for WIM format
-  bool AreReparseData() const { return ReparseData.Size() != 0 || ReparseData2.Size() != 0; }
+  int ReparseIndex2;  // fixed (reduced) absolute links for WIM format
+  bool AreReparseData() const { return ReparseIndex >= 0 || ReparseIndex2 >= 0; }
  #else
-  bool AreReparseData() const { return ReparseData.Size() != 0; }
+  bool AreReparseData() const { return ReparseIndex >= 0; }
  #endif // _WIN32
 
  #endif // !UNDER_CE
@@ -263,7 +272,14 @@ struct CDirItem: public NWindows::NFile::NFind::CFileInfoBase
   // bool Attrib_IsDefined;
 
   CDirItem():
-      PhyParent(-1)
+      NameOffset(0)
+   #ifndef UNDER_CE
+    , ReparseIndex(-1)
+   #ifdef _WIN32
+    , ReparseIndex2(-1)
+   #endif
+   #endif
+    , PhyParent(-1)
     , LogParent(-1)
     , SecureIndex(-1)
    #ifdef _WIN32
@@ -276,12 +292,15 @@ struct CDirItem: public NWindows::NFile::NFind::CFileInfoBase
   }
 
 
-  CDirItem(const NWindows::NFile::NFind::CFileInfo &fi,
+  CDirItem(const NWindows::NFile::NFind::CFileInfoBase &fi,
       int phyParent, int logParent, int secureIndex):
     CFileInfoBase(fi)
-    , Name(fs2us(fi.Name))
-   #if defined(_WIN32) && !defined(UNDER_CE)
-    // , ShortName(fs2us(fi.ShortName))
+    , NameOffset(0)
+   #ifndef UNDER_CE
+    , ReparseIndex(-1)
+   #ifdef _WIN32
+    , ReparseIndex2(-1)
+   #endif
    #endif
     , PhyParent(phyParent)
     , LogParent(logParent)
@@ -295,6 +314,28 @@ struct CDirItem: public NWindows::NFile::NFind::CFileInfoBase
 };
 
 
+/* CDirItemNames is the buffer of zero-terminated names.
+   The name is addressed by 32-bit offset (in characters). */
+
+class CDirItemNames
+{
+  wchar_t *_buf;
+  size_t _size;
+  size_t _capacity;
+
+  void Grow(size_t num);
+  Z7_CLASS_NO_COPY(CDirItemNames)
+public:
+  CDirItemNames(): _buf(NULL), _size(0), _capacity(0) {}
+  ~CDirItemNames() { delete []_buf; }
+
+  UInt32 Add(const wchar_t *s, unsigned len);
+  const wchar_t *Get(UInt32 offset) const { return _buf ? _buf + offset : L""; }
+  size_t Size() const { return _size; }
+  void ReserveDown();
+};
+
+
 
 class CDirItems
 {
@@ -302,12 +343,20 @@ class CDirItems
   CIntVector PhyParents;
   CIntVector LogParents;
 
-  UString GetPrefixesPath(const CIntVector &parents, int index, const UString &name) const;
+ #ifndef UNDER_CE
+  const CByteBuffer _emptyReparse;
+ #endif
+
+  UString GetPrefixesPath(const CIntVector &parents, int index, const wchar_t *name) const;
 
   HRESULT EnumerateDir(int phyParent, int logParent, const FString &phyPrefix);
 
 public:
-  CObjectVector<CDirItem> Items;
+  CRecordVector<CDirItem> Items;
+  CDirItemNames Names;
+ #ifndef UNDER_CE
+  CObjectVector<CByteBuffer> ReparseBufs;
+ #endif
 
   bool SymLinks;
   bool ScanAltStreams;
@@ -324,9 +373,19 @@ public:
 
   CDirItemsStat Stat;
 
+  const wchar_t *GetItemName(const CDirItem &di) const { return Names.Get(di.NameOffset); }
+
   #if !defined(UNDER_CE)
   HRESULT SetLinkInfo(CDirItem &dirItem, const NWindows::NFile::NFind::CFileInfo &fi,
       const FString &phyPrefix);
+
+  // it returns empty buffer, if there are no reparse data
+  const CByteBuffer &Get_ReparseData(const CDirItem &di) const
+    { return di.ReparseIndex < 0 ? _emptyReparse : ReparseBufs[(unsigned)di.ReparseIndex]; }
+  #ifdef _WIN32
+  const CByteBuffer &Get_ReparseData2(const CDirItem &di) const
+    { return di.ReparseIndex2 < 0 ? _emptyReparse : ReparseBufs[(unsigned)di.ReparseIndex2]; }
+  #endif
   #endif
 
  #if defined(_WIN32) && !defined(UNDER_CE)
@@ -357,6 +416,8 @@ public:
 
   void AddDirFileInfo(int phyParent, int logParent, int secureIndex,
       const NWindows::NFile::NFind::CFileInfo &fi);
+  // it adds item that is not from enumeration (stdin stream or new folder)
+  void AddItem(const CDirItem &di, const UString &name);
 
   HRESULT AddError(const FString &path, DWORD errorCode);
   HRESULT AddError(const FString &path);
@@ -62,17 +62,80 @@ static bool FindFile_KeepDots(NFile::NFind::CFileInfo &fi, const FString &path,
 }
 
 
+static const size_t kNamesBufStep = (size_t)1 << 16;
+
+void CDirItemNames::Grow(size_t num)
+{
+  size_t newCap = _capacity + (_capacity >> 1) + kNamesBufStep;
+  if (newCap < _size + num)
+    newCap = _size + num;
+  // offsets are 32-bit
+  if (newCap > ((size_t)1 << 32) - 1)
+  {
+    newCap = ((size_t)1 << 32) - 1;
+    if (newCap < _size + num)
+      throw CNewException();
+  }
+  wchar_t *newBuf = new wchar_t[newCap];
+  if (_size != 0)
+    wmemcpy(newBuf, _buf, _size);
+  delete []_buf;
+  _buf = newBuf;
+  _capacity = newCap;
+}
+
+UInt32 CDirItemNames::Add(const wchar_t *s, unsigned len)
+{
+  if (_size == 0)
+  {
+    // offset (0) is reserved for empty name
+    if (_capacity == 0)
+      Grow(len + 2);
+    _buf[_size++] = 0;
+  }
+  if (len == 0)
+    return 0;
+  if (_capacity - _size <= len)
+    Grow(len + 1);
+  const size_t offset = _size;
+  wmemcpy(_buf + offset, s, len);
+  _buf[offset + len] = 0;
+  _size = offset + len + 1;
+  return (UInt32)offset;
+}
+
+void CDirItemNames::ReserveDown()
+{
+  if (_size == _capacity)
+    return;
+  wchar_t *newBuf = NULL;
+  if (_size != 0)
+  {
+    newBuf = new wchar_t[_size];
+    wmemcpy(newBuf, _buf, _size);
+  }
+  delete []_buf;
+  _buf = newBuf;
+  _capacity = _size;
+}
+
+
+void CDirItems::AddItem(const CDirItem &di, const UString &name)
+{
+  CDirItem di2 = di;
+  di2.NameOffset = Names.Add(name, name.Len());
+  Items.Add(di2);
+}
+
 void CDirItems::AddDirFileInfo(int phyParent, int logParent, int secureIndex,
     const NFind::CFileInfo &fi)
 {
-  /*
-  CDirItem di(fi);
-  di.PhyParent = phyParent;
-  di.LogParent = logParent;
-  di.SecureIndex = secureIndex;
-  Items.Add(di);
-  */
-  VECTOR_ADD_NEW_OBJECT (Items, CDirItem(fi, phyParent, logParent, secureIndex))
+  {
+    const UString name = fs2us(fi.Name);
+    CDirItem di(fi, phyParent, logParent, secureIndex);
+    di.NameOffset = Names.Add(name, name.Len());
+    Items.Add(di);
+  }
   
   if (fi.IsDir())
     Stat.NumDirs++;
@@ -117,10 +180,11 @@ HRESULT CDirItems::ScanProgress(const FString &dirPath)
   return S_OK;
 }
 
-UString CDirItems::GetPrefixesPath(const CIntVector &parents, int index, const UString &name) const
+UString CDirItems::GetPrefixesPath(const CIntVector &parents, int index, const wchar_t *name) const
 {
   UString path;
-  unsigned len = name.Len();
+  const unsigned nameLen = MyStringLen(name);
+  unsigned len = nameLen;
   
   int i;
   for (i = index; i >= 0; i = parents[(unsigned)i])
@@ -128,8 +192,8 @@ UString CDirItems::GetPrefixesPath(const CIntVector &parents, int index, const U
   
   wchar_t *p = path.GetBuf_SetEnd(len) + len;
   
-  p -= name.Len();
-  wmemcpy(p, (const wchar_t *)name, name.Len());
+  p -= nameLen;
+  wmemcpy(p, name, nameLen);
   
   for (i = index; i >= 0; i = parents[(unsigned)i])
   {
@@ -144,13 +208,13 @@ UString CDirItems::GetPrefixesPath(const CIntVector &parents, int index, const U
 FString CDirItems::GetPhyPath(unsigned index) const
 {
   const CDirItem &di = Items[index];
-  return us2fs(GetPrefixesPath(PhyParents, di.PhyParent, di.Name));
+  return us2fs(GetPrefixesPath(PhyParents, di.PhyParent, GetItemName(di)));
 }
 
 UString CDirItems::GetLogPath(unsigned index) const
 {
   const CDirItem &di = Items[index];
-  return GetPrefixesPath(LogParents, di.LogParent, di.Name);
+  return GetPrefixesPath(LogParents, di.LogParent, GetItemName(di));
 }
 
 void CDirItems::ReserveDown()
@@ -159,6 +223,10 @@ void CDirItems::ReserveDown()
   PhyParents.ReserveDown();
   LogParents.ReserveDown();
   Items.ReserveDown();
+  Names.ReserveDown();
+ #ifndef UNDER_CE
+  ReparseBufs.ReserveDown();
+ #endif
 }
 
 unsigned CDirItems::AddPrefix(int phyParent, int logParent, const UString &prefix)
@@ -581,16 +649,20 @@ HRESULT CDirItems::SetLinkInfo(CDirItem &dirItem, const NFind::CFileInfo &fi,
       return S_OK;
 
   const FString path = phyPrefix + fi.Name;
-  CByteBuffer &buf = dirItem.ReparseData;
+  const unsigned bufIndex = ReparseBufs.Size();
+  CByteBuffer &buf = ReparseBufs.AddNew();
   if (NIO::GetReparseData(path, buf))
   {
-    // if (dirItem.ReparseData.Size() != 0)
     Stat.FilesSize -= fi.Size;
+    if (buf.Size() != 0)
+      dirItem.ReparseIndex = (int)bufIndex;
+    else
+      ReparseBufs.DeleteBack();
     return S_OK;
   }
 
   DWORD res = ::GetLastError();
-  buf.Free();
+  ReparseBufs.DeleteBack();
   return AddError(path, res);
 }
 
@@ -666,7 +738,7 @@ static HRESULT EnumerateForItem(
   {
     CDirItem &dirItem = dirItems.Items[(unsigned)dirItemIndex];
     RINOK(dirItems.SetLinkInfo(dirItem, fi, phyPrefix))
-    if (dirItem.ReparseData.Size() != 0)
+    if (dirItem.ReparseIndex >= 0)
       return S_OK;
   }
   
@@ -924,7 +996,7 @@ static HRESULT EnumerateDirItems(
         {
           CDirItem &dirItem = dirItems.Items.Back();
           RINOK(dirItems.SetLinkInfo(dirItem, fi, phyPrefix))
-          if (dirItem.ReparseData.Size() != 0)
+          if (dirItem.ReparseIndex >= 0)
             continue;
         }
         
@@ -1235,16 +1307,17 @@ HRESULT CDirItems::FillFixedReparse()
     }
 
     // (SymLinks == true)
-    if (item.ReparseData.Size() == 0)
+    if (item.ReparseIndex < 0)
       continue;
+    const CByteBuffer &reparse = ReparseBufs[(unsigned)item.ReparseIndex];
     // if (item.Size == 0)
     {
       // 20.03: we use Reparse Data instead of real data
-      item.Size = item.ReparseData.Size();
+      item.Size = reparse.Size();
     }
     
     CReparseAttr attr;
-    if (!attr.Parse(item.ReparseData, item.ReparseData.Size()))
+    if (!attr.Parse(reparse, reparse.Size()))
     {
       const FString phyPath = GetPhyPath(i);
       AddError(phyPath, attr.ErrorCode);
@@ -1299,7 +1372,7 @@ HRESULT CDirItems::FillFixedReparse()
     UString newLink = prefix.Left(rootPrefixSize);
     newLink += link.Ptr(prefix.Len());
 
-    CByteBuffer &data = item.ReparseData2;
+    CByteBuffer data;
 /*
     if (isWSL)
     {
@@ -1311,7 +1384,7 @@ HRESULT CDirItems::FillFixedReparse()
       FillLinkData_WinLink(data, newLink, !attr.IsMountPoint());
     if (data.Size() == 0)
       continue;
-    // item.ReparseData2 = data;
+    item.ReparseIndex2 = (int)ReparseBufs.Add(data);
   }
   return S_OK;
 }
@@ -1597,6 +1670,7 @@ static void ConvertToLongNames(const UString &prefix, NWildcard::CCensorNode &no
         j++;
     }
   }
+  node.Reset_Indexes();
   for (i = 0; i < node.SubNodes.Size(); i++)
   {
     NWildcard::CCensorNode &nextNode = node.SubNodes[i];
@@ -11,6 +11,7 @@
 
 #include "../../Common/FileStreams.h"
 #include "../../Common/ProgressUtils.h"
+#include "../../Common/StageStats.h"
 #include "../../Common/StreamObjects.h"
 #include "../../Common/StreamUtils.h"
 
@@ -129,6 +130,7 @@ void CHashBundle::InitForNewFile()
 
 void CHashBundle::Update(const void *data, UInt32 size)
 {
+  NStageStats::CTimer stageTimer(NStageStats::kStage_Hash, &size);
   CurSize += size;
   FOR_VECTOR (i, Hashers)
     Hashers[i].Hasher->Update(data, size);
@@ -478,7 +480,7 @@ HRESULT HashCalc(
     CDirItem di;
     if (!di.SetAs_StdInFile())
       return GetLastError_noZero_HRESULT();
-    dirItems.Items.Add(di);
+    dirItems.AddItem(di, UString());
   }
   else
   {
@@ -570,11 +572,12 @@ HRESULT HashCalc(
 
       #ifndef UNDER_CE
       // if (di.AreReparseData())
-      if (di.ReparseData.Size() != 0)
+      if (di.ReparseIndex >= 0)
       {
+        const CByteBuffer &reparse = dirItems.Get_ReparseData(di);
         CBufInStream *inStreamSpec = new CBufInStream();
         inStream = inStreamSpec;
-        inStreamSpec->Init(di.ReparseData, di.ReparseData.Size());
+        inStreamSpec->Init(reparse, reparse.Size());
       }
       else
       #endif
@@ -619,6 +622,14 @@ HRESULT HashCalc(
     
     if (!isDir)
     {
+      // for memory mapped file we pass mapped data to hashers without copying
+      const Byte *directData = NULL;
+      size_t directSize = 0;
+      {
+        Z7_DECL_CMyComPtr_QI_FROM(IStreamDirectBuf, directBuf, inStream)
+        if (directBuf && directBuf->GetDirectBuf(&directData, &directSize) != S_OK)
+          directData = NULL;
+      }
       for (UInt32 step = 0;; step++)
       {
         if ((step & 0xFF) == 0)
@@ -627,10 +638,21 @@ HRESULT HashCalc(
           RINOK(callback->SetCompleted(&completeValue))
         }
         UInt32 size;
-        RINOK(inStream->Read(buf, kBufSize, &size))
+        const Byte *data = (const Byte *)(void *)buf;
+        if (directData)
+        {
+          size = (UInt32)MyMin(directSize, (size_t)kBufSize);
+          data = directData;
+          directData += size;
+          directSize -= size;
+        }
+        else
+        {
+          RINOK(inStream->Read(buf, kBufSize, &size))
+        }
         if (size == 0)
           break;
-        hb.Update(buf, size);
+        hb.Update(data, size);
         fileSize += size;
         completeValue += size;
       }
@@ -2130,6 +2130,7 @@ HRESULT CArc::OpenStream2(const COpenOptions &op)
     // this code is better for full file archives than Parser's code.
 
     CByteBuffer byteBuffer;
+    const Byte *startBuf;
     bool endOfFile = false;
     size_t processedSize;
     {
@@ -2139,10 +2140,27 @@ HRESULT CArc::OpenStream2(const COpenOptions &op)
         bufSize = (size_t)fileSize;
         endOfFile = true;
       }
-      byteBuffer.Alloc(bufSize);
       RINOK(InStream_SeekToBegin(op.stream))
-      processedSize = bufSize;
-      RINOK(ReadStream(op.stream, byteBuffer, &processedSize))
+      const Byte *directData = NULL;
+      size_t directSize = 0;
+      {
+        Z7_DECL_CMyComPtr_QI_FROM(IStreamDirectBuf, directBuf, op.stream)
+        if (directBuf && directBuf->GetDirectBuf(&directData, &directSize) != S_OK)
+          directData = NULL;
+      }
+      if (directData)
+      {
+        // memory mapped file: we check signatures without copying
+        processedSize = MyMin(bufSize, directSize);
+        startBuf = directData;
+      }
+      else
+      {
+        byteBuffer.Alloc(bufSize);
+        processedSize = bufSize;
+        RINOK(ReadStream(op.stream, byteBuffer, &processedSize))
+        startBuf = byteBuffer;
+      }
       if (processedSize == 0)
         return S_FALSE;
       if (processedSize < bufSize)
@@ -2174,7 +2192,7 @@ HRESULT CArc::OpenStream2(const COpenOptions &op)
 
       if (ai.IsArcFunc)
       {
-        UInt32 isArcRes = ai.IsArcFunc(byteBuffer, processedSize);
+        UInt32 isArcRes = ai.IsArcFunc(startBuf, processedSize);
         if (isArcRes == k_IsArc_Res_NO)
           continue;
         if (isArcRes == k_IsArc_Res_NEED_MORE && endOfFile)
@@ -2202,7 +2220,7 @@ HRESULT CArc::OpenStream2(const COpenOptions &op)
             if (!endOfFile)
               needCheck = true;
           }
-          else if (TestSignature(sig, byteBuffer + ai.SignatureOffset, sig.Size()))
+          else if (TestSignature(sig, startBuf + ai.SignatureOffset, sig.Size()))
             break;
         }
         if (k != ai.Signatures.Size())
@@ -0,0 +1,270 @@
+// TrainDict.cpp
+
+#include "StdAfx.h"
+
+#include "../../../../C/CpuArch.h"
+
+#include "../../../Common/MyBuffer.h"
+
+#include "../../../Windows/FileIO.h"
+
+#include "../../Common/FileStreams.h"
+#include "../../Common/StreamUtils.h"
+
+#include "EnumDirItems.h"
+#include "TrainDict.h"
+
+using namespace NWindows;
+
+/*
+The builder selects the segments of sample data that contain most frequent
+strings (similar to "cover" algorithm of original zstd dictionary builder):
+  - it counts the frequencies of all (k_Dmer_Len)-byte strings (dmers) in samples
+    with hash table.
+  - the samples are divided to epochs. In each pass over epochs it selects
+    the segment of (k_SegmentSize) bytes in epoch that has largest sum of
+    frequencies of different dmers. The frequencies of dmers of selected segment
+    are cleared, so next segments will contain another strings.
+  - the segments are written from the end of dictionary, so the best segments
+    are closest to data and they will be encoded with smallest offsets.
+*/
+
+static const unsigned k_Dmer_Len = 8;
+static const unsigned k_HashBits = 20;
+static const UInt32 k_SegmentSize = 1024;
+static const unsigned k_NumPasses = 4;
+
+static const UInt32 k_SampleSizeMax = (UInt32)1 << 17;
+static const size_t k_SamplesSizeMax = (size_t)1 << 27;
+
+#define DMER_HASH(p)  ((UInt32)((GetUi64(p) * 0xCF1BBCDCB7A56463) >> (64 - k_HashBits)))
+
+struct CSegment
+{
+  size_t Begin;
+  size_t End;
+  UInt64 Score;
+};
+
+class CDictBuilder
+{
+  const Byte *_data;
+  CObjArray<UInt32> _freqs;
+  CObjArray<UInt16> _segFreqs;
+
+  UInt32 GetHash(size_t pos) const { return DMER_HASH(_data + pos); }
+  void SelectSegment(size_t begin, size_t end, CSegment &seg);
+public:
+  size_t Build(const Byte *data, size_t size, Byte *dict, size_t dictSize);
+};
+
+
+// (end) is the limit for dmer start positions
+
+void CDictBuilder::SelectSegment(size_t begin, size_t end, CSegment &seg)
+{
+  const size_t numDmersMax = k_SegmentSize - k_Dmer_Len + 1;
+  UInt32 *freqs = _freqs;
+  UInt16 *segFreqs = _segFreqs;
+  UInt64 score = 0;
+  size_t winBegin = begin;
+  seg.Begin = begin;
+  seg.End = begin;
+  seg.Score = 0;
+
+  for (size_t pos = begin; pos < end; pos++)
+  {
+    const UInt32 h = GetHash(pos);
+    if (segFreqs[h]++ == 0)
+      score += freqs[h];
+    if (pos - winBegin == numDmersMax)
+    {
+      const UInt32 h2 = GetHash(winBegin);
+      if (--segFreqs[h2] == 0)
+        score -= freqs[h2];
+      winBegin++;
+    }
+    if (score > seg.Score)
+    {
+      seg.Score = score;
+      seg.Begin = winBegin;
+      seg.End = pos + 1;
+    }
+  }
+  for (size_t pos = winBegin; pos < end; pos++)
+    segFreqs[GetHash(pos)] = 0;
+
+  if (seg.Score == 0)
+    return;
+  // we trim the dmers that are not useful
+  while (seg.Begin < seg.End && freqs[GetHash(seg.Begin)] == 0)
+    seg.Begin++;
+  while (seg.Begin < seg.End && freqs[GetHash(seg.End - 1)] == 0)
+    seg.End--;
+  for (size_t pos = seg.Begin; pos < seg.End; pos++)
+    freqs[GetHash(pos)] = 0;
+}
+
+
+// it returns the size of dictionary that was written to the end of (dict) buffer
+
+size_t CDictBuilder::Build(const Byte *data, size_t size, Byte *dict, size_t dictSize)
+{
+  if (size < k_SegmentSize)
+    return 0;
+  _data = data;
+  const size_t numDmers = size - k_Dmer_Len + 1;
+  _freqs.Alloc((size_t)1 << k_HashBits);
+  _segFreqs.Alloc((size_t)1 << k_HashBits);
+  memset(_freqs, 0, sizeof(UInt32) << k_HashBits);
+  memset(_segFreqs, 0, sizeof(UInt16) << k_HashBits);
+  {
+    UInt32 *freqs = _freqs;
+    for (size_t pos = 0; pos < numDmers; pos++)
+      freqs[GetHash(pos)]++;
+  }
+
+  size_t numEpochs = dictSize / k_SegmentSize / k_NumPasses;
+  if (numEpochs == 0)
+    numEpochs = 1;
+  size_t epochSize = numDmers / numEpochs;
+  const size_t kEpochSizeMin = (size_t)k_SegmentSize * 10;
+  if (epochSize < kEpochSizeMin)
+  {
+    epochSize = kEpochSizeMin;
+    if (epochSize > numDmers)
+      epochSize = numDmers;
+    numEpochs = numDmers / epochSize;
+  }
+
+  size_t rem = dictSize;
+  size_t numZeroEpochs = 0;
+  for (size_t epoch = 0; rem != 0; epoch = (epoch + 1) % numEpochs)
+  {
+    const size_t begin = epoch * epochSize;
+    CSegment seg;
+    SelectSegment(begin, begin + epochSize, seg);
+    if (seg.Score == 0)
+    {
+      if (++numZeroEpochs >= numEpochs)
+        break;
+      continue;
+    }
+    numZeroEpochs = 0;
+    size_t segSize = seg.End - seg.Begin + k_Dmer_Len - 1;
+    if (segSize > rem)
+      segSize = rem;
+    rem -= segSize;
+    memcpy(dict + rem, data + seg.Begin, segSize);
+  }
+  return dictSize - rem;
+}
+
+
+HRESULT TrainDict(
+    const NWildcard::CCensor &censor,
+    const CTrainDictOptions &options,
+    const FString &dictPath,
+    CTrainDictStat &stat,
+    AString &errorInfo,
+    IHashCallbackUI *callback)
+{
+  CDirItems dirItems;
+  dirItems.Callback = callback;
+  {
+    RINOK(callback->StartScanning())
+
+    dirItems.SymLinks = options.SymLinks.Val;
+    dirItems.ExcludeDirItems = censor.ExcludeDirItems;
+    dirItems.ExcludeFileItems = censor.ExcludeFileItems;
+    dirItems.ShareForWrite = options.OpenShareForWrite;
+
+    const HRESULT res = EnumerateItems(censor,
+        options.PathMode,
+        UString(),
+        dirItems);
+    if (res != S_OK)
+    {
+      if (res != E_ABORT)
+        errorInfo = "Scanning error";
+      return res;
+    }
+    RINOK(callback->FinishScanning(dirItems.Stat))
+  }
+
+  size_t samplesSize = 0;
+  {
+    FOR_VECTOR (i, dirItems.Items)
+    {
+      const CDirItem &di = dirItems.Items[i];
+      if (di.IsDir())
+        continue;
+      UInt64 size = di.Size;
+      if (size > k_SampleSizeMax)
+        size = k_SampleSizeMax;
+      samplesSize += (size_t)size;
+      if (samplesSize >= k_SamplesSizeMax)
+      {
+        samplesSize = k_SamplesSizeMax;
+        break;
+      }
+    }
+  }
+
+  RINOK(callback->SetTotal(samplesSize))
+
+  CByteBuffer samples(samplesSize);
+  size_t pos = 0;
+
+  FOR_VECTOR (i, dirItems.Items)
+  {
+    const CDirItem &di = dirItems.Items[i];
+    if (di.IsDir())
+      continue;
+    if (pos == samplesSize)
+      break;
+    const FString phyPath = dirItems.GetPhyPath(i);
+    CInFileStream *inStreamSpec = new CInFileStream;
+    CMyComPtr<ISequentialInStream> inStream(inStreamSpec);
+    if (!inStreamSpec->OpenShared(phyPath, options.OpenShareForWrite))
+    {
+      RINOK(callback->OpenFileError(phyPath, ::GetLastError()))
+      continue;
+    }
+    size_t size = samplesSize - pos;
+    if (size > k_SampleSizeMax)
+      size = k_SampleSizeMax;
+    RINOK(ReadStream(inStream, samples + pos, &size))
+    if (size != 0)
+    {
+      pos += size;
+      stat.NumSamples++;
+    }
+    const UInt64 completed = pos;
+    RINOK(callback->SetCompleted(&completed))
+  }
+
+  stat.SamplesSize = pos;
+
+  size_t dictSize = options.DictSize;
+  if (dictSize > pos)
+    dictSize = pos;
+  CByteBuffer dict(dictSize);
+  CDictBuilder builder;
+  const size_t size = builder.Build(samples, pos, dict, dictSize);
+  if (size == 0)
+  {
+    errorInfo = "There is not enough data in sample files";
+    return E_INVALIDARG;
+  }
+  stat.DictSize = (UInt32)size;
+
+  NFile::NIO::COutFile outFile;
+  if (!outFile.Create_ALWAYS(dictPath)
+      || !outFile.WriteFull(dict + dictSize - size, size))
+  {
+    errorInfo = "Cannot write dictionary file";
+    return GetLastError_noZero_HRESULT();
+  }
+  return S_OK;
+}
@@ -0,0 +1,51 @@
+// TrainDict.h
+
+#ifndef ZIP7_INC_TRAIN_DICT_H
+#define ZIP7_INC_TRAIN_DICT_H
+
+#include "../../../Common/Wildcard.h"
+
+#include "HashCalc.h"
+
+const UInt32 k_TrainDict_DefaultSize = (UInt32)112 << 10;
+
+struct CTrainDictOptions
+{
+  UInt32 DictSize;
+  bool OpenShareForWrite;
+  CBoolPair SymLinks;
+
+  NWildcard::ECensorPathMode PathMode;
+
+  CTrainDictOptions():
+      DictSize(k_TrainDict_DefaultSize),
+      OpenShareForWrite(false),
+      PathMode(NWildcard::k_RelatPath) {}
+};
+
+struct CTrainDictStat
+{
+  UInt64 NumSamples;
+  UInt64 SamplesSize;
+  UInt32 DictSize;
+
+  CTrainDictStat(): NumSamples(0), SamplesSize(0), DictSize(0) {}
+};
+
+/*
+TrainDict() builds raw content dictionary from the set of sample files,
+and writes it to (dictPath).
+The dictionary can be used with zstd (-D switch) for compression,
+and with (-mdict) property of zstd handler for decoding.
+It uses (callback) only for scanning and progress.
+*/
+
+HRESULT TrainDict(
+    const NWildcard::CCensor &censor,
+    const CTrainDictOptions &options,
+    const FString &dictPath,
+    CTrainDictStat &stat,
+    AString &errorInfo,
+    IHashCallbackUI *callback);
+
+#endif
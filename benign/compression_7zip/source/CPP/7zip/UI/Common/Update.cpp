@@ -7,6 +7,7 @@
 #include "Update.h"
 
 #include "../../../Common/StringConvert.h"
+#include "../../../Common/StringToInt.h"
 
 #include "../../../Windows/DLL.h"
 #include "../../../Windows/FileDir.h"
@@ -14,6 +15,7 @@
 #include "../../../Windows/FileName.h"
 #include "../../../Windows/PropVariant.h"
 #include "../../../Windows/PropVariantConv.h"
+#include "../../../Windows/System.h"
 #include "../../../Windows/TimeUtils.h"
 
 #include "../../Common/FileStreams.h"
@@ -28,6 +30,7 @@
 #include "../Common/OpenArchive.h"
 #include "../Common/UpdateProduce.h"
 
+#include "Bench.h"
 #include "EnumDirItems.h"
 #include "SetProperties.h"
 #include "TempFiles.h"
@@ -45,6 +48,10 @@ using namespace NFile;
 using namespace NDir;
 using namespace NName;
 
+#ifdef Z7_EXTERNAL_CODECS
+extern const CExternalCodecs *g_ExternalCodecs_Ptr;
+#endif
+
 #ifdef _WIN32
 static CFSTR const kTempFolderPrefix = FTEXT("7zE");
 #endif
@@ -343,6 +350,41 @@ int FindAltStreamColon_in_Path(const wchar_t *path);
 #endif
 
 
+/* it returns the number of threads from (-mmt) switch:
+     (-mmt=N) : (Name == "mt") and (Value == "N")
+     (-mmtN)  : (Name == "mtN")
+   Other properties with "mt" prefix (mtc, mtm, ...) are not thread switches.
+   It returns the number of processors, if there is no (-mmt) switch. */
+static UInt32 GetNumThreads_from_MethodProps(const CObjectVector<CProperty> &props)
+{
+  UInt32 numThreads = NSystem::GetNumberOfProcessors();
+  FOR_VECTOR (i, props)
+  {
+    const CProperty &prop = props[i];
+    if (!prop.Name.IsPrefixedBy_Ascii_NoCase("mt"))
+      continue;
+    UString s;
+    if (prop.Name.Len() == 2)
+      s = prop.Value;
+    else if (prop.Value.IsEmpty())
+      s = prop.Name.Ptr(2);
+    else
+      continue;
+    if (s.IsEqualTo_Ascii_NoCase("off"))
+      numThreads = 1;
+    else if (s.IsEqualTo_Ascii_NoCase("on"))
+      numThreads = NSystem::GetNumberOfProcessors();
+    else
+    {
+      const wchar_t *end;
+      const UInt32 v = ConvertStringToUInt32(s, &end);
+      if (*end == 0 && end != s.Ptr() && v != 0)
+        numThreads = v;
+    }
+  }
+  return numThreads;
+}
+
 
 static HRESULT Compress(
     const CUpdateOptions &options,
@@ -733,6 +775,12 @@ static HRESULT Compress(
     volStreamSpec->Prefix = us2fs(archivePath.GetFinalVolPath());
     volStreamSpec->Prefix.Add_Dot();
     volStreamSpec->Init(options.VolumesSizes);
+    volStreamSpec->SyncVolumes = options.VolumesSync;
+   #ifndef Z7_ST
+    volStreamSpec->WriteBehind_MemLimit = options.VolumesWriteBehind;
+    if (options.VolumesWriteBehind != 0)
+      volStreamSpec->WriteBehind_NumThreads = GetNumThreads_from_MethodProps(options.MethodMode.Properties);
+   #endif
     {
       CMultiOutStream_Rec &rec = multiStreams.Items.AddNew();
       rec.Spec = volStreamSpec;
@@ -1120,6 +1168,158 @@ struct C_CopyFileProgress_to_IUpdateCallbackUI2 Z7_final:
 };
 
 
+/* ---------- AutoTune ----------
+"-mauto=200MB/s" : the best ratio for speed >= 200 MB/s
+"-mauto=40%"     : the fastest method for (packSize <= 40% of unpackSize)
+*/
+
+static bool ParseAutoTuneTarget(const UString &s, CAutoTuneParams &params)
+{
+  const wchar_t *end;
+  const UInt64 val = ConvertStringToUInt64(s, &end);
+  if (end == s.Ptr() || val == 0)
+    return false;
+  if (*end == '%')
+  {
+    if (end[1] != 0 || val > 100)
+      return false;
+    params.Ratio = (UInt32)val;
+    return true;
+  }
+  unsigned numBits = 0;
+  switch (MyCharLower_Ascii(*end))
+  {
+    case 'k': numBits = 10; end++; break;
+    case 'm': numBits = 20; end++; break;
+    case 'g': numBits = 30; end++; break;
+    default: break;
+  }
+  if (MyCharLower_Ascii(*end) == 'b')
+    end++;
+  if (end[0] == '/' && MyCharLower_Ascii(end[1]) == 's')
+    end += 2;
+  if (*end != 0 || val >= ((UInt64)1 << (64 - 30)))
+    return false;
+  params.Speed = val << numBits;
+  return true;
+}
+
+
+static const size_t kAutoTune_SampleSize = (size_t)1 << 21;
+static const unsigned kAutoTune_NumSampleFiles = 32;
+
+// it reads the heads of some files that are distributed over (dirItems)
+
+static void AutoTune_ReadSample(const CDirItems &dirItems, CByteBuffer &buf, size_t &size)
+{
+  size = 0;
+  CRecordVector<unsigned> files;
+  FOR_VECTOR (i, dirItems.Items)
+  {
+    const CDirItem &di = dirItems.Items[i];
+    if (!di.IsDir() && di.Size != 0 && !di.AreReparseData())
+      files.Add(i);
+  }
+  if (files.IsEmpty())
+    return;
+  unsigned numParts = files.Size();
+  if (numParts > kAutoTune_NumSampleFiles)
+    numParts = kAutoTune_NumSampleFiles;
+  buf.Alloc(kAutoTune_SampleSize);
+  for (unsigned k = 0; k < numParts; k++)
+  {
+    const unsigned index = files[(unsigned)((UInt64)files.Size() * k / numParts)];
+    size_t cur = (kAutoTune_SampleSize - size) / (numParts - k);
+    NIO::CInFile file;
+    if (!file.Open(dirItems.GetPhyPath(index)))
+      continue;
+    size_t processed = 0;
+    if (file.ReadFull(buf + size, cur, processed))
+      size += processed;
+  }
+}
+
+
+static HRESULT AutoTune(CCodecs *codecs, const CDirItems &dirItems,
+    CUpdateOptions &options, CUpdateErrorInfo &errorInfo)
+{
+  CObjectVector<CProperty> &props = options.MethodMode.Properties;
+  int autoIndex = -1;
+  CAutoTuneParams params;
+  // the names of other properties (mtc, mtm) also start with "mt", so we parse only exact (-mmt) switch
+  params.NumThreads = GetNumThreads_from_MethodProps(props);
+  
+  FOR_VECTOR (i, props)
+    if (props[i].Name.IsEqualTo_Ascii_NoCase("auto"))
+      autoIndex = (int)i;
+  if (autoIndex < 0)
+    return S_OK;
+  
+  if (!ParseAutoTuneTarget(props[(unsigned)autoIndex].Value, params))
+  {
+    errorInfo.Message = "Unsupported -mauto target";
+    return E_INVALIDARG;
+  }
+  
+  const CArcInfoEx &arcInfo = codecs->Formats[(unsigned)options.MethodMode.Type.FormatIndex];
+  if (arcInfo.Name.IsEqualTo_Ascii_NoCase("zip"))
+    params.ZipMode = true;
+  else if (!arcInfo.Name.IsEqualTo_Ascii_NoCase("7z"))
+  {
+    errorInfo.Message = "-mauto is supported only for 7z and zip archives";
+    return E_NOTIMPL;
+  }
+  
+  props.Delete((unsigned)autoIndex);
+  
+  CByteBuffer buf;
+  size_t size = 0;
+  if (!options.StdInMode)
+    AutoTune_ReadSample(dirItems, buf, size);
+  if (size == 0)
+    return S_OK;
+
+#ifdef Z7_EXTERNAL_CODECS
+  const CExternalCodecs *_externalCodecs = g_ExternalCodecs_Ptr;
+#endif
+  CAutoTuneResult res;
+  RINOK(AutoTune_Method(EXTERNAL_CODECS_LOC_VARS buf, size, params, res))
+
+  // the selected method replaces the method and level from command line
+  for (unsigned i = 0; i < props.Size();)
+  {
+    const UString &name = props[i].Name;
+    if (name.IsEqualTo_Ascii_NoCase("x")
+        || name.IsEqualTo_Ascii_NoCase("m")
+        || name.IsEqualTo("0"))
+      props.Delete(i);
+    else
+      i++;
+  }
+  {
+    CProperty &prop = props.AddNew();
+    prop.Name = "x";
+    prop.Value.Add_UInt32(res.Level);
+  }
+  {
+    CProperty &prop = props.AddNew();
+    prop.Name = params.ZipMode ? "m" : "0";
+    prop.Value = res.MethodName;
+  }
+  
+  AString &s = options.AutoTune_Result;
+  s = res.MethodName;
+  s += ":x";
+  s.Add_UInt32(res.Level);
+  s += " : ";
+  s.Add_UInt64(res.Speed >> 20);
+  s += " MB/s : ";
+  s.Add_UInt64(res.UnpackSize == 0 ? 0 : res.PackSize * 100 / res.UnpackSize);
+  s += "%";
+  return S_OK;
+}
+
+
 HRESULT UpdateArchive(
     CCodecs *codecs,
     const CObjectVector<COpenType> &types,
@@ -1359,11 +1559,10 @@ HRESULT UpdateArchive(
     // di.Size = (UInt64)(Int64)-1;
     if (!di.SetAs_StdInFile())
       return GetLastError_noZero_HRESULT();
-    di.Name = options.StdInFileName;
     // di.Attrib_IsDefined = false;
     // NTime::GetCurUtc_FiTime(di.MTime);
     // di.CTime = di.ATime = di.MTime;
-    dirItems.Items.Add(di);
+    dirItems.AddItem(di, options.StdInFileName);
   }
   else
   {
@@ -1439,6 +1638,8 @@ HRESULT UpdateArchive(
     }
   }
 
+  RINOK(AutoTune(codecs, dirItems, options, errorInfo))
+
   FString tempDirPrefix;
   bool usesTempDir = false;
   
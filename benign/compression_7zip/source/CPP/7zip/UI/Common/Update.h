@@ -120,6 +120,10 @@ struct CUpdateOptions
 
   CObjectVector<CRenamePair> RenamePairs;
   CRecordVector<UInt64> VolumesSizes;
+  UInt64 VolumesWriteBehind; // memory limit for write-behind queue of volumes (0 : disabled)
+  bool VolumesSync;
+
+  AString AutoTune_Result; // method selected by "-mauto" mode
 
   bool InitFormatIndex(const CCodecs *codecs, const CObjectVector<COpenType> &types, const UString &arcPath);
   bool SetArcPath(const CCodecs *codecs, const UString &arcPath);
@@ -143,7 +147,9 @@ struct CUpdateOptions
     RenameMode(false),
 
     ArcNameMode(k_ArcNameMode_Smart),
-    PathMode(NWildcard::k_RelatPath)
+    PathMode(NWildcard::k_RelatPath),
+    VolumesWriteBehind(0),
+    VolumesSync(false)
     
     {}
 
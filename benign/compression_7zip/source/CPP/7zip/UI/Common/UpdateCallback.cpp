@@ -286,9 +286,9 @@ Z7_COM7F_IMF(CArchiveUpdateCallback::GetRawProp(UInt32 index, PROPID propID, con
           return S_OK;
         #if defined(_WIN32) && !defined(UNDER_CE)
         // we use ReparseData2 instead of ReparseData for WIM format
-        const CByteBuffer *buf = &di.ReparseData2;
+        const CByteBuffer *buf = &DirItems->Get_ReparseData2(di);
         if (buf->Size() == 0)
-          buf = &di.ReparseData;
+          buf = &DirItems->Get_ReparseData(di);
         if (buf->Size() != 0)
         {
           *data = *buf;
@@ -379,11 +379,12 @@ Z7_COM7F_IMF(CArchiveUpdateCallback::GetProperty(UInt32 index, PROPID propID, PR
       if (up.DirIndex >= 0)
       {
         const CDirItem &di = DirItems->Items[(unsigned)up.DirIndex];
-        if (di.ReparseData.Size())
+        const CByteBuffer &reparse = DirItems->Get_ReparseData(di);
+        if (reparse.Size())
         {
 #ifdef _WIN32
           CReparseAttr attr;
-          if (attr.Parse(di.ReparseData, di.ReparseData.Size()))
+          if (attr.Parse(reparse, reparse.Size()))
           {
             UString path = attr.GetPath();
             if (!path.IsEmpty())
@@ -437,7 +438,7 @@ Z7_COM7F_IMF(CArchiveUpdateCallback::GetProperty(UInt32 index, PROPID propID, PR
           }
 #else // ! _WIN32
           AString utf;
-          utf.SetFrom_CalcLen((const char *)(const Byte *)di.ReparseData, (unsigned)di.ReparseData.Size());
+          utf.SetFrom_CalcLen((const char *)(const Byte *)reparse, (unsigned)reparse.Size());
     #if 0 // 0 - for debug
           // it's expected that link data uses system codepage.
           // fs2us() ignores conversion errors. But we want correct path
@@ -658,7 +659,8 @@ Z7_COM7F_IMF(CArchiveUpdateCallback::GetStream2(UInt32 index, ISequentialInStrea
 
       CBufInStream *inStreamSpec = new CBufInStream();
       CMyComPtr<ISequentialInStream> inStreamLoc = inStreamSpec;
-      inStreamSpec->Init(di.ReparseData, di.ReparseData.Size());
+      const CByteBuffer &reparse = DirItems->Get_ReparseData(di);
+      inStreamSpec->Init(reparse, reparse.Size());
       *inStream = inStreamLoc.Detach();
 
       UpdateProcessedItemStatus((unsigned)up.DirIndex);
@@ -674,7 +676,7 @@ Z7_COM7F_IMF(CArchiveUpdateCallback::GetStream2(UInt32 index, ISequentialInStrea
    #ifdef _WIN32
     inStreamSpec->StoreOwnerName = true;
     inStreamSpec->OwnerName = "user_name";
-    inStreamSpec->OwnerName += di.Name;
+    inStreamSpec->OwnerName += DirItems->GetItemName(di);
     inStreamSpec->OwnerName += "11111111112222222222222333333333333";
     inStreamSpec->OwnerGroup = "gname_";
     inStreamSpec->OwnerGroup += inStreamSpec->OwnerName;
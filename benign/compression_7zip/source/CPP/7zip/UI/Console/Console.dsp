@@ -681,6 +681,14 @@ SOURCE=..\Common\TempFiles.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\Common\TrainDict.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\Common\TrainDict.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\Common\Update.cpp
 # End Source File
 # Begin Source File
@@ -801,6 +809,14 @@ SOURCE=..\..\Common\RegisterArc.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\Common\StageStats.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\Common\StageStats.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\Common\StreamObjects.cpp
 # End Source File
 # Begin Source File
@@ -925,11 +941,29 @@ SOURCE=..\..\..\..\C\Sort.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.c
 # SUBTRACT CPP /YX /Yc /Yu
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\..\..\C\MemBudget.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\ThreadPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\..\..\C\Threads.h
 # End Source File
 # End Group
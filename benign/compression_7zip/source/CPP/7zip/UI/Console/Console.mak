@@ -34,6 +34,7 @@ UI_COMMON_OBJS = \
   $O\SetProperties.obj \
   $O\SortUtils.obj \
   $O\TempFiles.obj \
+  $O\TrainDict.obj \
   $O\Update.obj \
   $O\UpdateAction.obj \
   $O\UpdateCallback.obj \
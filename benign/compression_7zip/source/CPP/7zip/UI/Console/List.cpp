@@ -374,6 +374,7 @@ class CFieldPrinter
 public:
   const CArc *Arc;
   bool TechMode;
+  bool JsonMode;
   UString FilePath;
   AString TempAString;
   UString TempWString;
@@ -390,6 +391,7 @@ public:
   void PrintTitle();
   void PrintTitleLines();
   HRESULT PrintItemInfo(UInt32 index, const CListStat &st);
+  HRESULT PrintItemInfo_Json(UInt32 index, const CListStat &st);
   void PrintSum(const CListStat &st, UInt64 numDirs, const char *str);
   void PrintSum(const CListStat2 &stat2);
 };
@@ -439,9 +441,13 @@ void CFieldPrinter::AddProp(const wchar_t *name, PROPID propID, bool isRawProp)
   f.PropID = propID;
   f.IsRawProp = isRawProp;
   GetPropName(propID, name, f.NameA, f.NameU);
-  f.NameU += " = ";
+  if (!JsonMode)
+    f.NameU += " = ";
   if (!f.NameA.IsEmpty())
-    f.NameA += " = ";
+  {
+    if (!JsonMode)
+      f.NameA += " = ";
+  }
   else
   {
     const UString &s = f.NameU;
@@ -545,8 +551,201 @@ inline bool IsPropId_for_PathString(UInt32 propId)
     || propId == kpidCopyLink);
 }
 
+/* JSON Lines (NDJSON) listing mode (-slj):
+   we write one JSON object per item, and we flush the output after each item.
+   So the caller can process the records while the archive headers are parsed
+   in sequential mode (stdin). */
+
+static void Json_AddEscaped(AString &s, const char *p)
+{
+  for (;; p++)
+  {
+    const unsigned c = (Byte)*p;
+    if (c == 0)
+      return;
+    if (c == '\"' || c == '\\')
+      s.Add_Char('\\');
+    else if (c < 0x20)
+    {
+      s += "\\u00";
+      s.Add_Char((char)GET_HEX_CHAR_LOWER(c >> 4));
+      s.Add_Char((char)GET_HEX_CHAR_LOWER(c & 15));
+      continue;
+    }
+    s.Add_Char((char)c);
+  }
+}
+
+static void Json_AddName(AString &s, const CFieldInfo &f)
+{
+  s += s.IsEmpty() ? "{\"" : ",\"";
+  if (!f.NameA.IsEmpty())
+    Json_AddEscaped(s, f.NameA);
+  else
+  {
+    AString nameUtf8;
+    ConvertUnicodeToUTF8(f.NameU, nameUtf8);
+    Json_AddEscaped(s, nameUtf8);
+  }
+  s += "\":";
+}
+
+static void Json_AddStringVal(AString &s, const char *val)
+{
+  s.Add_Char('\"');
+  Json_AddEscaped(s, val);
+  s.Add_Char('\"');
+}
+
+static void Json_AddUStringVal(AString &s, const UString &val, AString &temp)
+{
+  ConvertUnicodeToUTF8(val, temp);
+  Json_AddStringVal(s, temp);
+}
+
+// these integer properties are written as formatted strings
+static bool IsPropId_for_FormattedString(PROPID propID)
+{
+  return (propID == kpidCRC
+    || propID == kpidAttrib
+    || propID == kpidPosixAttrib
+    || propID == kpidINode
+    || propID == kpidVa);
+}
+
+HRESULT CFieldPrinter::PrintItemInfo_Json(UInt32 index, const CListStat &st)
+{
+  AString s;
+  FOR_VECTOR (i, _fields)
+  {
+    const CFieldInfo &f = _fields[i];
+
+    if (f.PropID == kpidPath)
+    {
+      Json_AddName(s, f);
+      Json_AddUStringVal(s, FilePath, TempAString);
+      continue;
+    }
+
+    if (f.IsRawProp)
+    {
+      #ifndef Z7_SFX
+      const void *data;
+      UInt32 dataSize;
+      UInt32 propType;
+      RINOK(Arc->GetRawProps->GetRawProp(index, f.PropID, &data, &dataSize, &propType))
+      if (dataSize == 0)
+        continue;
+      if (propType != NPropDataType::kRaw)
+        return E_FAIL;
+      Json_AddName(s, f);
+      if (f.PropID == kpidNtSecure)
+      {
+        ConvertNtSecureToString((const Byte *)data, dataSize, TempAString);
+        Json_AddStringVal(s, TempAString);
+        continue;
+      }
+      if (f.PropID == kpidNtReparse)
+      {
+        UString u;
+        if (ConvertNtReparseToString((const Byte *)data, dataSize, u))
+        {
+          Json_AddUStringVal(s, u, TempAString);
+          continue;
+        }
+      }
+      TempAString.Empty();
+      char *hex = TempAString.GetBuf((unsigned)dataSize * 2);
+      ConvertDataToHex_Lower(hex, (const Byte *)data, dataSize);
+      TempAString.ReleaseBuf_SetEnd((unsigned)dataSize * 2);
+      Json_AddStringVal(s, TempAString);
+      #endif
+      continue;
+    }
+
+    CPropVariant prop;
+    switch (f.PropID)
+    {
+      case kpidSize: if (st.Size.Def) prop = st.Size.Val; break;
+      case kpidPackSize: if (st.PackSize.Def) prop = st.PackSize.Val; break;
+      case kpidMTime:
+      {
+        const CListFileTimeDef &mtime = st.MTime;
+        if (mtime.Def)
+          prop.SetAsTimeFrom_FT_Prec_Ns100(mtime.FT, mtime.Prec, mtime.Ns100);
+        break;
+      }
+      default:
+        RINOK(Arc->Archive->GetProperty(index, f.PropID, &prop))
+    }
+
+    char temp[64];
+
+    if (f.PropID == kpidAttrib && (prop.vt == VT_EMPTY || prop.vt == VT_UI4))
+    {
+      GetAttribString((prop.vt == VT_EMPTY) ? 0 : prop.ulVal, IsDir, true, temp);
+      Json_AddName(s, f);
+      Json_AddStringVal(s, temp);
+      continue;
+    }
+    
+    switch (prop.vt)
+    {
+      case VT_EMPTY:
+        continue;
+      case VT_BSTR:
+        Json_AddName(s, f);
+        TempWString.SetFromBstr(prop.bstrVal);
+        Json_AddUStringVal(s, TempWString, TempAString);
+        continue;
+      case VT_BOOL:
+        Json_AddName(s, f);
+        s += (prop.boolVal != VARIANT_FALSE) ? "true" : "false";
+        continue;
+      case VT_FILETIME:
+      {
+        CListFileTimeDef t;
+        t.Set_From_Prop(prop);
+        PrintTime(temp, t, true);
+        if (temp[0] == 0)
+          continue;
+        Json_AddName(s, f);
+        Json_AddStringVal(s, temp);
+        continue;
+      }
+      case VT_UI1:
+      case VT_UI2:
+      case VT_UI4:
+      case VT_UI8:
+      case VT_I2:
+      case VT_I4:
+      case VT_I8:
+        if (!IsPropId_for_FormattedString(f.PropID))
+        {
+          ConvertPropVariantToShortString(prop, temp);
+          Json_AddName(s, f);
+          s += temp;
+          continue;
+        }
+        break;
+      default: break;
+    }
+    ConvertPropertyToShortString2(temp, prop, f.PropID);
+    Json_AddName(s, f);
+    Json_AddStringVal(s, temp);
+  }
+  s += s.IsEmpty() ? "{}" : "}";
+  g_StdOut << s << MY_ENDL;
+  g_StdOut.Flush();
+  return S_OK;
+}
+
+
 HRESULT CFieldPrinter::PrintItemInfo(UInt32 index, const CListStat &st)
 {
+  if (JsonMode)
+    return PrintItemInfo_Json(index, st);
+
   char temp[128];
   size_t tempPos = 0;
 
@@ -1095,7 +1294,8 @@ HRESULT ListArchives(
   numWarnings = 0;
 
   CFieldPrinter fp;
-  if (!techMode)
+  fp.JsonMode = listOptions.JsonMode;
+  if (!techMode && !listOptions.JsonMode)
     fp.Init(kStandardFieldTable, Z7_ARRAY_SIZE(kStandardFieldTable));
 
   CListStat2 stat2total;
@@ -1277,7 +1477,7 @@ HRESULT ListArchives(
     fp.Arc = &arc;
     fp.TechMode = techMode;
     IInArchive *archive = arc.Archive;
-    if (techMode)
+    if (techMode || listOptions.JsonMode)
     {
       fp.Clear();
       RINOK(fp.AddMainProps(archive))
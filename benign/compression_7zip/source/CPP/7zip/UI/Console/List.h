@@ -12,11 +12,13 @@ struct CListOptions
   bool ExcludeDirItems;
   bool ExcludeFileItems;
   bool DisablePercents;
+  bool JsonMode; // one JSON object per item (NDJSON)
 
   CListOptions():
     ExcludeDirItems(false),
     ExcludeFileItems(false),
-    DisablePercents(false)
+    DisablePercents(false),
+    JsonMode(false)
     {}
 };
 
@@ -40,6 +40,9 @@ typedef PROCESS_MEMORY_COUNTERS *PPROCESS_MEMORY_COUNTERS;
 #endif // _WIN32
 
 #include "../../../../C/CpuArch.h"
+#ifndef Z7_ST
+#include "../../../../C/MemBudget.h"
+#endif
 
 #include "../../../Common/MyInitGuid.h"
 
@@ -56,6 +59,8 @@ typedef PROCESS_MEMORY_COUNTERS *PPROCESS_MEMORY_COUNTERS;
 #include "../../../Windows/TimeUtils.h"
 #include "../../../Windows/FileDir.h"
 
+#include "../../Common/StageStats.h"
+
 #include "../Common/ArchiveCommandLine.h"
 #include "../Common/Bench.h"
 #include "../Common/ExitCode.h"
@@ -143,6 +148,7 @@ static const char * const kHelpString =
     "  l : List contents of archive\n"
     "  rn : Rename files in archive\n"
     "  t : Test integrity of archive\n"
+    "  td : Train zstd dictionary from sample files\n"
     "  u : Update files to archive\n"
     "  x : eXtract files with full paths\n"
     "\n"
@@ -156,6 +162,7 @@ static const char * const kHelpString =
     "  -bd : disable progress indicator\n"
     "  -bs{o|e|p}{0|1|2} : set output stream for output/error/progress line\n"
     "  -bt : show execution time statistics\n"
+    "  -bts[{file}] : show per-stage time statistics and write trace-event JSON file\n"
     "  -i[r[-|0]][m[-|2]][w[-]]{@listfile|!wildcard} : Include filenames\n"
     "  -m{Parameters} : set compression Method\n"
     "    -mmt[N] : set number of CPU threads\n"
@@ -180,6 +187,7 @@ static const char * const kHelpString =
     "  -seml[.] : send archive by email\n"
     "  -sfx[{name}] : Create SFX archive\n"
     "  -si[{name}] : read data from stdin\n"
+    "  -slj : show listing as JSON lines (one object per item) for l (List) command\n"
     "  -slp : set Large Pages mode\n"
     "  -slt : show technical information for l (List) command\n"
     "  -snh : store hard links as links\n"
@@ -191,15 +199,21 @@ static const char * const kHelpString =
     "  -spe : eliminate duplication of root folder for extract command\n"
     "  -spf[2] : use fully qualified file paths\n"
     "  -ssc[-] : set sensitive case mode\n"
+    "  -ssf[-] : write zero blocks as holes in extracted files\n"
     "  -sse : stop archive creating, if it can't open some input file\n"
+    "  -ssm : use memory mapped input files (non-Windows)\n"
     "  -ssp : do not change Last Access Time of source files while archiving\n"
     "  -ssw : compress shared files\n"
     "  -stl : set archive timestamp from the most recently modified file\n"
     "  -stm{HexMask} : set CPU thread affinity mask (hexadecimal number)\n"
+    "  -smb{Size}[b|k|m|g|t] : set memory budget for all coders in process\n"
+    "  -stp[N] : set limit for the number of worker threads in process (-stp0 : don't reuse threads)\n"
     "  -stx{Type} : exclude archive type\n"
     "  -t{Type} : Set type of archive\n"
     "  -u[-][p#][q#][r#][x#][y#][z#][!newArchiveName] : Update options\n"
     "  -v{Size}[b|k|m|g] : Create volumes\n"
+    "  -vwb{Size}[b|k|m|g] : use write-behind queue for volumes with memory limit\n"
+    "  -vws : flush each volume to disk before closing\n"
     "  -w[{path}] : assign Work directory. Empty path means a temporary directory\n"
     "  -x[r[-|0]][m[-|2]][w[-]]{@listfile|!wildcard} : eXclude filenames\n"
     "  -y : assume Yes on all queries\n";
@@ -791,6 +805,30 @@ static void PrintStat(const UInt64 startTime)
 
 
 
+#ifndef Z7_ST
+
+static void PrintMemBudgetStat()
+{
+  CMemBudgetStat st;
+  if (!MemBudget_GetStat(&st))
+    return;
+  *g_StdStream << "Budget   Peak =";
+  PrintNum(st.Peak >> 20, 7);
+  *g_StdStream << " MB";
+  if (st.Limit != 0)
+  {
+    *g_StdStream << "    Limit =";
+    PrintNum(st.Limit >> 20, 7);
+    *g_StdStream << " MB";
+  }
+  *g_StdStream << "    Reduced =";
+  PrintNum(st.NumReduced, 4);
+  *g_StdStream << endl;
+}
+
+#endif
+
+
 static void PrintHexId(CStdOutStream &so, UInt64 id)
 {
   char s[32];
@@ -918,6 +956,9 @@ int Main2(
 
   parser.Parse2(options);
 
+  if (options.ShowStageStats)
+    NStageStats::Enable(!options.StageTraceFile.IsEmpty());
+
   {
     int cp = options.ConsoleCodePage;
     
@@ -1500,6 +1541,7 @@ int Main2(
       lo.ExcludeDirItems = options.Censor.ExcludeDirItems;
       lo.ExcludeFileItems = options.Censor.ExcludeFileItems;
       lo.DisablePercents = options.DisablePercents;
+      lo.JsonMode = options.ListJsonMode;
 
       hresultMain = ListArchives(
           lo,
@@ -1586,6 +1628,9 @@ int Main2(
 
     callback.ClosePercents2();
 
+    if (g_StdStream && !uo.AutoTune_Result.IsEmpty())
+      *g_StdStream << endl << "Auto method: " << uo.AutoTune_Result << endl;
+
     CStdOutStream *se = g_StdStream;
     if (!se)
       se = g_ErrStream;
@@ -1619,15 +1664,62 @@ int Main2(
       se = g_ErrStream;
     retCode = WarningsCheck(hresultMain, callback, errorInfo, g_StdStream, se, options.EnableHeaders);
   }
+  else if (options.Command.CommandType == NCommandType::kTrainDict)
+  {
+    CHashCallbackConsole callback;
+    if (percentsStream)
+      callback.SetWindowWidth(consoleWidth);
+  
+    callback.Init(g_StdStream, g_ErrStream, percentsStream, options.DisablePercents);
+    callback.PrintHeaders = options.EnableHeaders;
+
+    CTrainDictStat stat;
+    AString errorInfoString;
+    hresultMain = TrainDict(options.Censor, options.TrainDictOptions,
+        us2fs(options.ArchiveName), stat,
+        errorInfoString, &callback);
+    callback.ClosePercents2();
+    if (hresultMain == S_OK && g_StdStream)
+    {
+      CStdOutStream &so = *g_StdStream;
+      so << "Samples: " << stat.NumSamples << endl;
+      so << "Samples size: " << stat.SamplesSize << endl;
+      so << "Dictionary size: " << stat.DictSize << endl;
+    }
+    CUpdateErrorInfo errorInfo;
+    errorInfo.Message = errorInfoString;
+    CStdOutStream *se = g_StdStream;
+    if (!se)
+      se = g_ErrStream;
+    retCode = WarningsCheck(hresultMain, callback, errorInfo, g_StdStream, se, options.EnableHeaders);
+  }
   else
     ShowMessageAndThrowException(kUserErrorMessage, NExitCode::kUserError);
 
   if (options.ShowTime && g_StdStream)
+  {
     PrintStat(
       #ifndef _WIN32
         startTime
       #endif
     );
+    #ifndef Z7_ST
+    PrintMemBudgetStat();
+    #endif
+  }
+
+  if (options.ShowStageStats)
+  {
+    if (g_StdStream)
+    {
+      AString s;
+      NStageStats::PrintStats(s);
+      *g_StdStream << s << endl;
+    }
+    if (!options.StageTraceFile.IsEmpty())
+      if (!NStageStats::WriteTrace(us2fs(options.StageTraceFile)))
+        throw CSystemException(GetLastError_noZero_HRESULT());
+  }
 
   ThrowException_if_Error(hresultMain);
 
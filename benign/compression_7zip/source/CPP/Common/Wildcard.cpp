@@ -253,6 +253,125 @@ ForDir   nonrec         [0, M)                   same as ForBoth-File
 
 */
 
+UInt32 CNameHashIndex::GetHash(const wchar_t *name) throw()
+{
+  UInt32 h = 0;
+  for (;;)
+  {
+    wchar_t c = *name++;
+    if (c == 0)
+      break;
+    if (!g_CaseSensitive)
+      c = MyCharUpper(c);
+    h = (h + (UInt32)c) * 0x9E3779B1;
+  }
+  return h ^ (h >> 16);
+}
+
+void CNameHashIndex::Clear()
+{
+  _hashes.Clear();
+  _values.Clear();
+  _next.Clear();
+  _heads.Clear();
+}
+
+void CNameHashIndex::Rehash()
+{
+  unsigned size = 16;
+  while (size < _values.Size() * 2)
+    size <<= 1;
+  _heads.ClearAndSetSize(size);
+  unsigned i;
+  for (i = 0; i < size; i++)
+    _heads[i] = -1;
+  const UInt32 mask = (UInt32)size - 1;
+  for (i = 0; i < _values.Size(); i++)
+  {
+    int &head = _heads[_hashes[i] & mask];
+    _next[i] = head;
+    head = (int)i;
+  }
+}
+
+void CNameHashIndex::Add(UInt32 hash, unsigned value)
+{
+  _hashes.Add(hash);
+  _values.Add(value);
+  _next.Add(-1);
+  if (_values.Size() > _heads.Size())
+  {
+    Rehash();
+    return;
+  }
+  int &head = _heads[hash & ((UInt32)_heads.Size() - 1)];
+  _next.Back() = head;
+  head = (int)_values.Size() - 1;
+}
+
+int CNameHashIndex::GetFirst(UInt32 hash) const
+{
+  if (_heads.IsEmpty())
+    return -1;
+  const int entry = _heads[hash & ((UInt32)_heads.Size() - 1)];
+  if (entry < 0 || _hashes[(unsigned)entry] == hash)
+    return entry;
+  return GetNext(entry, hash);
+}
+
+int CNameHashIndex::GetNext(int entry, UInt32 hash) const
+{
+  for (;;)
+  {
+    entry = _next[(unsigned)entry];
+    if (entry < 0 || _hashes[(unsigned)entry] == hash)
+      return entry;
+  }
+}
+
+
+// we use indexes only for big lists. Small lists are checked in linear loop.
+static const unsigned kNumItems_for_Index = 16;
+
+static bool IsExtMask(const UString &mask)
+{
+  if (mask.Len() < 3 || mask[0] != '*' || mask[1] != '.')
+    return false;
+  for (unsigned i = 2; i < mask.Len(); i++)
+  {
+    const wchar_t c = mask[i];
+    if (c == '*' || c == '?' || c == '.')
+      return false;
+  }
+  return true;
+}
+
+void CItemsIndex::Build(const CObjectVector<CItem> &items)
+{
+  Clear();
+  FOR_VECTOR (i, items)
+  {
+    const CItem &item = items[i];
+    if (item.PathParts.Size() == 1)
+    {
+      const UString &name = item.PathParts[0];
+      if (!item.WildcardMatching || !DoesNameContainWildcard(name))
+      {
+        Names.Add(CNameHashIndex::GetHash(name), i);
+        continue;
+      }
+      if (IsExtMask(name))
+      {
+        Exts.Add(CNameHashIndex::GetHash(name.Ptr(2)), i);
+        continue;
+      }
+    }
+    Others.Add(i);
+  }
+  NumItems = items.Size();
+  IsBuilt = true;
+}
+
 bool CItem::AreAllAllowed() const
 {
   return ForFile && ForDir && WildcardMatching
@@ -336,12 +455,44 @@ bool CCensorNode::AreAllAllowed() const
 
 int CCensorNode::FindSubNode(const UString &name) const
 {
-  FOR_VECTOR (i, SubNodes)
+  if (SubNodes.Size() < kNumItems_for_Index)
+  {
+    FOR_VECTOR (i, SubNodes)
+      if (CompareFileNames(SubNodes[i].Name, name) == 0)
+        return (int)i;
+    return -1;
+  }
+  if (_subNodesIndex.Size() != SubNodes.Size())
+  {
+    _subNodesIndex.Clear();
+    FOR_VECTOR (i, SubNodes)
+      _subNodesIndex.Add(CNameHashIndex::GetHash(SubNodes[i].Name), i);
+  }
+  const UInt32 hash = CNameHashIndex::GetHash(name);
+  for (int e = _subNodesIndex.GetFirst(hash); e >= 0; e = _subNodesIndex.GetNext(e, hash))
+  {
+    const unsigned i = _subNodesIndex.GetValue(e);
     if (CompareFileNames(SubNodes[i].Name, name) == 0)
       return (int)i;
+  }
   return -1;
 }
 
+CCensorNode &CCensorNode::Find_SubNode_Or_Add_New(const UString &name)
+{
+  const int i = FindSubNode(name);
+  if (i >= 0)
+    return SubNodes[(unsigned)i];
+  // return SubNodes.Add(CCensorNode(name, this));
+  CCensorNode &node = SubNodes.AddNew();
+  node.Parent = this;
+  node.Name = name;
+  // we update the index of big list here, so we don't rebuild it for each new node
+  if (_subNodesIndex.Size() != 0 && _subNodesIndex.Size() + 1 == SubNodes.Size())
+    _subNodesIndex.Add(CNameHashIndex::GetHash(name), SubNodes.Size() - 1);
+  return node;
+}
+
 void CCensorNode::AddItemSimple(bool include, CItem &item)
 {
   CObjectVector<CItem> &items = include ? IncludeItems : ExcludeItems;
@@ -413,8 +564,51 @@ bool CCensorNode::AreThereIncludeItems() const
 bool CCensorNode::CheckPathCurrent(bool include, const UStringVector &pathParts, bool isFile) const
 {
   const CObjectVector<CItem> &items = include ? IncludeItems : ExcludeItems;
-  FOR_VECTOR (i, items)
-    if (items[i].CheckPath(pathParts, isFile))
+  if (items.Size() < kNumItems_for_Index)
+  {
+    FOR_VECTOR (i, items)
+      if (items[i].CheckPath(pathParts, isFile))
+        return true;
+    return false;
+  }
+
+  CItemsIndex &index = include ? _includeIndex : _excludeIndex;
+  if (!index.IsBuilt || index.NumItems != items.Size())
+    index.Build(items);
+
+  /* the rules from (Names) and (Exts) contain one name,
+     that can be compared with any part of path.
+     CItem::CheckPath() checks the other conditions of rule. */
+  FOR_VECTOR (k, pathParts)
+  {
+    const UString &part = pathParts[k];
+    UInt32 hash = CNameHashIndex::GetHash(part);
+    int e;
+    for (e = index.Names.GetFirst(hash); e >= 0; e = index.Names.GetNext(e, hash))
+    {
+      const CItem &item = items[index.Names.GetValue(e)];
+      if (CompareFileNames(item.PathParts[0], part) == 0
+          && item.CheckPath(pathParts, isFile))
+        return true;
+    }
+    if (index.Exts.Size() == 0)
+      continue;
+    const int dotPos = part.ReverseFind_Dot();
+    if (dotPos < 0)
+      continue;
+    const wchar_t *ext = part.Ptr((unsigned)dotPos + 1);
+    hash = CNameHashIndex::GetHash(ext);
+    for (e = index.Exts.GetFirst(hash); e >= 0; e = index.Exts.GetNext(e, hash))
+    {
+      const CItem &item = items[index.Exts.GetValue(e)];
+      if (CompareFileNames(item.PathParts[0].Ptr(2), ext) == 0
+          && item.CheckPath(pathParts, isFile))
+        return true;
+    }
+  }
+  
+  FOR_VECTOR (i, index.Others)
+    if (items[index.Others[i]].CheckPath(pathParts, isFile))
       return true;
   return false;
 }
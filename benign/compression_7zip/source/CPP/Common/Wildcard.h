@@ -30,6 +30,35 @@ bool IsDriveColonName(const wchar_t *s);
 unsigned GetNumPrefixParts_if_DrivePath(UStringVector &pathParts);
 #endif
 
+/*
+CNameHashIndex is hash table for file names.
+The hash and the comparison of names follow CompareFileNames() rules
+(g_CaseSensitive). The table stores (value) for each added name,
+and the caller compares the real names of found entries.
+*/
+
+class CNameHashIndex
+{
+  CRecordVector<UInt32> _hashes;
+  CRecordVector<unsigned> _values;
+  CRecordVector<int> _next;
+  CRecordVector<int> _heads;
+
+  void Rehash();
+public:
+  static UInt32 GetHash(const wchar_t *name) throw();
+
+  unsigned Size() const { return _values.Size(); }
+  void Clear();
+  void Add(UInt32 hash, unsigned value);
+  
+  // these functions return (entry index) or (-1)
+  int GetFirst(UInt32 hash) const;
+  int GetNext(int entry, UInt32 hash) const;
+  unsigned GetValue(int entry) const { return _values[(unsigned)entry]; }
+};
+
+
 struct CItem
 {
   UStringVector PathParts;
@@ -71,9 +100,42 @@ struct CCensorPathProps
 };
 
 
+/*
+CItemsIndex is index for big list of CItem rules in CCensorNode.
+The rules with one literal name and ("*.ext") rules are found via hash,
+and the remaining rules are checked in linear loop.
+*/
+
+struct CItemsIndex
+{
+  CNameHashIndex Names;   // items with one name without wildcards
+  CNameHashIndex Exts;    // items with ("*.ext") mask
+  CRecordVector<unsigned> Others;
+  unsigned NumItems;      // number of items, when the index was built
+  bool IsBuilt;
+
+  CItemsIndex(): NumItems(0), IsBuilt(false) {}
+  void Build(const CObjectVector<CItem> &items);
+  void Clear()
+  {
+    Names.Clear();
+    Exts.Clear();
+    Others.Clear();
+    IsBuilt = false;
+  }
+};
+
+
 class CCensorNode  MY_UNCOPYABLE
 {
   CCensorNode *Parent;
+
+  /* the indexes are built at first check of path, and they are rebuilt,
+     if the number of items was changed.
+     So the first check is not thread-safe. */
+  mutable CItemsIndex _includeIndex;
+  mutable CItemsIndex _excludeIndex;
+  mutable CNameHashIndex _subNodesIndex;
   
   bool CheckPathCurrent(bool include, const UStringVector &pathParts, bool isFile) const;
   void AddItemSimple(bool include, CItem &item);
@@ -96,22 +158,21 @@ public:
   CObjectVector<CItem> IncludeItems;
   CObjectVector<CItem> ExcludeItems;
 
-  CCensorNode &Find_SubNode_Or_Add_New(const UString &name)
-  {
-    int i = FindSubNode(name);
-    if (i >= 0)
-      return SubNodes[(unsigned)i];
-    // return SubNodes.Add(CCensorNode(name, this));
-    CCensorNode &node = SubNodes.AddNew();
-    node.Parent = this;
-    node.Name = name;
-    return node;
-  }
+  CCensorNode &Find_SubNode_Or_Add_New(const UString &name);
 
   bool AreAllAllowed() const;
 
   int FindSubNode(const UString &path) const;
 
+  /* the caller must call Reset_Indexes(), if it changes
+     the names in SubNodes or in items without changing the number of items */
+  void Reset_Indexes()
+  {
+    _includeIndex.Clear();
+    _excludeIndex.Clear();
+    _subNodesIndex.Clear();
+  }
+
   void AddItem(bool include, CItem &item, int ignoreWildcardIndex = -1);
   // void AddItem(bool include, const UString &path, const CCensorPathProps &props);
   void Add_Wildcard()
@@ -592,6 +592,8 @@ bool COutFile::WriteFull(const void *data, size_t size) throw()
 
 bool COutFile::SetEndOfFile() throw() { return BOOLToBool(::SetEndOfFile(_handle)); }
 
+bool COutFile::Sync() throw() { return BOOLToBool(::FlushFileBuffers(_handle)); }
+
 bool COutFile::SetLength(UInt64 length) throw()
 {
   UInt64 newPosition;
@@ -785,6 +787,13 @@ ssize_t CInFile::read_part(void *data, size_t size) throw()
   return ::read(_handle, data, size);
 }
 
+ssize_t CInFile::pread_part(void *data, size_t size, UInt64 pos) throw()
+{
+  if (size > kChunkSizeMax)
+    size = kChunkSizeMax;
+  return ::pread(_handle, data, size, (off_t)pos);
+}
+
 bool CInFile::ReadFull(void *data, size_t size, size_t &processed) throw()
 {
   processed = 0;
@@ -948,6 +957,11 @@ bool COutFile::SetMTime(const CFiTime *mTime) throw()
   return true;
 }
 
+bool COutFile::Sync() throw()
+{
+  return fsync(_handle) == 0;
+}
+
 }}}
 
 
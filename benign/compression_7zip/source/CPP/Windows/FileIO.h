@@ -329,6 +329,8 @@ public:
   bool Write(const void *data, UInt32 size, UInt32 &processedSize) throw();
   bool WriteFull(const void *data, size_t size) throw();
   bool SetEndOfFile() throw();
+  // flushes file data and metadata to storage device
+  bool Sync() throw();
   bool SetLength(UInt64 length) throw();
   bool SetLength_KeepPosition(UInt64 length) throw();
 };
@@ -380,6 +382,7 @@ public:
   off_t seekToCur() const throw();
   // bool SeekToBegin() throw();
   int my_fstat(struct stat *st) const  { return fstat(_handle, st); }
+  int GetHandle() const { return _handle; }
   /*
   int my_ioctl_BLKGETSIZE64(unsigned long long *val);
   int GetDeviceSize_InBytes(UInt64 &size);
@@ -402,6 +405,8 @@ public:
   }
 #endif
   ssize_t read_part(void *data, size_t size) throw();
+  // it doesn't change current file position
+  ssize_t pread_part(void *data, size_t size, UInt64 pos) throw();
   // ssize_t read_full(void *data, size_t size, size_t &processed);
   bool ReadFull(void *data, size_t size, size_t &processedSize) throw();
 };
@@ -455,6 +460,7 @@ public:
   }
   bool SetTime(const CFiTime *cTime, const CFiTime *aTime, const CFiTime *mTime) throw();
   bool SetMTime(const CFiTime *mTime) throw();
+  bool Sync() throw();
 };
 
 }
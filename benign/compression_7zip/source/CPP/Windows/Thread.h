@@ -3,6 +3,7 @@
 #ifndef ZIP7_INC_WINDOWS_THREAD_H
 #define ZIP7_INC_WINDOWS_THREAD_H
 
+#include "../../C/ThreadPool.h"
 #include "../../C/Threads.h"
 
 #include "Defs.h"
@@ -41,6 +42,20 @@ public:
 #endif
 };
 
+/* CPoolThread runs the thread function in worker of process-wide pool (ThreadPool.h).
+   The function must be finished before Wait_Close() or destructor call. */
+class CPoolThread  MY_UNCOPYABLE
+{
+  ::CPoolThread thread;
+public:
+  CPoolThread() { PoolThread_CONSTRUCT(&thread) }
+  ~CPoolThread() { if (IsCreated()) Wait_Close(); }
+  bool IsCreated() { return PoolThread_WasCreated(&thread) != 0; }
+  WRes Wait_Close() { return PoolThread_Wait_Close(&thread); }
+  WRes Create(THREAD_FUNC_TYPE startAddress, LPVOID param)
+    { return PoolThread_Create(&thread, startAddress, param); }
+};
+
 }
 
 #endif